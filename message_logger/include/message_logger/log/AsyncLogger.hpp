@@ -0,0 +1,252 @@
+/**********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2014, Christian Gehring
+ * All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Autonomous Systems Lab nor ETH Zurich
+ *     nor the names of its contributors may be used to endorse or
+ *     promote products derived from this software without specific
+ *     prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/*!
+* @file     AsyncLogger.hpp
+* @brief    Realtime safe logging: the calling thread only copies the raw
+*           arguments into a preallocated lock-free ring, a background thread
+*           formats the messages and forwards them to the MELO backend.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "message_logger/log/log_messages.hpp"
+
+namespace message_logger {
+namespace log {
+
+/*!
+ * Static description of a logging call site. Its address is used as the call site id, it holds everything that
+ * does not change between two calls, in particular the format string.
+ * The format string uses {} as placeholder, {:x}, {:8} and {:08x} set the width, fill and hexadecimal output.
+ */
+struct CallSite {
+  levels::Level level;
+  const char* format;
+  const char* file;
+  int line;
+};
+
+/*!
+ * Fixed size record in the ring, the arguments are stored as type tag followed by the raw value.
+ */
+struct LogRecord {
+  enum class ArgType : uint8_t { Int, UInt, Double, Bool, Char, String, Pointer };
+  static constexpr std::size_t payloadSize = 232;
+
+  const CallSite* callSite;
+  uint64_t stamp;  // nanoseconds since epoch
+  uint16_t size;
+  bool truncated;
+  unsigned char payload[payloadSize];
+};
+
+namespace internal {
+
+/*!
+ * Appends the raw arguments to a record, never allocates. Arguments not fitting anymore are dropped and the record
+ * is marked as truncated, strings are cut.
+ */
+class LogRecordWriter {
+ public:
+  explicit LogRecordWriter(LogRecord& record) : record_(record) {
+    record_.size = 0;
+    record_.truncated = false;
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value && !std::is_same<T, char>::value>::type
+  write(const T value) {
+    writeValue(LogRecord::ArgType::Int, static_cast<int64_t>(value));
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value>::type
+  write(const T value) {
+    writeValue(LogRecord::ArgType::UInt, static_cast<uint64_t>(value));
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_enum<T>::value>::type write(const T value) {
+    writeValue(LogRecord::ArgType::Int, static_cast<int64_t>(value));
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_floating_point<T>::value>::type write(const T value) {
+    writeValue(LogRecord::ArgType::Double, static_cast<double>(value));
+  }
+
+  void write(const bool value) { writeValue(LogRecord::ArgType::Bool, value); }
+  void write(const char value) { writeValue(LogRecord::ArgType::Char, value); }
+  void write(const void* value) { writeValue(LogRecord::ArgType::Pointer, reinterpret_cast<uintptr_t>(value)); }
+  void write(const char* value) { writeString(value, value == nullptr ? 0 : std::strlen(value)); }
+  void write(char* value) { write(static_cast<const char*>(value)); }
+  void write(const std::string& value) { writeString(value.data(), value.size()); }
+
+  void writeAll() {}
+
+  template <typename Arg, typename... Args>
+  void writeAll(const Arg& arg, const Args&... args) {
+    write(arg);
+    writeAll(args...);
+  }
+
+ protected:
+  template <typename T>
+  void writeValue(const LogRecord::ArgType type, const T value) {
+    if (record_.size + 1u + sizeof(T) > LogRecord::payloadSize) {
+      record_.truncated = true;
+      return;
+    }
+    record_.payload[record_.size++] = static_cast<unsigned char>(type);
+    std::memcpy(record_.payload + record_.size, &value, sizeof(T));
+    record_.size += sizeof(T);
+  }
+
+  void writeString(const char* value, std::size_t length) {
+    if (record_.size + 2u > LogRecord::payloadSize) {
+      record_.truncated = true;
+      return;
+    }
+    const std::size_t space = LogRecord::payloadSize - record_.size - 2;
+    if (length > space || length > 255) {
+      length = space < 255 ? space : 255;
+      record_.truncated = true;
+    }
+    record_.payload[record_.size++] = static_cast<unsigned char>(LogRecord::ArgType::String);
+    record_.payload[record_.size++] = static_cast<unsigned char>(length);
+    std::memcpy(record_.payload + record_.size, value, length);
+    record_.size += length;
+  }
+
+  LogRecord& record_;
+};
+
+}  // namespace internal
+
+/*!
+ * Asynchronous logger. log() is lock-free and does not allocate, it can be called from realtime threads. If the ring is
+ * full the message is dropped and counted, the number of dropped messages is reported by the background thread.
+ */
+class AsyncLogger {
+ public:
+  //! Receives the formatted messages in the background thread.
+  using Sink = std::function<void(levels::Level, const std::string&)>;
+
+  static constexpr std::size_t defaultCapacity = 4096;
+  static constexpr unsigned int defaultPollPeriodMs = 5;
+
+  /*!
+   * Logger used by the MELO_RT_* macros, it forwards the messages to the MELO_*_STREAM macros.
+   * Call it once before entering a realtime loop, the first call starts the background thread.
+   */
+  static AsyncLogger& instance();
+
+  /*!
+   * @param capacity      Number of records of the ring, rounded up to a power of two.
+   * @param sink          Receives the formatted messages, defaults to the MELO_*_STREAM macros.
+   * @param pollPeriodMs  Period of the background thread polling the ring.
+   */
+  explicit AsyncLogger(std::size_t capacity = defaultCapacity, Sink sink = Sink(), unsigned int pollPeriodMs = defaultPollPeriodMs);
+  ~AsyncLogger();
+  AsyncLogger(const AsyncLogger&) = delete;
+  AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+  /*!
+   * Copies the arguments into the ring, realtime safe.
+   * @return False if the ring was full and the message was dropped.
+   */
+  template <typename... Args>
+  bool log(const CallSite& callSite, const Args&... args) {
+    Cell* cell = acquire();
+    if (cell == nullptr) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    cell->record.callSite = &callSite;
+    cell->record.stamp = now();
+    internal::LogRecordWriter writer(cell->record);
+    writer.writeAll(args...);
+    publish(cell);
+    return true;
+  }
+
+  /*!
+   * Blocks until all messages logged before the call have been passed to the sink.
+   */
+  void flush();
+
+  //! Number of messages dropped since the start because the ring was full.
+  uint64_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+  //! Formats a record, used by the background thread.
+  static std::string format(const LogRecord& record);
+
+ protected:
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    LogRecord record;
+  };
+
+  Cell* acquire();
+  void publish(Cell* cell);
+  bool consume();
+  void run();
+  static uint64_t now();
+
+  const std::size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  //! Producers and the consumer are kept on separate cache lines.
+  alignas(64) std::atomic<std::size_t> enqueuePosition_{0};
+  alignas(64) std::atomic<std::size_t> dequeuePosition_{0};
+  alignas(64) std::atomic<uint64_t> dropped_{0};
+  uint64_t reportedDropped_{0};
+
+  Sink sink_;
+  const unsigned int pollPeriodMs_;
+  std::atomic<bool> running_{true};
+  std::thread thread_;
+};
+
+} /* namespace log */
+} /* namespace message_logger */
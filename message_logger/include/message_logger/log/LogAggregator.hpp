@@ -0,0 +1,149 @@
+/**********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2014, Christian Gehring
+ * All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Autonomous Systems Lab nor ETH Zurich
+ *     nor the names of its contributors may be used to endorse or
+ *     promote products derived from this software without specific
+ *     prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/*!
+* @file     LogAggregator.hpp
+* @brief    Aggregation of messages logged at a high rate: per call site only the first message of an interval is
+*           logged, the following ones are counted and reported as one summary per interval.
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "message_logger/log/AsyncLogger.hpp"
+
+namespace message_logger {
+namespace log {
+
+/*!
+ * Call site of an aggregated message. It is updated with relaxed atomics only, the counters of an interval are
+ * therefore not exact if the flusher runs concurrently, which is acceptable for a summary.
+ */
+struct AggregatedCallSite {
+  constexpr AggregatedCallSite(const levels::Level level, const char* format, const char* file, const int line,
+                               const char* valueName)
+      : callSite{level, format, file, line}, valueName(valueName) {}
+
+  const CallSite callSite;
+  //! Name of the value whose minimum and maximum are reported in the summary.
+  const char* valueName;
+
+  std::atomic<bool> registered{false};
+  std::atomic<uint64_t> count{0};
+  std::atomic<int64_t> min{std::numeric_limits<int64_t>::max()};
+  std::atomic<int64_t> max{std::numeric_limits<int64_t>::min()};
+  //! Next call site registered at the same aggregator.
+  AggregatedCallSite* next{nullptr};
+};
+
+/*!
+ * Collects the aggregated call sites and periodically logs a summary of the suppressed messages through an
+ * AsyncLogger, e.g. "Suppressed 997 times in the last 1000 ms, wkc min/max: 3/5: <format of the call site>".
+ */
+class LogAggregator {
+ public:
+  static constexpr unsigned int defaultIntervalMs = 1000;
+
+  //! Aggregator used by the MELO_RT_*_AGGREGATED macros, it logs through AsyncLogger::instance().
+  static LogAggregator& instance();
+
+  /*!
+   * @param logger      Logger used for the first message of an interval and the summaries.
+   * @param intervalMs  Period of the summaries.
+   */
+  explicit LogAggregator(AsyncLogger& logger, unsigned int intervalMs = defaultIntervalMs);
+  ~LogAggregator();
+  LogAggregator(const LogAggregator&) = delete;
+  LogAggregator& operator=(const LogAggregator&) = delete;
+
+  /*!
+   * Counts an occurrence, realtime safe and of constant cost.
+   * @return True if this is the first occurrence of the interval, the message itself should be logged.
+   */
+  bool record(AggregatedCallSite& site, const int64_t value) {
+    if (!site.registered.load(std::memory_order_relaxed)) {
+      add(site);
+    }
+    updateMin(site.min, value);
+    updateMax(site.max, value);
+    return site.count.fetch_add(1, std::memory_order_relaxed) == 0;
+  }
+
+  /*!
+   * Logs the summaries of all call sites with suppressed messages and starts a new interval, called periodically by
+   * the background thread.
+   */
+  void flush();
+
+  //! The logger the summaries are written to.
+  AsyncLogger& getLogger() { return logger_; }
+
+ protected:
+  void add(AggregatedCallSite& site);
+  void run();
+
+  static void updateMin(std::atomic<int64_t>& min, const int64_t value) {
+    int64_t current = min.load(std::memory_order_relaxed);
+    while (value < current && !min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  static void updateMax(std::atomic<int64_t>& max, const int64_t value) {
+    int64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  AsyncLogger& logger_;
+  const std::chrono::milliseconds interval_;
+  //! Intrusive list of the registered call sites, only ever grows.
+  std::atomic<AggregatedCallSite*> sites_{nullptr};
+
+  std::mutex flushMutex_;
+  std::chrono::steady_clock::time_point lastFlush_;
+
+  std::mutex runMutex_;
+  std::condition_variable runCondition_;
+  bool running_{true};
+  std::thread thread_;
+};
+
+} /* namespace log */
+} /* namespace message_logger */
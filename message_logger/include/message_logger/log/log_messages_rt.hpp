@@ -0,0 +1,102 @@
+/**********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2014, Christian Gehring
+ * All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Autonomous Systems Lab nor ETH Zurich
+ *     nor the names of its contributors may be used to endorse or
+ *     promote products derived from this software without specific
+ *     prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/*!
+* @file     log_messages_rt.hpp
+* @brief    Realtime safe variants of the logging macros, see AsyncLogger.
+*
+* Usage: MELO_RT_WARN("[{}] Working counter is too low: {} < {}, alStatusCode: 0x{:08x}", name, wkc, expected, code);
+* The format string has to be a literal, the arguments are copied (strings are cut if the record is full).
+*
+* Messages which can fire every cycle use the aggregated variants, e.g.
+* MELO_RT_WARN_AGGREGATED("wkc", wkc, "[{}] Working counter is too low: {} < {}", name, wkc, expected);
+* Only the first message per interval is logged, the following ones are counted and reported in one summary per
+* interval together with the minimum and maximum of the given value, see LogAggregator.
+*/
+#pragma once
+
+#include "message_logger/log/AsyncLogger.hpp"
+#include "message_logger/log/LogAggregator.hpp"
+
+#define MELO_RT_LOG(level, format, ...)                                                                           \
+  do {                                                                                                            \
+    static const ::message_logger::log::CallSite meloRtCallSite_{level, format, __FILE__, __LINE__};               \
+    ::message_logger::log::AsyncLogger::instance().log(meloRtCallSite_, ##__VA_ARGS__);                          \
+  } while (0)
+
+#define MELO_RT_LOG_AGGREGATED(level, valueName, value, format, ...)                                                  \
+  do {                                                                                                                \
+    static ::message_logger::log::AggregatedCallSite meloRtAggregatedCallSite_{level, format, __FILE__, __LINE__,      \
+                                                                               valueName};                            \
+    auto& meloRtAggregator_ = ::message_logger::log::LogAggregator::instance();                                       \
+    if (meloRtAggregator_.record(meloRtAggregatedCallSite_, static_cast<int64_t>(value))) {                           \
+      meloRtAggregator_.getLogger().log(meloRtAggregatedCallSite_.callSite, ##__VA_ARGS__);                           \
+    }                                                                                                                 \
+  } while (0)
+
+#if defined(MELO_MIN_SEVERITY) && MELO_MIN_SEVERITY > MELO_SEVERITY_DEBUG
+#define MELO_RT_DEBUG(format, ...)
+#define MELO_RT_DEBUG_AGGREGATED(valueName, value, format, ...)
+#else
+#define MELO_RT_DEBUG(format, ...) MELO_RT_LOG(::message_logger::log::levels::Level::Debug, format, ##__VA_ARGS__)
+#define MELO_RT_DEBUG_AGGREGATED(valueName, value, format, ...) \
+  MELO_RT_LOG_AGGREGATED(::message_logger::log::levels::Level::Debug, valueName, value, format, ##__VA_ARGS__)
+#endif
+
+#if defined(MELO_MIN_SEVERITY) && MELO_MIN_SEVERITY > MELO_SEVERITY_INFO
+#define MELO_RT_INFO(format, ...)
+#define MELO_RT_INFO_AGGREGATED(valueName, value, format, ...)
+#else
+#define MELO_RT_INFO(format, ...) MELO_RT_LOG(::message_logger::log::levels::Level::Info, format, ##__VA_ARGS__)
+#define MELO_RT_INFO_AGGREGATED(valueName, value, format, ...) \
+  MELO_RT_LOG_AGGREGATED(::message_logger::log::levels::Level::Info, valueName, value, format, ##__VA_ARGS__)
+#endif
+
+#if defined(MELO_MIN_SEVERITY) && MELO_MIN_SEVERITY > MELO_SEVERITY_WARN
+#define MELO_RT_WARN(format, ...)
+#define MELO_RT_WARN_AGGREGATED(valueName, value, format, ...)
+#else
+#define MELO_RT_WARN(format, ...) MELO_RT_LOG(::message_logger::log::levels::Level::Warn, format, ##__VA_ARGS__)
+#define MELO_RT_WARN_AGGREGATED(valueName, value, format, ...) \
+  MELO_RT_LOG_AGGREGATED(::message_logger::log::levels::Level::Warn, valueName, value, format, ##__VA_ARGS__)
+#endif
+
+#if defined(MELO_MIN_SEVERITY) && MELO_MIN_SEVERITY > MELO_SEVERITY_ERROR
+#define MELO_RT_ERROR(format, ...)
+#define MELO_RT_ERROR_AGGREGATED(valueName, value, format, ...)
+#else
+#define MELO_RT_ERROR(format, ...) MELO_RT_LOG(::message_logger::log::levels::Level::Error, format, ##__VA_ARGS__)
+#define MELO_RT_ERROR_AGGREGATED(valueName, value, format, ...) \
+  MELO_RT_LOG_AGGREGATED(::message_logger::log::levels::Level::Error, valueName, value, format, ##__VA_ARGS__)
+#endif
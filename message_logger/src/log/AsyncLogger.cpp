@@ -0,0 +1,294 @@
+/**********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2014, Christian Gehring
+ * All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Autonomous Systems Lab nor ETH Zurich
+ *     nor the names of its contributors may be used to endorse or
+ *     promote products derived from this software without specific
+ *     prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/*!
+* @file     AsyncLogger.cpp
+* @brief
+*/
+#include "message_logger/log/AsyncLogger.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+namespace message_logger {
+namespace log {
+
+constexpr std::size_t LogRecord::payloadSize;
+constexpr std::size_t AsyncLogger::defaultCapacity;
+constexpr unsigned int AsyncLogger::defaultPollPeriodMs;
+
+static std::size_t roundUpToPowerOfTwo(std::size_t value) {
+  std::size_t result = 2;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+static void meloSink(const levels::Level level, const std::string& message) {
+  switch (level) {
+    case levels::Level::Debug:
+      MELO_DEBUG_STREAM(message);
+      break;
+    case levels::Level::Info:
+      MELO_INFO_STREAM(message);
+      break;
+    case levels::Level::Warn:
+      MELO_WARN_STREAM(message);
+      break;
+    default:
+      // fatal is reported as error, throwing in the background thread is not an option.
+      MELO_ERROR_STREAM(message);
+      break;
+  }
+}
+
+AsyncLogger& AsyncLogger::instance() {
+  static AsyncLogger logger;
+  return logger;
+}
+
+AsyncLogger::AsyncLogger(std::size_t capacity, Sink sink, unsigned int pollPeriodMs)
+    : mask_(roundUpToPowerOfTwo(capacity) - 1),
+      cells_(new Cell[mask_ + 1]),
+      sink_(sink ? std::move(sink) : Sink(&meloSink)),
+      pollPeriodMs_(pollPeriodMs) {
+  for (std::size_t i = 0; i <= mask_; i++) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  thread_ = std::thread(&AsyncLogger::run, this);
+}
+
+AsyncLogger::~AsyncLogger() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  // messages logged after the thread stopped.
+  while (consume()) {
+  }
+}
+
+AsyncLogger::Cell* AsyncLogger::acquire() {
+  // bounded MPMC queue by D. Vyukov, a cell is free for position p if its sequence equals p.
+  std::size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+  while (true) {
+    Cell* cell = &cells_[position & mask_];
+    const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (difference == 0) {
+      if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        return cell;
+      }
+    } else if (difference < 0) {
+      return nullptr;  // full
+    } else {
+      position = enqueuePosition_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void AsyncLogger::publish(Cell* cell) {
+  const std::size_t position = cell->sequence.load(std::memory_order_relaxed);
+  cell->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool AsyncLogger::consume() {
+  // single consumer, therefore no compare exchange is needed.
+  const std::size_t position = dequeuePosition_.load(std::memory_order_relaxed);
+  Cell& cell = cells_[position & mask_];
+  if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+    return false;
+  }
+  const levels::Level level = cell.record.callSite->level;
+  const std::string message = format(cell.record);
+  cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+  dequeuePosition_.store(position + 1, std::memory_order_release);
+  sink_(level, message);
+  return true;
+}
+
+void AsyncLogger::run() {
+  while (running_) {
+    bool consumed = false;
+    while (consume()) {
+      consumed = true;
+    }
+    const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reportedDropped_) {
+      std::stringstream message;
+      message << "[AsyncLogger] Ring full, dropped " << dropped - reportedDropped_ << " messages.";
+      sink_(levels::Level::Warn, message.str());
+      reportedDropped_ = dropped;
+    }
+    if (!consumed) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(pollPeriodMs_));
+    }
+  }
+}
+
+void AsyncLogger::flush() {
+  const std::size_t target = enqueuePosition_.load(std::memory_order_acquire);
+  while (dequeuePosition_.load(std::memory_order_acquire) < target && running_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+uint64_t AsyncLogger::now() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+namespace {
+
+//! Reads the arguments of a record in the order they were written.
+class LogRecordReader {
+ public:
+  explicit LogRecordReader(const LogRecord& record) : record_(record) {}
+
+  bool writeNext(std::ostream& out) {
+    if (position_ >= record_.size) {
+      return false;
+    }
+    const auto type = static_cast<LogRecord::ArgType>(record_.payload[position_++]);
+    switch (type) {
+      case LogRecord::ArgType::Int:
+        out << read<int64_t>();
+        break;
+      case LogRecord::ArgType::UInt:
+        out << read<uint64_t>();
+        break;
+      case LogRecord::ArgType::Double:
+        out << read<double>();
+        break;
+      case LogRecord::ArgType::Bool:
+        out << (read<bool>() ? "true" : "false");
+        break;
+      case LogRecord::ArgType::Char:
+        out << read<char>();
+        break;
+      case LogRecord::ArgType::Pointer:
+        out << reinterpret_cast<const void*>(read<uintptr_t>());
+        break;
+      case LogRecord::ArgType::String: {
+        const std::size_t length = record_.payload[position_++];
+        out.write(reinterpret_cast<const char*>(record_.payload + position_), static_cast<std::streamsize>(length));
+        position_ += length;
+        break;
+      }
+    }
+    return true;
+  }
+
+ protected:
+  template <typename T>
+  T read() {
+    T value;
+    std::memcpy(&value, record_.payload + position_, sizeof(T));
+    position_ += sizeof(T);
+    return value;
+  }
+
+  const LogRecord& record_;
+  std::size_t position_{0};
+};
+
+}  // namespace
+
+std::string AsyncLogger::format(const LogRecord& record) {
+  std::ostringstream out;
+  LogRecordReader reader(record);
+  const char* format = record.callSite->format;
+  bool argumentsLeft = true;
+  while (*format != '\0') {
+    if (format[0] == '{' && format[1] == '{') {
+      out << '{';
+      format += 2;
+      continue;
+    }
+    if (format[0] == '}' && format[1] == '}') {
+      out << '}';
+      format += 2;
+      continue;
+    }
+    if (format[0] != '{') {
+      out << *format++;
+      continue;
+    }
+    // placeholder {[:][0][width][x|X]}
+    const char* end = std::strchr(format, '}');
+    if (end == nullptr) {
+      out << format;
+      break;
+    }
+    const std::ios_base::fmtflags flags = out.flags();
+    const char fill = out.fill();
+    const char* spec = format + 1;
+    if (*spec == ':') {
+      spec++;
+    }
+    if (*spec == '0') {
+      out << std::setfill('0');
+      spec++;
+    }
+    int width = 0;
+    while (spec < end && *spec >= '0' && *spec <= '9') {
+      width = 10 * width + (*spec++ - '0');
+    }
+    if (spec < end && (*spec == 'x' || *spec == 'X')) {
+      out << std::hex;
+      if (*spec == 'X') {
+        out << std::uppercase;
+      }
+    }
+    out << std::setw(width);
+    if (argumentsLeft) {
+      argumentsLeft = reader.writeNext(out);
+    }
+    if (!argumentsLeft) {
+      out << "{?}";
+    }
+    out.flags(flags);
+    out.fill(fill);
+    format = end + 1;
+  }
+  if (record.truncated) {
+    out << " [truncated]";
+  }
+  return out.str();
+}
+
+} /* namespace log */
+} /* namespace message_logger */
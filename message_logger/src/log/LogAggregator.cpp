@@ -0,0 +1,140 @@
+/**********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2014, Christian Gehring
+ * All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Autonomous Systems Lab nor ETH Zurich
+ *     nor the names of its contributors may be used to endorse or
+ *     promote products derived from this software without specific
+ *     prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/*!
+* @file     LogAggregator.cpp
+* @brief
+*/
+#include "message_logger/log/LogAggregator.hpp"
+
+#include <cstring>
+
+namespace message_logger {
+namespace log {
+
+constexpr unsigned int LogAggregator::defaultIntervalMs;
+
+#define MELO_AGGREGATOR_SUMMARY_FORMAT "Suppressed {} times in the last {} ms, {} min/max: {}/{} ({}:{}): {}"
+
+static const CallSite& summaryCallSite(const levels::Level level) {
+  static const CallSite debug{levels::Level::Debug, MELO_AGGREGATOR_SUMMARY_FORMAT, __FILE__, __LINE__};
+  static const CallSite info{levels::Level::Info, MELO_AGGREGATOR_SUMMARY_FORMAT, __FILE__, __LINE__};
+  static const CallSite warn{levels::Level::Warn, MELO_AGGREGATOR_SUMMARY_FORMAT, __FILE__, __LINE__};
+  static const CallSite error{levels::Level::Error, MELO_AGGREGATOR_SUMMARY_FORMAT, __FILE__, __LINE__};
+  switch (level) {
+    case levels::Level::Debug:
+      return debug;
+    case levels::Level::Info:
+      return info;
+    case levels::Level::Warn:
+      return warn;
+    default:
+      return error;
+  }
+}
+
+#undef MELO_AGGREGATOR_SUMMARY_FORMAT
+
+static const char* fileName(const char* path) {
+  const char* name = std::strrchr(path, '/');
+  return name == nullptr ? path : name + 1;
+}
+
+LogAggregator& LogAggregator::instance() {
+  // the logger is constructed first and therefore outlives the aggregator.
+  static LogAggregator aggregator(AsyncLogger::instance());
+  return aggregator;
+}
+
+LogAggregator::LogAggregator(AsyncLogger& logger, unsigned int intervalMs)
+    : logger_(logger), interval_(intervalMs), lastFlush_(std::chrono::steady_clock::now()) {
+  thread_ = std::thread(&LogAggregator::run, this);
+}
+
+LogAggregator::~LogAggregator() {
+  {
+    std::lock_guard<std::mutex> lock(runMutex_);
+    running_ = false;
+  }
+  runCondition_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  flush();
+}
+
+void LogAggregator::add(AggregatedCallSite& site) {
+  if (site.registered.exchange(true)) {
+    return;
+  }
+  AggregatedCallSite* head = sites_.load(std::memory_order_relaxed);
+  do {
+    site.next = head;
+  } while (!sites_.compare_exchange_weak(head, &site, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void LogAggregator::flush() {
+  std::lock_guard<std::mutex> lock(flushMutex_);
+  const auto now = std::chrono::steady_clock::now();
+  const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastFlush_).count();
+  lastFlush_ = now;
+  for (AggregatedCallSite* site = sites_.load(std::memory_order_acquire); site != nullptr; site = site->next) {
+    const uint64_t count = site->count.exchange(0, std::memory_order_relaxed);
+    if (count == 0) {
+      continue;
+    }
+    const int64_t min = site->min.exchange(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+    const int64_t max = site->max.exchange(std::numeric_limits<int64_t>::min(), std::memory_order_relaxed);
+    if (count > 1) {
+      // the first message of the interval has been logged by the call site itself.
+      logger_.log(summaryCallSite(site->callSite.level), count - 1, elapsedMs, site->valueName, min, max,
+                  fileName(site->callSite.file), site->callSite.line, site->callSite.format);
+    }
+  }
+}
+
+void LogAggregator::run() {
+  std::unique_lock<std::mutex> lock(runMutex_);
+  while (running_) {
+    runCondition_.wait_for(lock, interval_, [this] { return !running_; });
+    if (running_) {
+      lock.unlock();
+      flush();
+      lock.lock();
+    }
+  }
+}
+
+} /* namespace log */
+} /* namespace message_logger */
@@ -0,0 +1,70 @@
+// Measures the cost of a log call on the calling (realtime) thread: MELO_RT_WARN compared to formatting the same
+// message synchronously with an ostream, which is the lower bound of what MELO_WARN_STREAM costs before any I/O.
+// Usage: benchmark_async_logger [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "message_logger/log/AsyncLogger.hpp"
+
+using message_logger::log::AsyncLogger;
+using message_logger::log::CallSite;
+using message_logger::log::levels::Level;
+
+template <typename Function>
+static std::vector<int64_t> measure(const int iterations, Function function) {
+  std::vector<int64_t> durations;
+  durations.reserve(iterations);
+  for (int i = 0; i < iterations; i++) {
+    const auto start = std::chrono::steady_clock::now();
+    function(i);
+    const auto end = std::chrono::steady_clock::now();
+    durations.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+  }
+  std::sort(durations.begin(), durations.end());
+  return durations;
+}
+
+static void print(const std::string& name, const std::vector<int64_t>& durations) {
+  const auto percentile = [&durations](const double p) { return durations[static_cast<std::size_t>(p * (durations.size() - 1))]; };
+  std::cout << std::left << std::setw(24) << name << " p50: " << std::setw(7) << percentile(0.5) << " p99: " << std::setw(7)
+            << percentile(0.99) << " p99.9: " << std::setw(7) << percentile(0.999) << " max: " << durations.back() << " [ns]"
+            << std::endl;
+}
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+  const std::string busName("eth0");
+  const int expectedWorkingCounter = 12;
+  const uint32_t alStatusCode = 0x1b;
+
+  // the ring is big enough to not drop, messages are discarded by the background thread.
+  AsyncLogger logger(static_cast<std::size_t>(iterations), [](Level, const std::string&) {});
+  static const CallSite callSite{Level::Warn, "[soem_interface_rsl::{}] Working counter is too low: {} < {}, alStatusCode: 0x{:08x}",
+                                 __FILE__, __LINE__};
+
+  const auto asyncDurations =
+      measure(iterations, [&](const int i) { logger.log(callSite, busName, i % 12, expectedWorkingCounter, alStatusCode); });
+  logger.flush();
+
+  std::size_t totalLength = 0;
+  const auto syncDurations = measure(iterations, [&](const int i) {
+    std::stringstream stream;
+    stream << "[soem_interface_rsl::" << busName << "] Working counter is too low: " << i % 12 << " < " << expectedWorkingCounter
+           << ", alStatusCode: 0x" << std::setfill('0') << std::setw(8) << std::hex << alStatusCode;
+    totalLength += stream.str().size();
+  });
+
+  std::cout << "Log call cost on the calling thread, " << iterations << " iterations:" << std::endl;
+  print("AsyncLogger::log", asyncDurations);
+  print("ostream formatting", syncDurations);
+  std::cout << "Dropped: " << logger.getDroppedCount() << ", formatted bytes: " << totalLength << std::endl;
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "message_logger/log/AsyncLogger.hpp"
+
+using message_logger::log::AsyncLogger;
+using message_logger::log::CallSite;
+using message_logger::log::LogRecord;
+using message_logger::log::levels::Level;
+
+static std::string formatRecord(const CallSite& callSite, const LogRecord& record) {
+  LogRecord copy = record;
+  copy.callSite = &callSite;
+  return AsyncLogger::format(copy);
+}
+
+TEST(AsyncLogger, format) {  // NOLINT
+  static const CallSite callSite{Level::Warn, "[{}] wkc {} < {}, code 0x{:08x} {:X} {} {} {{}}", __FILE__, __LINE__};
+  LogRecord record;
+  message_logger::log::internal::LogRecordWriter writer(record);
+  writer.writeAll(std::string("eth0"), 3, 5u, 0x1dU, 255, true, 'c');
+  EXPECT_EQ(formatRecord(callSite, record), "[eth0] wkc 3 < 5, code 0x0000001d FF true c {}");
+}
+
+TEST(AsyncLogger, formatFixedPointTime) {  // NOLINT
+  static const CallSite callSite{Level::Error, "Time: {}.{:06} slave: {}", __FILE__, __LINE__};
+  LogRecord record;
+  message_logger::log::internal::LogRecordWriter writer(record);
+  writer.writeAll(uint32_t{1760000000}, uint32_t{4200}, uint16_t{3});
+  EXPECT_EQ(formatRecord(callSite, record), "Time: 1760000000.004200 slave: 3");
+}
+
+TEST(AsyncLogger, missingArgumentsAndTruncation) {  // NOLINT
+  static const CallSite callSite{Level::Info, "{} {}", __FILE__, __LINE__};
+  LogRecord record;
+  message_logger::log::internal::LogRecordWriter writer(record);
+  writer.writeAll(std::string(1000, 'a'));
+  const std::string message = formatRecord(callSite, record);
+  EXPECT_EQ(message.substr(message.size() - 20), "aaaa {?} [truncated]");
+}
+
+TEST(AsyncLogger, sinkReceivesMessagesInOrder) {  // NOLINT
+  static const CallSite callSite{Level::Error, "message {}", __FILE__, __LINE__};
+  std::mutex mutex;
+  std::vector<std::string> messages;
+  AsyncLogger logger(16, [&](Level level, const std::string& message) {
+    EXPECT_EQ(level, Level::Error);
+    std::lock_guard<std::mutex> lock(mutex);
+    messages.push_back(message);
+  });
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(logger.log(callSite, i));
+  }
+  logger.flush();
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(messages.size(), 10u);
+  EXPECT_EQ(messages.front(), "message 0");
+  EXPECT_EQ(messages.back(), "message 9");
+}
+
+TEST(AsyncLogger, dropsWhenFull) {  // NOLINT
+  static const CallSite callSite{Level::Info, "{}", __FILE__, __LINE__};
+  std::atomic<bool> entered{false};
+  std::atomic<bool> release{false};
+  AsyncLogger logger(2, [&](Level, const std::string& message) {
+    if (message == "0") {
+      entered = true;
+      while (!release) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  EXPECT_TRUE(logger.log(callSite, 0));
+  while (!entered) {
+    std::this_thread::yield();
+  }
+  EXPECT_TRUE(logger.log(callSite, 1));
+  EXPECT_TRUE(logger.log(callSite, 2));
+  EXPECT_FALSE(logger.log(callSite, 3));
+  EXPECT_EQ(logger.getDroppedCount(), 1u);
+  release = true;
+  logger.flush();
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "message_logger/log/LogAggregator.hpp"
+
+using message_logger::log::AggregatedCallSite;
+using message_logger::log::AsyncLogger;
+using message_logger::log::LogAggregator;
+using message_logger::log::levels::Level;
+
+namespace {
+
+class LogAggregatorTest : public ::testing::Test {
+ protected:
+  LogAggregatorTest()
+      : logger_(64,
+                [this](Level, const std::string& message) {
+                  std::lock_guard<std::mutex> lock(mutex_);
+                  messages_.push_back(message);
+                }),
+        aggregator_(logger_, 60000) {}
+
+  std::vector<std::string> flush() {
+    aggregator_.flush();
+    logger_.flush();
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> messages;
+    messages.swap(messages_);
+    return messages;
+  }
+
+  std::mutex mutex_;
+  std::vector<std::string> messages_;
+  AsyncLogger logger_;
+  LogAggregator aggregator_;
+};
+
+}  // namespace
+
+TEST_F(LogAggregatorTest, firstOccurrenceOfIntervalIsLogged) {  // NOLINT
+  static AggregatedCallSite site{Level::Warn, "wkc {}", __FILE__, __LINE__, "wkc"};
+  EXPECT_TRUE(aggregator_.record(site, 3));
+  EXPECT_FALSE(aggregator_.record(site, 4));
+  flush();
+  EXPECT_TRUE(aggregator_.record(site, 3));
+}
+
+TEST_F(LogAggregatorTest, summaryReportsCountAndRange) {  // NOLINT
+  static AggregatedCallSite site{Level::Warn, "Working counter is too low: {}", __FILE__, __LINE__, "wkc"};
+  for (int i = 1; i <= 1000; i++) {
+    aggregator_.record(site, i % 7 + 2);
+  }
+  const std::vector<std::string> messages = flush();
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_EQ(messages.front().find("Suppressed 999 times"), 0u);
+  EXPECT_NE(messages.front().find("wkc min/max: 2/8"), std::string::npos);
+  EXPECT_NE(messages.front().find("Working counter is too low: {}"), std::string::npos);
+}
+
+TEST_F(LogAggregatorTest, noSummaryWithoutSuppressedMessages) {  // NOLINT
+  static AggregatedCallSite site{Level::Info, "once", __FILE__, __LINE__, "value"};
+  aggregator_.record(site, 1);
+  EXPECT_TRUE(flush().empty());
+  EXPECT_TRUE(flush().empty());
+}
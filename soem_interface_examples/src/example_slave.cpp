@@ -21,16 +21,13 @@
 */
 
 #include <soem_interface_examples/ExampleSlave.hpp>
+#include <soem_interface_rsl/CyclicExecutor.hpp>
 #include <soem_interface_rsl/EthercatBusBase.hpp>
 #include <soem_rsl/soem_rsl/ethercattype.h>
 
 #include <thread>
 
-#include <sched.h>
 #include <iostream>
-#include <unistd.h>
-#include <cstring>
-#include <cerrno>
 
 // This shows a minimal example on how to use the soem_interface_rsl library.
 // Keep in mind that this is non-working example code, with only minimal error handling
@@ -45,16 +42,6 @@ void signalHandler(int signum)
 
 int main(int argc, char **argv)
 {
-  // 设置线程优先级
-  pid_t pid = getpid(); // 获取当前进程 PID，也可以指定其他 PID
-  struct sched_param param;
-  param.sched_priority = 90; // 设置实时优先级为 50
-
-  if (sched_setscheduler(pid, SCHED_FIFO, &param) == -1) {
-    MELO_ERROR_STREAM("Failed to set real-time scheduler: " << strerror(errno));
-    MELO_ERROR_STREAM("Need root privileges for real-time scheduling.");
-  }
-
   signal(SIGINT, signalHandler);
 
   rclcpp::init(argc, argv);
@@ -80,36 +67,46 @@ int main(int argc, char **argv)
     return 1;
   }
 
-  rclcpp::Rate rate(1000.0);
-
-  while (run_loop.load())
-  {
-
-
+  // The executor runs updateRead(), the callback and updateWrite() every millisecond in its own SCHED_FIFO thread.
+  // Setting the realtime scheduler needs root privileges or CAP_SYS_NICE.
+  soem_interface_rsl::CyclicExecutor::Options options;
+  options.cycleTime = 0.001;
+  options.priority = 90;
+  soem_interface_rsl::CyclicExecutor executor(*bus, options);
+  executor.start([&bus]() {
     if (!bus->busIsAvailable() || !bus->busIsOk())
     {
-      MELO_ERROR_STREAM("Bus error detected, stopping main loop.");
-      break;
+      run_loop.store(false);
     }
+  });
 
-    auto start_time = std::chrono::high_resolution_clock::now();
-    bus->updateRead();
-    auto update_time = std::chrono::high_resolution_clock::now();
-    bus->updateWrite();
-    auto end_time = std::chrono::high_resolution_clock::now();
-
-
-    // Compute and print durations
-    auto read_duration = std::chrono::duration_cast<std::chrono::microseconds>(update_time - start_time).count();
-    auto write_duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - update_time).count();
-    // MELO_INFO_STREAM("Read duration: " << read_duration << " us, Write duration: " << write_duration << " us");
-    if (!rate.sleep()) {
-      rate.reset();
-      MELO_WARN_STREAM("Loop overrun!");
-      MELO_INFO_STREAM("Read duration: " << read_duration << " us, Write duration: " << write_duration << " us");
-    }
-    // std::this_thread::sleep_for(std::chrono::microseconds(250));
+  while (run_loop.load())
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
+  executor.stop();
+  if (!bus->busIsAvailable() || !bus->busIsOk())
+  {
+    MELO_ERROR_STREAM("Bus error detected, stopped the main loop.");
+  }
+
+  const auto statistics = executor.getStatistics();
+  MELO_INFO_STREAM("Cycles: " << statistics.cycles << ", overruns: " << statistics.overruns
+                              << ", max cycle duration: " << 1e6 * statistics.maxCycleDuration << " us");
+
+  // Phase durations of the bus cycles, recorded by updateRead() and updateWrite().
+  const auto busStatistics = bus->getCycleStatistics();
+  const auto printHistogram = [](const std::string& name, const soem_interface_rsl::common::HistogramSnapshot& histogram) {
+    MELO_INFO_STREAM(name << ": p50 " << 1e-3 * histogram.getPercentile(0.5) << " us, p99 " << 1e-3 * histogram.getPercentile(0.99)
+                          << " us, max " << 1e-3 * histogram.max << " us");
+  };
+  printHistogram("Slave updateWrite()", busStatistics.writeSlaves);
+  printHistogram("Send", busStatistics.send);
+  printHistogram("Receive", busStatistics.receive);
+  printHistogram("Slave updateRead()", busStatistics.readSlaves);
+  MELO_INFO_STREAM("Cycle period: mean " << 1e-3 * busStatistics.period.mean << " us, jitter " << 1e-3 * busStatistics.period.standardDeviation
+                                         << " us, working counter min/avg: " << busStatistics.workingCounterMin << "/"
+                                         << busStatistics.workingCounterAverage);
 
   bus->shutdown();
   return 0;
@@ -0,0 +1,205 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// pthread
+#include <pthread.h>
+
+#include <soem_interface_rsl/EthercatBusBase.hpp>
+#include <soem_interface_rsl/EthercatBusManagerBase.hpp>
+#include <soem_interface_rsl/common/soem_rsl_export.h>
+
+namespace soem_interface_rsl {
+
+/**
+ * @brief      Runs the cyclic exchange of a bus or of all busses of a manager
+ *             in a dedicated realtime thread: updateRead(), the user callback
+ *             and updateWrite() are called once per cycle, the cycle start
+ *             is an absolute CLOCK_MONOTONIC time, optionally with a busy
+ *             wait tail to reduce the wake up jitter. Overruns are counted
+ *             and written to the event log of the bus.
+ *             With distributed clocks the cycle start is phase locked to the
+ *             DC time of the reference clock, like ec_sync() of the soem_rsl
+ *             examples: a PI controller adjusts the cycle start such that the
+ *             frames pass the reference clock dcSyncShift after a multiple of
+ *             the cycle time, i.e. after the SYNC0 events of slaves
+ *             configured with syncDistributedClock0(.., cycleTime, 0).
+ */
+class SOEM_RSL_EXPORT CyclicExecutor {
+ public:
+  enum class SchedulingPolicy { Other, Fifo, Deadline };
+
+  struct Options {
+    //! Cycle time in seconds.
+    double cycleTime{0.001};
+    //! CPU the thread is pinned to, -1 to not pin it. Pinning is usually not allowed together with SCHED_DEADLINE.
+    int cpu{-1};
+    SchedulingPolicy policy{SchedulingPolicy::Fifo};
+    //! Priority for SCHED_FIFO.
+    int priority{90};
+    //! Runtime budget per cycle in seconds for SCHED_DEADLINE, the deadline and the period are the cycle time.
+    double deadlineRuntime{0.0005};
+    //! Locks all current and future pages of the process into memory.
+    bool lockMemory{true};
+    //! Stack size of the thread.
+    size_t stackSize{1024 * 1024};
+    //! Part of the stack touched before the first cycle, so that the cycles do not page fault.
+    size_t stackPrefaultSize{256 * 1024};
+    //! Time in seconds before the cycle start at which the thread stops sleeping and busy waits, 0 to only sleep.
+    double spinTime{0.0};
+    //! Phase lock the cycle start to the distributed clocks of the bus.
+    bool dcSync{false};
+    //! Bus providing the DC time if the executor runs a bus manager, without a bus of that name the executor runs free.
+    std::string dcSyncBus;
+    //! Time in seconds after a multiple of the cycle time in DC time at which the frames should pass the reference clock.
+    double dcSyncShift{0.0};
+    //! Proportional and integral gain of the phase lock, per cycle.
+    double dcSyncKp{0.05};
+    double dcSyncKi{0.001};
+    //! Safety margin added to the measured latency when tuning the SYNC0 shift, covers the processing time of the slaves.
+    double syncShiftMargin{5e-6};
+  };
+
+  struct Statistics {
+    uint64_t cycles{0};
+    uint64_t overruns{0};
+    //! Duration of read, callback and write of the last cycle, in seconds.
+    double lastCycleDuration{0.0};
+    double maxCycleDuration{0.0};
+    //! Phase error of the last cycle, i.e. time the frame passed the reference clock minus its target, in seconds.
+    double dcOffset{0.0};
+    //! Root mean square of the phase error, exponentially weighted over about 100 cycles, in seconds.
+    double dcOffsetJitter{0.0};
+    //! Largest absolute phase error since the lock was acquired, in seconds.
+    double maxDcOffset{0.0};
+    //! Whether the phase error stayed below 10% of the cycle time for the last 100 cycles.
+    bool dcLocked{false};
+  };
+
+  using Callback = std::function<void()>;
+
+  /**
+   * @brief      Executor for custom read and write functions
+   */
+  CyclicExecutor(Callback read, Callback write, const Options& options);
+  //! Executor of a single bus, overruns are written to its event log.
+  CyclicExecutor(EthercatBusBase& bus, const Options& options);
+  //! Executor of all busses of a manager.
+  CyclicExecutor(EthercatBusManagerBase& manager, const Options& options);
+  ~CyclicExecutor();
+  CyclicExecutor(const CyclicExecutor&) = delete;
+  CyclicExecutor& operator=(const CyclicExecutor&) = delete;
+
+  /**
+   * @brief      Starts the thread. Failing to apply a realtime setting is
+   *             reported but does not prevent the start
+   *
+   * @param[in]  callback  Called each cycle between read and write
+   *
+   * @return     True if the thread has been started
+   */
+  bool start(Callback callback = Callback());
+
+  /**
+   * @brief      Stops the thread after the current cycle and joins it
+   */
+  void stop();
+
+  bool isRunning() const { return running_; }
+
+  Statistics getStatistics() const;
+
+  /**
+   * @brief      Computes the smallest SYNC0 shift for which the outputs of a
+   *             cycle reach all DC capable slaves before SYNC0: the frames
+   *             pass the reference clock at most dcSyncShift + maxDcOffset
+   *             after a multiple of the cycle time and need the largest
+   *             propagation delay measured by ecx_configdc(..) to reach the
+   *             last slave, plus syncShiftMargin
+   *
+   * @param[out] shift  The SYNC0 shift in seconds
+   *
+   * @return     True if the cycle is phase locked and the shift fits into
+   *             the cycle
+   */
+  bool getRecommendedSyncShift(double& shift) const;
+
+  /**
+   * @brief      Activates SYNC0 (or SYNC0 and SYNC1) with the recommended
+   *             shift, to be called from a non realtime thread once the
+   *             cycle is phase locked
+   *
+   * @param[in]  slaves      Addresses of the slaves, all DC capable slaves if
+   *                         empty
+   * @param[in]  cycleTime1  SYNC1 delay, 0 to only use SYNC0
+   *
+   * @return     True if the shift has been applied
+   */
+  bool tuneSyncShift(const std::vector<uint16_t>& slaves = {}, double cycleTime1 = 0.0);
+
+ protected:
+  static void* threadEntry(void* executor);
+  void configureThread();
+  void run();
+  //! Returns the correction of the next cycle start in ns.
+  int64_t updateDcSync(int64_t period);
+
+  Callback read_;
+  Callback write_;
+  Callback callback_;
+  const Options options_;
+  common::EventLog* eventLog_{nullptr};
+  //! Bus providing the distributed clocks, nullptr if there is none.
+  EthercatBusBase* bus_{nullptr};
+  //! DC time of the last received frame, empty if no DC time is available.
+  std::function<int64_t()> dcTime_;
+
+  pthread_t thread_{};
+  bool threadStarted_{false};
+  std::atomic<bool> running_{false};
+
+  std::atomic<uint64_t> cycles_{0};
+  std::atomic<uint64_t> overruns_{0};
+  std::atomic<int64_t> lastCycleDurationNs_{0};
+  std::atomic<int64_t> maxCycleDurationNs_{0};
+
+  // phase lock, only accessed by the thread except for the atomics.
+  int64_t lastDcTime_{0};
+  double dcIntegral_{0.0};
+  double dcSquaredOffset_{0.0};
+  unsigned int dcInLockCycles_{0};
+  std::atomic<int64_t> dcOffsetNs_{0};
+  std::atomic<int64_t> dcOffsetJitterNs_{0};
+  std::atomic<int64_t> maxDcOffsetNs_{0};
+  std::atomic<bool> dcLocked_{false};
+};
+
+}  // namespace soem_interface_rsl
@@ -25,6 +25,7 @@
 // std
 #include <atomic>
 #include <chrono>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -36,10 +37,19 @@
 // soem_interface_rsl
 
 #include <soem_interface_rsl/common/soem_rsl_export.h>
+#include <soem_interface_rsl/common/CycleStatistics.hpp>
+#include <soem_interface_rsl/common/CyclicRegisters.hpp>
+#include <soem_interface_rsl/common/DistributedClockMapping.hpp>
+#include <soem_interface_rsl/common/ErrorCounterDiagnosis.hpp>
 #include <soem_interface_rsl/common/EthercatTypes.hpp>
+#include <soem_interface_rsl/common/EventLog.hpp>
 #include <soem_interface_rsl/common/ExtendedRegisters.hpp>
+#include <soem_interface_rsl/common/FrameCapture.hpp>
 #include <soem_interface_rsl/common/Macros.hpp>
+#include <soem_interface_rsl/common/SegmentTopology.hpp>
+#include <soem_interface_rsl/common/SlaveTiming.hpp>
 #include <soem_interface_rsl/common/ObjectDictionaryUtilities.hpp>
+#include <soem_interface_rsl/common/ProcessImageRecorder.hpp>
 #include <soem_interface_rsl/common/ThreadSleep.hpp>
 
 namespace soem_interface_rsl {
@@ -107,11 +117,17 @@ class SOEM_RSL_EXPORT EthercatBusBase : private EthercatBusBaseTemplateAdapter {
   static void printAvailableBusses();
 
   /*!
-   * Check if this bus is available.
+   * Check if this bus is available, i.e. its interface is up.
    * @return True if available.
    */
   bool busIsAvailable() const;
 
+  /*!
+   * Check if the interface of this bus has a carrier, i.e. a cable is plugged in.
+   * @return True if the link is up.
+   */
+  bool hasCarrier() const;
+
   /*!
    * Get the number of slaves which were detected on this bus.
    * @return Number of slaves.
@@ -137,6 +153,60 @@ class SOEM_RSL_EXPORT EthercatBusBase : private EthercatBusBaseTemplateAdapter {
 
   bool startup(std::atomic<bool>& abortFlag, bool sizeCheck, int maxDiscoverRetries = 10);
 
+  /*!
+   * Staged startup of the bus communication. Opens the bus, requests PRE_OP and maps the process image, but does not start the slaves.
+   * The slaves are started and brought to OP one by one with stepStagedStartup() while the bus is already cycling. A slave takes part in
+   * the cyclic exchange and in the expected working counter only once it reached OP, a slave failing its startup is left out.
+   * @param abortFlag  the abortFlag can be set to abort waiting for the slaves.
+   * @param sizeCheck	perform a check of the Rx and Tx Pdo sizes defined in the PdoInfo oject of the slaves
+   * @param maxDiscoverRetries	number of retries till the configured number of slaves are found on the bus.
+   * @return True if successful.
+   */
+  bool startupStaged(bool sizeCheck, int maxDiscoverRetries = 10);
+
+  bool startupStaged(std::atomic<bool>& abortFlag, bool sizeCheck, int maxDiscoverRetries = 10);
+
+  /*!
+   * Advance the staged startup by one step, to be called from a non realtime thread while updateRead() and updateWrite() are cycling.
+   * Does not exchange process data, therefore it can run concurrently to the cyclic update.
+   * @return True if all slaves either reached OP or failed.
+   */
+  bool stepStagedStartup();
+
+  /*!
+   * Check if a slave takes part in the cyclic exchange, i.e. its updateRead() and updateWrite() are called.
+   * @param slave Address of the slave.
+   * @return True if the slave is active.
+   */
+  bool slaveIsActive(const uint16_t slave) const;
+
+  /*!
+   * Set the time a single slave may take to reach a requested state during the staged startup, a remap or a recovery, 10 s by default.
+   * Not threadsafe, to be called before the bus is started.
+   * @param timeout The timeout in seconds.
+   */
+  void setSlaveStateTimeout(const double timeout);
+
+  /*!
+   * @return The working counter expected from the cyclic exchange, i.e. the sum of the contributions of the active slaves.
+   */
+  int getExpectedWorkingCounter() const;
+
+  /*!
+   * Change the PDO mapping of a single slave without restarting the bus, e.g. to switch to another moduleId.
+   * The slave is taken out of the cyclic exchange and brought to PRE_OP, then writePdoAssignment is called to rewrite its PDO assignment
+   * with SDOs. The new mapping is placed in a headroom region of the IO map and the slave is brought back to OP, while all other slaves
+   * keep cycling. Must be called from a non realtime thread while updateRead() and updateWrite() are cycling. Only one slave at a time
+   * can live in the headroom, remapping it again is possible, remapping another slave requires a restart of the bus. The PDO assignment is
+   * read with one SDO at a time, the context is locked for the whole remap only while the sync managers and FMMUs are reprogrammed. If the
+   * remap fails, the previous mapping is restored and the slave is brought back to OP by stepSlaveRecovery().
+   * @param slave              Address of the slave.
+   * @param writePdoAssignment Called while the slave is in PRE_OP, the slave object should return its new PdoInfo afterwards.
+   * @param sizeCheck          perform a check of the Rx and Tx Pdo sizes defined in the PdoInfo oject of the slave
+   * @return True if the slave is back in OP with the new mapping.
+   */
+  bool remapSlave(const uint16_t slave, const std::function<bool()>& writePdoAssignment, const bool sizeCheck = true);
+
   /*!
    * Update step 1: Read all PDOs.
    */
@@ -159,6 +229,53 @@ class SOEM_RSL_EXPORT EthercatBusBase : private EthercatBusBaseTemplateAdapter {
    */
   const std::chrono::time_point<std::chrono::high_resolution_clock>& getUpdateWriteStamp() const;
 
+  /*!
+   * Get a snapshot of the cycle statistics: histograms of the durations of the slave updateWrite() loop, of sending, of waiting for
+   * the frames and of the slave updateRead() loop, of the cycle period, and the working counter statistics. They are recorded by
+   * updateRead() and updateWrite() without allocating, taking the snapshot does not block them.
+   * @return Snapshot.
+   */
+  common::CycleStatisticsSnapshot getCycleStatistics() const;
+
+  /*!
+   * Clear the cycle statistics, carried out at the start of the next updateRead().
+   */
+  void resetCycleStatistics();
+
+  /*!
+   * Start recording the wall time and the thread CPU time of the updateRead() and updateWrite() callbacks of each slave. Call it after
+   * adding the slaves, it allocates the histograms of all slaves. Can be called while cycling, calling it again only sets the budget.
+   * @param budget Budget of each callback in seconds, a callback taking longer is logged and written to the event log. 0 for no budget.
+   */
+  void enableSlaveTiming(const double budget = 0.0);
+
+  /*!
+   * Stop recording the timing of the slave callbacks, the recorded timings are kept.
+   */
+  void disableSlaveTiming();
+
+  /*!
+   * Set the budget of the callbacks of a slave, see enableSlaveTiming(..).
+   * @param slave Address of the slave.
+   * @param budget Budget of each callback in seconds, 0 for no budget.
+   * @return True if the slave timing is enabled and the slave exists.
+   */
+  bool setSlaveBudget(const uint16_t slave, const double budget);
+
+  /*!
+   * Get the timing of the callbacks of all slaves, empty if the slave timing has never been enabled.
+   * @return Snapshots in the order the slaves were added.
+   */
+  std::vector<common::SlaveTimingSnapshot> getSlaveTimings() const;
+
+  /*!
+   * Get the slaves with the slowest callbacks.
+   * @param count Maximum number of slaves.
+   * @param fraction Percentile the slaves are ranked by, applied to the sum of the updateRead() and updateWrite() wall times.
+   * @return Snapshots, slowest first.
+   */
+  std::vector<common::SlaveTimingSnapshot> getTopSlaveTimings(const size_t count, const double fraction = 0.99) const;
+
   /*!
    * Shutdown the bus communication.
    */
@@ -201,11 +318,20 @@ class SOEM_RSL_EXPORT EthercatBusBase : private EthercatBusBaseTemplateAdapter {
   /*!
    * Checks if all slaves are in EC_STATE_OPERATIONAL, therefore reads EC state from all slaves!
    * If not does some basic printing for potential debugging.
-   * @param logErrorCounterForDiagnosis runs some error counter diagnosis, which are available to log in getBusDiagnosis.
+   * @param logErrorCounterForDiagnosis every second call sweeps the error counters of all slaves, see sweepErrorCounters().
    * @return true if all fine = all slaves in EC_STATE_OP
    */
   bool doBusMonitoring(bool logErrorCounterForDiagnosis = false);
 
+  /*!
+   * Non blocking recovery of slaves which dropped out of OP or got lost, e.g. due to a flaky connector. To be called periodically from a
+   * non realtime thread while updateRead() and updateWrite() are cycling. A dropped slave is excluded from the cyclic exchange and the
+   * expected working counter, recovered with ecx_recover_slave(..) and the steps of ecx_reconfig_slave(..), EthercatSlaveBase::recover() is
+   * called in SAFE_OP and the slave is included again once it is back in OP. Every call runs only a short time slice.
+   * @return True if no slave is being recovered.
+   */
+  bool stepSlaveRecovery();
+
   /*!
    * @param if returns true busDiagnosisLogOut gets updated with the newest data.
    * @return Return true if the busDiagnosisLog got updated.
@@ -214,6 +340,158 @@ class SOEM_RSL_EXPORT EthercatBusBase : private EthercatBusBaseTemplateAdapter {
 
   bool getBusDiagnosisLog(BusDiagnosisLog& busDiagnosisLogOut);
 
+  /*!
+   * Reads the error counters (0x0300 - 0x0313) of all slaves with one FPRD datagram per slave, packed into one frame per 46 slaves, and
+   * updates the per port error rates and link health scores of getErrorCounterDiagnosis() and the counters of getBusDiagnosisLog(..).
+   * The counters of a slave are cleared before they saturate.
+   * Note: needs to be called within the same thread as doBusMonitoring, not threadsafe!!
+   * @return True if the counters of all slaves with a driver have been read.
+   */
+  bool sweepErrorCounters();
+
+  /*!
+   * @return Accumulated error counters, rate trends and link health of all slaves, e.g. getWorstLinks(..) to locate a degrading cable.
+   * Note: needs to be called within the same thread as doBusMonitoring, not threadsafe!!
+   */
+  const common::ErrorCounterDiagnosis& getErrorCounterDiagnosis() const;
+  void setErrorCounterDiagnosisOptions(const common::ErrorCounterDiagnosis::Options& options);
+
+  /*!
+   * Enables the working counter attribution. After a cycle with a too low working counter, the next cycles send one frame with per slave
+   * datagrams along with the process data: an FPRD of the AL status and an LRW of every logical sub-range of the slave, writing the same
+   * outputs as the process data. Groups blocking LRW get an LRD for an input sub-range and an LWR for an output sub-range. Comparing their
+   * working counters with the expected contributions pinpoints the slaves missing in the working counter, usually within one or two cycles.
+   * The result is available in BusDiagnosisLog::workingCounterFaults after the next doBusMonitoring(..) and is logged as
+   * EventType::WorkingCounterFault.
+   * @param enable Enable the attribution, disabled by default.
+   */
+  void setWorkingCounterAttribution(const bool enable);
+
+  /*!
+   * Enables the periodic refresh of the propagation delays of getSegmentTopology(). A refresh latches the port receive times of all slaves
+   * with a broadcast write to 0x0900 and reads them (0x0900 - 0x090C) in the next cycles, both appended to the register frame of the
+   * cyclic exchange (see addCyclicRegisterRead(..)). A refresh missing a slave is dropped, the last complete one stays published until the
+   * slave answers again. Needs distributed clocks.
+   * @param decimation Refresh every decimation-th cycle, 0 to disable it (default).
+   */
+  void setTopologyRefresh(const unsigned int decimation);
+
+  /*!
+   * Starts capturing every frame sent and received on the port into a preallocated ring, written as pcapng by a background thread. In
+   * continuous mode all frames are written to path, otherwise the last frames are kept and a working counter drop, a slave losing OP or
+   * triggerFrameCapture() dumps the frames around it to path with the trigger number appended. Can be called before or after startup().
+   * @param path    The pcapng file.
+   * @param options Capacity of the ring, mode, time kept around a trigger and enabled triggers.
+   * @return True if successful.
+   */
+  bool startFrameCapture(const std::string& path, const common::FrameCapture::Options& options = common::FrameCapture::Options());
+  void stopFrameCapture();
+
+  /*!
+   * Dumps the frames around now, realtime safe.
+   * @return True if a dump is started, false in continuous mode, while another dump is pending or if the capture is not running.
+   */
+  bool triggerFrameCapture();
+  const common::FrameCapture& getFrameCapture() const;
+
+  /*!
+   * Record the inputs and outputs of all slaves together with the working counter and the DC time each cycle. updateRead() copies the IO
+   * map into a ring, a background thread writes it column by column to a memory mapped file, see common::ProcessImageRecording for
+   * reading it. Call it after startup(), a slave remapped by remapSlave(..) pauses the recording until it is started again.
+   * @param path    The recording, an existing file is replaced.
+   * @param options Size of the ring and of the chunks of the file.
+   * @return True if successful.
+   */
+  bool startProcessImageRecording(const std::string& path,
+                                  const common::ProcessImageRecorder::Options& options = common::ProcessImageRecorder::Options());
+  void stopProcessImageRecording();
+  const common::ProcessImageRecorder& getProcessImageRecorder() const;
+
+  /*!
+   * Serve the process data from a recording instead of the NIC, see ProcessImageReplay. Each updateRead() loads the inputs, the working
+   * counters and the times of the next row into the IO map, readTxPdo(..) of the slaves reads them from there as usual. updateWrite()
+   * sends nothing, a process image recording started after this records the outputs written by the slaves instead. SDOs fail while
+   * replaying. Call it instead of startup(), after the slaves were added.
+   * @param recording    The recording, has to be kept open until stopReplay().
+   * @param firstRow     First row to replay.
+   * @param numberOfRows Number of rows to replay, 0 for all.
+   * @return True if the slaves of the bus match the recorded ones.
+   */
+  bool startReplay(const common::ProcessImageRecording& recording, uint64_t firstRow = 0, uint64_t numberOfRows = 0);
+  void stopReplay();
+
+  /*!
+   * @return True if all rows were replayed or no replay is running.
+   */
+  bool replayIsFinished() const;
+
+  /*!
+   * Tree of the slaves with the port they are connected to and the propagation delay of every hop, measured at startup and by the last
+   * refresh. A growing hop delay points to a heating cable or a bad connector. Threadsafe.
+   * @return The slaves indexed by the bus address, index 0 is the master.
+   */
+  std::vector<common::TopologyNode> getSegmentTopology() const;
+
+  /*!
+   * Register a cyclic read of an ESC register block. The due reads are packed into one frame which updateWrite() sends right after the
+   * process data and updateRead() collects together with it, so monitoring costs no extra round trip. Reads which do not fit into the
+   * frame are postponed to the next cycle. Call it after startup(), can be called while cycling.
+   * @param slave      Address of the slave, 0 for a broadcast read (BRD) which ORs the registers of all slaves.
+   * @param address    Register address.
+   * @param length     Number of bytes, at most common::RegisterValue::maxLength.
+   * @param decimation Read every decimation-th cycle. Registering an existing read again changes its decimation.
+   * @return Handle for getCyclicRegister(..), -1 on failure.
+   */
+  int addCyclicRegisterRead(const uint16_t slave, const uint16_t address, const uint16_t length, const unsigned int decimation = 1);
+
+  /*!
+   * Get the latest value of a cyclic register read, threadsafe and lock-free.
+   * @param handle Handle returned by addCyclicRegisterRead(..).
+   * @param value  Latest value, its cycle is 0 if it has not been read yet.
+   * @return False if the handle is invalid.
+   */
+  bool getCyclicRegister(const int handle, common::RegisterValue& value) const;
+
+  /*!
+   * Register a cyclic read of a status register block, see addCyclicRegisterRead(..).
+   * @param statusRegister Register block.
+   * @param slave          Address of the slave, 0 for a broadcast read.
+   * @param decimation     Read every decimation-th cycle.
+   * @return True on success.
+   */
+  bool addCyclicStatusRead(const common::StatusRegister statusRegister, const uint16_t slave = 0, const unsigned int decimation = 1);
+
+  /*!
+   * Register a cyclic read of a status register block of every slave, one datagram per slave.
+   * @param statusRegister Register block.
+   * @param decimation     Read every decimation-th cycle, e.g. the number of slaves to read one slave per cycle on average.
+   * @return True on success.
+   */
+  bool addCyclicStatusReadForAllSlaves(const common::StatusRegister statusRegister, const unsigned int decimation = 1);
+
+  /*!
+   * Get the cyclically read status registers of a slave, threadsafe and lock-free. doBusMonitoring() skips reading the states if the
+   * broadcast AL status shows all slaves operational.
+   * @param slave  Address of the slave, 0 for the broadcast reads.
+   * @param status Status, only the registered blocks are filled.
+   * @return True if a status read of the slave is registered.
+   */
+  bool getSlaveStatus(const uint16_t slave, common::SlaveStatus& status) const;
+
+  /*!
+   * Starts writing binary event records (state requests and errors, working counter drops, mailbox errors, overruns and
+   * recovery actions) to a memory mapped ring file, see common::EventLog. Call it before startup().
+   * @param path     Path of the file, an existing event log with the same capacity is continued.
+   * @param capacity Number of records kept, 32 bytes each.
+   * @return True if the file could be mapped.
+   */
+  bool openEventLog(const std::string& path, uint64_t capacity = common::EventLog::defaultCapacity);
+
+  /*!
+   * The event log of the bus, e.g. to add overruns of the cyclic thread. Logging does nothing while no file is open.
+   */
+  common::EventLog& getEventLog();
+
   /*!
    * Generate and return the state string.
    * @param state EtherCAT.
@@ -231,6 +509,59 @@ class SOEM_RSL_EXPORT EthercatBusBase : private EthercatBusBaseTemplateAdapter {
    */
   void syncDistributedClock0(const uint16_t slave, const bool activate, const double cycleTime, const double cycleShift);
 
+  /*!
+   * Synchronize the distributed clocks with SYNC0 and SYNC1.
+   *
+   * @param      slave       Address of the slave.
+   * @param      activate    True to activate the distr. clock, false to deactivate.
+   * @param[in]  cycleTime0  The SYNC0 cycle time.
+   * @param[in]  cycleTime1  The SYNC1 delay after SYNC0, SYNC1 fires once every (cycleTime1 / cycleTime0 + 1) SYNC0 cycles.
+   * @param[in]  cycleShift  The shift of SYNC0 relative to a multiple of the cycle time in DC time.
+   */
+  void syncDistributedClock01(const uint16_t slave, const bool activate, const double cycleTime0, const double cycleTime1,
+                              const double cycleShift);
+
+  /*!
+   * Whether distributed clock capable slaves have been found at startup. The clocks are configured with ecx_configdc(..) at startup and
+   * the first DC capable slave is the reference clock.
+   */
+  bool hasDistributedClocks() const;
+
+  /*!
+   * @return Address of the reference clock, 0 if there are no distributed clocks.
+   */
+  uint16_t getReferenceClock() const;
+
+  /*!
+   * DC system time of the reference clock in ns when the last process data frame passed it, updated by updateRead().
+   * The DC epoch is 2000-01-01. 0 if no frame with a DC time has been received yet.
+   */
+  int64_t getDistributedClockTime() const;
+
+  /*!
+   * CLOCK_MONOTONIC time in ns at which the frame read by the last updateRead() was sent, i.e. the host time belonging to
+   * getDistributedClockTime(). 0 if no frame with a DC time has been received yet.
+   */
+  int64_t getUpdateReadMonotonicTime() const;
+
+  /*!
+   * Mapping of the DC system time to CLOCK_MONOTONIC, fed by updateRead() with the pairs of getDistributedClockTime() and
+   * getUpdateReadMonotonicTime(). Use it to timestamp latched slave inputs in host time, its conversions are threadsafe.
+   */
+  const common::DistributedClockMapping& getDistributedClockMapping() const;
+
+  /*!
+   * @param slave Address of the slave.
+   * @return True if the slave has a distributed clock.
+   */
+  bool slaveHasDistributedClock(const uint16_t slave) const;
+
+  /*!
+   * Largest propagation delay from the reference clock to a DC capable slave as measured by ecx_configdc(..), in seconds. A frame
+   * passing the reference clock at time t delivers its outputs to all DC capable slaves by t + getMaxPropagationDelay().
+   */
+  double getMaxPropagationDelay() const;
+
   /*!
    * Returns a map of the actually requested PDO sizes (Rx & Tx) This is useful
    * for slaves where the PDO size at startup is unknown This method shall be
@@ -23,9 +23,12 @@
 #pragma once
 
 // std
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include <soem_interface_rsl/EthercatBusBase.hpp>
 
@@ -34,12 +37,24 @@ namespace soem_interface_rsl {
 /**
  * @brief      Class for managing multiple ethercat busses
  */
-class EthercatBusManagerBase {
+class SOEM_RSL_EXPORT EthercatBusManagerBase {
  public:
   using BusMap = std::unordered_map<std::string, std::unique_ptr<EthercatBusBase>>;
 
+  /**
+   * @brief      Options of the bus workers, see startBusWorkers(..)
+   */
+  struct WorkerOptions {
+    //! CPU of the worker of each bus in the order of getBusNames(), -1 or missing entries are not pinned.
+    std::vector<int> cpus;
+    //! SCHED_FIFO priority of the workers, 0 keeps the scheduling policy of the calling thread.
+    int priority{0};
+    //! Busy wait instead of sleeping on a futex, for workers pinned to isolated CPUs. Saves the wakeup latency.
+    bool spin{false};
+  };
+
   EthercatBusManagerBase() = default;
-  virtual ~EthercatBusManagerBase() = default;
+  virtual ~EthercatBusManagerBase();
 
   /**
    * @brief      Adds an ethercat bus to the manager. The manager takes
@@ -75,6 +90,37 @@ class EthercatBusManagerBase {
    */
   bool startupCommunication();
 
+  /**
+   * @brief      Starts up all busses in staged mode, see
+   *             EthercatBusBase::startupStaged(..). The slaves are brought to
+   *             operational mode by repeatedly calling
+   *             stepStagedStartupAllBuses() while the busses are cycling.
+   *             setBussesOperational() is not needed in this mode.
+   *
+   * @return     True if successful
+   */
+  bool startupAllBusesStaged();
+
+  /**
+   * @brief      Advances the staged startup of all busses by one step. Does
+   *             not lock the bus manager, so that slow slave startups do not
+   *             block readAllBuses() and writeToAllBuses(). Busses must not be
+   *             added or extracted concurrently.
+   *
+   * @return     True if the staged startup of all busses finished
+   */
+  bool stepStagedStartupAllBuses();
+
+  /**
+   * @brief      Advances the recovery of dropped out slaves on all busses,
+   *             see EthercatBusBase::stepSlaveRecovery(). Does not lock the
+   *             bus manager, busses must not be added or extracted
+   *             concurrently.
+   *
+   * @return     True if no slave is being recovered
+   */
+  bool stepSlaveRecoveryAllBuses();
+
   /**
    * @brief      Sets all busses to safe operational state
    */
@@ -102,15 +148,49 @@ class EthercatBusManagerBase {
   void waitForState(const uint16_t state, const uint16_t slave = 0, const std::string busName = "", const unsigned int maxRetries = 40);
 
   /**
-   * @brief      Calls update read on all busses
+   * @brief      Calls update read on all busses, in parallel if the bus
+   *             workers are running
    */
   void readAllBuses();
 
   /**
-   * @brief      Calls update write on all busses
+   * @brief      Calls update write on all busses, in parallel if the bus
+   *             workers are running
    */
   void writeToAllBuses();
 
+  /**
+   * @brief      Sends the outputs on all busses, then collects the inputs
+   *             from all busses. The frames of all busses are on the wire at
+   *             the same time, with the bus workers running each bus also
+   *             processes its frames on its own CPU, so the cycle is bounded
+   *             by the slowest bus instead of the sum of all busses
+   */
+  void updateAllBuses();
+
+  /**
+   * @brief      Starts one worker thread per bus, from now on
+   *             readAllBuses(), writeToAllBuses() and updateAllBuses() hand
+   *             each bus to its worker and wait until all workers are done.
+   *             Busses must not be added or extracted while the workers are
+   *             running
+   *
+   * @param[in]  options  The worker options
+   *
+   * @return     True if the workers have been started
+   */
+  bool startBusWorkers(const WorkerOptions& options);
+
+  /**
+   * @brief      Stops the bus workers, the busses are updated serially again
+   */
+  void stopBusWorkers();
+
+  /**
+   * @brief      Returns the names of the busses in the order they are updated
+   */
+  std::vector<std::string> getBusNames() const;
+
   /**
    * @brief      Calls shutdown on all busses
    */
@@ -126,6 +206,15 @@ class EthercatBusManagerBase {
    */
   EthercatBusBase* getBusByName(const std::string& name) const { return buses_.at(name).get(); }
 
+  /**
+   * @brief      Checks whether the manager manages a bus
+   *
+   * @param[in]  name  The bus name
+   *
+   * @return     True if getBusByName(name) returns the bus.
+   */
+  bool hasBus(const std::string& name) const { return buses_.find(name) != buses_.end(); }
+
   /**
    * @brief      Returns an owning bus pointer. The manager is now not managing
    *             this bus anymore
@@ -151,9 +240,31 @@ class EthercatBusManagerBase {
   bool allBusesAreOk();
 
  protected:
+  enum class BusTask : int { Read, Write, Update };
+
+  struct BusWorker {
+    EthercatBusBase* bus{nullptr};
+    //! Last generation handled by the worker.
+    uint32_t generation{0};
+    std::thread thread;
+  };
+
+  void runBusTask(EthercatBusBase& bus, const BusTask task) const;
+  void runBusWorker(BusWorker& worker, const int cpu);
+  void dispatchToBusWorkers(const BusTask task);
+
   // Mutex prohibiting simultaneous access to EtherCAT bus manager.
   std::mutex busMutex_;
   BusMap buses_;
+
+  std::vector<std::unique_ptr<BusWorker>> workers_;
+  WorkerOptions workerOptions_;
+  std::atomic<bool> workersRunning_{false};
+  //! Incremented to hand busTask_ to the workers, the workers wait on it.
+  std::atomic<uint32_t> workerGeneration_{0};
+  std::atomic<int> busTask_{0};
+  //! Number of workers which have not finished the current task, the dispatching thread waits on it.
+  std::atomic<uint32_t> pendingWorkers_{0};
 };
 
 using EthercatBusManagerBasePtr = std::shared_ptr<EthercatBusManagerBase>;
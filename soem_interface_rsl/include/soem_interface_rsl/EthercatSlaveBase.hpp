@@ -93,6 +93,16 @@ class SOEM_RSL_EXPORT EthercatSlaveBase {
    */
   virtual void shutdown() = 0;
 
+  /**
+   * @brief      Called by EthercatBusBase::stepSlaveRecovery() when the slave
+   *             is back in SAFE_OP after it dropped out or got lost. Use
+   *             this method to restore settings the slave lost, e.g. SDO
+   *             parameters after a power loss
+   *
+   * @return     True if succesful, otherwise it is called again
+   */
+  virtual bool recover() { return true; }
+
   /**
    * @brief      Gets the current pdo information.
    *
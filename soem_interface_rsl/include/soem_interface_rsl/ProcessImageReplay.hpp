@@ -0,0 +1,131 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+// std
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <soem_interface_rsl/EthercatBusBase.hpp>
+#include <soem_interface_rsl/common/ProcessImageRecorder.hpp>
+#include <soem_interface_rsl/common/soem_rsl_export.h>
+
+namespace soem_interface_rsl {
+
+/**
+ * @brief      Replays a process image recording through the slaves of a bus
+ *             as fast as possible, without a NIC. The recorded inputs are
+ *             served to readTxPdo(..) of the slaves (see
+ *             EthercatBusBase::startReplay(..)), the outputs the slaves
+ *             write are recorded and compared to the recorded ones. This
+ *             reproduces field incidents bit by bit and benchmarks the CPU
+ *             time of the slaves and the controller on real traffic, the
+ *             slave timing of the bus (EthercatBusBase::enableSlaveTiming(..))
+ *             splits it up per slave.
+ */
+class SOEM_RSL_EXPORT ProcessImageReplay {
+ public:
+  struct Options {
+    uint64_t firstRow{0};
+    //! Number of cycles to replay, 0 for all rows from firstRow on.
+    uint64_t numberOfRows{0};
+    //! Recording of the replayed cycles with the outputs written by the slaves, compared to the original recording. Empty to not compare.
+    std::string outputPath;
+  };
+
+  /**
+   * @brief      A slave whose outputs differ from the recorded ones
+   */
+  struct SlaveDifference {
+    uint16_t slave{0};
+    std::string name;
+    //! Rows with different outputs.
+    uint64_t rows{0};
+    //! First row with different outputs and the first differing byte in it.
+    uint64_t firstRow{0};
+    size_t firstByte{0};
+  };
+
+  struct Result {
+    uint64_t cycles{0};
+    //! Thread CPU time spent in updateRead(), the callback and updateWrite() of all cycles, in seconds.
+    double cpuTime{0.0};
+    //! Wall time of the same, without waiting for the output recording.
+    double wallTime{0.0};
+    double maxCycleWallTime{0.0};
+    //! First row of the recording whose outputs are compared. The outputs of the first replayed row were written by the priming
+    //! updateWrite() before any recorded inputs were read, they are not compared.
+    uint64_t firstComparedRow{0};
+    std::vector<SlaveDifference> differences;
+  };
+
+  using Callback = std::function<void()>;
+
+  /**
+   * @brief      The bus must not be started, its slaves need to be added
+   *             and started by the caller. SDOs fail while replaying
+   */
+  explicit ProcessImageReplay(EthercatBusBase& bus);
+
+  /**
+   * @brief      Replays a recording
+   *
+   * @param[in]  path      The recording
+   * @param[in]  options   The options
+   * @param[out] result    Timing and differences of the outputs
+   * @param[in]  callback  Called each cycle between updateRead() and
+   *                       updateWrite(), like by the CyclicExecutor
+   *
+   * @return     True if the recording was replayed
+   */
+  bool run(const std::string& path, const Options& options, Result& result, const Callback& callback = Callback());
+
+  /**
+   * @brief      Compares the outputs of a replay to the ones of the
+   *             reference, row r of the replay to row firstRow + r of the
+   *             reference. The outputs of the first rows differ if the
+   *             replay does not start with the recording, as the slaves
+   *             and the controller lack the history
+   *
+   * @param[in]  reference    The original recording
+   * @param[in]  firstRow     First replayed row of the reference
+   * @param[in]  replayed     The recording of the replay
+   * @param[out] differences  Slaves with different outputs
+   * @param[in]  skippedRows  Number of rows at the start of the replay
+   *                          whose outputs are not compared, their stamps
+   *                          are
+   *
+   * @return     False if the recordings do not belong together, i.e.
+   *             different columns or stamps
+   */
+  static bool compare(const common::ProcessImageRecording& reference, uint64_t firstRow, const common::ProcessImageRecording& replayed,
+                      std::vector<SlaveDifference>& differences, uint64_t skippedRows = 0);
+
+ protected:
+  EthercatBusBase& bus_;
+};
+
+}  // namespace soem_interface_rsl
@@ -0,0 +1,193 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// soem_interface_rsl
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      Copy of a LatencyHistogram
+ */
+struct SOEM_RSL_EXPORT HistogramSnapshot {
+  //! Number of samples per bucket, see LatencyHistogram::getBucketLowerBound(..).
+  std::vector<uint64_t> counts;
+  uint64_t count{0};
+  //! Minimum, maximum and mean in ns, 0 without samples.
+  int64_t min{0};
+  int64_t max{0};
+  double mean{0.0};
+  double standardDeviation{0.0};
+
+  /**
+   * @brief      Returns the value below which a fraction of the samples lies,
+   *             with the precision of the buckets
+   *
+   * @param[in]  fraction  The fraction in [0, 1], e.g. 0.99
+   *
+   * @return     The value in ns
+   */
+  int64_t getPercentile(const double fraction) const;
+};
+
+/**
+ * @brief      HDR style histogram of durations in ns with log-linear buckets:
+ *             every power of two is split into subBuckets equal buckets, so
+ *             the relative error is below 1 / subBuckets over the whole range
+ *             up to about 68 s. Recording is allocation-free and meant for a
+ *             single writer thread, any thread can take a snapshot without
+ *             blocking the writer. A snapshot taken while recording may be
+ *             off by the sample being recorded.
+ */
+class SOEM_RSL_EXPORT LatencyHistogram {
+ public:
+  static constexpr unsigned int subBucketBits = 5;
+  static constexpr unsigned int subBuckets = 1u << subBucketBits;
+  static constexpr unsigned int maxBit = 36;
+  static constexpr unsigned int numberOfBuckets = (maxBit - subBucketBits + 2) * subBuckets;
+
+  /**
+   * @brief      Records a sample, to be called from a single thread
+   *
+   * @param[in]  value  The duration in ns, negative values count as 0
+   */
+  void record(const int64_t value);
+
+  /**
+   * @brief      Clears the histogram, to be called from the recording thread
+   */
+  void reset();
+
+  HistogramSnapshot getSnapshot() const;
+
+  static unsigned int getBucketIndex(const int64_t value);
+  static int64_t getBucketLowerBound(const unsigned int index);
+
+ protected:
+  static void increment(std::atomic<uint64_t>& counter, const uint64_t value = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<uint64_t>, numberOfBuckets> counts_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<int64_t> min_{0};
+  std::atomic<int64_t> max_{0};
+  std::atomic<double> sum_{0.0};
+  std::atomic<double> sumOfSquares_{0.0};
+};
+
+/**
+ * @brief      Snapshot of the statistics of a bus
+ */
+struct SOEM_RSL_EXPORT CycleStatisticsSnapshot {
+  //! Duration of the updateWrite() loop over the slaves.
+  HistogramSnapshot writeSlaves;
+  //! Duration of ecx_send_processdata(..).
+  HistogramSnapshot send;
+  //! Duration of ecx_receive_processdata(..), i.e. the wait for the frames.
+  HistogramSnapshot receive;
+  //! Duration of the updateRead() loop over the slaves.
+  HistogramSnapshot readSlaves;
+  //! Time between the starts of consecutive updateRead() calls, its standard deviation is the cycle jitter.
+  HistogramSnapshot period;
+
+  uint64_t cycles{0};
+  int workingCounterMin{0};
+  double workingCounterAverage{0.0};
+  //! Number of runs of consecutive cycles with a too low working counter.
+  uint64_t lowWorkingCounterRuns{0};
+  uint64_t longestLowWorkingCounterRun{0};
+  uint64_t currentLowWorkingCounterRun{0};
+};
+
+/**
+ * @brief      Always-on statistics of the cycles of a bus, recorded by the
+ *             cyclic thread without allocating. reset() can be called from
+ *             any thread, it is carried out by the cyclic thread at the start
+ *             of the next cycle.
+ */
+class SOEM_RSL_EXPORT CycleStatistics {
+ public:
+  enum class Phase : unsigned int { WriteSlaves = 0, Send = 1, Receive = 2, ReadSlaves = 3 };
+
+  /**
+   * @brief      Records the start of updateRead() and returns the current
+   *             time, to be called from the cyclic thread
+   *
+   * @return     The current time in ns
+   */
+  int64_t startCycle();
+
+  /**
+   * @brief      Records the duration of a phase which started at start and
+   *             returns the current time, to be called from the cyclic thread
+   *
+   * @param[in]  phase  The phase
+   * @param[in]  start  The start of the phase in ns
+   *
+   * @return     The current time in ns
+   */
+  int64_t recordPhase(const Phase phase, const int64_t start);
+
+  /**
+   * @brief      Records the working counter of a cycle, to be called from the
+   *             cyclic thread
+   *
+   * @param[in]  workingCounter          The working counter
+   * @param[in]  expectedWorkingCounter  The expected working counter
+   */
+  void recordWorkingCounter(const int workingCounter, const int expectedWorkingCounter);
+
+  void reset();
+
+  CycleStatisticsSnapshot getSnapshot() const;
+
+  /**
+   * @brief      Returns the current CLOCK_MONOTONIC time in ns
+   */
+  static int64_t now();
+
+ protected:
+  void applyReset();
+
+  std::array<LatencyHistogram, 4> phases_;
+  LatencyHistogram period_;
+  int64_t lastCycleStart_{0};
+  std::atomic<bool> resetRequested_{false};
+
+  std::atomic<uint64_t> cycles_{0};
+  std::atomic<int> workingCounterMin_{0};
+  std::atomic<int64_t> workingCounterSum_{0};
+  std::atomic<uint64_t> lowWorkingCounterRuns_{0};
+  std::atomic<uint64_t> longestLowWorkingCounterRun_{0};
+  std::atomic<uint64_t> currentLowWorkingCounterRun_{0};
+};
+
+}  // namespace soem_interface_rsl::common
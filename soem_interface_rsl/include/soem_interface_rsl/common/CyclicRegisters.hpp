@@ -0,0 +1,193 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+// soem_interface_rsl
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      ESC status registers which can be read cyclically, see
+ *             EthercatBusBase::addCyclicStatusRead(..)
+ */
+enum class StatusRegister : uint8_t {
+  //! AL status 0x0130 and AL status code 0x0134.
+  AlStatus = 0,
+  //! DL status 0x0110.
+  DlStatus = 1,
+  //! Error counters 0x0300 - 0x0313.
+  ErrorCounters = 2,
+};
+
+/**
+ * @brief      Address and length of a status register block
+ */
+struct SOEM_RSL_EXPORT StatusRegisterBlock {
+  uint16_t address;
+  uint16_t length;
+
+  static StatusRegisterBlock get(const StatusRegister statusRegister);
+};
+
+/**
+ * @brief      Latest value of a cyclic register read
+ */
+struct SOEM_RSL_EXPORT RegisterValue {
+  static constexpr uint16_t maxLength = 32;
+
+  //! Slave address, 0 for a broadcast read.
+  uint16_t slave{0};
+  uint16_t address{0};
+  uint16_t length{0};
+  unsigned int decimation{1};
+  //! Working counter of the datagram, the number of answering slaves for a broadcast read. 0 if the read failed.
+  uint16_t workingCounter{0};
+  //! Number of the bus cycle the value has been read in, 0 if it has never been read.
+  uint64_t cycle{0};
+  //! CLOCK_MONOTONIC time the frame was sent at, in ns.
+  int64_t stamp{0};
+  std::array<uint8_t, maxLength> data{};
+
+  /**
+   * @brief      Returns the little endian value at an offset into the register
+   *             block
+   */
+  template <typename T>
+  T get(const uint16_t offset = 0) const {
+    T value{};
+    if (offset + sizeof(T) <= length) {
+      std::memcpy(&value, data.data() + offset, sizeof(T));
+    }
+    return value;
+  }
+};
+
+/**
+ * @brief      Decoded status registers of a slave, see
+ *             EthercatBusBase::getSlaveStatus(..)
+ */
+struct SOEM_RSL_EXPORT SlaveStatus {
+  //! AL status 0x0130 and AL status code 0x0134, the states of all slaves ORed for a broadcast read.
+  uint16_t alStatus{0};
+  uint16_t alStatusCode{0};
+  RegisterValue alStatusRegister;
+  //! DL status 0x0110.
+  uint16_t dlStatus{0};
+  RegisterValue dlStatusRegister;
+  //! Raw error counters 0x0300 - 0x0313, see REG::ERROR_COUNTERS.
+  RegisterValue errorCounterRegisters;
+};
+
+/**
+ * @brief      Table of register reads which the bus appends to its cyclic
+ *             frames, with the latest value of each. Reads are added by a
+ *             single non realtime thread at any time. The cyclic thread
+ *             schedules and publishes them without locking or allocating and
+ *             any thread can read the values, every entry is a seqlock.
+ */
+class SOEM_RSL_EXPORT CyclicRegisterTable {
+ public:
+  static constexpr size_t capacity = 1024;
+
+  //! Read as seen by the cyclic thread.
+  struct Read {
+    uint16_t slave{0};
+    //! Station address of the slave, 0 for a broadcast read.
+    uint16_t stationAddress{0};
+    uint16_t address{0};
+    uint16_t length{0};
+    std::atomic<unsigned int> decimation{1};
+    //! Cycle the read is due in, owned by the cyclic thread.
+    uint64_t dueCycle{0};
+  };
+
+  /**
+   * @brief      Adds a read or changes the decimation of an existing one
+   *
+   * @param[in]  slave           The slave address, 0 for a broadcast read
+   * @param[in]  stationAddress  The configured station address of the slave
+   * @param[in]  address         The register address
+   * @param[in]  length          The number of bytes, at most
+   *                             RegisterValue::maxLength
+   * @param[in]  decimation      Read every decimation-th cycle
+   *
+   * @return     Handle of the read, -1 if the table is full or the length is
+   *             invalid
+   */
+  int add(const uint16_t slave, const uint16_t stationAddress, const uint16_t address, const uint16_t length,
+          const unsigned int decimation);
+
+  /**
+   * @brief      Returns the handle of a read, -1 if it has not been added
+   */
+  int find(const uint16_t slave, const uint16_t address, const uint16_t length) const;
+
+  /**
+   * @brief      Number of reads, the handles are 0 .. size() - 1
+   */
+  size_t size() const { return size_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief      Returns a read, to be called from the cyclic thread with a
+   *             handle below size()
+   */
+  Read& getRead(const size_t handle) { return entries_[handle].read; }
+
+  /**
+   * @brief      Publishes a value, to be called from the cyclic thread
+   */
+  void publish(const size_t handle, const uint8_t* data, const uint16_t workingCounter, const uint64_t cycle, const int64_t stamp);
+
+  /**
+   * @brief      Copies the latest value of a read
+   *
+   * @return     False if the handle is invalid
+   */
+  bool get(const int handle, RegisterValue& value) const;
+
+ protected:
+  struct Entry {
+    Read read;
+    std::atomic<uint64_t> sequence{0};
+    uint16_t workingCounter{0};
+    uint64_t cycle{0};
+    int64_t stamp{0};
+    std::array<uint8_t, RegisterValue::maxLength> data{};
+  };
+
+  //! Serializes add(..), never taken by the cyclic thread.
+  mutable std::mutex addMutex_;
+  std::unique_ptr<Entry[]> entries_{new Entry[capacity]};
+  std::atomic<size_t> size_{0};
+};
+
+}  // namespace soem_interface_rsl::common
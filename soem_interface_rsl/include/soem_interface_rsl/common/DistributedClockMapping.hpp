@@ -0,0 +1,190 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// soem_interface_rsl
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      Maps the EtherCAT distributed clock (DC) system time to the
+ *             host CLOCK_MONOTONIC. Every cycle the bus adds the DC time of
+ *             the reference clock read by a process data frame together with
+ *             the monotonic time the frame was sent. The mapping is a linear
+ *             regression over a window of these samples, so that the drift
+ *             between the clocks is followed and the host jitter averages
+ *             out. Samples which deviate from the current mapping by more
+ *             than rejectionFactor times the residual RMS (at least
+ *             minRejectionThreshold) are rejected as outliers, e.g. when the
+ *             sending thread got preempted between taking the stamp and
+ *             sending the frame.
+ *
+ *             addSample(..) is called by the cyclic thread and does not
+ *             allocate, the conversions can be called from any thread.
+ *             The mapped time carries the constant wire delay from the host
+ *             to the reference clock, which is in the order of a few us.
+ */
+class SOEM_RSL_EXPORT DistributedClockMapping {
+ public:
+  /**
+   * @brief      Constructor
+   *
+   * @param[in]  windowSize             Number of samples of the regression
+   * @param[in]  minSamples             Number of samples needed for a valid
+   *                                    mapping
+   * @param[in]  rejectionFactor        Outlier threshold in multiples of the
+   *                                    residual RMS
+   * @param[in]  minRejectionThreshold  Lower bound of the outlier threshold
+   *                                    in ns
+   */
+  explicit DistributedClockMapping(const size_t windowSize = 500, const size_t minSamples = 20, const double rejectionFactor = 4.0,
+                                   const double minRejectionThreshold = 5000.0);
+
+  /**
+   * @brief      Forgets all samples, e.g. after the distributed clocks have
+   *             been (re)configured. Not threadsafe with addSample(..)
+   */
+  void reset();
+
+  /**
+   * @brief      Adds a sample and updates the mapping, to be called from a
+   *             single thread
+   *
+   * @param[in]  distributedClockTime  The DC system time in ns
+   * @param[in]  monotonicTime         The CLOCK_MONOTONIC time in ns
+   */
+  void addSample(const int64_t distributedClockTime, const int64_t monotonicTime);
+
+  /**
+   * @brief      Whether enough samples have been collected for a mapping
+   */
+  bool isValid() const;
+
+  /**
+   * @brief      Converts a DC system time to CLOCK_MONOTONIC
+   *
+   * @param[in]  distributedClockTime  The DC system time in ns
+   * @param[out] monotonicTime         The CLOCK_MONOTONIC time in ns
+   *
+   * @return     False if the mapping is not valid yet
+   */
+  bool toMonotonic(const int64_t distributedClockTime, int64_t& monotonicTime) const;
+
+  /**
+   * @brief      Converts the lower 32 bits of a DC system time, as latched by
+   *             slaves with 32 bit distributed clocks, to CLOCK_MONOTONIC. The
+   *             upper bits are taken from the latest sample, so the time must
+   *             be within +-2.1 s of it
+   *
+   * @param[in]  distributedClockTime  The lower 32 bits of the DC system time
+   *                                   in ns
+   * @param[out] monotonicTime         The CLOCK_MONOTONIC time in ns
+   *
+   * @return     False if the mapping is not valid yet
+   */
+  bool toMonotonic32(const uint32_t distributedClockTime, int64_t& monotonicTime) const;
+
+  /**
+   * @brief      Converts a CLOCK_MONOTONIC time to the DC system time
+   *
+   * @param[in]  monotonicTime         The CLOCK_MONOTONIC time in ns
+   * @param[out] distributedClockTime  The DC system time in ns
+   *
+   * @return     False if the mapping is not valid yet
+   */
+  bool toDistributedClock(const int64_t monotonicTime, int64_t& distributedClockTime) const;
+
+  /**
+   * @brief      RMS of the residuals of the inliers in ns
+   */
+  double getResidualRms() const;
+
+  /**
+   * @brief      Drift of the host clock against the distributed clocks in
+   *             ppm, positive if the host clock runs faster
+   */
+  double getDrift() const;
+
+  /**
+   * @brief      Number of samples rejected as outliers since the last reset
+   */
+  uint64_t getNumberOfOutliers() const;
+
+  /**
+   * @brief      Returns the current CLOCK_MONOTONIC time in ns
+   */
+  static int64_t getMonotonicTime();
+
+ protected:
+  struct Sample {
+    int64_t distributedClockTime{0};
+    int64_t monotonicTime{0};
+    bool outlier{false};
+  };
+
+  //! Current mapping: monotonic = monotonicReference + offset + slope * (distributedClock - distributedClockReference).
+  struct Model {
+    int64_t distributedClockReference{0};
+    int64_t monotonicReference{0};
+    double offset{0.0};
+    double slope{1.0};
+    double residualRms{0.0};
+    bool valid{false};
+  };
+
+  bool isOutlier(const Sample& sample) const;
+  bool fit();
+  void publish();
+  Model load() const;
+
+  const size_t minSamples_;
+  const double rejectionFactor_;
+  const double minRejectionThreshold_;
+
+  // Owned by the thread calling addSample(..).
+  std::vector<Sample> samples_;
+  size_t next_{0};
+  size_t size_{0};
+  size_t outliersInWindow_{0};
+  Model model_;
+
+  // Published copy of model_, seqlock: odd while being written.
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<int64_t> distributedClockReference_{0};
+  std::atomic<int64_t> monotonicReference_{0};
+  std::atomic<double> offset_{0.0};
+  std::atomic<double> slope_{1.0};
+  std::atomic<double> residualRms_{0.0};
+  std::atomic<bool> valid_{false};
+  std::atomic<int64_t> latestDistributedClockTime_{0};
+  std::atomic<uint64_t> outliers_{0};
+};
+
+}  // namespace soem_interface_rsl::common
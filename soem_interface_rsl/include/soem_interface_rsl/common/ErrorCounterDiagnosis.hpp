@@ -0,0 +1,162 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/ExtendedRegisters.hpp"
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      Error counters and their trends of one port of a slave
+ */
+struct SOEM_RSL_EXPORT PortErrorCounters {
+  //! Accumulated frame and physical layer errors received on the port.
+  uint64_t rxErrors{0};
+  //! Accumulated errors detected by a slave before, forwarded through the port.
+  uint64_t forwardedErrors{0};
+  uint64_t lostLinks{0};
+  //! Error rates in 1/s, averaged over the short time constant.
+  double rxErrorRate{0.0};
+  double lostLinkRate{0.0};
+  //! RX error rate averaged over the long time constant.
+  double rxErrorRateLongTerm{0.0};
+  //! Short minus long term RX error rate in 1/s, positive while the link degrades.
+  double rxErrorTrend{0.0};
+  //! Health of the link into the port, 1 without errors, towards 0 with increasing error rates.
+  double health{1.0};
+  //! A counter saturated at 0xff before it was cleared, the accumulated counts are a lower bound.
+  bool saturated{false};
+};
+
+/**
+ * @brief      Error counters of a slave
+ */
+struct SOEM_RSL_EXPORT SlaveErrorCounters {
+  std::array<PortErrorCounters, 4> ports;
+  //! Accumulated malformed frames and PDI errors.
+  uint64_t processingUnitErrors{0};
+  uint64_t pdiErrors{0};
+  //! Number of sweeps which read the counters.
+  uint64_t sweeps{0};
+};
+
+/**
+ * @brief      Health of a link, identified by the slave and its receiving
+ *             port
+ */
+struct SOEM_RSL_EXPORT LinkHealth {
+  uint16_t slave{0};
+  uint8_t port{0};
+  double health{1.0};
+  double rxErrorRate{0.0};
+  double rxErrorTrend{0.0};
+};
+
+/**
+ * @brief      Accumulates the error counters (0x0300-0x0313) of all slaves
+ *             read by a sweep and keeps per port rate trends and a health
+ *             score per link. The ESC counters saturate at 0xff, therefore
+ *             update() asks to clear the counters of a slave once one of them
+ *             reaches the clear threshold. Not threadsafe.
+ */
+class SOEM_RSL_EXPORT ErrorCounterDiagnosis {
+ public:
+  struct Options {
+    //! Time constants of the short and long term rate averages in s.
+    double shortTimeConstant{1.0};
+    double longTimeConstant{60.0};
+    //! Rates in 1/s which reduce the health of a link to 1/e.
+    double rxErrorRateScale{1.0};
+    double lostLinkRateScale{0.1};
+    //! Counter value at which the counters of a slave are cleared.
+    uint8_t clearThreshold{0x80};
+  };
+
+  //! Register block read per slave.
+  static constexpr uint16_t blockAddress = static_cast<uint16_t>(REG::ERROR_COUNTERS::FRAME_ERROR_PORT0_ADDR);
+  static constexpr uint16_t blockLength = REG::ERROR_COUNTERS_LIST.blockSize();
+
+  ErrorCounterDiagnosis() = default;
+  explicit ErrorCounterDiagnosis(const Options& options) : options_(options) {}
+
+  void setOptions(const Options& options) { options_ = options; }
+
+  /**
+   * @brief      Resets the counters of all slaves
+   *
+   * @param[in]  nSlaves  The number of slaves, the slaves are addressed from
+   *                      1 to nSlaves
+   */
+  void reset(const uint16_t nSlaves);
+
+  /**
+   * @brief      Adds the counters read from a slave
+   *
+   * @param[in]  slave  The slave address
+   * @param[in]  block  The raw register block of blockLength bytes
+   * @param[in]  time   The time of the read in s
+   *
+   * @return     True if the counters of the slave should be cleared, call
+   *             cleared() afterwards
+   */
+  bool update(const uint16_t slave, const uint8_t* block, const double time);
+
+  /**
+   * @brief      Notifies that the counters of a slave have been cleared
+   */
+  void cleared(const uint16_t slave);
+
+  const SlaveErrorCounters& getSlave(const uint16_t slave) const { return slaves_[slave].counters; }
+  uint16_t getNumberOfSlaves() const { return static_cast<uint16_t>(slaves_.size() - 1); }
+
+  /**
+   * @brief      Returns the links with the lowest health
+   *
+   * @param[in]  count  The maximum number of links
+   *
+   * @return     The links, the worst first. Links without any error are
+   *             omitted
+   */
+  std::vector<LinkHealth> getWorstLinks(const size_t count) const;
+
+ protected:
+  struct Slave {
+    SlaveErrorCounters counters;
+    //! Raw counters of the previous read, valid if time >= 0.
+    std::array<uint8_t, blockLength> previous{};
+    double time{-1.0};
+  };
+
+  Options options_;
+  //! Indexed by the slave address, 0 is unused.
+  std::vector<Slave> slaves_{1};
+};
+
+}  // namespace soem_interface_rsl::common
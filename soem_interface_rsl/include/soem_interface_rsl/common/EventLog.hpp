@@ -0,0 +1,188 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// soem_interface_rsl
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      Type of a binary event record
+ */
+enum class EventType : uint16_t {
+  None = 0,
+  //! A state was requested, value0: state before the request, value1: requested state.
+  StateRequest = 1,
+  //! A requested state was not reached, value0: current state, value1: requested state, code: AL status code.
+  StateError = 2,
+  //! The working counter dropped below the expected one, value0: working counter, value1: expected working counter.
+  WorkingCounterDrop = 3,
+  //! The working counter is as expected again, value0: working counter, value1: cycles with a too low working counter.
+  WorkingCounterRestored = 4,
+  //! SDO abort, index and subIndex of the object, code: abort code.
+  SdoAbort = 5,
+  //! Emergency message, code: error code, value0: error register.
+  Emergency = 6,
+  //! Mailbox packet error, index and subIndex of the object, code: error code.
+  PacketError = 7,
+  //! Mailbox error, code: error code.
+  MailboxError = 8,
+  //! SoE error, index of the IDN, code: error code.
+  SoeError = 9,
+  //! A cycle took longer than its period, value0: cycle time in us, value1: period in us.
+  Overrun = 10,
+  //! Recovery of a slave, value0: RecoveryAction, value1: state of the slave.
+  Recovery = 11,
+  //! A slave callback took longer than its budget, code: 0 updateRead(), 1 updateWrite(), value0: wall time in us, value1: budget in us.
+  SlaveBudgetExceeded = 12,
+  //! A slave is missing in the working counter, value0: working counter, value1: expected working counter, code: AL status code,
+  //! index: AL status, 0xffff if the slave did not answer.
+  WorkingCounterFault = 13,
+};
+
+/**
+ * @brief      Action taken while recovering a slave
+ */
+enum class RecoveryAction : int32_t { Lost = 0, Found = 1, Acknowledge = 2, Reconfigure = 3, Recovered = 4 };
+
+/**
+ * @brief      Fixed size record in the event log file, as returned by
+ *             EventLog::read. The file holds it with an atomic sequence
+ */
+struct EventRecord {
+  //! Nanoseconds since epoch.
+  uint64_t stamp;
+  //! Position of the record in the log + 1 (lower 32 bits), written last. Records with a mismatching sequence are being
+  //! written or were never written.
+  uint32_t sequence;
+  uint16_t type;
+  uint16_t slave;
+  uint32_t code;
+  uint16_t index;
+  uint8_t subIndex;
+  uint8_t reserved;
+  int32_t value0;
+  int32_t value1;
+};
+static_assert(sizeof(EventRecord) == 32, "The event record is part of the file format.");
+
+/**
+ * @brief      Header of the event log file, followed by capacity records
+ */
+struct EventLogHeader {
+  static constexpr char magic_[8] = {'S', 'O', 'E', 'M', 'E', 'V', 'T', '1'};
+  static constexpr uint32_t version_ = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint64_t capacity;
+  //! Number of records written since the file was created, constructed in place when the file is created.
+  std::atomic<uint64_t> head;
+  char busName[32];
+};
+static_assert(sizeof(EventLogHeader) == 64, "The event log header is part of the file format.");
+static_assert(std::is_standard_layout_v<EventLogHeader>, "The event log header is part of the file format.");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The head of the event log is shared through the file mapping.");
+
+//! Record slot in the mapped file, see EventLog.cpp.
+struct EventLogSlot;
+
+/**
+ * @brief      Description of an event log file as returned by EventLog::read
+ */
+struct EventLogInfo {
+  std::string busName;
+  uint64_t capacity{0};
+  //! Number of records written since the file was created, only the last capacity ones are kept.
+  uint64_t written{0};
+};
+
+/**
+ * @brief      Compact binary log of bus events in a memory mapped ring file.
+ *             Logging an event is wait-free and does not call into the
+ *             kernel, the page cache writes the file back. An existing file
+ *             with the same capacity is continued, therefore the history
+ *             survives restarts. Decode it with soem_event_log_decoder.
+ */
+class SOEM_RSL_EXPORT EventLog {
+ public:
+  static constexpr uint64_t defaultCapacity = 1 << 20;
+
+  EventLog() = default;
+  ~EventLog();
+  EventLog(const EventLog&) = delete;
+  EventLog& operator=(const EventLog&) = delete;
+
+  /**
+   * @brief      Maps the log file, creates it if it does not exist or does
+   *             not match
+   *
+   * @param[in]  path      The file path
+   * @param[in]  capacity  Number of records kept, 32 bytes each
+   * @param[in]  busName   Name of the bus, stored in the header
+   *
+   * @return     True if successful
+   */
+  bool open(const std::string& path, uint64_t capacity = defaultCapacity, const std::string& busName = "");
+  void close();
+  bool isOpen() const { return header_ != nullptr; }
+
+  /**
+   * @brief      Appends an event, wait-free. Does nothing if the log is not
+   *             open
+   */
+  void log(EventType type, uint16_t slave = 0, uint32_t code = 0, int32_t value0 = 0, int32_t value1 = 0, uint16_t index = 0,
+           uint8_t subIndex = 0);
+
+  /**
+   * @brief      Reads all valid records of an event log file, the oldest
+   *             first
+   *
+   * @param[in]  path     The file path
+   * @param[out] info     Description of the file
+   * @param[out] records  The records
+   *
+   * @return     True if the file is a valid event log
+   */
+  static bool read(const std::string& path, EventLogInfo& info, std::vector<EventRecord>& records);
+
+  static std::string getTypeString(EventType type);
+  static std::string getRecoveryActionString(RecoveryAction action);
+
+ protected:
+  EventLogHeader* header_{nullptr};
+  EventLogSlot* slots_{nullptr};
+  uint64_t capacity_{0};
+  size_t mappedSize_{0};
+};
+
+}  // namespace soem_interface_rsl::common
@@ -29,10 +29,15 @@
 #include <cstdint>
 #include <cstring>
 #include <exception>
+#include <ostream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <vector>
+
+// soem_interface_rsl
+#include "soem_rsl_export.h"
 
 namespace soem_interface_rsl {
 
@@ -89,6 +94,22 @@ struct RegisterDefinition {
     throw std::runtime_error("Could not find Register by regAddrsEnum");
   };
 
+  // size of the register block from the first to the end of the last register, including reserved gaps.
+  [[nodiscard]] constexpr uint16_t blockSize() const {
+    const auto& last = Registers[Registers.size() - 1];
+    return static_cast<uint16_t>(last.addr + last.regTypeEnum - Registers[0].addr);
+  }
+
+  // offset of a register in a raw block read from the first register on, see registerBlockOffset for the compile time version.
+  [[nodiscard]] constexpr uint16_t blockOffsetByAddr(RegAddrEnum regAddrEnum) const {
+    for (const auto& reg : Registers) {
+      if (reg.addr == static_cast<uint16_t>(regAddrEnum)) {
+        return static_cast<uint16_t>(reg.addr - Registers[0].addr);
+      }
+    }
+    throw std::runtime_error("Could not find Register by regAddrsEnum");
+  }
+
   // calcualtes the size required to read up to/including the given register.
   [[nodiscard]] constexpr uint16_t sizeUpToAddr(RegAddrEnum regAddrEnum) const {
     uint16_t size{0};
@@ -132,6 +153,10 @@ struct RegisterDefinition {
   }
 };
 
+// offset of a register in a raw block of a register definition, resolved at compile time (an unknown register does not compile).
+template <const auto& definition, auto regAddrEnum>
+inline constexpr uint16_t registerBlockOffset = definition.blockOffsetByAddr(regAddrEnum);
+
 struct SOEM_RSL_EXPORT REG  {
   enum class ERROR_COUNTERS : uint16_t {
     FRAME_ERROR_PORT0_ADDR = 0x0300,
@@ -152,7 +177,7 @@ struct SOEM_RSL_EXPORT REG  {
     LOST_LINK_CNT_PORT1 = 0x0311,
     LOST_LINK_CNT_PORT2 = 0x0312,
     LOST_LINK_CNT_PORT3 = 0x0313,
-    SIZE = 18  // 18 bytes - we can easily read this in one datagram per slave.
+    SIZE = 18  // 18 registers in 20 bytes (0x030E-0x030F reserved) - we can easily read this in one datagram per slave.
   };
 
   static constexpr RegisterDefinition<RegEntry<ERROR_COUNTERS>> ERROR_COUNTERS_LIST{
@@ -214,11 +239,26 @@ struct SOEM_RSL_EXPORT REG  {
   //  PACKED_END
 };
 
+// a slave missing in the working counter, see EthercatBusBase::setWorkingCounterAttribution(..).
+struct WorkingCounterFault {
+  uint16_t slave{0};  // bus address.
+  // working counter of the logical sub-ranges of the slave and the expected one.
+  int workingCounter{0};
+  int expectedWorkingCounter{0};
+  // whether the slave answered the read of its AL status.
+  bool answered{false};
+  uint16_t alStatus{0};
+  uint16_t alStatusCode{0};
+};
+
 struct BusDiagnosisLog {
   bool fullyUpdated{false};
   std::vector<std::array<REG::Counter, static_cast<uint16_t>(REG::ERROR_COUNTERS::SIZE)>> errorCounters_{};
   // the OR of all slaves ALStatusCode.
   uint16_t ecatApplicationLayerStatus{};
+  // slaves found responsible for the last working counter drop and the number of attributions so far.
+  std::vector<WorkingCounterFault> workingCounterFaults{};
+  uint64_t workingCounterAttributions{0};
 };
 
 }  // namespace soem_interface_rsl
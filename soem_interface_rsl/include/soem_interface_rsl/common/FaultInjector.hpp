@@ -0,0 +1,193 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+
+// soem_interface_rsl
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      Impairment stage between the NIC driver and the wire of one
+ *             interface. It registers itself as transport under the
+ *             interface name (see ecx_registertransport(..)) and forwards
+ *             the frames to the transport registered before, e.g. a
+ *             VirtualSegment, or to a raw socket on the interface. On the way
+ *             it drops, delays, reorders and duplicates frames, corrupts
+ *             working counters and flaps the link, driven by a seeded random
+ *             generator so that runs are reproducible. Meant to measure the
+ *             detection and recovery of bus faults without unplugging cables.
+ */
+class SOEM_RSL_EXPORT FaultInjector {
+ public:
+  struct Options {
+    //! Probability that a frame is lost before it reaches the slaves.
+    double dropProbability{0.0};
+    //! Probability that the answer to a frame is lost after the slaves processed it.
+    double replyDropProbability{0.0};
+    //! Fixed delay of the answers in ns.
+    int64_t delay{0};
+    //! Maximum of the uniformly distributed additional delay of the answers in ns.
+    int64_t delayJitter{0};
+    //! Probability that an answer is held back until the next answer arrived.
+    double reorderProbability{0.0};
+    //! Probability that an answer is delivered twice.
+    double duplicateProbability{0.0};
+    //! Probability that the working counter of one datagram of an answer is decremented.
+    double workingCounterProbability{0.0};
+    //! Mean number of link flaps per second, 0 disables random flaps.
+    double linkFlapRate{0.0};
+    //! Duration of a link flap in ns, all frames are lost meanwhile.
+    int64_t linkFlapDuration{100000000};
+    //! Seed of the random generator.
+    uint64_t seed{0};
+  };
+
+  //! Number of injected faults, lastFaultTime is the steady clock time in ns of the latest one.
+  struct Statistics {
+    uint64_t frames{0};
+    uint64_t dropped{0};
+    uint64_t repliesDropped{0};
+    uint64_t delayed{0};
+    uint64_t reordered{0};
+    uint64_t duplicated{0};
+    uint64_t workingCountersCorrupted{0};
+    uint64_t linkFlaps{0};
+    int64_t lastFaultTime{0};
+  };
+
+  //! Longest frame passed through the stage.
+  static constexpr size_t maxFrameLength = 1518;
+
+  explicit FaultInjector(const std::string& interface);
+  FaultInjector(const std::string& interface, const Options& options);
+  ~FaultInjector();
+  FaultInjector(const FaultInjector&) = delete;
+  FaultInjector& operator=(const FaultInjector&) = delete;
+
+  const std::string& getInterface() const { return interface_; }
+
+  /**
+   * @brief      Inserts the stage. Buses opened afterwards on the interface
+   *             use it, they have to be shut down before it is detached. A
+   *             transport registered under the name before, e.g. by
+   *             VirtualSegment::attach(), has to stay registered meanwhile
+   *
+   * @return     True if successful, opening the raw socket needs CAP_NET_RAW
+   */
+  bool attach();
+
+  /**
+   * @brief      Removes the stage and restores the previous transport
+   */
+  void detach();
+  bool isAttached() const { return attached_; }
+
+  /**
+   * @brief      Changes the impairments, e.g. to start injecting at a known
+   *             time. The random generator is not reseeded
+   *
+   * @param[in]  options  The options
+   */
+  void setOptions(const Options& options);
+  Options getOptions() const;
+
+  /**
+   * @brief      Takes the link down for a duration, starting now. Answers
+   *             queued before are still delivered
+   *
+   * @param[in]  duration  The duration in ns
+   */
+  void flapLink(const int64_t duration);
+  bool isLinkUp() const { return linkUp_.load(std::memory_order_relaxed); }
+
+  Statistics getStatistics() const;
+  void resetStatistics();
+
+  //! Transport functions, userdata is the stage.
+  static int send(void* userdata, int stack, const void* frame, int length);
+  static int receive(void* userdata, int stack, void* frame, int length);
+
+ protected:
+  //! The transport the frames are forwarded to.
+  struct Downstream {
+    int (*send)(void* userdata, int stack, const void* frame, int length){nullptr};
+    int (*receive)(void* userdata, int stack, void* frame, int length){nullptr};
+    void* userdata{nullptr};
+  };
+
+  struct Frame {
+    bool used{false};
+    //! Held back until the next answer arrived.
+    bool held{false};
+    int64_t due{0};
+    uint64_t sequence{0};
+    uint16_t length{0};
+    std::array<uint8_t, maxFrameLength> data{};
+  };
+
+  static int64_t now();
+  static int sendSocket(void* userdata, int stack, const void* frame, int length);
+  static int receiveSocket(void* userdata, int stack, void* frame, int length);
+  bool openSocket();
+
+  bool random(const double probability);
+  void updateLinkLocked(const int64_t time);
+  void setLinkLocked(const bool up);
+  void scheduleLinkFlapLocked(const int64_t time);
+  void queueReplyLocked(const uint8_t* frame, const uint16_t length, const int64_t time);
+  void corruptWorkingCounterLocked(uint8_t* frame, const uint16_t length);
+  Frame* pushLocked();
+
+  //! Answers waiting for their delivery, like the receive ring of a NIC.
+  static constexpr size_t queueCapacity = 64;
+
+  std::string interface_;
+  Options options_;
+  std::mt19937_64 random_;
+  //! Guards everything below, frames are passed one at a time.
+  mutable std::mutex mutex_;
+  Downstream downstream_;
+  bool attached_{false};
+  int socket_{-1};
+  std::array<Frame, queueCapacity> queue_;
+  uint64_t sequence_{0};
+  Statistics statistics_;
+  std::atomic<bool> linkUp_{true};
+  //! Link state set in the LinkMonitor before the first flap.
+  bool linkWasVirtual_{false};
+  int64_t linkDownUntil_{0};
+  int64_t nextLinkFlap_{0};
+};
+
+}  // namespace soem_interface_rsl::common
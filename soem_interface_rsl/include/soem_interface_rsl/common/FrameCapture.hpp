@@ -0,0 +1,168 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+// soem_interface_rsl
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      Captures the frames sent and received on a port into a
+ *             preallocated ring through the capture hook of the NIC driver
+ *             (see ecx_setcapturehook(..)). A background thread writes them
+ *             as pcapng, which Wireshark decodes with its EtherCAT dissector.
+ *             Either all frames are written continuously, or the ring keeps
+ *             the last frames and a trigger (e.g. a working counter drop)
+ *             dumps the frames around it into a file of its own.
+ */
+class SOEM_RSL_EXPORT FrameCapture {
+ public:
+  enum class Trigger { Manual, WorkingCounterDrop, StateLoss };
+
+  struct Options {
+    //! Number of frames kept in the ring, about 1.5 kB each. Needs to hold the frames of preTrigger + postTrigger.
+    size_t capacity{16384};
+    //! Write all frames, otherwise only the frames around a trigger.
+    bool continuous{false};
+    //! Time kept before and after a trigger in s.
+    double preTrigger{2.0};
+    double postTrigger{0.5};
+    bool triggerOnWorkingCounterDrop{true};
+    bool triggerOnStateLoss{true};
+    //! Interface name written to the file.
+    std::string interface;
+  };
+
+  //! Largest frame captured, longer frames are truncated.
+  static constexpr size_t maxFrameLength = 1518;
+
+  FrameCapture() = default;
+  ~FrameCapture();
+  FrameCapture(const FrameCapture&) = delete;
+  FrameCapture& operator=(const FrameCapture&) = delete;
+
+  /**
+   * @brief      Allocates the ring and starts the writer thread
+   *
+   * @param[in]  path     The pcapng file. Dumps of triggers are written to
+   *                      the path with the number of the trigger appended,
+   *                      e.g. capture_3.pcapng
+   * @param[in]  options  The options
+   *
+   * @return     True if successful
+   */
+  bool start(const std::string& path, const Options& options);
+
+  /**
+   * @brief      Stops the writer thread, frames not written yet are written
+   *             first. The capture hook has to be removed before
+   */
+  void stop();
+  bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief      Capture hook for ecx_setcapturehook(..), userdata is the
+   *             FrameCapture
+   */
+  static void hook(void* userdata, int direction, int stack, const void* frame, int length);
+
+  /**
+   * @brief      Copies a frame into the ring, wait-free
+   *
+   * @param[in]  received  True for a received frame, false for a sent one
+   * @param[in]  stack     0 for the primary, 1 for the redundant port
+   * @param[in]  frame     The ethernet frame
+   * @param[in]  length    The length of the frame
+   */
+  void record(const bool received, const int stack, const void* frame, const int length);
+
+  /**
+   * @brief      Dumps the frames around now once the post trigger time
+   *             passed, realtime safe. Ignored in continuous mode, while a
+   *             dump is pending or if the trigger is disabled in the options
+   *
+   * @return     True if a dump is started
+   */
+  bool trigger(const Trigger reason = Trigger::Manual);
+
+  uint64_t getNumberOfFrames() const { return head_.load(std::memory_order_relaxed); }
+  //! Frames overwritten before the writer thread got them, continuous mode only.
+  uint64_t getNumberOfDroppedFrames() const { return dropped_.load(std::memory_order_relaxed); }
+  uint64_t getNumberOfDumps() const { return dumps_.load(std::memory_order_relaxed); }
+
+ protected:
+  struct Slot {
+    //! 2 * frame number + 1 while being written, 2 * frame number + 2 once written.
+    std::atomic<uint64_t> sequence{0};
+    //! Realtime clock in ns.
+    int64_t stamp{0};
+    uint16_t length{0};
+    bool received{false};
+    uint8_t stack{0};
+    std::array<uint8_t, maxFrameLength> data{};
+  };
+
+  enum class ReadResult { Ok, Pending, Overwritten };
+
+  static int64_t now();
+  ReadResult read(const uint64_t number, Slot& frame) const;
+  void run();
+  void writeContinuously(const bool drain);
+  void dump(const int64_t triggerTime);
+  bool openFile(const std::string& path);
+  void closeFile();
+  void writeFrame(const Slot& frame);
+
+  //! Poll period of the writer thread.
+  static constexpr int pollPeriodMs_ = 10;
+
+  Options options_;
+  std::string path_;
+  std::unique_ptr<Slot[]> slots_;
+  size_t capacity_{0};
+  //! Number of frames recorded, the next one goes to slot head_ % capacity_.
+  std::atomic<uint64_t> head_{0};
+  //! Next frame to write in continuous mode.
+  uint64_t tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+  //! Time of the pending trigger, 0 if none.
+  std::atomic<int64_t> triggerTime_{0};
+  std::atomic<uint64_t> dumps_{0};
+  std::atomic<bool> running_{false};
+  std::atomic<bool> stopRequested_{false};
+  std::thread thread_;
+  //! Current output file, owned by the writer thread.
+  FILE* file_{nullptr};
+};
+
+}  // namespace soem_interface_rsl::common
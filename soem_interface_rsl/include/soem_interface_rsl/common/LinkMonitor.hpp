@@ -0,0 +1,156 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// std
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      Process wide monitor of the link state of network interfaces.
+ *             A background thread subscribes to RTNETLINK link
+ *             notifications and keeps atomic flags per watched interface, so
+ *             that checking the link is a single atomic load. If no netlink
+ *             socket can be opened, the watched interfaces are polled instead.
+ */
+class LinkMonitor {
+ public:
+  struct LinkState {
+    //! The interface exists and is up (IFF_UP), it can be opened.
+    std::atomic<bool> up{false};
+    //! The interface is up and has a carrier (IFF_RUNNING), i.e. a cable is plugged in.
+    std::atomic<bool> carrier{false};
+  };
+
+  /**
+   * @brief      Returns the monitor, the background thread is started on the
+   *             first call
+   */
+  static LinkMonitor& instance();
+
+  /**
+   * @brief      Starts watching an interface, watching it again returns the
+   *             same state
+   *
+   * @param[in]  interface  The interface name, e.g. eth0
+   *
+   * @return     State following the interface. It stays valid until every
+   *             watch(..) is matched by an unwatch(..)
+   */
+  const LinkState& watch(const std::string& interface);
+
+  /**
+   * @brief      Stops watching an interface, it is forgotten once it is not
+   *             watched anymore and not virtual
+   *
+   * @param[in]  interface  The interface name
+   */
+  void unwatch(const std::string& interface);
+
+  /**
+   * @brief      Checks whether an interface is up (IFF_UP), without watching
+   *             it. Watched and virtual interfaces return their flag, others
+   *             are queried once
+   *
+   * @param[in]  interface  The interface name
+   */
+  bool isUp(const std::string& interface);
+
+  /**
+   * @brief      Checks whether an interface has a carrier, like isUp(..)
+   *
+   * @param[in]  interface  The interface name
+   */
+  bool hasCarrier(const std::string& interface);
+
+  /**
+   * @brief      Sets the carrier of an interface which does not exist in the
+   *             kernel, e.g. a simulated segment. It counts as up, its state
+   *             is not touched by notifications or polling until the
+   *             interface is released
+   *
+   * @param[in]  interface  The interface name
+   * @param[in]  up         The carrier
+   */
+  void setVirtualLinkUp(const std::string& interface, const bool up);
+
+  /**
+   * @brief      Hands a virtual interface back to the kernel, its state is
+   *             queried again
+   *
+   * @param[in]  interface  The interface name
+   */
+  void releaseVirtualLink(const std::string& interface);
+
+  /**
+   * @brief      Checks whether the state of an interface is set by
+   *             setVirtualLinkUp(..)
+   *
+   * @param[in]  interface  The interface name
+   */
+  bool isVirtualLink(const std::string& interface);
+
+  ~LinkMonitor();
+  LinkMonitor(const LinkMonitor&) = delete;
+  LinkMonitor& operator=(const LinkMonitor&) = delete;
+
+ protected:
+  LinkMonitor();
+
+  void run();
+  void processNetlinkMessages();
+  void pollLinks();
+  void setLinkState(LinkState& state, const std::string& interface, const bool up, const bool carrier) const;
+  //! Returns the link, nullptr if it is neither watched nor virtual.
+  const LinkState* findLinkLocked(const std::string& interface) const;
+  //! Forgets a link which is neither watched nor virtual anymore.
+  void eraseUnusedLinkLocked(const std::string& interface);
+
+  struct Link {
+    std::unique_ptr<LinkState> state{std::make_unique<LinkState>()};
+    //! Number of watch(..) calls not matched by unwatch(..) yet.
+    size_t watchers{0};
+  };
+
+  //! Poll period of the background thread, also bounds the time to shut it down.
+  static constexpr int pollPeriodMs_ = 100;
+
+  //! Netlink socket subscribed to link notifications, -1 if not available.
+  int socket_{-1};
+  std::atomic<bool> running_{true};
+  //! Guards links_, never taken on the hot path.
+  mutable std::mutex mutex_;
+  std::map<std::string, Link> links_;
+  //! Interfaces whose state is set by setVirtualLinkUp(..).
+  std::set<std::string> virtualLinks_;
+  std::thread thread_;
+};
+
+}  // namespace soem_interface_rsl::common
@@ -23,10 +23,15 @@
 #pragma once
 
 // std
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <deque>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 // message logger
 #include "soem_rsl_export.h"
@@ -34,21 +39,95 @@
 
 namespace soem_interface_rsl::common {
 
-class MessageLog {
+/*!
+ * Log of the most recent bus errors for post-mortem analysis. Messages are stored in a preallocated ring of fixed size
+ * records, inserting is wait-free and does not allocate, the oldest entries are overwritten when the ring is full.
+ */
+class SOEM_RSL_EXPORT MessageLog {
  public:
+  struct Entry {
+    static constexpr size_t maxTextLength = 119;
+
+    message_logger::log::levels::Level level{message_logger::log::levels::Level::Info};
+    //! Nanoseconds since epoch.
+    uint64_t stamp{0};
+    //! Address of the slave the message refers to, 0 if it refers to the bus.
+    uint16_t slave{0};
+    //! Error code, e.g. the SDO abort code.
+    uint32_t code{0};
+    //! Null terminated, longer texts are cut.
+    char text[maxTextLength + 1]{};
+  };
+  using Entries = std::vector<Entry>;
+  //! Level and text of the entries, the format of the log before the entries were introduced.
   using Log = std::deque<std::pair<message_logger::log::levels::Level, std::string>>;
 
+  static constexpr size_t defaultCapacity = 256;
+
  protected:
-  static constexpr size_t maxLogSize_ = 20;
+  struct Slot {
+    //! 2 * position + 1 while the entry of the position is written, 2 * position + 2 once it is complete.
+    std::atomic<uint64_t> sequence{0};
+    Entry entry;
+  };
+
+  //! The ring, its slots and capacity are published together so that a producer never pairs one with the other of a replaced ring.
+  struct Storage {
+    explicit Storage(size_t capacity) : capacity(capacity), slots(new Slot[capacity]) {}
+    const size_t capacity;
+    const std::unique_ptr<Slot[]> slots;
+  };
 
-  static std::mutex logMutex_;
-  static Log log_;
+  //! Number of times a reader waits for a writer which claimed a position but did not publish it yet.
+  static constexpr unsigned int maxReadRetries_ = 64;
+
+  static bool readSlot(const Storage& storage, uint64_t position, Entry& entry);
+  static Entries read(uint64_t begin, uint64_t end);
+  static Log toLog(const Entries& entries);
+
+  static std::mutex allocateMutex_;
+  //! All rings allocated, the first one at static initialization. A replaced ring is kept, a producer may still hold it.
+  static std::vector<std::unique_ptr<Storage>> storages_;
+  //! Replaced by setCapacity(..) only before the first insertion.
+  static std::atomic<Storage*> storage_;
+  //! Position of the next entry to write.
+  static std::atomic<uint64_t> head_;
+  static std::atomic<uint64_t> dropped_;
+  //! Position of the first entry not yet returned by getAndClearLog(), only accessed with readMutex_ locked.
+  static uint64_t tail_;
+  static std::mutex readMutex_;
 
  public:
+  /*!
+   * Sets the number of stored entries, has to be called before the first message is inserted.
+   * A message inserted concurrently may go to the replaced ring and be lost, but it never accesses freed memory.
+   * @return False if a message has already been inserted.
+   */
+  static bool setCapacity(size_t capacity);
+  static size_t getCapacity();
+
+  /*!
+   * Inserts a message, wait-free.
+   * A producer claims the slot of its position with a compare and swap of the slot sequence. If the slot holds a newer
+   * entry or another producer is still writing it, which happens if the producer was preempted for more than capacity
+   * insertions, the message is dropped and counted instead.
+   */
+  static void insertMessage(message_logger::log::levels::Level level, uint16_t slave, uint32_t code, const char* text);
   static void insertMessage(message_logger::log::levels::Level level, const std::string& message);
-  static Log getLog();
+
+  //! Entries which are still stored, the oldest first. Entries whose producer has not finished writing are skipped.
+  static Entries getEntries();
+  //! Entries inserted since the last call, the oldest first. Every entry is returned at most once.
+  static Entries getAndClearEntries();
   static void clearLog();
+
+  //! Level and text of getEntries().
+  static Log getLog();
+  //! Level and text of getAndClearEntries().
   static Log getAndClearLog();
+
+  //! Number of messages dropped because their slot was taken by another producer.
+  static uint64_t getNumberOfDroppedMessages() { return dropped_.load(std::memory_order_relaxed); }
 };
 
 }  // namespace soem_interface_rsl
@@ -0,0 +1,293 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// soem_interface_rsl
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      Content of a column of a process image recording
+ */
+enum class ProcessImageColumnKind : uint8_t {
+  //! One of the fields of ProcessImageRowHeader.
+  Cycle = 0,
+  //! Output (RxPDO) image of a slave.
+  Outputs = 1,
+  //! Input (TxPDO) image of a slave.
+  Inputs = 2,
+};
+
+/**
+ * @brief      Fields recorded each cycle in front of the process image
+ */
+struct ProcessImageRowHeader {
+  //! Number of the cycle since the recording started, cycles dropped because the ring was full leave a gap.
+  uint64_t cycle;
+  //! Monotonic clock in ns when the process data was sent.
+  int64_t stamp;
+  //! Distributed clock time of the frame in ns, 0 without distributed clocks.
+  int64_t distributedClockTime;
+  int32_t workingCounter;
+  int32_t expectedWorkingCounter;
+};
+static_assert(sizeof(ProcessImageRowHeader) == 32, "The row header is part of the file format.");
+
+/**
+ * @brief      Description of a column in the process image file
+ */
+struct ProcessImageColumnDescriptor {
+  char name[40];
+  //! Slave address, 0 for the cycle fields.
+  uint16_t slave;
+  uint8_t kind;
+  uint8_t reserved;
+  //! Bytes per row.
+  uint32_t width;
+  //! Offset of the column in the row, the process image starts behind the row header.
+  uint32_t rowOffset;
+  uint32_t reserved1;
+  //! Offset of the column in each chunk.
+  uint64_t chunkOffset;
+};
+static_assert(sizeof(ProcessImageColumnDescriptor) == 64, "The column descriptor is part of the file format.");
+
+/**
+ * @brief      Header of the process image file. It is followed by the
+ *             column descriptors and, at headerSize, by the chunks. A chunk
+ *             holds rowsPerChunk rows column by column, row r of a column is
+ *             at headerSize + (r / rowsPerChunk) * chunkSize + chunkOffset +
+ *             (r % rowsPerChunk) * width.
+ */
+struct ProcessImageFileHeader {
+  static constexpr char magic_[8] = {'S', 'O', 'E', 'M', 'P', 'I', 'M', '1'};
+  static constexpr uint32_t version_ = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t numberOfColumns;
+  uint64_t headerSize;
+  uint64_t chunkSize;
+  uint32_t rowsPerChunk;
+  //! Bytes of the process image per row, without the row header.
+  uint32_t imageSize;
+  //! Number of complete rows, written last. Constructed in place when the file is created.
+  std::atomic<uint64_t> rows;
+  //! Realtime clock in ns when the recording started, to relate the monotonic stamps to wall time.
+  int64_t startTime;
+  int64_t startStamp;
+  char busName[32];
+};
+static_assert(sizeof(ProcessImageFileHeader) == 96, "The process image file header is part of the file format.");
+static_assert(std::is_standard_layout_v<ProcessImageFileHeader>, "The process image file header is part of the file format.");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The rows of the process image file are shared through the file mapping.");
+
+/**
+ * @brief      Records the process image of a bus each cycle. The cyclic
+ *             thread copies the image with a single memcpy into a
+ *             preallocated ring, wait-free. A background thread transposes
+ *             the rows into an append-only, memory mapped file with one
+ *             column per slave and direction, such that the signals of one
+ *             slave can be scanned without touching the others. Open the
+ *             file with ProcessImageRecording.
+ */
+class SOEM_RSL_EXPORT ProcessImageRecorder {
+ public:
+  /**
+   * @brief      A range of the process image recorded as one column
+   */
+  struct Column {
+    std::string name;
+    uint16_t slave{0};
+    ProcessImageColumnKind kind{ProcessImageColumnKind::Inputs};
+    //! Offset in the process image.
+    uint32_t offset{0};
+    uint32_t width{0};
+  };
+
+  struct Options {
+    //! Rows buffered between the cyclic and the writer thread.
+    size_t ringCapacity{8192};
+    //! Rows per chunk of the file, the file grows by one chunk at a time.
+    uint32_t rowsPerChunk{4096};
+  };
+
+  ProcessImageRecorder() = default;
+  ~ProcessImageRecorder();
+  ProcessImageRecorder(const ProcessImageRecorder&) = delete;
+  ProcessImageRecorder& operator=(const ProcessImageRecorder&) = delete;
+
+  /**
+   * @brief      Creates the file and starts the writer thread
+   *
+   * @param[in]  path       The file path, an existing file is replaced
+   * @param[in]  busName    Name of the bus, stored in the header
+   * @param[in]  columns    The columns of the process image
+   * @param[in]  imageSize  The size of the process image passed to record(..)
+   * @param[in]  options    The options
+   *
+   * @return     True if successful
+   */
+  bool start(const std::string& path, const std::string& busName, const std::vector<Column>& columns, size_t imageSize,
+             const Options& options);
+
+  /**
+   * @brief      Writes the buffered rows and closes the file. record(..)
+   *             must not be called anymore
+   */
+  void stop();
+  bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief      Appends a row, wait-free. The row is dropped if the writer
+   *             thread fell behind by ringCapacity rows
+   *
+   * @param[in]  stamp                   Monotonic clock in ns
+   * @param[in]  distributedClockTime    Distributed clock time in ns
+   * @param[in]  workingCounter          The working counter
+   * @param[in]  expectedWorkingCounter  The expected working counter
+   * @param[in]  image                   The process image, imageSize bytes
+   *
+   * @return     True if the row was recorded
+   */
+  bool record(int64_t stamp, int64_t distributedClockTime, int32_t workingCounter, int32_t expectedWorkingCounter, const void* image);
+
+  uint64_t getNumberOfRows() const { return written_.load(std::memory_order_relaxed); }
+  uint64_t getNumberOfDroppedRows() const { return dropped_.load(std::memory_order_relaxed); }
+  //! Rows recorded but not yet taken over by the writer thread.
+  uint64_t getNumberOfPendingRows() const { return head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed); }
+  size_t getRingCapacity() const { return ringCapacity_; }
+
+ protected:
+  void run();
+  void flush();
+  bool mapChunk(uint64_t chunk);
+  void close();
+
+  //! Poll period of the writer thread.
+  static constexpr int pollPeriodMs_ = 10;
+
+  std::string path_;
+  std::vector<ProcessImageColumnDescriptor> columns_;
+  size_t imageSize_{0};
+  size_t rowSize_{0};
+  size_t ringCapacity_{0};
+  std::unique_ptr<uint8_t[]> ring_;
+  //! Rows recorded, the next one goes to row head_ % ringCapacity_ of the ring. Only written by the cyclic thread.
+  std::atomic<uint64_t> head_{0};
+  //! Rows taken over by the writer thread.
+  std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> cycle_{0};
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<bool> running_{false};
+  std::atomic<bool> stopRequested_{false};
+  std::thread thread_;
+
+  // owned by the writer thread.
+  int fd_{-1};
+  ProcessImageFileHeader* header_{nullptr};
+  size_t headerSize_{0};
+  size_t chunkSize_{0};
+  uint32_t rowsPerChunk_{0};
+  uint8_t* chunk_{nullptr};
+  uint64_t mappedChunk_{0};
+};
+
+/**
+ * @brief      Read only view of a process image file, also of one still
+ *             being recorded. Only the rows complete when it was opened are
+ *             visible
+ */
+class SOEM_RSL_EXPORT ProcessImageRecording {
+ public:
+  ProcessImageRecording() = default;
+  ~ProcessImageRecording();
+  ProcessImageRecording(const ProcessImageRecording&) = delete;
+  ProcessImageRecording& operator=(const ProcessImageRecording&) = delete;
+
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const { return header_ != nullptr; }
+
+  uint64_t getNumberOfRows() const { return rows_; }
+  size_t getImageSize() const { return header_ != nullptr ? header_->imageSize : 0; }
+  std::string getBusName() const;
+  const std::vector<ProcessImageColumnDescriptor>& getColumns() const { return columns_; }
+
+  /**
+   * @brief      Finds the column of a slave
+   *
+   * @return     The index of the column, -1 if the slave has none of the kind
+   */
+  int findColumn(uint16_t slave, ProcessImageColumnKind kind) const;
+
+  /**
+   * @brief      The bytes of a column in a row, the width of the column
+   *             long. Rows of a column are contiguous within a chunk
+   */
+  const uint8_t* getCell(size_t column, uint64_t row) const;
+
+  ProcessImageRowHeader getRowHeader(uint64_t row) const;
+
+  /**
+   * @brief      Copies the process image of a row, as passed to
+   *             ProcessImageRecorder::record(..). Ranges not covered by a
+   *             column are zero
+   *
+   * @param[in]  row    The row
+   * @param[out] image  Buffer of getImageSize() bytes
+   */
+  void getImage(uint64_t row, void* image) const;
+
+  /**
+   * @brief      Copies the inputs of a row into a process image, the other
+   *             ranges of the image are left untouched
+   *
+   * @param[in]  row    The row
+   * @param[out] image  Buffer of getImageSize() bytes
+   */
+  void getInputs(uint64_t row, void* image) const;
+
+ protected:
+  void copyColumns(uint64_t row, uint8_t* image, bool onlyInputs) const;
+
+  const ProcessImageFileHeader* header_{nullptr};
+  const uint8_t* mapping_{nullptr};
+  size_t mappedSize_{0};
+  uint64_t rows_{0};
+  std::vector<ProcessImageColumnDescriptor> columns_;
+};
+
+}  // namespace soem_interface_rsl::common
@@ -0,0 +1,127 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// soem_interface_rsl
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      A slave in the segment topology
+ */
+struct SOEM_RSL_EXPORT TopologyNode {
+  //! Bus address of the slave and of its parent, 0 for the master.
+  uint16_t address{0};
+  uint16_t parent{0};
+  //! Port of the parent the slave is connected to and the port the frames enter the slave.
+  uint8_t parentPort{0};
+  uint8_t entryPort{0};
+  //! Bit mask of the ports with a link.
+  uint8_t activePorts{0};
+  //! Bus address of the slave connected to each port, 0 if none or the parent.
+  std::array<uint16_t, 4> children{};
+  bool hasDistributedClock{false};
+  //! Distributed clock parent, the delays are measured between it and this slave.
+  uint16_t distributedClockParent{0};
+  //! Propagation delay from the reference clock in ns, as measured at startup and by the last refresh.
+  int32_t startupPropagationDelay{0};
+  int32_t propagationDelay{0};
+  //! Delay of the hop from the distributed clock parent in ns, at startup, by the last refresh and its average over the refreshes.
+  int32_t startupHopDelay{0};
+  int32_t hopDelay{0};
+  double averageHopDelay{0.0};
+  //! Largest hop delay seen by a refresh in ns.
+  int32_t maxHopDelay{0};
+  //! Receive times of the ports latched by the last refresh, local time in ns.
+  std::array<uint32_t, 4> receiveTimes{};
+};
+
+/**
+ * @brief      Tree of the slaves of a segment with the propagation delay of
+ *             each hop. The delays measured by ecx_configdc(..) at startup
+ *             are refreshed from the port receive times latched by a write to
+ *             0x0900, computed as ecx_configdc(..) does. A hop delay growing
+ *             from its startup value points to a heating cable or a bad
+ *             connector.
+ */
+class SOEM_RSL_EXPORT SegmentTopology {
+ public:
+  /**
+   * @brief      Builds the tree
+   *
+   * @param[in]  nodes  The slaves in the order of their bus addresses,
+   *                    starting at address 1. Address, parent, entryPort,
+   *                    activePorts, hasDistributedClock and
+   *                    startupPropagationDelay need to be set, parentPort
+   *                    to the port of the distributed clock parent (as
+   *                    ec_slavet::parentport). It is replaced by the port of
+   *                    the direct parent
+   */
+  void build(const std::vector<TopologyNode>& nodes);
+
+  /**
+   * @brief      Recomputes the delays from latched receive times, does not
+   *             allocate
+   *
+   * @param[in]  receiveTimes  The receive times of the ports (0x0900 -
+   *                           0x090C), indexed by the bus address
+   */
+  void update(const std::vector<std::array<uint32_t, 4>>& receiveTimes);
+
+  /**
+   * @brief      Returns the slaves, indexed by the bus address. Index 0 is
+   *             the master
+   */
+  const std::vector<TopologyNode>& getNodes() const { return nodes_; }
+
+  //! Number of refreshes since build().
+  uint64_t getNumberOfUpdates() const { return updates_; }
+
+  /**
+   * @brief      Returns the port visited before a port, the frames pass the
+   *             ports in the order 0 - 3 - 1 - 2. Ports without a link are
+   *             skipped
+   */
+  static uint8_t previousPort(const uint8_t activePorts, const uint8_t port);
+
+ protected:
+  int32_t portTime(const uint16_t address, const uint8_t port) const;
+
+  //! Weight of a new hop delay in the average.
+  static constexpr double averageWeight_{0.1};
+
+  std::vector<TopologyNode> nodes_;
+  //! Port of the distributed clock parent the slave is connected to.
+  std::vector<uint8_t> distributedClockParentPort_;
+  //! Whether a slave is connected to a later port of its distributed clock parent than the first child.
+  std::vector<bool> laterChild_;
+  uint64_t updates_{0};
+};
+
+}  // namespace soem_interface_rsl::common
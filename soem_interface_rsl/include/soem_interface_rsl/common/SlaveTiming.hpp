@@ -0,0 +1,106 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/CycleStatistics.hpp"
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      Snapshot of the timing of the callbacks of a slave
+ */
+struct SOEM_RSL_EXPORT SlaveTimingSnapshot {
+  uint32_t address{0};
+  std::string name;
+  //! Wall time and thread CPU time of updateRead() and updateWrite(), in ns.
+  HistogramSnapshot readWallTime;
+  HistogramSnapshot readCpuTime;
+  HistogramSnapshot writeWallTime;
+  HistogramSnapshot writeCpuTime;
+  //! Budget of a callback in ns, 0 if none.
+  int64_t budget{0};
+  //! Number of callbacks which took longer than the budget.
+  uint64_t budgetExceeded{0};
+};
+
+/**
+ * @brief      Wall time and thread CPU time of the updateRead() and
+ *             updateWrite() callbacks of a slave. A wall time well above the
+ *             CPU time points to blocking calls in the callback, e.g.
+ *             syscalls of a device SDK. Recorded by the cyclic thread, see
+ *             LatencyHistogram.
+ */
+class SOEM_RSL_EXPORT SlaveTiming {
+ public:
+  enum class Callback : unsigned int { UpdateRead = 0, UpdateWrite = 1 };
+
+  //! Start of a callback.
+  struct Stamp {
+    int64_t wallTime{0};
+    int64_t cpuTime{0};
+  };
+
+  /**
+   * @brief      Returns the start of a callback, to be called from the cyclic
+   *             thread
+   */
+  static Stamp start();
+
+  /**
+   * @brief      Records a callback which started at start, to be called from
+   *             the cyclic thread
+   *
+   * @param[in]  callback  The callback
+   * @param[in]  start     The start of the callback
+   *
+   * @return     The wall time of the callback in ns if it exceeded the
+   *             budget, 0 otherwise
+   */
+  int64_t stop(const Callback callback, const Stamp& start);
+
+  /**
+   * @brief      Sets the budget of each callback
+   *
+   * @param[in]  budget  The budget in ns, 0 to disable it
+   */
+  void setBudget(const int64_t budget) { budget_.store(budget, std::memory_order_relaxed); }
+  int64_t getBudget() const { return budget_.load(std::memory_order_relaxed); }
+
+  SlaveTimingSnapshot getSnapshot() const;
+
+ protected:
+  std::array<LatencyHistogram, 2> wallTimes_;
+  std::array<LatencyHistogram, 2> cpuTimes_;
+  std::atomic<int64_t> budget_{0};
+  std::atomic<uint64_t> budgetExceeded_{0};
+};
+
+}  // namespace soem_interface_rsl::common
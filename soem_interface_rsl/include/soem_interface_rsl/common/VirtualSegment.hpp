@@ -0,0 +1,178 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/VirtualSlave.hpp"
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      In-process simulation of a line of EtherCAT slaves. Frames are
+ *             passed through the emulated ESCs of all slaves in order, which
+ *             update the datagrams and working counters like the real
+ *             hardware. The segment either registers itself as transport of
+ *             the NIC driver under its name (see ecx_registertransport(..)),
+ *             so that a bus of the same name runs on it unchanged, or serves
+ *             a network interface such as one end of a veth pair.
+ */
+class SOEM_RSL_EXPORT VirtualSegment {
+ public:
+  struct Options {
+    //! Delay of a frame from one slave to the next in ns, used for the DC port times.
+    int64_t hopDelay{500};
+    //! Seed of the random offsets of the local clocks of the slaves.
+    uint64_t seed{0};
+  };
+
+  //! Longest frame passed through the segment.
+  static constexpr size_t maxFrameLength = 1518;
+
+  explicit VirtualSegment(const std::string& name);
+  VirtualSegment(const std::string& name, const Options& options);
+  ~VirtualSegment();
+  VirtualSegment(const VirtualSegment&) = delete;
+  VirtualSegment& operator=(const VirtualSegment&) = delete;
+
+  const std::string& getName() const { return name_; }
+
+  /**
+   * @brief      Appends a slave to the end of the line
+   *
+   * @param[in]  description  The description of the slave
+   *
+   * @return     The slave, its bus address is the number of slaves
+   */
+  VirtualSlave& addSlave(const VirtualSlaveDescription& description);
+  void addSlaves(const VirtualSlaveDescription& description, const size_t count);
+  size_t getNumberOfSlaves() const;
+
+  /**
+   * @brief      Returns a slave. It must not be changed while frames are
+   *             processed, except from its application which runs with the
+   *             segment locked
+   *
+   * @param[in]  address  The bus address, starting at 1
+   */
+  VirtualSlave& getSlave(const size_t address) { return *slaves_.at(address - 1); }
+
+  /**
+   * @brief      Unplugs the cable in front of a slave. It and the slaves
+   *             behind it no longer see the frames, the slave in front of it
+   *             closes its port 1
+   *
+   * @param[in]  address  The bus address, starting at 1
+   */
+  void unplug(const size_t address);
+
+  //! Plugs the cable back in, the slaves behind it keep their state.
+  void plugIn();
+
+  /**
+   * @brief      Registers the segment as transport under its name and marks
+   *             the link as up. Buses opened afterwards with the name of the
+   *             segment use it, they have to be shut down before the segment
+   *             is destroyed
+   *
+   * @return     True if successful
+   */
+  bool attach();
+  void detach();
+  bool isAttached() const { return attached_; }
+
+  /**
+   * @brief      Answers the EtherCAT frames received on a network interface
+   *             from a background thread, e.g. one end of a veth pair whose
+   *             other end is used by the bus. Needs CAP_NET_RAW
+   *
+   * @param[in]  interface  The interface name
+   *
+   * @return     True if successful
+   */
+  bool serve(const std::string& interface);
+  void stopServing();
+
+  /**
+   * @brief      Passes a frame through all slaves, in place
+   *
+   * @param      frame   The ethernet frame
+   * @param[in]  length  The length of the frame
+   *
+   * @return     False if it is no EtherCAT frame
+   */
+  bool processFrame(uint8_t* frame, const size_t length);
+
+  uint64_t getNumberOfFrames() const { return frames_.load(std::memory_order_relaxed); }
+
+  //! Transport functions, userdata is the segment.
+  static int send(void* userdata, int stack, const void* frame, int length);
+  static int receive(void* userdata, int stack, void* frame, int length);
+
+ protected:
+  struct Frame {
+    uint16_t length{0};
+    std::array<uint8_t, maxFrameLength> data{};
+  };
+
+  static int64_t now();
+  bool processFrameLocked(uint8_t* frame, const size_t length);
+  void plugInLocked();
+  static void processDatagram(VirtualSlave& slave, uint8_t* datagram);
+  void serveInterface();
+
+  //! Frames answered but not received yet, like the receive ring of a NIC.
+  static constexpr size_t queueCapacity = 32;
+
+  std::string name_;
+  Options options_;
+  std::mt19937_64 random_;
+  //! Guards the slaves and the queue, frames are processed one at a time.
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<VirtualSlave>> slaves_;
+  //! Bus address of the first unplugged slave, 0 if all slaves are connected.
+  size_t unpluggedAddress_{0};
+  std::array<Frame, queueCapacity> queue_;
+  size_t queueHead_{0};
+  size_t queueSize_{0};
+  std::atomic<uint64_t> frames_{0};
+  bool attached_{false};
+
+  int socket_{-1};
+  std::atomic<bool> serving_{false};
+  std::thread thread_;
+};
+
+}  // namespace soem_interface_rsl::common
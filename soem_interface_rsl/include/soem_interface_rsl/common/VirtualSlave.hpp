@@ -0,0 +1,236 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+// std
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// soem_interface_rsl
+#include "soem_rsl_export.h"
+
+namespace soem_interface_rsl::common {
+
+/**
+ * @brief      Description of a simulated slave, from which its SII EEPROM,
+ *             object dictionary and memory layout are generated
+ */
+struct SOEM_RSL_EXPORT VirtualSlaveDescription {
+  struct PdoEntry {
+    uint16_t index{0};
+    uint8_t subIndex{0};
+    uint8_t bitLength{0};
+  };
+
+  struct Pdo {
+    uint16_t index{0};
+    std::vector<PdoEntry> entries;
+  };
+
+  //! Additional object of the object dictionary, writable over SDO.
+  struct Object {
+    uint16_t index{0};
+    uint8_t subIndex{0};
+    std::vector<uint8_t> value;
+  };
+
+  std::string name{"VirtualSlave"};
+  uint32_t vendorId{0};
+  uint32_t productCode{0};
+  uint32_t revision{0};
+  uint32_t serialNumber{0};
+  //! Outputs, written by the master.
+  std::vector<Pdo> rxPdos;
+  //! Inputs, read by the master.
+  std::vector<Pdo> txPdos;
+  //! Slaves with a mailbox support CoE, the PDO mapping is read over SDO.
+  //! Without a mailbox it is read from the SII.
+  bool hasMailbox{true};
+  uint16_t mailboxSize{256};
+  bool hasDistributedClocks{true};
+  //! Time in ns the slave takes to reach SAFE_OP or OP, like the application controller of a drive. The AL status keeps the
+  //! previous state meanwhile.
+  int64_t stateChangeDelay{0};
+  std::vector<Object> objects;
+
+  /**
+   * @brief      Creates a description with one RxPDO 0x1600 and one TxPDO
+   *             0x1A00, mapping the given number of bytes to 0x7000 and
+   *             0x6000 in entries of 32 bit
+   *
+   * @param[in]  name         The name
+   * @param[in]  vendorId     The vendor id
+   * @param[in]  productCode  The product code
+   * @param[in]  rxPdoSize    The size of the outputs in bytes, e.g.
+   *                          sizeof(ecat2can_tx_rx_message)
+   * @param[in]  txPdoSize    The size of the inputs in bytes
+   *
+   * @return     The description
+   */
+  static VirtualSlaveDescription fromPdoSizes(const std::string& name, const uint32_t vendorId, const uint32_t productCode,
+                                              const size_t rxPdoSize, const size_t txPdoSize);
+
+  size_t getRxPdoSize() const;
+  size_t getTxPdoSize() const;
+};
+
+/**
+ * @brief      Emulates the EtherCAT slave controller (ESC) of a slave: its
+ *             registers, FMMUs and SyncManagers, the AL state machine, the
+ *             SII EEPROM interface, a CoE SDO server in the mailbox and the
+ *             DC system time. Datagrams are applied by VirtualSegment, which
+ *             also serializes all accesses.
+ */
+class SOEM_RSL_EXPORT VirtualSlave {
+ public:
+  //! Size of the ESC memory, registers below 0x1000 and process RAM above.
+  static constexpr size_t memorySize = 0x4000;
+
+  //! Called after the master wrote the outputs in OP, computes the inputs.
+  using Application = std::function<void(VirtualSlave& slave)>;
+
+  explicit VirtualSlave(const VirtualSlaveDescription& description, const int64_t clockOffset = 0);
+
+  const VirtualSlaveDescription& getDescription() const { return description_; }
+  uint16_t getStationAddress() const;
+  //! AL state without the error flag.
+  uint8_t getState() const;
+  uint16_t getAlStatusCode() const;
+
+  //! Process data in the SyncManager buffers of the description.
+  const uint8_t* getOutputs() const { return memory_.data() + outputsAddress_; }
+  uint8_t* getInputs() { return memory_.data() + inputsAddress_; }
+  size_t getOutputSize() const { return outputSize_; }
+  size_t getInputSize() const { return inputSize_; }
+
+  /**
+   * @brief      Replaces the application, by default the outputs are copied
+   *             to the inputs like the loop test of the ECAT2CAN bridge
+   */
+  void setApplication(Application application) { application_ = std::move(application); }
+
+  /**
+   * @brief      Sets the link state of the ports, reflected by the DL status
+   *
+   * @param[in]  port1  True if a slave is connected behind the slave
+   */
+  void setLinks(const bool port1);
+
+  /**
+   * @brief      Sets the times a frame passes the ports, in ns of
+   *             CLOCK_MONOTONIC. They are latched by a write to the
+   *             receive time register and used for the system time
+   *
+   * @param[in]  port0  Time the frame arrives at port 0
+   * @param[in]  port1  Time the frame returns through port 1
+   */
+  void setFrameTimes(const int64_t port0, const int64_t port1);
+
+  /**
+   * @brief      Physical read of the ESC memory
+   *
+   * @param[in]  address  The address
+   * @param      data     The datagram data
+   * @param[in]  length   The length
+   * @param[in]  combine  ORs the memory into the data, for BRD
+   *
+   * @return     True if the address range is valid
+   */
+  bool read(const uint16_t address, uint8_t* data, const uint16_t length, const bool combine = false);
+  bool write(const uint16_t address, const uint8_t* data, const uint16_t length);
+
+  /**
+   * @brief      Logical access through the FMMUs, only active in SAFEOP and
+   *             OP, the outputs only in OP
+   *
+   * @param[in]  address  The logical address
+   * @param      data     The datagram data
+   * @param[in]  length   The length
+   * @param[in]  read     Copies mapped inputs into the data
+   * @param[in]  write    Copies the data into mapped outputs
+   *
+   * @return     The increment of the working counter
+   */
+  uint16_t accessLogical(const uint32_t address, uint8_t* data, const uint16_t length, const bool read, const bool write);
+
+ protected:
+  struct ObjectEntry {
+    std::vector<uint8_t> value;
+    bool writable{false};
+  };
+
+  uint16_t getRegister16(const uint16_t address) const;
+  void setRegister16(const uint16_t address, const uint16_t value);
+  uint64_t getRegister64(const uint16_t address) const;
+  void setRegister64(const uint16_t address, const uint64_t value);
+  static bool isReadOnly(const uint16_t address);
+  static bool overlaps(const uint16_t address, const uint16_t length, const uint16_t begin, const uint16_t size);
+
+  int64_t getLocalTime(const int64_t time) const { return time + clockOffset_; }
+  int64_t getSystemTime(const int64_t time) const;
+
+  void createSii();
+  void createObjectDictionary();
+  void addObject(const uint16_t index, const uint8_t subIndex, const std::vector<uint8_t>& value, const bool writable = false);
+
+  void processAlControl();
+  bool checkSyncManager(const int syncManager, const uint16_t address, const uint16_t length) const;
+  void processEepromCommand();
+  void processSystemTime();
+  void processMailbox();
+  void sendMailbox(const uint8_t* data, const uint16_t length);
+  void abortSdo(const uint8_t* request, const uint32_t code);
+  void runApplication();
+
+  VirtualSlaveDescription description_;
+  std::vector<uint8_t> memory_;
+  //! SII EEPROM in words.
+  std::vector<uint16_t> sii_;
+  //! Object dictionary by index << 8 | sub index.
+  std::map<uint32_t, ObjectEntry> objects_;
+  Application application_;
+
+  uint16_t mailboxOutAddress_{0};
+  uint16_t mailboxInAddress_{0};
+  int outputsSyncManager_{0};
+  uint16_t outputsAddress_{0};
+  size_t outputSize_{0};
+  uint16_t inputsAddress_{0};
+  size_t inputSize_{0};
+
+  //! Offset of the local clock to CLOCK_MONOTONIC in ns.
+  int64_t clockOffset_{0};
+  int64_t port0Time_{0};
+  int64_t port1Time_{0};
+  bool port1_{false};
+
+  //! State reached after stateChangeDelay, 0 if no state change is in progress.
+  uint8_t pendingState_{0};
+  int64_t pendingStateTime_{0};
+};
+
+}  // namespace soem_interface_rsl::common
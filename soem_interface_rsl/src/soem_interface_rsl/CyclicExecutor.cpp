@@ -0,0 +1,372 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// soem_interface_rsl
+#include "soem_interface_rsl/CyclicExecutor.hpp"
+
+// std
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+// linux
+#include <alloca.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// message logger
+#include <message_logger/log/log_messages_rt.hpp>
+#include <message_logger/message_logger.hpp>
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+namespace soem_interface_rsl {
+
+namespace {
+
+// Argument of the sched_setattr system call, not exposed by all C libraries.
+struct SchedulingAttributes {
+  uint32_t size;
+  uint32_t policy;
+  uint64_t flags;
+  int32_t nice;
+  uint32_t priority;
+  uint64_t runtime;
+  uint64_t deadline;
+  uint64_t period;
+};
+
+constexpr int64_t nanosecondsPerSecond = 1000000000;
+
+int64_t toNanoseconds(const double seconds) {
+  return static_cast<int64_t>(seconds * 1e9);
+}
+
+int64_t toNanoseconds(const timespec& time) {
+  return static_cast<int64_t>(time.tv_sec) * nanosecondsPerSecond + time.tv_nsec;
+}
+
+timespec toTimespec(const int64_t nanoseconds) {
+  timespec time{};
+  time.tv_sec = static_cast<time_t>(nanoseconds / nanosecondsPerSecond);
+  time.tv_nsec = static_cast<long>(nanoseconds % nanosecondsPerSecond);
+  return time;
+}
+
+int64_t now() {
+  timespec time{};
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return toNanoseconds(time);
+}
+
+void sleepUntil(const int64_t wakeUp) {
+  const timespec time = toTimespec(wakeUp);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR) {
+  }
+}
+
+// Touches the given part of the stack, never inlined so that the memory lies below the caller's frame.
+__attribute__((noinline)) void prefaultStack(const size_t size) {
+  if (size == 0) {
+    return;
+  }
+  volatile auto* stack = static_cast<unsigned char*>(alloca(size));
+  for (size_t i = 0; i < size; i += 4096) {
+    stack[i] = 0;
+  }
+}
+
+}  // namespace
+
+CyclicExecutor::CyclicExecutor(Callback read, Callback write, const Options& options)
+    : read_(std::move(read)), write_(std::move(write)), options_(options) {}
+
+CyclicExecutor::CyclicExecutor(EthercatBusBase& bus, const Options& options)
+    : CyclicExecutor([&bus]() { bus.updateRead(); }, [&bus]() { bus.updateWrite(); }, options) {
+  eventLog_ = &bus.getEventLog();
+  bus_ = &bus;
+  dcTime_ = [&bus]() { return bus.getDistributedClockTime(); };
+}
+
+CyclicExecutor::CyclicExecutor(EthercatBusManagerBase& manager, const Options& options)
+    : CyclicExecutor([&manager]() { manager.readAllBuses(); }, [&manager]() { manager.writeToAllBuses(); }, options) {
+  if (options.dcSync && !options.dcSyncBus.empty()) {
+    if (manager.hasBus(options.dcSyncBus)) {
+      EthercatBusBase* bus = manager.getBusByName(options.dcSyncBus);
+      bus_ = bus;
+      dcTime_ = [bus]() { return bus->getDistributedClockTime(); };
+    } else {
+      MELO_WARN_STREAM("[CyclicExecutor] The manager has no bus '" << options.dcSyncBus << "' to synchronize to, running free.")
+    }
+  }
+  // overruns go to the event log of the DC bus, or of the first bus.
+  if (bus_ != nullptr) {
+    eventLog_ = &bus_->getEventLog();
+  } else {
+    const std::vector<std::string> busNames = manager.getBusNames();
+    if (!busNames.empty()) {
+      eventLog_ = &manager.getBusByName(busNames.front())->getEventLog();
+    }
+  }
+}
+
+CyclicExecutor::~CyclicExecutor() {
+  stop();
+}
+
+bool CyclicExecutor::start(Callback callback) {
+  if (threadStarted_) {
+    MELO_WARN_STREAM("[CyclicExecutor] Already started.")
+    return false;
+  }
+  if (options_.cycleTime <= 0.0) {
+    MELO_ERROR_STREAM("[CyclicExecutor] The cycle time has to be positive.")
+    return false;
+  }
+  if (options_.dcSync && !dcTime_) {
+    MELO_WARN_STREAM("[CyclicExecutor] No bus providing the distributed clock time, the cycle is not synchronized.")
+  }
+  callback_ = std::move(callback);
+  // the logging threads are started here and not from within the first cycle.
+  message_logger::log::LogAggregator::instance();
+  if (options_.lockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    MELO_WARN_STREAM("[CyclicExecutor] Could not lock the memory: " << std::strerror(errno))
+  }
+
+  pthread_attr_t attributes;
+  pthread_attr_init(&attributes);
+  if (options_.stackSize > 0 && pthread_attr_setstacksize(&attributes, options_.stackSize) != 0) {
+    MELO_WARN_STREAM("[CyclicExecutor] Could not set the stack size to " << options_.stackSize << " bytes.")
+  }
+  running_ = true;
+  const int result = pthread_create(&thread_, &attributes, &CyclicExecutor::threadEntry, this);
+  pthread_attr_destroy(&attributes);
+  if (result != 0) {
+    running_ = false;
+    MELO_ERROR_STREAM("[CyclicExecutor] Could not create the thread: " << std::strerror(result))
+    return false;
+  }
+  threadStarted_ = true;
+  return true;
+}
+
+void CyclicExecutor::stop() {
+  running_ = false;
+  if (threadStarted_) {
+    pthread_join(thread_, nullptr);
+    threadStarted_ = false;
+  }
+}
+
+CyclicExecutor::Statistics CyclicExecutor::getStatistics() const {
+  Statistics statistics;
+  statistics.cycles = cycles_.load(std::memory_order_relaxed);
+  statistics.overruns = overruns_.load(std::memory_order_relaxed);
+  statistics.lastCycleDuration = 1e-9 * static_cast<double>(lastCycleDurationNs_.load(std::memory_order_relaxed));
+  statistics.maxCycleDuration = 1e-9 * static_cast<double>(maxCycleDurationNs_.load(std::memory_order_relaxed));
+  statistics.dcOffset = 1e-9 * static_cast<double>(dcOffsetNs_.load(std::memory_order_relaxed));
+  statistics.dcOffsetJitter = 1e-9 * static_cast<double>(dcOffsetJitterNs_.load(std::memory_order_relaxed));
+  statistics.maxDcOffset = 1e-9 * static_cast<double>(maxDcOffsetNs_.load(std::memory_order_relaxed));
+  statistics.dcLocked = dcLocked_.load(std::memory_order_relaxed);
+  return statistics;
+}
+
+bool CyclicExecutor::getRecommendedSyncShift(double& shift) const {
+  if (bus_ == nullptr || !bus_->hasDistributedClocks() || !dcLocked_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  const double latestArrival =
+      options_.dcSyncShift + 1e-9 * static_cast<double>(maxDcOffsetNs_.load(std::memory_order_relaxed)) + bus_->getMaxPropagationDelay();
+  shift = latestArrival + options_.syncShiftMargin;
+  return shift < options_.cycleTime;
+}
+
+bool CyclicExecutor::tuneSyncShift(const std::vector<uint16_t>& slaves, const double cycleTime1) {
+  double shift = 0.0;
+  if (!getRecommendedSyncShift(shift)) {
+    MELO_WARN_STREAM("[CyclicExecutor] Cannot tune the SYNC0 shift, the cycle is not phase locked to the distributed clocks or the "
+                     "latency exceeds the cycle.")
+    return false;
+  }
+  std::vector<uint16_t> addresses = slaves;
+  if (addresses.empty()) {
+    for (uint16_t address = 1; address <= static_cast<uint16_t>(bus_->getNumberOfSlaves()); address++) {
+      if (bus_->slaveHasDistributedClock(address)) {
+        addresses.push_back(address);
+      }
+    }
+  }
+  MELO_INFO_STREAM("[CyclicExecutor] SYNC0 shift: " << 1e6 * shift << " us (max. phase error: "
+                                                    << 1e-3 * static_cast<double>(maxDcOffsetNs_.load()) << " us, max. propagation delay: "
+                                                    << 1e6 * bus_->getMaxPropagationDelay() << " us).")
+  for (const uint16_t address : addresses) {
+    if (cycleTime1 > 0.0) {
+      bus_->syncDistributedClock01(address, true, options_.cycleTime, cycleTime1, shift);
+    } else {
+      bus_->syncDistributedClock0(address, true, options_.cycleTime, shift);
+    }
+  }
+  return true;
+}
+
+void* CyclicExecutor::threadEntry(void* executor) {
+  auto* self = static_cast<CyclicExecutor*>(executor);
+  self->configureThread();
+  self->run();
+  return nullptr;
+}
+
+void CyclicExecutor::configureThread() {
+  if (options_.cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(options_.cpu, &cpus);
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (result != 0) {
+      MELO_WARN_STREAM("[CyclicExecutor] Could not pin the thread to CPU " << options_.cpu << ": " << std::strerror(result))
+    }
+  }
+
+  switch (options_.policy) {
+    case SchedulingPolicy::Other:
+      break;
+    case SchedulingPolicy::Fifo: {
+      sched_param parameter{};
+      parameter.sched_priority = options_.priority;
+      const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameter);
+      if (result != 0) {
+        MELO_WARN_STREAM("[CyclicExecutor] Could not set SCHED_FIFO with priority " << options_.priority << ": " << std::strerror(result))
+      }
+      break;
+    }
+    case SchedulingPolicy::Deadline: {
+      SchedulingAttributes attributes{};
+      attributes.size = sizeof(attributes);
+      attributes.policy = SCHED_DEADLINE;
+      attributes.runtime = static_cast<uint64_t>(toNanoseconds(options_.deadlineRuntime));
+      attributes.deadline = static_cast<uint64_t>(toNanoseconds(options_.cycleTime));
+      attributes.period = attributes.deadline;
+      if (syscall(SYS_sched_setattr, 0, &attributes, 0) != 0) {
+        MELO_WARN_STREAM("[CyclicExecutor] Could not set SCHED_DEADLINE: " << std::strerror(errno))
+      }
+      break;
+    }
+  }
+
+  prefaultStack(options_.stackPrefaultSize);
+}
+
+void CyclicExecutor::run() {
+  const int64_t period = toNanoseconds(options_.cycleTime);
+  const int64_t spin = toNanoseconds(options_.spinTime);
+  int64_t cycleStart = now();
+  while (running_) {
+    const int64_t start = now();
+    read_();
+    const int64_t correction = dcTime_ && options_.dcSync ? updateDcSync(period) : 0;
+    if (callback_) {
+      callback_();
+    }
+    write_();
+    const int64_t end = now();
+
+    const int64_t duration = end - start;
+    lastCycleDurationNs_.store(duration, std::memory_order_relaxed);
+    if (duration > maxCycleDurationNs_.load(std::memory_order_relaxed)) {
+      maxCycleDurationNs_.store(duration, std::memory_order_relaxed);
+    }
+    cycles_.fetch_add(1, std::memory_order_relaxed);
+
+    cycleStart += period + correction;
+    if (end > cycleStart) {
+      // the next cycle should already have started, skip the missed cycles instead of catching up with a burst.
+      overruns_.fetch_add(1, std::memory_order_relaxed);
+      const int64_t late = end - cycleStart + period;
+      if (eventLog_ != nullptr) {
+        eventLog_->log(common::EventType::Overrun, 0, 0, static_cast<int32_t>(late / 1000), static_cast<int32_t>(period / 1000));
+      }
+      MELO_RT_WARN_AGGREGATED("cycle time [us]", late / 1000, "[CyclicExecutor] Overrun, the cycle took {} us, the period is {} us.",
+                              late / 1000, period / 1000);
+      cycleStart = end;
+      continue;
+    }
+
+    if (spin > 0) {
+      sleepUntil(cycleStart - spin);
+      while (now() < cycleStart) {
+      }
+    } else {
+      sleepUntil(cycleStart);
+    }
+  }
+}
+
+int64_t CyclicExecutor::updateDcSync(const int64_t period) {
+  const int64_t dcTime = dcTime_();
+  if (dcTime == 0 || dcTime == lastDcTime_) {
+    // no frame received in this cycle.
+    return 0;
+  }
+  lastDcTime_ = dcTime;
+
+  // phase error within (-period / 2, period / 2].
+  int64_t offset = (dcTime - toNanoseconds(options_.dcSyncShift)) % period;
+  if (offset < 0) {
+    offset += period;
+  }
+  if (offset > period / 2) {
+    offset -= period;
+  }
+
+  // the integral is limited such that it cannot request more than a tenth of the cycle.
+  const double maxCorrection = 0.1 * static_cast<double>(period);
+  if (options_.dcSyncKi > 0.0) {
+    const double maxIntegral = maxCorrection / options_.dcSyncKi;
+    dcIntegral_ = std::clamp(dcIntegral_ + static_cast<double>(offset), -maxIntegral, maxIntegral);
+  }
+  const double correction = std::clamp(-(options_.dcSyncKp * static_cast<double>(offset) + options_.dcSyncKi * dcIntegral_),
+                                       -maxCorrection, maxCorrection);
+
+  dcSquaredOffset_ += 0.01 * (static_cast<double>(offset) * static_cast<double>(offset) - dcSquaredOffset_);
+  const bool inLock = std::abs(offset) < period / 10;
+  dcInLockCycles_ = inLock ? dcInLockCycles_ + 1 : 0;
+  const bool locked = dcInLockCycles_ >= 100;
+  if (locked && !dcLocked_.load(std::memory_order_relaxed)) {
+    maxDcOffsetNs_.store(0, std::memory_order_relaxed);
+  }
+  if (locked && std::abs(offset) > maxDcOffsetNs_.load(std::memory_order_relaxed)) {
+    maxDcOffsetNs_.store(std::abs(offset), std::memory_order_relaxed);
+  }
+  dcLocked_.store(locked, std::memory_order_relaxed);
+  dcOffsetNs_.store(offset, std::memory_order_relaxed);
+  dcOffsetJitterNs_.store(static_cast<int64_t>(std::sqrt(dcSquaredOffset_)), std::memory_order_relaxed);
+  return static_cast<int64_t>(correction);
+}
+
+}  // namespace soem_interface_rsl
@@ -22,25 +22,23 @@
 
 #include <soem_interface_rsl/EthercatBusBase.hpp>
 #include <soem_interface_rsl/EthercatSlaveBase.hpp>
+#include <soem_interface_rsl/common/LinkMonitor.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+#include <message_logger/log/log_messages_rt.hpp>
 
 #include <soem_rsl/ethercat.h>
 
 namespace soem_interface_rsl {
 
-static bool busIsAvailable(const std::string& name) {
-  ec_adaptert* adapter = ec_find_adapters();
-  while (adapter != nullptr) {
-    if (name == std::string(adapter->name)) {
-      return true;
-    }
-    adapter = adapter->next;
-  }
-  return false;
-}
 
 struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
   EthercatSlaveBaseImpl() = delete;
-  explicit EthercatSlaveBaseImpl(const std::string name) : name_(name), wkc_(0) {
+  explicit EthercatSlaveBaseImpl(const std::string name)
+      : name_(name), link_(common::LinkMonitor::instance().watch(name)), wkc_(0) {
     // Initialize all soem_rsl context data pointers that are not used with null.
     ecatContext_.elist->head = 0;
     ecatContext_.elist->tail = 0;
@@ -56,9 +54,13 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
     ecatContext_.FOEhook = nullptr;
   }
 
+  ~EthercatSlaveBaseImpl() { common::LinkMonitor::instance().unwatch(name_); }
+
   const std::string& getName() const { return name_; }
 
-  bool busIsAvailable() const { return soem_interface_rsl::busIsAvailable(name_); }
+  // only read the flags maintained by the link monitor, so both can be called every cycle.
+  bool busIsAvailable() const { return link_.up.load(std::memory_order_relaxed); }
+  bool hasCarrier() const { return link_.carrier.load(std::memory_order_relaxed); }
 
   int getNumberOfSlaves() const {
     if (!initlialized_) {
@@ -87,99 +89,13 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
   }
 
   bool startup(std::atomic<bool>& abortFlag, const bool sizeCheck, int maxDiscoverRetries) {
-    /*
-     * Followed by start of the application we need to set up the NIC to be used as
-     * EtherCAT Ethernet interface. In a simple setup we call ec_init(ifname) and if
-     * soem_rsl comes with support for cable redundancy we call ec_init_redundant that
-     * will open a second port as backup. You can send NULL as ifname if you have a
-     * dedicated NIC selected in the nicdrv.c. It returns >0 if succeeded.
-     */
-
-    if (!busIsAvailable()) {
-      MELO_ERROR_STREAM("[" << name_ << "] "
-                            << "Bus is not available.");
-      EthercatBusBase::printAvailableBusses();
-      return false;
-    }
-
+    // start the logging threads before the first cyclic update can log.
+    message_logger::log::LogAggregator::instance();
     {
       std::lock_guard<std::mutex> contextLock(contextMutex_);
-      if (ecx_init(&ecatContext_, name_.c_str()) <= 0) {
-        MELO_ERROR_STREAM("[" << name_ << "] "
-                              << "No socket connection. Execute as root.");
-        return false;
-      }
-      for (int retry = 0; retry <= maxDiscoverRetries; retry++) {
-        if (abortFlag) {
-          MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] "
-                                                   << "Shutdown during waiting for slaves.");
-          ecx_close(&ecatContext_);
-          return false;  // avoid that executation continues.
-        }
-        if (ecx_detect_slaves(&ecatContext_) >= static_cast<int>(slaves_.size())) {
-          // on some of the older (rsl) anydrives there seems to be a short race between bus is responsive and slave is fully ready...
-          // so give them this 1 sec to be fully ready to be started...
-          soem_interface_rsl::threadSleep(1.0);
-          break;
-        }
-        if (retry == maxDiscoverRetries) {
-          MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
-                                                    << "No slaves have been found.");
-          ecx_close(&ecatContext_);
-          return false;
-        }
-        // Sleep and retry.
-        soem_interface_rsl::threadSleep(ecatConfigRetrySleep_);
-        MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] No slaves have been found, retrying " << retry + 1 << "/"
-                                                 << maxDiscoverRetries << " ...");
-      }
-
-      // this should no work cleanly, since we're sure that all slaves are started.
-      if (ecx_config_init(&ecatContext_, FALSE) < static_cast<int>(slaves_.size())) {
-        ecx_close(&ecatContext_);
-        MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
-                                                  << "No slaves have been found.");
-        return false;
-      }
-
-      int nSlaves = *ecatContext_.slavecount;
-      // Print the slaves which have been detected.
-      MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] The following " << nSlaves << " slaves have been found and configured:");
-      for (int slave = 1; slave <= nSlaves; slave++) {
-        MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Address: " << slave << " - Name: '"
-                                                 << std::string(ecatContext_.slavelist[slave].name) << "'");
-      }
-
-      // Check if the given slave addresses are valid.
-      bool slaveAddressesAreOk = true;
-      for (const auto& slave : slaves_) {
-        auto address = static_cast<int>(slave->getAddress());
-        if (address == 0) {
-          MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
-                                                    << "Slave '" << slave->getName() << "': Invalid address " << address << ".");
-          slaveAddressesAreOk = false;
-        }
-        if (address > nSlaves) {
-          MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
-                                                    << "Slave '" << slave->getName() << "': Invalid address " << address << ", "
-                                                    << "only " << nSlaves << " slave(s) found.");
-          slaveAddressesAreOk = false;
-        }
-      }
-      if (!slaveAddressesAreOk) {
-        ecx_close(&ecatContext_);
+      if (!initializeCommunicationLocked(abortFlag, maxDiscoverRetries)) {
         return false;
       }
-
-      // Disable symmetrical transfers.
-      ecatContext_.grouplist[0].blockLRW = 1;
-
-      // some slave might require SAFE_OP during setup...
-      busDiagnosisLog_.errorCounters_.resize(slaves_.size());
-      nSlaves_ = slaves_.size();
-      initlialized_ = true;
-      setStateLocked(EC_STATE_PRE_OP);
-      waitForStateLocked(EC_STATE_PRE_OP, 0);
     }
     //  MELO_DEBUG_STREAM("[EthercatBus] Bus Startup: Set all salves to SAFE_OP")
 
@@ -195,47 +111,212 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
     }
 
     std::lock_guard<std::mutex> contextLock(contextMutex_);
-    // Set up the communication IO mapping.
     // Note: ecx_config_map_group(..) requests the slaves to go to SAFE-OP.
-    [[maybe_unused]] int ioMapSize = ecx_config_map_group(&ecatContext_, &ioMap_, 0);
-    MELO_DEBUG_STREAM("[soem_interface_rsl::" << name_ << "] Configured ioMap with size: " << ioMapSize)
+    if (!configureIoMapLocked(sizeCheck)) {
+      return false;
+    }
 
-    // Check if the size of the IO mapping fits our slaves.
-    bool ioMapIsOk = true;
-    // do this check only if 'sizeCheck' is true
-    if (sizeCheck) {
-      for (const auto& slave : slaves_) {
-        const EthercatSlaveBase::PdoInfo pdoInfo = slave->getCurrentPdoInfo();
-        if (pdoInfo.rxPdoSize_ != ecatContext_.slavelist[slave->getAddress()].Obytes) {
-          MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
-                                                    << "RxPDO size mismatch: The slave '" << slave->getName() << "' expects a size of "
-                                                    << pdoInfo.rxPdoSize_ << " bytes but the slave found at its address "
-                                                    << slave->getAddress() << " requests "
-                                                    << ecatContext_.slavelist[slave->getAddress()].Obytes << " bytes).");
-          ioMapIsOk = false;
+    // All slaves take part in the cyclic exchange right away, the user sets the bus to OP.
+    stagedStartup_ = false;
+    for (auto& stage : slaveStages_) {
+      stage = SlaveStage::Operational;
+    }
+    updateExpectedWorkingCounter();
+    return true;
+  }
+
+  bool startupStaged(std::atomic<bool>& abortFlag, const bool sizeCheck, int maxDiscoverRetries) {
+    message_logger::log::LogAggregator::instance();
+    std::lock_guard<std::mutex> contextLock(contextMutex_);
+    if (!initializeCommunicationLocked(abortFlag, maxDiscoverRetries)) {
+      return false;
+    }
+
+    // Map the process image before the slaves are started. The automatic request of SAFE_OP for all slaves is disabled, every slave is
+    // moved to SAFE_OP individually once its startup() succeeded (see stepStagedStartup()).
+    ecatContext_.manualstatechange = 1;
+    const bool ioMapIsOk = configureIoMapLocked(sizeCheck);
+    ecatContext_.manualstatechange = 0;
+    if (!ioMapIsOk) {
+      return false;
+    }
+
+    stagedStartup_ = true;
+    for (auto& stage : slaveStages_) {
+      stage = SlaveStage::Pending;
+    }
+    updateExpectedWorkingCounter();
+    MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Process image mapped, slaves are brought up individually.")
+    return true;
+  }
+
+  bool stepStagedStartup() {
+    if (!initlialized_ || !stagedStartup_) {
+      return true;
+    }
+
+    bool finished = true;
+    for (uint16_t address = 1; address < slaveStages_.size(); address++) {
+      auto& stage = slaveStages_[address];
+      switch (stage.load()) {
+        case SlaveStage::Pending: {
+          // slaves without an EthercatSlaveBase object (e.g. junctions) are ready right away.
+          const EthercatSlaveBasePtr slave = getSlaveByAddress(address);
+          if (slave) {
+            MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Starting slave: " << slave->getName())
+            if (!slave->startup()) {
+              MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Slave '" << slave->getName()
+                                                        << "' was not initialized successfully, it is excluded from the cyclic exchange.");
+              stage = SlaveStage::Failed;
+              break;
+            }
+          }
+          std::lock_guard<std::mutex> guard(contextMutex_);
+          requestStateLocked(address, EC_STATE_SAFE_OP);
+          stageDeadlines_[address] = slaveStateDeadline();
+          stage = SlaveStage::SafeOpRequested;
+          finished = false;
+          break;
         }
-        if (pdoInfo.txPdoSize_ != ecatContext_.slavelist[slave->getAddress()].Ibytes) {
-          MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
-                                                    << "TxPDO size mismatch: The slave '" << slave->getName() << "' expects a size of "
-                                                    << pdoInfo.txPdoSize_ << " bytes but the slave found at its address "
-                                                    << slave->getAddress() << " requests "
-                                                    << ecatContext_.slavelist[slave->getAddress()].Ibytes << " bytes).");
-          ioMapIsOk = false;
+        case SlaveStage::SafeOpRequested:
+        case SlaveStage::OpRequested: {
+          const bool safeOpRequested = stage == SlaveStage::SafeOpRequested;
+          const uint16_t targetState = safeOpRequested ? EC_STATE_SAFE_OP : EC_STATE_OPERATIONAL;
+          std::lock_guard<std::mutex> guard(contextMutex_);
+          const uint16_t state = readStateLocked(address);
+          if ((state & 0x0f) == targetState && (state & EC_STATE_ERROR) == 0) {
+            if (safeOpRequested) {
+              // the outputs are already cycled, therefore the slave can directly be requested to go to OP.
+              requestStateLocked(address, EC_STATE_OPERATIONAL);
+              stageDeadlines_[address] = slaveStateDeadline();
+              stage = SlaveStage::OpRequested;
+            } else {
+              stage = SlaveStage::Operational;
+              updateExpectedWorkingCounter();
+              MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << " reached "
+                                                       << EthercatBusBase::getStateString(state) << ", expected working counter is now "
+                                                       << expectedWorkingCounter_.load())
+              break;
+            }
+          } else if ((state & EC_STATE_ERROR) != 0 || std::chrono::steady_clock::now() > stageDeadlines_[address]) {
+            MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << ": Targetstate "
+                                                      << EthercatBusBase::getStateString(targetState)
+                                                      << " has not been reached. Current State: " << EthercatBusBase::getStateString(state)
+                                                      << ", alStatusCode: 0x" << std::setfill('0') << std::setw(8) << std::hex
+                                                      << ecatContext_.slavelist[address].ALstatuscode << " "
+                                                      << ec_ALstatuscode2string(ecatContext_.slavelist[address].ALstatuscode));
+            stage = SlaveStage::Failed;
+            break;
+          }
+          finished = false;
+          break;
         }
+        case SlaveStage::Operational:
+        case SlaveStage::Remapping:
+        case SlaveStage::Recovering:
+        case SlaveStage::Failed:
+          break;
       }
     }
-    if (!ioMapIsOk) {
+
+    if (finished) {
+      stagedStartup_ = false;
+      MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Staged startup finished, expected working counter: "
+                                               << expectedWorkingCounter_.load())
+    }
+    return finished;
+  }
+
+  bool slaveIsActive(const uint16_t slave) const {
+    if (slave == 0 || slave >= slaveStages_.size()) {
       return false;
     }
+    return slaveStages_[slave].load(std::memory_order_relaxed) == SlaveStage::Operational;
+  }
 
-    // Initialize the memory with zeroes.
-    for (int slave = 1; slave <= *ecatContext_.slavecount; slave++) {
-      memset(ecatContext_.slavelist[slave].inputs, 0, ecatContext_.slavelist[slave].Ibytes);
-      memset(ecatContext_.slavelist[slave].outputs, 0, ecatContext_.slavelist[slave].Obytes);
+  void setSlaveStateTimeout(const double timeout) { slaveStateTimeout_ = timeout; }
+
+  int getExpectedWorkingCounter() const { return expectedWorkingCounter_.load(std::memory_order_relaxed); }
+
+  bool remapSlave(const uint16_t address, const std::function<bool()>& writePdoAssignment, const bool sizeCheck) {
+    if (!initlialized_ || stagedStartup_) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Cannot remap slave " << address
+                                                << ", the bus is not started or the staged startup is not finished.");
+      return false;
+    }
+    if (address == 0 || address >= slaveStages_.size()) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Cannot remap slave " << address << ", invalid address.");
+      return false;
+    }
+    if (slaveStages_[address] == SlaveStage::Recovering) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Cannot remap slave " << address << ", it is being recovered.");
+      return false;
+    }
+    if (remappedSlave_ != 0 && remappedSlave_ != address) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Cannot remap slave " << address << ", slave " << remappedSlave_
+                                                << " already uses the headroom of the IO map. Restart the bus instead.");
+      return false;
     }
 
-    workingCounterTooLowCounter_ = 0;
+    // Take the slave out of the cyclic exchange before it leaves OP.
+    slaveStages_[address] = SlaveStage::Remapping;
+    updateExpectedWorkingCounter();
+    if (remappedSlave_ == address) {
+      remapGroupActive_ = false;
+    }
+    PreviousMapping previousMapping;
+    {
+      std::lock_guard<std::mutex> guard(contextMutex_);
+      previousMapping.slave = ecatContext_.slavelist[address];
+      previousMapping.remapGroup = ecatContext_.grouplist[remapGroup_];
+      previousMapping.remappedSlave = remappedSlave_;
+      previousMapping.wkcContribution = slaveWkcContribution_[address];
+      requestStateLocked(address, EC_STATE_PRE_OP);
+    }
+    if (!waitForSlaveState(address, EC_STATE_PRE_OP)) {
+      restoreMapping(address, previousMapping);
+      return false;
+    }
+
+    // SDOs lock the context themselves, the cyclic exchange of the other slaves goes on in between.
+    if (writePdoAssignment && !writePdoAssignment()) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << ": Writing the PDO assignment failed.");
+      restoreMapping(address, previousMapping);
+      return false;
+    }
+    PdoAssignment pdoAssignment;
+    if (!readPdoAssignment(address, pdoAssignment)) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << ": Reading the PDO assignment failed.");
+      restoreMapping(address, previousMapping);
+      return false;
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(contextMutex_);
+      const EthercatSlaveBasePtr slave = getSlaveByAddress(address);
+      if (!mapRemapGroupLocked(address, pdoAssignment) || (sizeCheck && slave && !pdoSizesMatchLocked(slave))) {
+        restoreMappingLocked(address, previousMapping);
+        return false;
+      }
+    }
+
+    // The remap group has to be cycled for the slave to accept SAFE_OP and OP.
+    remapGroupActive_ = true;
+    for (const uint16_t state : {EC_STATE_SAFE_OP, EC_STATE_OPERATIONAL}) {
+      {
+        std::lock_guard<std::mutex> guard(contextMutex_);
+        requestStateLocked(address, state);
+      }
+      if (!waitForSlaveState(address, state)) {
+        restoreMapping(address, previousMapping);
+        return false;
+      }
+    }
 
+    slaveStages_[address] = SlaveStage::Operational;
+    updateExpectedWorkingCounter();
+    MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << " remapped, expected working counter is now "
+                                             << expectedWorkingCounter_.load())
     return true;
   }
 
@@ -244,42 +325,99 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
       MELO_DEBUG_STREAM("No process data to read.");
       return;
     }
+    if (replayRecording_ != nullptr && replayIsFinished()) {
+      sentProcessData_ = false;
+      return;
+    }
 
     //! Receive the EtherCAT data.
     updateReadStamp_ = std::chrono::high_resolution_clock::now();
+    const int64_t receiveStart = cycleStatistics_.startCycle();
     {
       std::lock_guard<std::mutex> guard(contextMutex_);
-      wkc_ = ecx_receive_processdata(&ecatContext_, EC_TIMEOUTRET);
+      if (replayRecording_ != nullptr) {
+        receiveReplayLocked();
+      } else {
+        wkc_ = ecx_receive_processdata(&ecatContext_, EC_TIMEOUTRET);
+        receiveRegisterReadsLocked();
+        receiveAttributionLocked();
+      }
+      if (hasDistributedClocks_ && wkc_ > 0) {
+        distributedClockTime_.store(ecatDcTime_, std::memory_order_relaxed);
+        updateReadMonotonicTime_.store(sendMonotonicTime_, std::memory_order_relaxed);
+      }
+      if (recordProcessImage_) {
+        // the outputs in the IO map are the ones sent with this frame, updateWrite() did not run since.
+        processImageRecorder_.record(sendMonotonicTime_, hasDistributedClocks_ ? ecatDcTime_ : 0, wkc_.load(),
+                                     expectedWorkingCounter_.load(std::memory_order_relaxed), ioMap_);
+      }
     }
     sentProcessData_ = false;
+    cycleStatistics_.recordPhase(common::CycleStatistics::Phase::Receive, receiveStart);
+    if (hasDistributedClocks_ && wkc_ > 0) {
+      // The send stamp is closer to the moment the frame passes the reference clock than the receive stamp, which also carries the
+      // wakeup latency of this thread.
+      distributedClockMapping_.addSample(distributedClockTime_.load(std::memory_order_relaxed), sendMonotonicTime_);
+    }
 
-    int expectedWorkingCounter = ecatContext_.grouplist[0].outputsWKC * 2 + ecatContext_.grouplist[0].inputsWKC;
+    // only slaves taking part in the cyclic exchange are accounted, see updateExpectedWorkingCounter().
+    const int expectedWorkingCounter = expectedWorkingCounter_.load(std::memory_order_relaxed);
+    cycleStatistics_.recordWorkingCounter(wkc_, expectedWorkingCounter);
     //! Check the working counter.
     if (wkc_ < expectedWorkingCounter) {
-      ++workingCounterTooLowCounter_;
-      MELO_DEBUG_STREAM("[soem_interface_rsl::" << name_ << "] Working counter too low counter: " << workingCounterTooLowCounter_)
-      MELO_DEBUG_THROTTLE_STREAM(1.0, "[soem_interface_rsl::" << getName() << "] Update Read:" << this);
-      MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] Working counter is too low: " << wkc_.load() << " < "
-                                               << expectedWorkingCounter << ", wkc's to low in a row: " << workingCounterTooLowCounter_);
+      if (++workingCounterTooLowCounter_ == 1) {
+        eventLog_.log(common::EventType::WorkingCounterDrop, 0, 0, wkc_.load(), expectedWorkingCounter);
+        frameCapture_.trigger(common::FrameCapture::Trigger::WorkingCounterDrop);
+      }
+      // split the exchange of the next cycles into per slave datagrams to find the slaves missing in the working counter.
+      attributionRequested_ = attributionEnabled_.load(std::memory_order_relaxed);
+      // called every cycle while the bus is degraded, the aggregated logging emits the first message and one summary
+      // per interval (shared by all buses) instead of one line per cycle.
+      MELO_RT_DEBUG_AGGREGATED("wkc's to low in a row", workingCounterTooLowCounter_.load(),
+                               "[soem_interface_rsl::{}] Working counter too low counter: {}", name_, workingCounterTooLowCounter_.load());
+      MELO_RT_WARN_AGGREGATED("wkc", wkc_.load(), "[soem_interface_rsl::{}] Working counter is too low: {} < {}, wkc's to low in a row: {}",
+                              name_, wkc_.load(), expectedWorkingCounter, workingCounterTooLowCounter_.load());
       {
         std::lock_guard<std::mutex> guard(contextMutex_);
-        MELO_WARN_STREAM("[soem_interface_rsl" << name_ << "] For all slaves alStatusCode: 0x" << std::setfill('0') << std::setw(8)
-                                               << std::hex << ecatContext_.slavelist[0].ALstatuscode << " "
-                                               << ec_ALstatuscode2string(ecatContext_.slavelist[0].ALstatuscode));
+        MELO_RT_WARN_AGGREGATED("alStatusCode", ecatContext_.slavelist[0].ALstatuscode,
+                                "[soem_interface_rsl::{}] For all slaves alStatusCode: 0x{:08x} {}", name_,
+                                ecatContext_.slavelist[0].ALstatuscode, ec_ALstatuscode2string(ecatContext_.slavelist[0].ALstatuscode));
       }
       if (workingCounterTooLowCounter_ > maxWorkingCounterTooLow_) {
-        MELO_ERROR_THROTTLE_STREAM(1.0, "[soem_interface_rsl" << name_ << "] Bus is not ok. Too many working counter too low in a row: "
-                                                              << workingCounterTooLowCounter_)
+        MELO_RT_ERROR_AGGREGATED("wkc's to low in a row", workingCounterTooLowCounter_.load(),
+                                 "[soem_interface_rsl::{}] Bus is not ok. Too many working counter too low in a row: {}", name_,
+                                 workingCounterTooLowCounter_.load());
       }
       return;
     }
     // Reset working counter too low counter.
+    attributionRequested_ = false;
+    if (attributionFrameIndex_ < 0) {
+      // a pass interrupted by the working counter recovering is discarded.
+      attributionCursor_ = 1;
+    }
+    if (workingCounterTooLowCounter_ > 0) {
+      eventLog_.log(common::EventType::WorkingCounterRestored, 0, 0, wkc_.load(),
+                    static_cast<int32_t>(workingCounterTooLowCounter_.load()));
+    }
     workingCounterTooLowCounter_ = 0;
 
     //! Each slave attached to this bus reads its data to the buffer.
-    for (auto& slave : slaves_) {
-      slave->updateRead();
+    const int64_t readStart = common::CycleStatistics::now();
+    const bool timeSlaves = slaveTimingEnabled_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < slaves_.size(); i++) {
+      const auto& slave = slaves_[i];
+      if (slaveIsActive(slave->getAddress())) {
+        if (timeSlaves) {
+          const common::SlaveTiming::Stamp start = common::SlaveTiming::start();
+          slave->updateRead();
+          recordSlaveTiming(i, common::SlaveTiming::Callback::UpdateRead, start);
+        } else {
+          slave->updateRead();
+        }
+      }
     }
+    cycleStatistics_.recordPhase(common::CycleStatistics::Phase::ReadSlaves, readStart);
   }
 
   void updateWrite() {
@@ -288,106 +426,800 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
     }
 
     //! Each slave attached to this bus write its data to the buffer.
-    for (auto& slave : slaves_) {
-      slave->updateWrite();
+    const int64_t writeStart = common::CycleStatistics::now();
+    const bool timeSlaves = slaveTimingEnabled_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < slaves_.size(); i++) {
+      const auto& slave = slaves_[i];
+      if (slaveIsActive(slave->getAddress())) {
+        if (timeSlaves) {
+          const common::SlaveTiming::Stamp start = common::SlaveTiming::start();
+          slave->updateWrite();
+          recordSlaveTiming(i, common::SlaveTiming::Callback::UpdateWrite, start);
+        } else {
+          slave->updateWrite();
+        }
+      }
     }
+    // The send phase includes waiting for the context, e.g. while a mailbox transfer is in progress.
+    const int64_t sendStart = cycleStatistics_.recordPhase(common::CycleStatistics::Phase::WriteSlaves, writeStart);
 
     //! Send the EtherCAT data.
     updateWriteStamp_ = std::chrono::high_resolution_clock::now();
+    if (replayRecording_ != nullptr) {
+      // the outputs stay in the IO map, updateRead() records them together with the replayed inputs.
+      sentProcessData_ = true;
+      return;
+    }
     std::lock_guard<std::mutex> guard(contextMutex_);
+    sendMonotonicTime_ = common::DistributedClockMapping::getMonotonicTime();
     ecx_send_processdata(&ecatContext_);
+    if (remapGroupActive_) {
+      // ecx_receive_processdata(..) collects the frames of both groups and sums up their working counters.
+      ecx_send_processdata_group(&ecatContext_, remapGroup_);
+    }
+    sendRegisterReadsLocked();
+    sendAttributionLocked();
     sentProcessData_ = true;
+    cycleStatistics_.recordPhase(common::CycleStatistics::Phase::Send, sendStart);
   }
 
   const std::chrono::time_point<std::chrono::high_resolution_clock>& getUpdateReadStamp() const { return updateReadStamp_; }
 
   const std::chrono::time_point<std::chrono::high_resolution_clock>& getUpateWriteStamp() const { return updateWriteStamp_; }
 
-  void shutdown() {
-    if (initlialized_) {
-      {
-        std::lock_guard<std::mutex> guard(contextMutex_);
-        // Set the slaves to state Init.
-        if (*ecatContext_.slavecount > 0) {
-          setStateLocked(EC_STATE_INIT);
-          waitForStateLocked(EC_STATE_INIT);
-        }
-      }  // release the contextMutex_ in case slave wants to do low_level commands at shutdown.
-      for (auto& slave : slaves_) {
-        slave->shutdown();
+  common::CycleStatisticsSnapshot getCycleStatistics() const { return cycleStatistics_.getSnapshot(); }
+
+  void resetCycleStatistics() { cycleStatistics_.reset(); }
+
+  // Appends a datagram to the frame with index idx, sets up a new frame if idx < 0. lastHeader keeps the position of the last datagram.
+  // Returns the offset of the datagram data in the received frame, -1 if the datagram does not fit into the frame.
+  int appendDatagramLocked(int& idx, int& lastHeader, const uint8 command, const uint16 adp, const uint16 ado, const uint16 length,
+                           void* data) {
+    ecx_portt* port = ecatContext_.port;
+    if (idx < 0) {
+      idx = ecx_getindex(port);
+      ecx_setupdatagram(port, &(port->txbuf[idx]), command, static_cast<uint8>(idx), adp, ado, length, data);
+      lastHeader = ETH_HEADERSIZE;
+      return EC_HEADERSIZE;
+    }
+    if (port->txbuflength[idx] + EC_HEADERSIZE - EC_ELENGTHSIZE + length + EC_WKCSIZE > maxFrameLength_) {
+      return -1;
+    }
+    const int header = port->txbuflength[idx] - static_cast<int>(EC_ELENGTHSIZE);
+    const int offset = ecx_adddatagram(port, &(port->txbuf[idx]), command, static_cast<uint8>(idx), FALSE, adp, ado, length, data);
+    // ecx_adddatagram(..) only flags the first datagram as followed, the slaves stop parsing at a datagram without the flag.
+    auto* datagram = reinterpret_cast<ec_comt*>(&(port->txbuf[idx][lastHeader]));
+    datagram->dlength = htoes(etohs(datagram->dlength) | EC_DATAGRAMFOLLOWS);
+    lastHeader = header;
+    return offset;
+  }
+
+  void sendRegisterReadsLocked() {
+    const size_t nReads = registerTable_.size();
+    if (registerFrameIndex_ >= 0 || (!topologyRefreshDue() && nReads == 0)) {
+      // updateRead() has not collected the previous frame, or nothing to read.
+      return;
+    }
+    const uint64_t cycle = registerCycle_.load(std::memory_order_relaxed) + 1;
+    registerCycle_.store(cycle, std::memory_order_relaxed);
+    int idx = -1;
+    int lastHeader = 0;
+    nSentRegisterReads_ = 0;
+    appendTopologyDatagramsLocked(idx, lastHeader);
+    size_t i = 0;
+    for (; i < nReads && nSentRegisterReads_ < sentRegisterReads_.size(); i++) {
+      const size_t handle = (registerCursor_ + i) % nReads;
+      common::CyclicRegisterTable::Read& read = registerTable_.getRead(handle);
+      if (read.dueCycle > cycle) {
+        continue;
+      }
+      const uint8 command = read.slave == 0 ? EC_CMD_BRD : EC_CMD_FPRD;
+      const int offset = appendDatagramLocked(idx, lastHeader, command, read.stationAddress, read.address, read.length, nullptr);
+      if (offset < 0) {
+        // The frame is full, the next cycle starts with this read.
+        break;
       }
+      read.dueCycle = cycle + read.decimation.load(std::memory_order_relaxed);
+      sentRegisterReads_[nSentRegisterReads_++] = {handle, offset};
     }
+    if (nReads > 0) {
+      registerCursor_ = (registerCursor_ + i) % nReads;
+    }
+    if (idx >= 0) {
+      ecx_outframe_red(ecatContext_.port, idx);
+      registerFrameIndex_ = idx;
+    }
+  }
 
-    // Close the port.
-    std::lock_guard<std::mutex> guard(contextMutex_);
-    if (ecatContext_.port != nullptr) {
-      MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Closing socket ...");
-      ecx_close(&ecatContext_);
-      // Sleep to make sure the socket is closed, because ecx_close is non-blocking.
-      soem_interface_rsl::threadSleep(0.5);
+  void receiveRegisterReadsLocked() {
+    if (registerFrameIndex_ < 0) {
+      return;
     }
-    initlialized_ = false;
+    ecx_portt* port = ecatContext_.port;
+    const int idx = registerFrameIndex_;
+    registerFrameIndex_ = -1;
+    // Sent right after the process data, the frame is back by now or shortly after.
+    const bool received = ecx_waitinframe(port, idx, EC_TIMEOUTRET) > EC_NOFRAME;
+    receiveTopologyDatagramsLocked(received ? port->rxbuf[idx] : nullptr);
+    if (received) {
+      const uint64_t cycle = registerCycle_.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < nSentRegisterReads_; i++) {
+        const SentRegisterRead& sent = sentRegisterReads_[i];
+        const uint16_t length = registerTable_.getRead(sent.handle).length;
+        uint16 workingCounter = 0;
+        memcpy(&workingCounter, &(port->rxbuf[idx][sent.offset + length]), EC_WKCSIZE);
+        registerTable_.publish(sent.handle, &(port->rxbuf[idx][sent.offset]), etohs(workingCounter), cycle, sendMonotonicTime_);
+      }
+    }
+    ecx_setbufstat(port, idx, EC_BUF_EMPTY);
   }
 
-  void setState(const uint16_t state, const uint16_t slave = 0) {
-    std::lock_guard<std::mutex> guard(contextMutex_);
-    setStateLocked(state, slave);
+  // Counts the register frames until the next topology refresh, called once per frame.
+  bool topologyRefreshDue() {
+    const unsigned int decimation = topologyRefreshDecimation_.load(std::memory_order_relaxed);
+    if (decimation == 0 || !hasDistributedClocks_) {
+      topologyRefresh_ = TopologyRefresh::Idle;
+      return false;
+    }
+    if (topologyRefresh_ == TopologyRefresh::Idle && ++topologyRefreshCycles_ >= decimation) {
+      topologyRefreshCycles_ = 0;
+      topologyRefresh_ = TopologyRefresh::Latch;
+    }
+    return topologyRefresh_ != TopologyRefresh::Idle;
   }
 
-  bool waitForState(const uint16_t state, const uint16_t slave = 0, const unsigned int maxRetries = 20) {
-    std::lock_guard<std::mutex> guard(contextMutex_);
-    return waitForStateLocked(state, slave, maxRetries);
+  void appendTopologyDatagramsLocked(int& idx, int& lastHeader) {
+    topologyLatchOffset_ = -1;
+    nSentTopologyReads_ = 0;
+    if (topologyRefresh_ == TopologyRefresh::Latch) {
+      // A write to 0x0900 latches the receive time of this frame at every port. The return path ports latch it after the datagrams of
+      // the same frame passed the slave, therefore the receive times are read by the next frames.
+      topologyLatchOffset_ = appendDatagramLocked(idx, lastHeader, EC_CMD_BWR, 0, ECT_REG_DCTIME0, sizeof(topologyLatchData_),
+                                                  &topologyLatchData_);
+      topologyRefresh_ = TopologyRefresh::Read;
+      topologyCursor_ = 1;
+      return;
+    }
+    if (topologyRefresh_ != TopologyRefresh::Read) {
+      return;
+    }
+    for (; topologyCursor_ <= *ecatContext_.slavecount && nSentTopologyReads_ < sentTopologyReads_.size(); topologyCursor_++) {
+      const ec_slavet& slave = ecatContext_.slavelist[topologyCursor_];
+      if (!slave.hasdc) {
+        continue;
+      }
+      const int offset = appendDatagramLocked(idx, lastHeader, EC_CMD_FPRD, slave.configadr, ECT_REG_DCTIME0, receiveTimesLength_, nullptr);
+      if (offset < 0) {
+        break;
+      }
+      sentTopologyReads_[nSentTopologyReads_++] = {topologyCursor_, offset};
+    }
   }
 
-  ETHERCAT_SM_STATE getEthercatState(const uint16_t slave = 0) {
-    uint16_t stateRaw = getState(slave);
-    // check if Error
-    if ((stateRaw & 0xf0) == EC_STATE_ERROR) {
-      return ETHERCAT_SM_STATE::ERROR;
+  // frame is nullptr if the register frame got lost.
+  void receiveTopologyDatagramsLocked(const uint8* frame) {
+    if (topologyLatchOffset_ < 0 && nSentTopologyReads_ == 0) {
+      return;
     }
-    switch (stateRaw & 0x0f) {
-      case EC_STATE_INIT:
-        return ETHERCAT_SM_STATE::INIT;
-      case EC_STATE_BOOT:
-        return ETHERCAT_SM_STATE::BOOT;
-      case EC_STATE_PRE_OP:
-        return ETHERCAT_SM_STATE::PRE_OP;
-      case EC_STATE_SAFE_OP:
-        return ETHERCAT_SM_STATE::SAFE_OP;
-      case EC_STATE_OPERATIONAL:
-        return ETHERCAT_SM_STATE::OPERATIONAL;
-      default:
-        return ETHERCAT_SM_STATE::NONE;  // should not happen.
+    bool failed = frame == nullptr;
+    uint16 workingCounter = 0;
+    if (!failed && topologyLatchOffset_ >= 0) {
+      memcpy(&workingCounter, frame + topologyLatchOffset_ + sizeof(topologyLatchData_), EC_WKCSIZE);
+      failed = etohs(workingCounter) == 0;
+    }
+    for (size_t i = 0; i < nSentTopologyReads_ && !failed; i++) {
+      const SentTopologyRead& sent = sentTopologyReads_[i];
+      memcpy(&workingCounter, frame + sent.offset + receiveTimesLength_, EC_WKCSIZE);
+      failed = etohs(workingCounter) != 1;
+      auto& receiveTimes = topologyReceiveTimes_[sent.address];
+      for (size_t port = 0; port < receiveTimes.size(); port++) {
+        uint32 receiveTime = 0;
+        memcpy(&receiveTime, frame + sent.offset + port * sizeof(receiveTime), sizeof(receiveTime));
+        receiveTimes[port] = etohl(receiveTime);
+      }
+    }
+    topologyLatchOffset_ = -1;
+    nSentTopologyReads_ = 0;
+    if (failed) {
+      // starts over with the next refresh.
+      topologyRefresh_ = TopologyRefresh::Idle;
+      return;
+    }
+    if (topologyRefresh_ == TopologyRefresh::Read && topologyCursor_ > *ecatContext_.slavecount) {
+      segmentTopology_.update(topologyReceiveTimes_);
+      std::unique_lock<std::mutex> lock(topologyMutex_, std::try_to_lock);
+      if (lock.owns_lock()) {
+        // same size, does not allocate. Skipped while getSegmentTopology() copies the previous one.
+        publishedTopology_ = segmentTopology_.getNodes();
+      }
+      topologyRefresh_ = TopologyRefresh::Idle;
     }
-    return ETHERCAT_SM_STATE::NONE;
   }
 
-  bool busIsOk() const { return workingCounterTooLowCounter_ < maxWorkingCounterTooLow_; }
+  void buildSegmentTopology() {
+    std::vector<common::TopologyNode> nodes(static_cast<size_t>(*ecatContext_.slavecount));
+    for (size_t address = 1; address <= nodes.size(); address++) {
+      const ec_slavet& slave = ecatContext_.slavelist[address];
+      common::TopologyNode& node = nodes[address - 1];
+      node.parent = slave.parent;
+      node.parentPort = slave.parentport;
+      node.entryPort = slave.entryport;
+      node.activePorts = slave.activeports;
+      node.hasDistributedClock = slave.hasdc != FALSE;
+      node.startupPropagationDelay = slave.pdelay;
+    }
+    segmentTopology_.build(nodes);
+    topologyReceiveTimes_.assign(nodes.size() + 1, {});
+    topologyRefresh_ = TopologyRefresh::Idle;
+    topologyRefreshCycles_ = 0;
+    std::lock_guard<std::mutex> lock(topologyMutex_);
+    publishedTopology_ = segmentTopology_.getNodes();
+  }
 
-  bool doBusMonitoring(bool logErrorCounterForDiagnosis) {
-    if (!initlialized_) {
+  bool startFrameCapture(const std::string& path, common::FrameCapture::Options options) {
+    stopFrameCapture();
+    if (options.interface.empty()) {
+      options.interface = name_;
+    }
+    if (!frameCapture_.start(path, options)) {
       return false;
     }
-    bool allFine = true;
-    busDiagnosisLog_.fullyUpdated = false;
-    BusDiagState nextBusDiagState{BusDiagState::StateReading};
-    MELO_DEBUG_STREAM("[DriveManager::DoBusMonitoring::" << name_ << "] Running Bus Monitoring/Diagnosis")
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    if (initlialized_) {
+      ecx_setcapturehook(ecatContext_.port, &common::FrameCapture::hook, &frameCapture_);
+    }
+    return true;
+  }
 
-    if (busDiagState_ == BusDiagState::StateReading) {
-      if (logErrorCounterForDiagnosis) {
-        nextBusDiagState = BusDiagState::CounterReading;
+  void stopFrameCapture() {
+    {
+      std::lock_guard<std::mutex> guard(contextMutex_);
+      if (initlialized_) {
+        ecx_setcapturehook(ecatContext_.port, nullptr, nullptr);
       }
-      // read all the states from all slaves.
-      MELO_DEBUG_STREAM("[DriveManager::DoBusMonitoring::" << name_ << "] Running Bus Monitoring/Diagnosis State/AlstatusCode")
+    }
+    frameCapture_.stop();
+  }
 
-      int lowestSlaveState = getState(0);  // one datagram iff all slaves in the same state, otherwise one datagram per slave.
+  bool triggerFrameCapture() { return frameCapture_.trigger(); }
 
-      // can we do more than looking on the state machine? error counters would be interessting but needs very raw register reads, but
-      // possible.
+  const common::FrameCapture& getFrameCapture() const { return frameCapture_; }
+
+  bool startProcessImageRecording(const std::string& path, const common::ProcessImageRecorder::Options& options) {
+    stopProcessImageRecording();
+    std::vector<common::ProcessImageRecorder::Column> columns;
+    size_t imageSize = 0;
+    {
       std::lock_guard<std::mutex> guard(contextMutex_);
-      if ((lowestSlaveState & 0x0f) < EC_STATE_OPERATIONAL) {  // if ECAT Error bus state is e.g. 0x14 = 0x10 (error) + 0x04 (safeOP)
-        MELO_WARN_STREAM("[EthercatBus::BusMonitoring::" << name_ << "] No all slaves in EC_STATE_OPERATIONAL")
-        for (const auto& slave : slaves_) {
+      if ((!initlialized_ && replayRecording_ == nullptr) || ioMapGroupSize_ == 0) {
+        MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Cannot record the process image before the IO map is configured.")
+        return false;
+      }
+      // one column per slave and direction, the offsets cover the remap group as well.
+      for (int address = 1; address <= *ecatContext_.slavecount; address++) {
+        const ec_slavet& slave = ecatContext_.slavelist[address];
+        const EthercatSlaveBasePtr slaveObject = getSlaveByAddress(static_cast<uint16_t>(address));
+        const std::string slaveName = slaveObject ? slaveObject->getName() : std::string(slave.name);
+        const std::pair<uint8*, uint32> images[] = {{slave.outputs, slave.Obytes}, {slave.inputs, slave.Ibytes}};
+        for (size_t i = 0; i < 2; i++) {
+          if (images[i].first == nullptr || images[i].second == 0) {
+            continue;
+          }
+          common::ProcessImageRecorder::Column column;
+          column.kind = i == 0 ? common::ProcessImageColumnKind::Outputs : common::ProcessImageColumnKind::Inputs;
+          column.name = slaveName + (i == 0 ? ".outputs" : ".inputs");
+          column.slave = static_cast<uint16_t>(address);
+          column.offset = static_cast<uint32_t>(reinterpret_cast<char*>(images[i].first) - ioMap_);
+          column.width = images[i].second;
+          imageSize = std::max(imageSize, static_cast<size_t>(column.offset) + column.width);
+          columns.push_back(column);
+        }
+      }
+    }
+    if (!processImageRecorder_.start(path, name_, columns, imageSize, options)) {
+      return false;
+    }
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    recordProcessImage_ = true;
+    return true;
+  }
+
+  void stopProcessImageRecording() {
+    {
+      std::lock_guard<std::mutex> guard(contextMutex_);
+      recordProcessImage_ = false;
+    }
+    processImageRecorder_.stop();
+  }
+
+  const common::ProcessImageRecorder& getProcessImageRecorder() const { return processImageRecorder_; }
+
+  bool startReplay(const common::ProcessImageRecording& recording, const uint64_t firstRow, const uint64_t numberOfRows) {
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    if (initlialized_) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Cannot replay a recording on a started bus.")
+      return false;
+    }
+    if (!recording.isOpen() || recording.getImageSize() > sizeof(ioMap_)) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] The recording is not open or its process image does not fit the IO map.")
+      return false;
+    }
+
+    // map the slaves to the ranges of the recorded process image, the IO map takes the place of the frames.
+    memset(ioMap_, 0, sizeof(ioMap_));
+    memset(ecatSlavelist_, 0, sizeof(ecatSlavelist_));
+    int slaveCount = 0;
+    for (const auto& column : recording.getColumns()) {
+      if (column.kind == static_cast<uint8_t>(common::ProcessImageColumnKind::Cycle)) {
+        continue;
+      }
+      if (column.slave == 0 || column.slave >= EC_MAXSLAVE) {
+        MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] The recording contains the invalid slave address " << column.slave)
+        return false;
+      }
+      ec_slavet& slave = ecatContext_.slavelist[column.slave];
+      uint8* image = reinterpret_cast<uint8*>(ioMap_) + column.rowOffset - sizeof(common::ProcessImageRowHeader);
+      if (column.kind == static_cast<uint8_t>(common::ProcessImageColumnKind::Outputs)) {
+        slave.outputs = image;
+        slave.Obytes = column.width;
+        slave.Obits = static_cast<uint16>(column.width * 8);
+      } else {
+        slave.inputs = image;
+        slave.Ibytes = column.width;
+        slave.Ibits = static_cast<uint16>(column.width * 8);
+      }
+      // the column is named after the slave, e.g. "Drive.inputs".
+      const std::string columnName(column.name, strnlen(column.name, sizeof(column.name)));
+      const std::string slaveName = columnName.substr(0, columnName.rfind('.'));
+      strncpy(slave.name, slaveName.c_str(), sizeof(slave.name) - 1);
+      slaveCount = std::max(slaveCount, static_cast<int>(column.slave));
+    }
+    *ecatContext_.slavecount = slaveCount;
+    for (const auto& slave : slaves_) {
+      if (slave->getAddress() == 0 || static_cast<int>(slave->getAddress()) > slaveCount || !pdoSizesMatchLocked(slave)) {
+        MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << slave->getName() << " at address " << slave->getAddress()
+                                                  << " does not match the recording.")
+        *ecatContext_.slavecount = 0;
+        return false;
+      }
+    }
+
+    const size_t nAddresses = static_cast<size_t>(slaveCount) + 1;
+    slaveStages_ = std::vector<std::atomic<SlaveStage>>(nAddresses);
+    for (size_t address = 1; address < nAddresses; address++) {
+      slaveStages_[address] = SlaveStage::Operational;
+    }
+    ioMapGroupSize_ = recording.getImageSize();
+    replayRow_ = std::min(firstRow, recording.getNumberOfRows());
+    replayEnd_ = numberOfRows == 0 ? recording.getNumberOfRows() : std::min(replayRow_ + numberOfRows, recording.getNumberOfRows());
+    hasDistributedClocks_ = replayRow_ < replayEnd_ && recording.getRowHeader(replayRow_).distributedClockTime != 0;
+    workingCounterTooLowCounter_ = 0;
+    sentProcessData_ = false;
+    replayRecording_ = &recording;
+    MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Replaying " << replayEnd_ - replayRow_ << " cycles of bus '"
+                                             << recording.getBusName() << "' with " << slaveCount << " slaves.")
+    return true;
+  }
+
+  void stopReplay() {
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    if (replayRecording_ == nullptr) {
+      return;
+    }
+    recordProcessImage_ = false;
+    replayRecording_ = nullptr;
+    slaveStages_.clear();
+    memset(ecatSlavelist_, 0, sizeof(ecatSlavelist_));
+    *ecatContext_.slavecount = 0;
+    ioMapGroupSize_ = 0;
+    hasDistributedClocks_ = false;
+  }
+
+  bool replayIsFinished() const { return replayRecording_ == nullptr || replayRow_ >= replayEnd_; }
+
+  void setTopologyRefresh(const unsigned int decimation) { topologyRefreshDecimation_ = decimation; }
+
+  std::vector<common::TopologyNode> getSegmentTopology() const {
+    std::lock_guard<std::mutex> lock(topologyMutex_);
+    return publishedTopology_;
+  }
+
+  int addCyclicRegisterRead(const uint16_t slave, const uint16_t address, const uint16_t length, const unsigned int decimation) {
+    if (!initlialized_ || slave > *ecatContext_.slavecount) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Cannot add a cyclic register read for slave " << slave
+                                                << ", the bus is not started or the slave does not exist.")
+      return -1;
+    }
+    const uint16_t stationAddress = slave == 0 ? 0 : ecatContext_.slavelist[slave].configadr;
+    const int handle = registerTable_.add(slave, stationAddress, address, length, decimation);
+    if (handle < 0) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Cannot add a cyclic read of register 0x" << std::hex << address << std::dec
+                                                << " with " << length << " bytes, the table is full or the length is invalid.")
+    }
+    return handle;
+  }
+
+  bool getCyclicRegister(const int handle, common::RegisterValue& value) const { return registerTable_.get(handle, value); }
+
+  bool addCyclicStatusRead(const common::StatusRegister statusRegister, const uint16_t slave, const unsigned int decimation) {
+    const common::StatusRegisterBlock block = common::StatusRegisterBlock::get(statusRegister);
+    return addCyclicRegisterRead(slave, block.address, block.length, decimation) >= 0;
+  }
+
+  bool addCyclicStatusReadForAllSlaves(const common::StatusRegister statusRegister, const unsigned int decimation) {
+    bool success = true;
+    for (const auto& slave : slaves_) {
+      success &= addCyclicStatusRead(statusRegister, static_cast<uint16_t>(slave->getAddress()), decimation);
+    }
+    return success;
+  }
+
+  bool getSlaveStatus(const uint16_t slave, common::SlaveStatus& status) const {
+    const auto getBlock = [this, slave](const common::StatusRegister statusRegister, common::RegisterValue& value) {
+      const common::StatusRegisterBlock block = common::StatusRegisterBlock::get(statusRegister);
+      return registerTable_.get(registerTable_.find(slave, block.address, block.length), value);
+    };
+    bool found = false;
+    if (getBlock(common::StatusRegister::AlStatus, status.alStatusRegister)) {
+      status.alStatus = status.alStatusRegister.get<uint16_t>(0);
+      status.alStatusCode = status.alStatusRegister.get<uint16_t>(4);
+      found = true;
+    }
+    if (getBlock(common::StatusRegister::DlStatus, status.dlStatusRegister)) {
+      status.dlStatus = status.dlStatusRegister.get<uint16_t>(0);
+      found = true;
+    }
+    found |= getBlock(common::StatusRegister::ErrorCounters, status.errorCounterRegisters);
+    return found;
+  }
+
+  // The broadcast read ORs the AL status of all slaves, it reads exactly operational only if every slave is operational.
+  bool cyclicStatusShowsAllOperational() const {
+    common::SlaveStatus status;
+    if (!getSlaveStatus(0, status) || status.alStatusRegister.cycle == 0) {
+      return false;
+    }
+    const common::RegisterValue& value = status.alStatusRegister;
+    const bool recent = registerCycle_.load(std::memory_order_relaxed) - value.cycle <= 2 * static_cast<uint64_t>(value.decimation);
+    return recent && value.workingCounter == *ecatContext_.slavecount && (status.alStatus & 0x1f) == EC_STATE_OPERATIONAL;
+  }
+
+  // Takes the place of ecx_receive_processdata(..) while replaying: the inputs, working counter and times come from the next row.
+  void receiveReplayLocked() {
+    const common::ProcessImageRowHeader row = replayRecording_->getRowHeader(replayRow_);
+    replayRecording_->getInputs(replayRow_, ioMap_);
+    replayRow_++;
+    wkc_ = row.workingCounter;
+    expectedWorkingCounter_ = row.expectedWorkingCounter;
+    ecatDcTime_ = row.distributedClockTime;
+    sendMonotonicTime_ = row.stamp;
+  }
+
+  void sendAttributionLocked() {
+    if (!attributionRequested_ || attributionFrameIndex_ >= 0) {
+      return;
+    }
+    attributionRequested_ = false;
+    const auto nAddresses = static_cast<uint16_t>(*ecatContext_.slavecount);
+    if (attributionCursor_ == 1) {
+      for (auto& result : attribution_) {
+        result = WorkingCounterFault();
+      }
+    }
+    int idx = -1;
+    int lastHeader = 0;
+    nSentAttributionDatagrams_ = 0;
+    for (; attributionCursor_ <= nAddresses; attributionCursor_++) {
+      const uint16_t address = attributionCursor_;
+      if (!slaveIsActive(address)) {
+        continue;
+      }
+      const ec_slavet& slave = ecatContext_.slavelist[address];
+      // the datagrams of a slave go into the same frame: one FPRD of the AL status and one logical datagram per FMMU of its sub-range.
+      // Groups with slaves that do not support LRW get an LRD for an input FMMU and an LWR for an output FMMU, as the process data does.
+      int length = EC_HEADERSIZE - EC_ELENGTHSIZE + alStatusLength_ + EC_WKCSIZE;
+      size_t nDatagrams = 1;
+      for (const auto& fmmu : slave.FMMU) {
+        if (isProcessDataFmmu(fmmu)) {
+          length += EC_HEADERSIZE - EC_ELENGTHSIZE + etohs(fmmu.LogLength) + EC_WKCSIZE;
+          nDatagrams++;
+        }
+      }
+      const int frameLength = idx < 0 ? ETH_HEADERSIZE + EC_ELENGTHSIZE : ecatContext_.port->txbuflength[idx];
+      if (nSentAttributionDatagrams_ + nDatagrams > sentAttributionDatagrams_.size() || frameLength + length > maxFrameLength_) {
+        if (idx < 0) {
+          // does not fit into a frame at all, not attributed.
+          continue;
+        }
+        // the next cycle continues with this slave.
+        break;
+      }
+      int offset = appendDatagramLocked(idx, lastHeader, EC_CMD_FPRD, slave.configadr, ECT_REG_ALSTAT, alStatusLength_, nullptr);
+      sentAttributionDatagrams_[nSentAttributionDatagrams_++] = {address, offset, alStatusLength_, 1, true};
+      const ec_groupt& group = ecatContext_.grouplist[slave.group];
+      for (const auto& fmmu : slave.FMMU) {
+        if (!isProcessDataFmmu(fmmu)) {
+          continue;
+        }
+        const uint32 logStart = etohl(fmmu.LogStart);
+        const uint16 logLength = etohs(fmmu.LogLength);
+        uint8 command = EC_CMD_LRW;
+        if (group.blockLRW != 0) {
+          command = fmmu.FMMUtype == 1 ? EC_CMD_LRD : EC_CMD_LWR;
+        }
+        // an LRW or LWR writes the same outputs as the process data frame of this cycle, an LRD carries no outputs.
+        offset = appendDatagramLocked(idx, lastHeader, command, LO_WORD(logStart), HI_WORD(logStart), logLength,
+                                      command == EC_CMD_LRD ? nullptr : group.outputs + (logStart - group.logstartaddr));
+        sentAttributionDatagrams_[nSentAttributionDatagrams_++] = {address, offset, logLength,
+                                                                   expectedLogicalWorkingCounter(command, logStart, logLength), false};
+      }
+    }
+    if (idx >= 0) {
+      ecx_outframe_red(ecatContext_.port, idx);
+      attributionFrameIndex_ = idx;
+    } else if (attributionCursor_ > nAddresses) {
+      // no active slave left to attribute.
+      publishAttribution();
+      attributionCursor_ = 1;
+    }
+  }
+
+  void receiveAttributionLocked() {
+    if (attributionFrameIndex_ < 0) {
+      return;
+    }
+    ecx_portt* port = ecatContext_.port;
+    const int idx = attributionFrameIndex_;
+    attributionFrameIndex_ = -1;
+    const bool received = ecx_waitinframe(port, idx, EC_TIMEOUTRET) > EC_NOFRAME;
+    for (size_t i = 0; i < nSentAttributionDatagrams_; i++) {
+      const SentAttributionDatagram& sent = sentAttributionDatagrams_[i];
+      uint16 workingCounter = 0;
+      if (received) {
+        memcpy(&workingCounter, &(port->rxbuf[idx][sent.offset + sent.length]), EC_WKCSIZE);
+        workingCounter = etohs(workingCounter);
+      }
+      WorkingCounterFault& result = attribution_[sent.address];
+      result.slave = sent.address;
+      if (sent.alStatus) {
+        result.answered = workingCounter == 1;
+        if (result.answered) {
+          memcpy(&result.alStatus, &(port->rxbuf[idx][sent.offset]), sizeof(result.alStatus));
+          memcpy(&result.alStatusCode, &(port->rxbuf[idx][sent.offset + 4]), sizeof(result.alStatusCode));
+          result.alStatus = etohs(result.alStatus);
+          result.alStatusCode = etohs(result.alStatusCode);
+        }
+      } else {
+        result.expectedWorkingCounter += sent.expectedWorkingCounter;
+        result.workingCounter += workingCounter;
+      }
+    }
+    ecx_setbufstat(port, idx, EC_BUF_EMPTY);
+    if (attributionCursor_ > *ecatContext_.slavecount) {
+      publishAttribution();
+      attributionCursor_ = 1;
+    }
+  }
+
+  void publishAttribution() {
+    std::unique_lock<std::mutex> lock(attributionMutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      // doBusMonitoring() is taking over the previous result, this one is dropped rather than blocking the cyclic thread.
+      return;
+    }
+    attributionFaults_.clear();
+    for (const auto& result : attribution_) {
+      if (result.slave == 0) {
+        continue;
+      }
+      const bool operational = (result.alStatus & 0x1f) == EC_STATE_OPERATIONAL;
+      if (result.workingCounter < result.expectedWorkingCounter || !result.answered || !operational) {
+        // attribution_ is sized to the bus, the capacity reserved at startup suffices.
+        attributionFaults_.push_back(result);
+        eventLog_.log(common::EventType::WorkingCounterFault, result.slave, result.alStatusCode, result.workingCounter,
+                      result.expectedWorkingCounter, result.answered ? result.alStatus : noAlStatus_);
+        MELO_RT_WARN("[soem_interface_rsl::{}] Slave {} caused the working counter drop: working counter {} of {}, AL status 0x{:04x}{}",
+                     name_, result.slave, result.workingCounter, result.expectedWorkingCounter, result.alStatus,
+                     result.answered ? "" : ", did not answer");
+      }
+    }
+    attributionPasses_++;
+  }
+
+  static bool isProcessDataFmmu(const ec_fmmut& fmmu) {
+    return fmmu.FMMUactive != 0 && fmmu.LogLength != 0 && (fmmu.FMMUtype == 1 || fmmu.FMMUtype == 2);
+  }
+
+  // Sum of the working counter contributions of the active slaves mapped into a logical range by a datagram. Slaves sharing bytes of the
+  // range, e.g. bit sized terminals, are all counted, a fault of one of them shows up at all of them.
+  int expectedLogicalWorkingCounter(const uint8 command, const uint32 logStart, const uint16 logLength) const {
+    int expected = 0;
+    for (uint16_t address = 1; address <= *ecatContext_.slavecount; address++) {
+      if (!slaveIsActive(address)) {
+        continue;
+      }
+      for (const auto& fmmu : ecatContext_.slavelist[address].FMMU) {
+        const uint32 start = etohl(fmmu.LogStart);
+        if (!isProcessDataFmmu(fmmu) || start >= logStart + logLength || logStart >= start + etohs(fmmu.LogLength)) {
+          continue;
+        }
+        if (command == EC_CMD_LRW) {
+          // a read FMMU counts once, a write FMMU twice.
+          expected += fmmu.FMMUtype;
+        } else if ((command == EC_CMD_LRD && fmmu.FMMUtype == 1) || (command == EC_CMD_LWR && fmmu.FMMUtype == 2)) {
+          expected++;
+        }
+      }
+    }
+    return expected;
+  }
+
+  void recordSlaveTiming(const size_t index, const common::SlaveTiming::Callback callback, const common::SlaveTiming::Stamp& start) {
+    common::SlaveTiming& timing = *slaveTimings_[index];
+    const int64_t wallTime = timing.stop(callback, start);
+    if (wallTime == 0) {
+      return;
+    }
+    const auto address = static_cast<uint16_t>(slaves_[index]->getAddress());
+    const auto wallTimeUs = static_cast<int32_t>(wallTime / 1000);
+    const auto budgetUs = static_cast<int32_t>(timing.getBudget() / 1000);
+    eventLog_.log(common::EventType::SlaveBudgetExceeded, address, static_cast<uint32_t>(callback), wallTimeUs, budgetUs);
+    MELO_RT_WARN_AGGREGATED("wall time [us]", wallTimeUs, "[soem_interface_rsl::{}] Slave {} exceeded its budget of {} us in {}: {} us",
+                            name_, address, budgetUs,
+                            callback == common::SlaveTiming::Callback::UpdateRead ? "updateRead()" : "updateWrite()", wallTimeUs);
+  }
+
+  void enableSlaveTiming(const double budget) {
+    // The timings are only allocated once, the cyclic thread may still be using them after disableSlaveTiming().
+    if (slaveTimings_.empty()) {
+      for (size_t i = 0; i < slaves_.size(); i++) {
+        slaveTimings_.push_back(std::make_unique<common::SlaveTiming>());
+      }
+    } else if (slaveTimings_.size() != slaves_.size()) {
+      MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] Slaves have been added after enabling the slave timing, they are not timed.")
+    }
+    for (auto& timing : slaveTimings_) {
+      timing->setBudget(static_cast<int64_t>(budget * 1e9));
+    }
+    slaveTimingEnabled_.store(slaveTimings_.size() == slaves_.size(), std::memory_order_release);
+  }
+
+  void disableSlaveTiming() { slaveTimingEnabled_.store(false, std::memory_order_release); }
+
+  bool setSlaveBudget(const uint16_t slave, const double budget) {
+    for (size_t i = 0; i < slaveTimings_.size(); i++) {
+      if (slaves_[i]->getAddress() == slave) {
+        slaveTimings_[i]->setBudget(static_cast<int64_t>(budget * 1e9));
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<common::SlaveTimingSnapshot> getSlaveTimings() const {
+    std::vector<common::SlaveTimingSnapshot> timings;
+    for (size_t i = 0; i < slaveTimings_.size(); i++) {
+      common::SlaveTimingSnapshot snapshot = slaveTimings_[i]->getSnapshot();
+      snapshot.address = slaves_[i]->getAddress();
+      snapshot.name = slaves_[i]->getName();
+      timings.push_back(std::move(snapshot));
+    }
+    return timings;
+  }
+
+  std::vector<common::SlaveTimingSnapshot> getTopSlaveTimings(const size_t count, const double fraction) const {
+    std::vector<common::SlaveTimingSnapshot> timings = getSlaveTimings();
+    const auto cost = [fraction](const common::SlaveTimingSnapshot& timing) {
+      return timing.readWallTime.getPercentile(fraction) + timing.writeWallTime.getPercentile(fraction);
+    };
+    std::stable_sort(timings.begin(), timings.end(),
+                     [&cost](const common::SlaveTimingSnapshot& a, const common::SlaveTimingSnapshot& b) { return cost(a) > cost(b); });
+    timings.resize(std::min(count, timings.size()));
+    return timings;
+  }
+
+  void shutdown() {
+    if (replayRecording_ != nullptr) {
+      // no port was opened.
+      stopProcessImageRecording();
+      stopReplay();
+      return;
+    }
+    if (initlialized_) {
+      {
+        std::lock_guard<std::mutex> guard(contextMutex_);
+        // Set the slaves to state Init.
+        if (*ecatContext_.slavecount > 0) {
+          setStateLocked(EC_STATE_INIT);
+          waitForStateLocked(EC_STATE_INIT);
+        }
+      }  // release the contextMutex_ in case slave wants to do low_level commands at shutdown.
+      for (auto& slave : slaves_) {
+        slave->shutdown();
+      }
+    }
+
+    // Close the port.
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    if (ecatContext_.port != nullptr) {
+      MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Closing socket ...");
+      ecx_close(&ecatContext_);
+      // Sleep to make sure the socket is closed, because ecx_close is non-blocking.
+      soem_interface_rsl::threadSleep(0.5);
+    }
+    initlialized_ = false;
+  }
+
+  void setState(const uint16_t state, const uint16_t slave = 0) {
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    setStateLocked(state, slave);
+  }
+
+  bool waitForState(const uint16_t state, const uint16_t slave = 0, const unsigned int maxRetries = 20) {
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    return waitForStateLocked(state, slave, maxRetries);
+  }
+
+  ETHERCAT_SM_STATE getEthercatState(const uint16_t slave = 0) {
+    uint16_t stateRaw = getState(slave);
+    // check if Error
+    if ((stateRaw & 0xf0) == EC_STATE_ERROR) {
+      return ETHERCAT_SM_STATE::ERROR;
+    }
+    switch (stateRaw & 0x0f) {
+      case EC_STATE_INIT:
+        return ETHERCAT_SM_STATE::INIT;
+      case EC_STATE_BOOT:
+        return ETHERCAT_SM_STATE::BOOT;
+      case EC_STATE_PRE_OP:
+        return ETHERCAT_SM_STATE::PRE_OP;
+      case EC_STATE_SAFE_OP:
+        return ETHERCAT_SM_STATE::SAFE_OP;
+      case EC_STATE_OPERATIONAL:
+        return ETHERCAT_SM_STATE::OPERATIONAL;
+      default:
+        return ETHERCAT_SM_STATE::NONE;  // should not happen.
+    }
+    return ETHERCAT_SM_STATE::NONE;
+  }
+
+  bool busIsOk() const { return workingCounterTooLowCounter_ < maxWorkingCounterTooLow_; }
+
+  bool doBusMonitoring(bool logErrorCounterForDiagnosis) {
+    if (!initlialized_) {
+      return false;
+    }
+    bool allFine = true;
+    busDiagnosisLog_.fullyUpdated = false;
+    bool attributionUpdated = false;
+    {
+      std::lock_guard<std::mutex> guard(attributionMutex_);
+      if (busDiagnosisLog_.workingCounterAttributions != attributionPasses_) {
+        busDiagnosisLog_.workingCounterFaults = attributionFaults_;
+        busDiagnosisLog_.workingCounterAttributions = attributionPasses_;
+        attributionUpdated = true;
+      }
+    }
+    BusDiagState nextBusDiagState{BusDiagState::StateReading};
+    MELO_DEBUG_STREAM("[DriveManager::DoBusMonitoring::" << name_ << "] Running Bus Monitoring/Diagnosis")
+
+    if (busDiagState_ == BusDiagState::StateReading) {
+      if (logErrorCounterForDiagnosis) {
+        nextBusDiagState = BusDiagState::CounterReading;
+      }
+      // read all the states from all slaves.
+      MELO_DEBUG_STREAM("[DriveManager::DoBusMonitoring::" << name_ << "] Running Bus Monitoring/Diagnosis State/AlstatusCode")
+
+      // one datagram iff all slaves in the same state, otherwise one datagram per slave. None if the cyclic frames read the states.
+      const int lowestSlaveState = cyclicStatusShowsAllOperational() ? EC_STATE_OPERATIONAL : getState(0);
+
+      // can we do more than looking on the state machine? error counters would be interessting but needs very raw register reads, but
+      // possible.
+      std::lock_guard<std::mutex> guard(contextMutex_);
+      if ((lowestSlaveState & 0x0f) < EC_STATE_OPERATIONAL) {  // if ECAT Error bus state is e.g. 0x14 = 0x10 (error) + 0x04 (safeOP)
+        MELO_WARN_STREAM("[EthercatBus::BusMonitoring::" << name_ << "] No all slaves in EC_STATE_OPERATIONAL")
+        frameCapture_.trigger(common::FrameCapture::Trigger::StateLoss);
+        for (const auto& slave : slaves_) {
           MELO_WARN_STREAM("[EthercatBus::BusMonitoring::"
                            << name_ << "] Slave: " << slave->getName()
                            << " in state: " << EthercatBusBase::getStateString(ecatContext_.slavelist[slave->getAddress()].state))
@@ -402,9 +1234,7 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
               ecatContext_.slavelist[slave->getAddress()].islost = TRUE;
               MELO_ERROR_STREAM("[EthercatBus::BusMonitoring] Slave: "
                                 << slave->getName() << " no valid state read - slave probably lost - check your cables ;-) !")
-              // todo  Trying to recover the lost slave. !NOT IMPLEMENTED! example: in soem_rsl simple_test.c
-              // slave (sdks) would require an optional virtual method, something like: slave->recover() in case they loose connection.
-              // (could fix partially shacky cables in software..)
+              // the recovery of lost slaves is done by stepSlaveRecovery().
             }
           }
         }
@@ -414,186 +1244,900 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
 
     // only reached if errorCounterDiagnosis enabled.
     if (busDiagState_ == BusDiagState::CounterReading) {
-      MELO_DEBUG_STREAM(
-          "[DriveManager::DoBusMonitoring::" << name_ << "] Running Bus Monitoring/Diagnosis counter slave no: " << busDiagOfCurrentSlave_)
+      MELO_DEBUG_STREAM("[DriveManager::DoBusMonitoring::" << name_ << "] Running Bus Monitoring/Diagnosis error counters")
       nextBusDiagState = BusDiagState::StateReading;
-      auto& selectedSlave = slaves_[busDiagOfCurrentSlave_];
-      // Reading from registers: e.g. ECT_REG_RXERR, addr_0x0300 - 0x0307 (check Ethercat Specification ETG1000.4 for details)
-      // one frame per slave.( BRD call would OR together the error counters, therefore for exact number one frame per slave required.)
-      // we therefore continously update our saved values by mixing in a single datagram per call to this function and sweeping over the
-      // slaves.
-      std::byte rawData[REG::ERROR_COUNTERS_LIST.memorySize()];
-      memset(rawData, 0xbe, REG::ERROR_COUNTERS_LIST.memorySize());
+      busDiagnosisLog_.fullyUpdated = sweepErrorCounters();
+    }
+    busDiagnosisLog_.fullyUpdated |= attributionUpdated;
+    busDiagState_ = nextBusDiagState;
+    return allFine;
+  }
+
+  bool sweepErrorCounters() {
+    if (!initlialized_) {
+      return false;
+    }
+    using Block = std::array<uint8_t, common::ErrorCounterDiagnosis::blockLength>;
+    const uint16_t nAddresses = static_cast<uint16_t>(*ecatContext_.slavecount);
+    // Reading from registers 0x0300 - 0x0313 (check Ethercat Specification ETG1000.4 for details). A BRD call would OR together the error
+    // counters, therefore one FPRD datagram per slave, packed into as few frames as possible (46 slaves per frame).
+    std::vector<Block> blocks(static_cast<size_t>(nAddresses) + 1);
+    std::vector<bool> read(static_cast<size_t>(nAddresses) + 1, false);
+    std::vector<uint16_t> clear;
+    {
       std::lock_guard<std::mutex> guard(contextMutex_);
-      if (ecx_FPRD(ecatContext_.port, ecatContext_.slavelist[selectedSlave->getAddress()].configadr,
-                   static_cast<uint16_t>(REG::ERROR_COUNTERS::FRAME_ERROR_PORT0_ADDR), REG::ERROR_COUNTERS_LIST.memorySize(), rawData,
-                   EC_TIMEOUTRET3)) {
-        size_t currentRegNo{0};
-        for (const auto& reg : REG::ERROR_COUNTERS_LIST) {
-          uint8_t value = REG::ERROR_COUNTERS_LIST.getValueFromRawAs<uint8_t>(reg.addrEnum, rawData, REG::ERROR_COUNTERS_LIST.memorySize());
-          if (busDiagnosisLog_.errorCounters_[busDiagOfCurrentSlave_][currentRegNo].previousValue > value) {
-            // we had an overflow, (or multiple..) lets assume it was one, we just have to diagnose fast enough..
-            busDiagnosisLog_.errorCounters_[busDiagOfCurrentSlave_][currentRegNo].fullValue +=
-                (255 - busDiagnosisLog_.errorCounters_[busDiagOfCurrentSlave_][currentRegNo].previousValue) + value;
-          } else {
-            busDiagnosisLog_.errorCounters_[busDiagOfCurrentSlave_][currentRegNo].fullValue += value;
+      // first slave, frame index and data offset of the frames in flight.
+      std::vector<std::pair<uint16_t, int>> frames;
+      std::vector<int> offsets(static_cast<size_t>(nAddresses) + 1, 0);
+      int idx = -1;
+      int lastHeader = 0;
+      for (uint16_t slave = 1; slave <= nAddresses; slave++) {
+        int offset = appendDatagramLocked(idx, lastHeader, EC_CMD_FPRD, ecatContext_.slavelist[slave].configadr,
+                                          common::ErrorCounterDiagnosis::blockAddress, common::ErrorCounterDiagnosis::blockLength, nullptr);
+        if (offset < 0) {
+          ecx_outframe_red(ecatContext_.port, idx);
+          idx = -1;
+          offset = appendDatagramLocked(idx, lastHeader, EC_CMD_FPRD, ecatContext_.slavelist[slave].configadr,
+                                        common::ErrorCounterDiagnosis::blockAddress, common::ErrorCounterDiagnosis::blockLength, nullptr);
+        }
+        if (offset == EC_HEADERSIZE) {
+          frames.emplace_back(slave, idx);
+        }
+        offsets[slave] = offset;
+      }
+      if (idx >= 0) {
+        ecx_outframe_red(ecatContext_.port, idx);
+      }
+      const double time = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      for (size_t f = 0; f < frames.size(); f++) {
+        const int frameIndex = frames[f].second;
+        const uint16_t end = f + 1 < frames.size() ? frames[f + 1].first : static_cast<uint16_t>(nAddresses + 1);
+        if (ecx_waitinframe(ecatContext_.port, frameIndex, EC_TIMEOUTRET3) > EC_NOFRAME) {
+          const uint8_t* rx = ecatContext_.port->rxbuf[frameIndex];
+          for (uint16_t slave = frames[f].first; slave < end; slave++) {
+            uint16 workingCounter = 0;
+            memcpy(&workingCounter, rx + offsets[slave] + common::ErrorCounterDiagnosis::blockLength, EC_WKCSIZE);
+            if (etohs(workingCounter) == 1) {
+              memcpy(blocks[slave].data(), rx + offsets[slave], common::ErrorCounterDiagnosis::blockLength);
+              read[slave] = true;
+              if (errorCounterDiagnosis_.update(slave, blocks[slave].data(), time)) {
+                clear.push_back(slave);
+              }
+            }
           }
-          currentRegNo++;
         }
-      } else {
-        MELO_WARN_STREAM(
-            "[soem_interface_rsl::BusMonitoring::" << name_ << "] Could not read Error counters for slave: " << selectedSlave->getName())
+        ecx_setbufstat(ecatContext_.port, frameIndex, EC_BUF_EMPTY);
       }
-      busDiagOfCurrentSlave_++;
-      if (busDiagOfCurrentSlave_ >= nSlaves_) {
-        busDiagOfCurrentSlave_ = 0;
-        busDiagnosisLog_.fullyUpdated = true;
+    }
+
+    // the counters saturate at 0xff, clear them before. Errors counted between the read and the clear are lost.
+    static const Block zeros{};
+    for (size_t i = 0; i < clear.size();) {
+      std::lock_guard<std::mutex> guard(contextMutex_);
+      int idx = -1;
+      int lastHeader = 0;
+      std::vector<std::pair<uint16_t, int>> clears;
+      for (; i < clear.size(); i++) {
+        const int offset = appendDatagramLocked(idx, lastHeader, EC_CMD_FPWR, ecatContext_.slavelist[clear[i]].configadr,
+                                                common::ErrorCounterDiagnosis::blockAddress, common::ErrorCounterDiagnosis::blockLength,
+                                                const_cast<uint8_t*>(zeros.data()));
+        if (offset < 0) {
+          break;
+        }
+        clears.emplace_back(clear[i], offset);
       }
+      if (ecx_srconfirm(ecatContext_.port, idx, EC_TIMEOUTRET3) > EC_NOFRAME) {
+        for (const auto& cleared : clears) {
+          uint16 workingCounter = 0;
+          const int offset = cleared.second + common::ErrorCounterDiagnosis::blockLength;
+          memcpy(&workingCounter, &(ecatContext_.port->rxbuf[idx][offset]), EC_WKCSIZE);
+          if (etohs(workingCounter) == 1) {
+            errorCounterDiagnosis_.cleared(cleared.first);
+            blocks[cleared.first].fill(0);
+          }
+        }
+      }
+      ecx_setbufstat(ecatContext_.port, idx, EC_BUF_EMPTY);
     }
-    busDiagState_ = nextBusDiagState;
-    return allFine;
+
+    // raw counters per register of the slaves with a driver, see getBusDiagnosisLog(..).
+    bool allRead = true;
+    for (size_t i = 0; i < slaves_.size(); i++) {
+      const auto address = static_cast<uint16_t>(slaves_[i]->getAddress());
+      if (address > nAddresses || !read[address]) {
+        MELO_WARN_STREAM("[soem_interface_rsl::BusMonitoring::" << name_ << "] Could not read Error counters for slave: "
+                                                                << slaves_[i]->getName())
+        allRead = false;
+        continue;
+      }
+      size_t currentRegNo{0};
+      for (const auto& reg : REG::ERROR_COUNTERS_LIST) {
+        // the counters only count up and saturate, a lower value means they have been cleared.
+        const uint8_t value = blocks[address][REG::ERROR_COUNTERS_LIST.blockOffsetByAddr(reg.addrEnum)];
+        REG::Counter& counter = busDiagnosisLog_.errorCounters_[i][currentRegNo++];
+        counter.fullValue += value >= counter.previousValue ? value - counter.previousValue : value;
+        counter.previousValue = value;
+      }
+    }
+    return allRead;
+  }
+
+  bool stepSlaveRecovery() {
+    if (!initlialized_ || stagedStartup_ || slaveStages_.size() < 2) {
+      return true;
+    }
+
+    const auto sliceEnd = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                                 std::chrono::duration<double>(recoveryTimeSlice_));
+    // a slave dropping out lowers the working counter, only then the states of the active slaves are checked.
+    const bool lookForDroppedSlaves = workingCounterTooLowCounter_ > 0;
+    const uint16_t nAddresses = static_cast<uint16_t>(slaveStages_.size() - 1);
+    for (uint16_t i = 0; i < nAddresses && std::chrono::steady_clock::now() < sliceEnd; i++) {
+      const uint16_t address = recoveryCursor_;
+      recoveryCursor_ = recoveryCursor_ % nAddresses + 1;
+      const SlaveStage stage = slaveStages_[address].load();
+      if (stage == SlaveStage::Operational && lookForDroppedSlaves) {
+        std::lock_guard<std::mutex> guard(contextMutex_);
+        const uint16_t state = readStateLocked(address);
+        if (state != EC_STATE_OPERATIONAL) {
+          frameCapture_.trigger(common::FrameCapture::Trigger::StateLoss);
+          MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << " dropped out in state "
+                                                   << EthercatBusBase::getStateString(state)
+                                                   << ", it is excluded from the cyclic exchange during the recovery.")
+          slaveStages_[address] = SlaveStage::Recovering;
+          recoverySteps_[address] = RecoveryStep::CheckState;
+          updateExpectedWorkingCounter();
+        }
+      } else if (stage == SlaveStage::Recovering) {
+        stepSlaveRecovery(address);
+      }
+    }
+
+    for (size_t address = 1; address < slaveStages_.size(); address++) {
+      if (slaveStages_[address].load(std::memory_order_relaxed) == SlaveStage::Recovering) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool getBusDiagnosisLog(BusDiagnosisLog& busDiagnosisLogOut) {
+    if (busDiagnosisLog_.fullyUpdated) {
+      // is called in the update loop, therefore not thread safe implemented here..
+      busDiagnosisLogOut = busDiagnosisLog_;
+      return true;
+    }
+    return false;
+  }
+
+  const common::ErrorCounterDiagnosis& getErrorCounterDiagnosis() const { return errorCounterDiagnosis_; }
+
+  void setWorkingCounterAttribution(const bool enable) { attributionEnabled_ = enable; }
+
+  void setErrorCounterDiagnosisOptions(const common::ErrorCounterDiagnosis::Options& options) {
+    errorCounterDiagnosis_.setOptions(options);
+  }
+
+  bool openEventLog(const std::string& path, uint64_t capacity) { return eventLog_.open(path, capacity, name_); }
+
+  common::EventLog& getEventLog() { return eventLog_; }
+
+  void syncDistributedClock0(const uint16_t slave, const bool activate, const double cycleTime, const double cycleShift) {
+    // todo verify!
+    MELO_INFO_STREAM("Bus '" << name_ << "', slave " << slave << ":  " << (activate ? "Activating" : "Deactivating")
+                             << " distributed clock synchronization...");
+
+    {
+      std::lock_guard<std::mutex> guard(contextMutex_);
+      ecx_dcsync0(&ecatContext_, slave, static_cast<uint8_t>(activate), static_cast<uint32_t>(cycleTime * 1e9),
+                  static_cast<int32_t>(1e9 * cycleShift));
+    }
+
+    MELO_INFO_STREAM("Bus '" << name_ << "', slave " << slave << ":  " << (activate ? "Activated" : "Deactivated")
+                             << " distributed clock synchronization.");
+  }
+
+  void syncDistributedClock01(const uint16_t slave, const bool activate, const double cycleTime0, const double cycleTime1,
+                              const double cycleShift) {
+    MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << slave << ": " << (activate ? "Activating" : "Deactivating")
+                                             << " SYNC0/SYNC1, cycle time: " << cycleTime0 << " s, SYNC1 delay: " << cycleTime1
+                                             << " s, shift: " << cycleShift << " s.")
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    ecx_dcsync01(&ecatContext_, slave, static_cast<uint8_t>(activate), static_cast<uint32_t>(cycleTime0 * 1e9),
+                 static_cast<uint32_t>(cycleTime1 * 1e9), static_cast<int32_t>(1e9 * cycleShift));
+  }
+
+  bool hasDistributedClocks() const { return hasDistributedClocks_; }
+
+  bool slaveHasDistributedClock(const uint16_t slave) const {
+    return slave > 0 && static_cast<int>(slave) <= ecatSlavecount_ && ecatContext_.slavelist[slave].hasdc != FALSE;
+  }
+
+  double getMaxPropagationDelay() const {
+    int32_t maxDelay = 0;
+    for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+      if (ecatContext_.slavelist[slave].hasdc) {
+        maxDelay = std::max(maxDelay, ecatContext_.slavelist[slave].pdelay);
+      }
+    }
+    return 1e-9 * static_cast<double>(maxDelay);
+  }
+
+  uint16_t getReferenceClock() const { return hasDistributedClocks_ ? ecatContext_.slavelist[0].DCnext : 0; }
+
+  int64_t getDistributedClockTime() const { return distributedClockTime_.load(std::memory_order_relaxed); }
+
+  int64_t getUpdateReadMonotonicTime() const { return updateReadMonotonicTime_.load(std::memory_order_relaxed); }
+
+  const common::DistributedClockMapping& getDistributedClockMapping() const { return distributedClockMapping_; }
+
+  EthercatBusBase::PdoSizePair getHardwarePdoSizes(const uint16_t slave) {
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    return std::make_pair(ecatContext_.slavelist[slave].Obytes, ecatContext_.slavelist[slave].Ibytes);
+  }
+
+  EthercatBusBase::PdoSizeMap getHardwarePdoSizes() {
+    EthercatBusBase::PdoSizeMap pdoMap;
+
+    for (const auto& slave : slaves_) {
+      pdoMap.insert(std::make_pair(slave->getName(), getHardwarePdoSizes(slave->getAddress())));
+    }
+    return pdoMap;
+  }
+
+  bool sdoWrite(const uint16_t slave, const uint16_t index, const uint8_t subindex, const bool completeAccess, int size, void* buf) {
+    if (replayRecording_ != nullptr) {
+      MELO_RT_ERROR("[soem_interface_rsl::{}] Slave {}: SDOs are not available while replaying a recording.", name_, slave);
+      return false;
+    }
+    int wkc = 0;
+    {
+      assert(static_cast<int>(slave) <= *ecatContext_.slavecount);
+      std::lock_guard<std::mutex> guard(contextMutex_);
+      wkc = ecx_SDOwrite(&ecatContext_, slave, index, subindex, static_cast<boolean>(completeAccess), size, buf, EC_TIMEOUTRXM);
+    }
+    if (wkc <= 0) {
+      MELO_RT_ERROR("Slave {}: Working counter too low ({}) for writing SDO (ID: 0x{:04x}, SID 0x{:02x}).", slave, wkc, index, subindex);
+      checkForSdoErrors(slave, index);
+      logAlStatusCode(slave);
+      return false;
+    }
+    return true;
+  }
+
+  bool sdoRead(const uint16_t slave, const uint16_t index, const uint8_t subindex, const bool completeAccess, int size, void* buf) {
+    if (replayRecording_ != nullptr) {
+      MELO_RT_ERROR("[soem_interface_rsl::{}] Slave {}: SDOs are not available while replaying a recording.", name_, slave);
+      return false;
+    }
+    int requestedSize = size;
+    int wkc = 0;
+    {
+      assert(static_cast<int>(slave) <= *ecatContext_.slavecount);
+      std::lock_guard<std::mutex> guard(contextMutex_);
+      wkc = ecx_SDOread(&ecatContext_, slave, index, subindex, static_cast<boolean>(completeAccess), &size, buf, EC_TIMEOUTRXM);
+    }
+    if (wkc <= 0) {
+      MELO_RT_ERROR("Slave {}: Working counter too low ({}) for reading SDO (ID: 0x{:04x}, SID 0x{:02x}).", slave, wkc, index, subindex);
+      checkForSdoErrors(slave, index);
+      logAlStatusCode(slave);
+      return false;
+    }
+    if (size != requestedSize) {
+      MELO_RT_ERROR("Slave {}: Size mismatch (expected {} bytes, read {} bytes) for reading SDO (ID: 0x{:04x}, SID 0x{:02x}).", slave,
+                    requestedSize, size, index, subindex);
+      return false;
+    }
+    return true;
+  }
+
+  int sdoReadSize(const uint16_t slave, const uint16_t index, const uint8_t subindex, const bool completeAccess, int size, void* buf) {
+    if (replayRecording_ != nullptr) {
+      MELO_RT_ERROR("[soem_interface_rsl::{}] Slave {}: SDOs are not available while replaying a recording.", name_, slave);
+      return 0;
+    }
+    int wkc = 0;
+    {
+      assert(static_cast<int>(slave) <= *ecatContext_.slavecount);
+      std::lock_guard<std::mutex> guard(contextMutex_);
+      wkc = ecx_SDOread(&ecatContext_, slave, index, subindex, static_cast<boolean>(completeAccess), &size, buf, EC_TIMEOUTRXM);
+    }
+    if (wkc <= 0) {
+      MELO_RT_ERROR("Slave {}: Working counter too low ({}) for reading SDO (ID: 0x{:04x}, SID 0x{:02x}).", slave, wkc, index, subindex);
+      checkForSdoErrors(slave, index);
+      logAlStatusCode(slave);
+      return 0;
+    }
+    return size;
+  }
+
+  void readTxPdo(const uint16_t slave, int size, void* buf) const {
+    assert(static_cast<int>(slave) <= *ecatContext_.slavecount);
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    assert(size == (int)ecatContext_.slavelist[slave].Ibytes);
+    memcpy(buf, ecatContext_.slavelist[slave].inputs, size);
+  }
+
+  void writeRxPdo(const uint16_t slave, int size, const void* buf) {
+    assert(static_cast<int>(slave) <= *ecatContext_.slavecount);
+    std::lock_guard<std::mutex> guard(contextMutex_);
+    assert((int)ecatContext_.slavelist[slave].Obytes == size);
+    memcpy(ecatContext_.slavelist[slave].outputs, buf, size);
+  }
+
+ private:
+  //! PDO assignment read by readPdoAssignment(..).
+  struct PdoAssignment {
+    //! False if the slave keeps the sizes of its previous mapping.
+    bool fromCoe{false};
+    int outputBits{0};
+    int inputBits{0};
+    std::array<uint8_t, EC_MAXSM> syncManagerTypes{};
+    std::array<int, EC_MAXSM> syncManagerBits{};
+  };
+  //! Mapping of a slave before remapSlave(..) changed it, restored if the remap fails.
+  struct PreviousMapping {
+    ec_slavet slave{};
+    ec_groupt remapGroup{};
+    uint16_t remappedSlave{0};
+    int wkcContribution{0};
+  };
+
+  /*!
+   * Opens the socket, discovers and configures the slaves and requests PRE_OP.
+   * @return True if successful.
+   */
+  bool initializeCommunicationLocked(std::atomic<bool>& abortFlag, int maxDiscoverRetries) {
+    /*
+     * Followed by start of the application we need to set up the NIC to be used as
+     * EtherCAT Ethernet interface. In a simple setup we call ec_init(ifname) and if
+     * soem_rsl comes with support for cable redundancy we call ec_init_redundant that
+     * will open a second port as backup. You can send NULL as ifname if you have a
+     * dedicated NIC selected in the nicdrv.c. It returns >0 if succeeded.
+     */
+
+    if (!busIsAvailable()) {
+      MELO_ERROR_STREAM("[" << name_ << "] "
+                            << "Bus is not available.");
+      EthercatBusBase::printAvailableBusses();
+      return false;
+    }
+
+    if (ecx_init(&ecatContext_, name_.c_str()) <= 0) {
+      MELO_ERROR_STREAM("[" << name_ << "] "
+                            << "No socket connection. Execute as root.");
+      return false;
+    }
+    if (frameCapture_.isRunning()) {
+      ecx_setcapturehook(ecatContext_.port, &common::FrameCapture::hook, &frameCapture_);
+    }
+    for (int retry = 0; retry <= maxDiscoverRetries; retry++) {
+      if (abortFlag) {
+        MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] "
+                                                 << "Shutdown during waiting for slaves.");
+        ecx_close(&ecatContext_);
+        return false;  // avoid that executation continues.
+      }
+      if (ecx_detect_slaves(&ecatContext_) >= static_cast<int>(slaves_.size())) {
+        // on some of the older (rsl) anydrives there seems to be a short race between bus is responsive and slave is fully ready...
+        // so give them this 1 sec to be fully ready to be started...
+        soem_interface_rsl::threadSleep(1.0);
+        break;
+      }
+      if (retry == maxDiscoverRetries) {
+        MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
+                                                  << "No slaves have been found.");
+        ecx_close(&ecatContext_);
+        return false;
+      }
+      // Sleep and retry.
+      soem_interface_rsl::threadSleep(ecatConfigRetrySleep_);
+      MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] No slaves have been found, retrying " << retry + 1 << "/"
+                                               << maxDiscoverRetries << " ...");
+    }
+
+    // this should no work cleanly, since we're sure that all slaves are started.
+    if (ecx_config_init(&ecatContext_, FALSE) < static_cast<int>(slaves_.size())) {
+      ecx_close(&ecatContext_);
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
+                                                << "No slaves have been found.");
+      return false;
+    }
+
+    int nSlaves = *ecatContext_.slavecount;
+    // Print the slaves which have been detected.
+    MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] The following " << nSlaves << " slaves have been found and configured:");
+    for (int slave = 1; slave <= nSlaves; slave++) {
+      MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Address: " << slave << " - Name: '"
+                                               << std::string(ecatContext_.slavelist[slave].name) << "'");
+    }
+
+    // Check if the given slave addresses are valid.
+    bool slaveAddressesAreOk = true;
+    for (const auto& slave : slaves_) {
+      auto address = static_cast<int>(slave->getAddress());
+      if (address == 0) {
+        MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
+                                                  << "Slave '" << slave->getName() << "': Invalid address " << address << ".");
+        slaveAddressesAreOk = false;
+      }
+      if (address > nSlaves) {
+        MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
+                                                  << "Slave '" << slave->getName() << "': Invalid address " << address << ", "
+                                                  << "only " << nSlaves << " slave(s) found.");
+        slaveAddressesAreOk = false;
+      }
+    }
+    if (!slaveAddressesAreOk) {
+      ecx_close(&ecatContext_);
+      return false;
+    }
+
+    // Disable symmetrical transfers.
+    ecatContext_.grouplist[0].blockLRW = 1;
+
+    // Measure the propagation delays and align the clocks of the DC capable slaves, the first of them is the reference clock. From now
+    // on every process data frame reads the system time of the reference clock.
+    hasDistributedClocks_ = ecx_configdc(&ecatContext_) != FALSE;
+    distributedClockTime_ = 0;
+    updateReadMonotonicTime_ = 0;
+    distributedClockMapping_.reset();
+    if (hasDistributedClocks_) {
+      MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Distributed clocks configured, reference clock: slave "
+                                               << ecatContext_.slavelist[0].DCnext)
+    }
+    buildSegmentTopology();
+
+    // some slave might require SAFE_OP during setup...
+    busDiagnosisLog_.errorCounters_.resize(slaves_.size());
+    errorCounterDiagnosis_.reset(static_cast<uint16_t>(nSlaves));
+    nSlaves_ = slaves_.size();
+    initlialized_ = true;
+    setStateLocked(EC_STATE_PRE_OP);
+    waitForStateLocked(EC_STATE_PRE_OP, 0);
+    return true;
+  }
+
+  /*!
+   * Maps the process image of all slaves and checks the PDO sizes.
+   * @param sizeCheck perform a check of the Rx and Tx Pdo sizes defined in the PdoInfo oject of the slaves
+   * @return True if successful.
+   */
+  bool configureIoMapLocked(const bool sizeCheck) {
+    // Set up the communication IO mapping.
+    const int ioMapSize = ecx_config_map_group(&ecatContext_, &ioMap_, 0);
+    MELO_DEBUG_STREAM("[soem_interface_rsl::" << name_ << "] Configured ioMap with size: " << ioMapSize)
+    ioMapGroupSize_ = static_cast<size_t>(ioMapSize);
+    remappedSlave_ = 0;
+    remapGroupActive_ = false;
+
+    // Check if the size of the IO mapping fits our slaves.
+    bool ioMapIsOk = true;
+    // do this check only if 'sizeCheck' is true
+    if (sizeCheck) {
+      for (const auto& slave : slaves_) {
+        ioMapIsOk &= pdoSizesMatchLocked(slave);
+      }
+    }
+    if (!ioMapIsOk) {
+      return false;
+    }
+
+    // Initialize the memory with zeroes.
+    for (int slave = 1; slave <= *ecatContext_.slavecount; slave++) {
+      memset(ecatContext_.slavelist[slave].inputs, 0, ecatContext_.slavelist[slave].Ibytes);
+      memset(ecatContext_.slavelist[slave].outputs, 0, ecatContext_.slavelist[slave].Obytes);
+    }
+
+    // Working counter contribution of every slave: LRW (or LWR emulating it) counts an output twice, an input once.
+    // This is the per slave share of grouplist[0].outputsWKC * 2 + grouplist[0].inputsWKC.
+    const size_t nAddresses = static_cast<size_t>(*ecatContext_.slavecount) + 1;
+    slaveStages_ = std::vector<std::atomic<SlaveStage>>(nAddresses);
+    stageDeadlines_.assign(nAddresses, std::chrono::steady_clock::time_point{});
+    recoverySteps_.assign(nAddresses, RecoveryStep::CheckState);
+    recoveryCursor_ = 1;
+    slaveWkcContribution_.assign(nAddresses, 0);
+    attribution_.assign(nAddresses, WorkingCounterFault());
+    attributionFaults_.reserve(nAddresses);
+    attributionCursor_ = 1;
+    for (size_t address = 1; address < nAddresses; address++) {
+      slaveWkcContribution_[address] =
+          (ecatContext_.slavelist[address].Obits > 0 ? 2 : 0) + (ecatContext_.slavelist[address].Ibits > 0 ? 1 : 0);
+    }
+
+    workingCounterTooLowCounter_ = 0;
+    return true;
+  }
+
+  /*!
+   * Compares the PDO sizes the slave object expects with the ones mapped for its address.
+   * @return True if the sizes match.
+   */
+  bool pdoSizesMatchLocked(const EthercatSlaveBasePtr& slave) const {
+    bool sizesMatch = true;
+    const EthercatSlaveBase::PdoInfo pdoInfo = slave->getCurrentPdoInfo();
+    if (pdoInfo.rxPdoSize_ != ecatContext_.slavelist[slave->getAddress()].Obytes) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
+                                                << "RxPDO size mismatch: The slave '" << slave->getName() << "' expects a size of "
+                                                << pdoInfo.rxPdoSize_ << " bytes but the slave found at its address " << slave->getAddress()
+                                                << " requests " << ecatContext_.slavelist[slave->getAddress()].Obytes << " bytes).");
+      sizesMatch = false;
+    }
+    if (pdoInfo.txPdoSize_ != ecatContext_.slavelist[slave->getAddress()].Ibytes) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] "
+                                                << "TxPDO size mismatch: The slave '" << slave->getName() << "' expects a size of "
+                                                << pdoInfo.txPdoSize_ << " bytes but the slave found at its address " << slave->getAddress()
+                                                << " requests " << ecatContext_.slavelist[slave->getAddress()].Ibytes << " bytes).");
+      sizesMatch = false;
+    }
+    return sizesMatch;
+  }
+
+  //! Disables all FMMUs of a slave that were programmed by a previous mapping, the FMMU registers are written with a single datagram.
+  void clearSlaveMappingLocked(const uint16_t address) {
+    ec_slavet& slave = ecatContext_.slavelist[address];
+    if (slave.FMMUunused > 0) {
+      std::array<ec_fmmut, EC_MAXFMMU> disabledFmmus{};
+      ecx_FPWR(ecatContext_.port, slave.configadr, ECT_REG_FMMU0, static_cast<uint16_t>(sizeof(ec_fmmut) * slave.FMMUunused),
+               disabledFmmus.data(), EC_TIMEOUTRET3);
+    }
+    memset(slave.FMMU, 0, sizeof(slave.FMMU));
+    slave.FMMUunused = 0;
+    slave.outputs = nullptr;
+    slave.inputs = nullptr;
+    slave.Obytes = 0;
+    slave.Ibytes = 0;
+  }
+
+  /*!
+   * Reads the PDO assignment of a slave in PRE_OP like ecx_readPDOmap(..) does, but with the context locked for one SDO at a time.
+   * Slaves from the config list and slaves without CoE keep their previous sizes, their mapping cannot be changed by SDOs.
+   * @return False if an SDO failed.
+   */
+  bool readPdoAssignment(const uint16_t address, PdoAssignment& pdoAssignment) {
+    const ec_slavet& slave = ecatContext_.slavelist[address];
+    if (slave.configindex || (slave.mbx_proto & ECT_MBXPROT_COE) == 0) {
+      return true;
+    }
+    uint8_t nSyncManagers = 0;
+    if (sdoReadSize(address, ECT_SDO_SMCOMMTYPE, 0x00, false, sizeof(nSyncManagers), &nSyncManagers) == 0) {
+      return false;
+    }
+    nSyncManagers = std::min<uint8_t>(nSyncManagers, EC_MAXSM);
+    for (uint8_t syncManager = 2; syncManager < nSyncManagers; syncManager++) {
+      uint8_t type = 0;
+      if (sdoReadSize(address, ECT_SDO_SMCOMMTYPE, syncManager + 1, false, sizeof(type), &type) == 0) {
+        return false;
+      }
+      // slaves reporting type 0 for the process data sync managers, as handled by ecx_readPDOmap(..).
+      if (type == 0 && (syncManager == 2 || syncManager == 3)) {
+        type = syncManager + 1;
+      }
+      pdoAssignment.syncManagerTypes[syncManager] = type;
+      if (type != 3 && type != 4) {
+        continue;
+      }
+      const uint16_t assignIndex = ECT_SDO_PDOASSIGN + syncManager;
+      uint16_t nPdos = 0;
+      if (sdoReadSize(address, assignIndex, 0x00, false, sizeof(nPdos), &nPdos) == 0) {
+        return false;
+      }
+      int bits = 0;
+      for (uint16_t pdo = 1; pdo <= etohs(nPdos); pdo++) {
+        uint16_t pdoIndex = 0;
+        if (sdoReadSize(address, assignIndex, static_cast<uint8_t>(pdo), false, sizeof(pdoIndex), &pdoIndex) == 0) {
+          return false;
+        }
+        uint8_t nEntries = 0;
+        if (etohs(pdoIndex) == 0 || sdoReadSize(address, etohs(pdoIndex), 0x00, false, sizeof(nEntries), &nEntries) == 0) {
+          continue;
+        }
+        for (uint8_t entry = 1; entry <= nEntries; entry++) {
+          uint32_t mappedObject = 0;
+          if (sdoReadSize(address, etohs(pdoIndex), entry, false, sizeof(mappedObject), &mappedObject) == 0) {
+            return false;
+          }
+          bits += etohl(mappedObject) & 0xff;
+        }
+      }
+      pdoAssignment.syncManagerBits[syncManager] = bits;
+      (type == 3 ? pdoAssignment.outputBits : pdoAssignment.inputBits) += bits;
+    }
+    pdoAssignment.fromCoe = true;
+    return true;
   }
 
-  bool getBusDiagnosisLog(BusDiagnosisLog& busDiagnosisLogOut) {
-    if (busDiagnosisLog_.fullyUpdated) {
-      // is called in the update loop, therefore not thread safe implemented here..
-      busDiagnosisLogOut = busDiagnosisLog_;
-      return true;
+  /*!
+   * Maps a single slave in PRE_OP into the remap group, which lies in the headroom of the IO map behind group 0.
+   * The PDO assignment read by readPdoAssignment(..) is applied and the sync managers and FMMUs of the slave are reprogrammed with a
+   * few datagrams, all other slaves are untouched.
+   * @return True if the new mapping fits into the headroom.
+   */
+  bool mapRemapGroupLocked(const uint16_t address, const PdoAssignment& pdoAssignment) {
+    ec_slavet& slave = ecatContext_.slavelist[address];
+    clearSlaveMappingLocked(address);
+    if (pdoAssignment.fromCoe) {
+      for (int syncManager = 2; syncManager < EC_MAXSM; syncManager++) {
+        slave.SMtype[syncManager] = pdoAssignment.syncManagerTypes[syncManager];
+        if (pdoAssignment.syncManagerTypes[syncManager] == 0) {
+          slave.SM[syncManager].SMflags = htoel(etohl(slave.SM[syncManager].SMflags) & EC_SMENABLEMASK);
+        }
+        slave.SM[syncManager].SMlength = htoes(static_cast<uint16>((pdoAssignment.syncManagerBits[syncManager] + 7) / 8));
+      }
+      slave.Obits = static_cast<uint16>(pdoAssignment.outputBits);
+      slave.Ibits = static_cast<uint16>(pdoAssignment.inputBits);
     }
-    return false;
+    slave.group = remapGroup_;
+
+    ec_groupt& group = ecatContext_.grouplist[remapGroup_];
+    memset(&group, 0, sizeof(group));
+    group.logstartaddr = static_cast<uint32>(ioMapGroupSize_);
+
+    // The sizes are known already, a config index keeps ecx_config_map_group(..) from reading them again with the context locked.
+    // The slave is moved to SAFE_OP by remapSlave(..) once the remap group is cycled.
+    const uint16 configIndex = slave.configindex;
+    slave.configindex = 1;
+    ecatContext_.manualstatechange = 1;
+    const int remapSize = ecx_config_map_group(&ecatContext_, ioMap_ + ioMapGroupSize_, remapGroup_);
+    ecatContext_.manualstatechange = 0;
+    slave.configindex = configIndex;
+    // Disable symmetrical transfers, as for group 0.
+    group.blockLRW = 1;
+    remappedSlave_ = address;
+
+    if (ioMapGroupSize_ + remapSize > sizeof(ioMap_)) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << ": New mapping needs " << remapSize
+                                                << " bytes but only " << sizeof(ioMap_) - ioMapGroupSize_
+                                                << " bytes of headroom are left.");
+      return false;
+    }
+    memset(ioMap_ + ioMapGroupSize_, 0, remapSize);
+    if (recordProcessImage_) {
+      // the columns of the recording point to the previous mapping of the slave.
+      recordProcessImage_ = false;
+      MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address
+                                               << " was remapped, the process image recording is paused. Restart it to continue.")
+    }
+    slaveWkcContribution_[address] = (slave.Obits > 0 ? 2 : 0) + (slave.Ibits > 0 ? 1 : 0);
+    MELO_DEBUG_STREAM("[soem_interface_rsl::" << name_ << "] Remapped slave " << address << " with size " << remapSize
+                                              << " at offset " << ioMapGroupSize_)
+    return true;
   }
 
-  void syncDistributedClock0(const uint16_t slave, const bool activate, const double cycleTime, const double cycleShift) {
-    // todo verify!
-    MELO_INFO_STREAM("Bus '" << name_ << "', slave " << slave << ":  " << (activate ? "Activating" : "Deactivating")
-                             << " distributed clock synchronization...");
-
-    ecx_dcsync0(&ecatContext_, slave, static_cast<uint8_t>(activate), static_cast<uint32_t>(cycleTime * 1e9),
-                static_cast<int32_t>(1e9 * cycleShift));
-
-    MELO_INFO_STREAM("Bus '" << name_ << "', slave " << slave << ":  " << (activate ? "Activated" : "Deactivated")
-                             << " distributed clock synchronization.");
+  /*!
+   * Puts back the mapping a slave had before a failed remap and hands the slave to the recovery, which reprograms its sync managers and
+   * FMMUs from INIT on and brings it back to OP. The PDO assignment has to match the previous mapping again for that.
+   */
+  void restoreMappingLocked(const uint16_t address, const PreviousMapping& previousMapping) {
+    clearSlaveMappingLocked(address);
+    ecatContext_.slavelist[address] = previousMapping.slave;
+    ecatContext_.grouplist[remapGroup_] = previousMapping.remapGroup;
+    remappedSlave_ = previousMapping.remappedSlave;
+    remapGroupActive_ = remappedSlave_ != 0;
+    slaveWkcContribution_[address] = previousMapping.wkcContribution;
+    // a rejected state change leaves an error which would block the way up again.
+    requestStateLocked(address, EC_STATE_INIT | EC_STATE_ACK);
+    recoverySteps_[address] = RecoveryStep::CheckState;
+    slaveStages_[address] = SlaveStage::Recovering;
+    MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address
+                                             << ": Remapping failed, the previous mapping is restored by the slave recovery.")
   }
 
-  EthercatBusBase::PdoSizePair getHardwarePdoSizes(const uint16_t slave) {
+  void restoreMapping(const uint16_t address, const PreviousMapping& previousMapping) {
     std::lock_guard<std::mutex> guard(contextMutex_);
-    return std::make_pair(ecatContext_.slavelist[slave].Obytes, ecatContext_.slavelist[slave].Ibytes);
+    restoreMappingLocked(address, previousMapping);
   }
 
-  EthercatBusBase::PdoSizeMap getHardwarePdoSizes() {
-    EthercatBusBase::PdoSizeMap pdoMap;
-
-    for (const auto& slave : slaves_) {
-      pdoMap.insert(std::make_pair(slave->getName(), getHardwarePdoSizes(slave->getAddress())));
+  /*!
+   * Polls the AL state of a single slave until the state is reached, the slave reports an error or the timeout expired.
+   * @return True if the state was reached.
+   */
+  bool waitForSlaveState(const uint16_t address, const uint16_t state) {
+    const auto deadline = slaveStateDeadline();
+    uint16_t currentState = EC_STATE_NONE;
+    uint16_t alStatusCode = 0;
+    while (std::chrono::steady_clock::now() < deadline) {
+      {
+        std::lock_guard<std::mutex> guard(contextMutex_);
+        currentState = readStateLocked(address);
+        alStatusCode = ecatContext_.slavelist[address].ALstatuscode;
+      }
+      if ((currentState & EC_STATE_ERROR) != 0) {
+        break;
+      }
+      if ((currentState & 0x0f) == state) {
+        return true;
+      }
+      soem_interface_rsl::threadSleep(0.001);
     }
-    return pdoMap;
+    eventLog_.log(common::EventType::StateError, address, alStatusCode, currentState, state);
+    MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << ": Targetstate "
+                                              << EthercatBusBase::getStateString(state)
+                                              << " has not been reached. Current State: " << EthercatBusBase::getStateString(currentState)
+                                              << ", alStatusCode: 0x" << std::setfill('0') << std::setw(8) << std::hex << alStatusCode
+                                              << " " << ec_ALstatuscode2string(alStatusCode));
+    return false;
   }
 
-  bool sdoWrite(const uint16_t slave, const uint16_t index, const uint8_t subindex, const bool completeAccess, int size, void* buf) {
-    int wkc = 0;
-    {
-      assert(static_cast<int>(slave) <= *ecatContext_.slavecount);
-      std::lock_guard<std::mutex> guard(contextMutex_);
-      wkc = ecx_SDOwrite(&ecatContext_, slave, index, subindex, static_cast<boolean>(completeAccess), size, buf, EC_TIMEOUTRXM);
-    }
-    if (wkc <= 0) {
-      MELO_ERROR_STREAM("Slave " << slave << ": Working counter too low (" << wkc << ") for writing SDO (ID: 0x" << std::setfill('0')
-                                 << std::setw(4) << std::hex << index << ", SID 0x" << std::setfill('0') << std::setw(2) << std::hex
-                                 << static_cast<uint16_t>(subindex) << ").");
-      checkForSdoErrors(slave, index);
-      if (slave == 0) {
-        MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Worst AL status code of all slaves, alStatusCode: 0x" << std::setfill('0')
-                                                 << std::setw(8) << std::hex << ecatContext_.slavelist[slave].ALstatuscode << " "
-                                                 << ec_ALstatuscode2string(ecatContext_.slavelist[slave].ALstatuscode));
-      } else {
-        MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Slave: " << slaves_[slave - 1]->getName() << " alStatusCode: 0x"
-                                                 << std::setfill('0') << std::setw(8) << std::hex
-                                                 << ecatContext_.slavelist[slave].ALstatuscode << " "
-                                                 << ec_ALstatuscode2string(ecatContext_.slavelist[slave].ALstatuscode));
+  /*!
+   * Performs a single step of the recovery of a slave, following the slave check of the soem_rsl simple_test.
+   * Every step consists of few datagrams only, the reconfiguration of ecx_reconfig_slave(..) is split into one step per state transition
+   * so that the context is never locked while waiting for the slave.
+   */
+  void stepSlaveRecovery(const uint16_t address) {
+    RecoveryStep& step = recoverySteps_[address];
+    ec_slavet& ecatSlave = ecatContext_.slavelist[address];
+    switch (step) {
+      case RecoveryStep::CheckState: {
+        std::unique_lock<std::mutex> lock(contextMutex_);
+        const uint16_t state = readStateLocked(address);
+        if (state == EC_STATE_NONE) {
+          if (!ecatSlave.islost) {
+            ecatSlave.islost = TRUE;
+            eventLog_.log(common::EventType::Recovery, address, 0, static_cast<int32_t>(common::RecoveryAction::Lost), state);
+            MELO_ERROR_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << " lost, trying to recover it.")
+          }
+          step = RecoveryStep::Lost;
+        } else if (state == (EC_STATE_SAFE_OP | EC_STATE_ERROR)) {
+          MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << " in SAFE_OP with error, alStatusCode: 0x"
+                                                   << std::setfill('0') << std::setw(8) << std::hex << ecatSlave.ALstatuscode << " "
+                                                   << ec_ALstatuscode2string(ecatSlave.ALstatuscode) << ", acknowledging.")
+          eventLog_.log(common::EventType::Recovery, address, ecatSlave.ALstatuscode,
+                        static_cast<int32_t>(common::RecoveryAction::Acknowledge), state);
+          requestStateLocked(address, EC_STATE_SAFE_OP | EC_STATE_ACK);
+        } else if (state == EC_STATE_SAFE_OP) {
+          lock.unlock();
+          const EthercatSlaveBasePtr slave = getSlaveByAddress(address);
+          if (slave && !slave->recover()) {
+            MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] Slave '" << slave->getName() << "' could not be recovered, retrying.")
+            break;
+          }
+          lock.lock();
+          requestStateLocked(address, EC_STATE_OPERATIONAL);
+          stageDeadlines_[address] = slaveStateDeadline();
+          step = RecoveryStep::WaitForOp;
+        } else if (state == EC_STATE_OPERATIONAL) {
+          step = RecoveryStep::WaitForOp;
+        } else {
+          step = RecoveryStep::Reconfigure;
+        }
+        break;
+      }
+      case RecoveryStep::Lost: {
+        std::lock_guard<std::mutex> guard(contextMutex_);
+        if (ecx_recover_slave(&ecatContext_, address, EC_TIMEOUTRET) > 0) {
+          ecatSlave.islost = FALSE;
+          eventLog_.log(common::EventType::Recovery, address, 0, static_cast<int32_t>(common::RecoveryAction::Found), ecatSlave.state);
+          MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << " found again.")
+          step = RecoveryStep::CheckState;
+        }
+        break;
+      }
+      case RecoveryStep::Reconfigure: {
+        std::lock_guard<std::mutex> guard(contextMutex_);
+        requestStateLocked(address, EC_STATE_INIT);
+        ecx_eeprom2pdi(&ecatContext_, address);
+        stageDeadlines_[address] = slaveStateDeadline();
+        step = RecoveryStep::WaitForInit;
+        break;
+      }
+      case RecoveryStep::WaitForInit: {
+        std::lock_guard<std::mutex> guard(contextMutex_);
+        const uint16_t state = readStateLocked(address);
+        if ((state & 0x0f) == EC_STATE_INIT) {
+          // program all enabled sync managers, as ecx_reconfig_slave(..) does.
+          for (int nSm = 0; nSm < EC_MAXSM; nSm++) {
+            if (ecatSlave.SM[nSm].StartAddr != 0) {
+              ecx_FPWR(ecatContext_.port, ecatSlave.configadr, static_cast<uint16>(ECT_REG_SM0 + nSm * sizeof(ec_smt)), sizeof(ec_smt),
+                       &ecatSlave.SM[nSm], EC_TIMEOUTRET3);
+            }
+          }
+          requestStateLocked(address, EC_STATE_PRE_OP);
+          stageDeadlines_[address] = slaveStateDeadline();
+          step = RecoveryStep::WaitForPreOp;
+        } else if (std::chrono::steady_clock::now() > stageDeadlines_[address]) {
+          step = RecoveryStep::CheckState;
+        }
+        break;
+      }
+      case RecoveryStep::WaitForPreOp: {
+        std::lock_guard<std::mutex> guard(contextMutex_);
+        const uint16_t state = readStateLocked(address);
+        if ((state & 0x0f) == EC_STATE_PRE_OP) {
+          if (ecatSlave.PO2SOconfig != nullptr) {
+            ecatSlave.PO2SOconfig(address);
+          }
+          // the FMMUs are programmed before requesting SAFE_OP, the slave needs them for the transition anyway.
+          for (int nFmmu = 0; nFmmu < ecatSlave.FMMUunused; nFmmu++) {
+            const auto fmmuAddress = static_cast<uint16>(ECT_REG_FMMU0 + nFmmu * sizeof(ec_fmmut));
+            ecx_FPWR(ecatContext_.port, ecatSlave.configadr, fmmuAddress, sizeof(ec_fmmut), &ecatSlave.FMMU[nFmmu], EC_TIMEOUTRET3);
+          }
+          requestStateLocked(address, EC_STATE_SAFE_OP);
+          stageDeadlines_[address] = slaveStateDeadline();
+          step = RecoveryStep::WaitForSafeOp;
+        } else if (std::chrono::steady_clock::now() > stageDeadlines_[address]) {
+          step = RecoveryStep::CheckState;
+        }
+        break;
+      }
+      case RecoveryStep::WaitForSafeOp: {
+        std::lock_guard<std::mutex> guard(contextMutex_);
+        const uint16_t state = readStateLocked(address);
+        if (state == EC_STATE_SAFE_OP || (state & EC_STATE_ERROR) != 0 || std::chrono::steady_clock::now() > stageDeadlines_[address]) {
+          eventLog_.log(common::EventType::Recovery, address, 0, static_cast<int32_t>(common::RecoveryAction::Reconfigure), state);
+          MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address
+                                                   << " reconfigured, state: " << EthercatBusBase::getStateString(state))
+          step = RecoveryStep::CheckState;
+        }
+        break;
+      }
+      case RecoveryStep::WaitForOp: {
+        std::lock_guard<std::mutex> guard(contextMutex_);
+        const uint16_t state = readStateLocked(address);
+        if (state == EC_STATE_OPERATIONAL) {
+          slaveStages_[address] = SlaveStage::Operational;
+          updateExpectedWorkingCounter();
+          eventLog_.log(common::EventType::Recovery, address, 0, static_cast<int32_t>(common::RecoveryAction::Recovered), state);
+          MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << address << " recovered, expected working counter is now "
+                                                   << expectedWorkingCounter_.load())
+        } else if ((state & EC_STATE_ERROR) != 0 || std::chrono::steady_clock::now() > stageDeadlines_[address]) {
+          step = RecoveryStep::CheckState;
+        }
+        break;
       }
-      return false;
     }
-    return true;
   }
 
-  bool sdoRead(const uint16_t slave, const uint16_t index, const uint8_t subindex, const bool completeAccess, int size, void* buf) {
-    int requestedSize = size;
-    int wkc = 0;
-    {
-      assert(static_cast<int>(slave) <= *ecatContext_.slavecount);
-      std::lock_guard<std::mutex> guard(contextMutex_);
-      wkc = ecx_SDOread(&ecatContext_, slave, index, subindex, static_cast<boolean>(completeAccess), &size, buf, EC_TIMEOUTRXM);
-    }
-    if (wkc <= 0) {
-      MELO_ERROR_STREAM("Slave " << slave << ": Working counter too low (" << wkc << ") for reading SDO (ID: 0x" << std::setfill('0')
-                                 << std::setw(4) << std::hex << index << ", SID 0x" << std::setfill('0') << std::setw(2) << std::hex
-                                 << static_cast<uint16_t>(subindex) << ").");
+  std::chrono::steady_clock::time_point slaveStateDeadline() const {
+    return std::chrono::steady_clock::now() +
+           std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(slaveStateTimeout_));
+  }
 
-      checkForSdoErrors(slave, index);
-      if (slave == 0) {
-        MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Worst AL status code of all slaves, alStatusCode: 0x" << std::setfill('0')
-                                                 << std::setw(8) << std::hex << ecatContext_.slavelist[slave].ALstatuscode << " "
-                                                 << ec_ALstatuscode2string(ecatContext_.slavelist[slave].ALstatuscode));
-      } else {
-        MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Slave: " << slaves_[slave - 1]->getName() << " alStatusCode: 0x"
-                                                 << std::setfill('0') << std::setw(8) << std::hex
-                                                 << ecatContext_.slavelist[slave].ALstatuscode << " "
-                                                 << ec_ALstatuscode2string(ecatContext_.slavelist[slave].ALstatuscode));
+  //! Recomputes the expected working counter from the slaves taking part in the cyclic exchange.
+  void updateExpectedWorkingCounter() {
+    int expectedWorkingCounter = 0;
+    for (size_t address = 1; address < slaveStages_.size(); address++) {
+      if (slaveStages_[address].load(std::memory_order_relaxed) == SlaveStage::Operational) {
+        expectedWorkingCounter += slaveWkcContribution_[address];
       }
-      return false;
     }
-    if (size != requestedSize) {
-      MELO_ERROR_STREAM("Slave " << slave << ": Size mismatch (expected " << requestedSize << " bytes, read " << size
-                                 << " bytes) for reading SDO (ID: 0x" << std::setfill('0') << std::setw(4) << std::hex << index
-                                 << ", SID 0x" << std::setfill('0') << std::setw(2) << std::hex << static_cast<uint16_t>(subindex) << ").");
-      return false;
-    }
-    return true;
+    expectedWorkingCounter_ = expectedWorkingCounter;
   }
 
-  int sdoReadSize(const uint16_t slave, const uint16_t index, const uint8_t subindex, const bool completeAccess, int size, void* buf) {
-    int wkc = 0;
-    {
-      assert(static_cast<int>(slave) <= *ecatContext_.slavecount);
-      std::lock_guard<std::mutex> guard(contextMutex_);
-      wkc = ecx_SDOread(&ecatContext_, slave, index, subindex, static_cast<boolean>(completeAccess), &size, buf, EC_TIMEOUTRXM);
-    }
-    if (wkc <= 0) {
-      MELO_ERROR_STREAM("Slave " << slave << ": Working counter too low (" << wkc << ") for reading SDO (ID: 0x" << std::setfill('0')
-                                 << std::setw(4) << std::hex << index << ", SID 0x" << std::setfill('0') << std::setw(2) << std::hex
-                                 << static_cast<uint16_t>(subindex) << ").");
-
-      checkForSdoErrors(slave, index);
-      if (slave == 0) {
-        MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Worst AL status code of all slaves, alStatusCode: 0x" << std::setfill('0')
-                                                 << std::setw(8) << std::hex << ecatContext_.slavelist[slave].ALstatuscode << " "
-                                                 << ec_ALstatuscode2string(ecatContext_.slavelist[slave].ALstatuscode));
-      } else {
-        MELO_INFO_STREAM("[soem_interface_rsl::" << name_ << "] Slave: " << slaves_[slave - 1]->getName() << " alStatusCode: 0x"
-                                                 << std::setfill('0') << std::setw(8) << std::hex
-                                                 << ecatContext_.slavelist[slave].ALstatuscode << " "
-                                                 << ec_ALstatuscode2string(ecatContext_.slavelist[slave].ALstatuscode));
+  EthercatSlaveBasePtr getSlaveByAddress(const uint16_t address) const {
+    for (const auto& slave : slaves_) {
+      if (slave->getAddress() == address) {
+        return slave;
       }
-      return 0;
     }
-    return size;
+    return nullptr;
   }
 
-  void readTxPdo(const uint16_t slave, int size, void* buf) const {
-    assert(static_cast<int>(slave) <= *ecatContext_.slavecount);
-    std::lock_guard<std::mutex> guard(contextMutex_);
-    assert(size == (int)ecatContext_.slavelist[slave].Ibytes);
-    memcpy(buf, ecatContext_.slavelist[slave].inputs, size);
+  /*!
+   * Requests a state for a single slave with one datagram, without touching the process data.
+   * Unlike setStateLocked(..) this is safe to use while the bus is cycling.
+   */
+  void requestStateLocked(const uint16_t slave, const uint16_t state) {
+    eventLog_.log(common::EventType::StateRequest, slave, 0, ecatContext_.slavelist[slave].state, state);
+    ecatContext_.slavelist[slave].state = state;
+    ecx_FPWRw(ecatContext_.port, ecatContext_.slavelist[slave].configadr, ECT_REG_ALCTL, htoes(state), EC_TIMEOUTRET3);
   }
 
-  void writeRxPdo(const uint16_t slave, int size, const void* buf) {
-    assert(static_cast<int>(slave) <= *ecatContext_.slavecount);
-    std::lock_guard<std::mutex> guard(contextMutex_);
-    assert((int)ecatContext_.slavelist[slave].Obytes == size);
-    memcpy(ecatContext_.slavelist[slave].outputs, buf, size);
+  /*!
+   * Reads the AL state of a single slave with one datagram and updates the slave list.
+   * @return State of the slave, EC_STATE_NONE if the slave did not respond.
+   */
+  uint16_t readStateLocked(const uint16_t slave) {
+    ec_alstatust alStatus{};
+    if (ecx_FPRD(ecatContext_.port, ecatContext_.slavelist[slave].configadr, ECT_REG_ALSTAT, sizeof(alStatus), &alStatus, EC_TIMEOUTRET) <=
+        0) {
+      return EC_STATE_NONE;
+    }
+    ecatContext_.slavelist[slave].state = etohs(alStatus.alstatus);
+    ecatContext_.slavelist[slave].ALstatuscode = etohs(alStatus.alstatuscode);
+    return ecatContext_.slavelist[slave].state;
   }
 
- private:
   uint16_t getState(const uint16_t slave) {
     std::lock_guard<std::mutex> guard(contextMutex_);
     int lowest_state = ecx_readstate(&ecatContext_);
@@ -612,6 +2156,7 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
       MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] Bus " << name_ << " was not successfully initialized, skipping operation");
       return;
     }
+    eventLog_.log(common::EventType::StateRequest, slave, 0, ecatContext_.slavelist[slave].state, state);
     ecatContext_.slavelist[slave].state = state;
     if (state == EC_STATE_OPERATIONAL) {
       ecx_send_processdata(&ecatContext_);
@@ -665,6 +2210,7 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
         return true;
       }
     }
+    eventLog_.log(common::EventType::StateError, slave, ecatContext_.slavelist[slave].ALstatuscode, returnedState, state);
     MELO_WARN_STREAM("[soem_interface_rsl::" << name_ << "] Slave " << slave << ": Targetstate " << EthercatBusBase::getStateString(state)
                                              << " has not been reached. Current State: " << returnedState);
 
@@ -681,44 +2227,67 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
     return false;
   }
 
-  std::string getErrorString(ec_errort error) {
-    std::stringstream stream;
-    stream << "Time: " << (static_cast<double>(error.Time.sec) + (static_cast<double>(error.Time.usec) / 1000000.0));
-
+  //! Logs an error of the SOEM error stack through the realtime logger, without allocating.
+  void logError(const ec_errort& error) const {
     switch (error.Etype) {
       case EC_ERR_TYPE_SDO_ERROR:
-        stream << " SDO slave: " << error.Slave << " index: 0x" << std::setfill('0') << std::setw(4) << std::hex << error.Index << "."
-               << std::setfill('0') << std::setw(2) << std::hex << static_cast<uint16_t>(error.SubIdx) << " error: 0x" << std::setfill('0')
-               << std::setw(8) << std::hex << static_cast<unsigned>(error.AbortCode) << " " << ec_sdoerror2string(error.AbortCode);
+      case EC_ERR_TYPE_SDOINFO_ERROR:
+        MELO_RT_ERROR("Time: {}.{:06} SDO slave: {} index: 0x{:04x}.{:02x} error: 0x{:08x} {}", error.Time.sec, error.Time.usec,
+                      error.Slave, error.Index, error.SubIdx, static_cast<uint32_t>(error.AbortCode), ec_sdoerror2string(error.AbortCode));
         break;
       case EC_ERR_TYPE_EMERGENCY:
-        stream << " EMERGENCY slave: " << error.Slave << " error: 0x" << std::setfill('0') << std::setw(4) << std::hex << error.ErrorCode;
+        MELO_RT_ERROR("Time: {}.{:06} EMERGENCY slave: {} error: 0x{:04x}", error.Time.sec, error.Time.usec, error.Slave,
+                      error.ErrorCode);
         break;
       case EC_ERR_TYPE_PACKET_ERROR:
-        stream << " PACKET slave: " << error.Slave << " index: 0x" << std::setfill('0') << std::setw(4) << std::hex << error.Index << "."
-               << std::setfill('0') << std::setw(2) << std::hex << static_cast<uint16_t>(error.SubIdx) << " error: 0x" << std::setfill('0')
-               << std::setw(8) << std::hex << error.ErrorCode;
-        break;
-      case EC_ERR_TYPE_SDOINFO_ERROR:
-        stream << " SDO slave: " << error.Slave << " index: 0x" << std::setfill('0') << std::setw(4) << std::hex << error.Index << "."
-               << std::setfill('0') << std::setw(2) << std::hex << static_cast<uint16_t>(error.SubIdx) << " error: 0x" << std::setfill('0')
-               << std::setw(8) << std::hex << static_cast<unsigned>(error.AbortCode) << " " << ec_sdoerror2string(error.AbortCode);
+        MELO_RT_ERROR("Time: {}.{:06} PACKET slave: {} index: 0x{:04x}.{:02x} error: 0x{:08x}", error.Time.sec, error.Time.usec,
+                      error.Slave, error.Index, error.SubIdx, error.ErrorCode);
         break;
       case EC_ERR_TYPE_SOE_ERROR:
-        stream << " SoE slave: " << error.Slave << " index: 0x" << std::setfill('0') << std::setw(4) << std::hex << error.Index
-               << " error: 0x" << std::setfill('0') << std::setw(8) << std::hex << static_cast<unsigned>(error.AbortCode) << " "
-               << ec_soeerror2string(error.ErrorCode);
+        MELO_RT_ERROR("Time: {}.{:06} SoE slave: {} index: 0x{:04x} error: 0x{:08x} {}", error.Time.sec, error.Time.usec, error.Slave,
+                      error.Index, static_cast<uint32_t>(error.AbortCode), ec_soeerror2string(error.ErrorCode));
         break;
       case EC_ERR_TYPE_MBX_ERROR:
-        stream << " MBX slave: " << error.Slave << " error: 0x" << std::setfill('0') << std::setw(8) << std::hex << error.ErrorCode << " "
-               << ec_mbxerror2string(error.ErrorCode);
+        MELO_RT_ERROR("Time: {}.{:06} MBX slave: {} error: 0x{:08x} {}", error.Time.sec, error.Time.usec, error.Slave, error.ErrorCode,
+                      ec_mbxerror2string(error.ErrorCode));
+        break;
+      default:
+        MELO_RT_ERROR("Time: {}.{:06} MBX slave: {} error: 0x{:08x}", error.Time.sec, error.Time.usec, error.Slave,
+                      static_cast<uint32_t>(error.AbortCode));
+        break;
+    }
+  }
+
+  //! Logs the AL status code of a slave, the worst one of all slaves for slave 0.
+  void logAlStatusCode(const uint16_t slave) const {
+    if (slave == 0) {
+      MELO_RT_INFO("[soem_interface_rsl::{}] Worst AL status code of all slaves, alStatusCode: 0x{:08x} {}", name_,
+                   ecatContext_.slavelist[slave].ALstatuscode, ec_ALstatuscode2string(ecatContext_.slavelist[slave].ALstatuscode));
+    } else {
+      MELO_RT_INFO("[soem_interface_rsl::{}] Slave: {} alStatusCode: 0x{:08x} {}", name_, slaves_[slave - 1]->getName(),
+                   ecatContext_.slavelist[slave].ALstatuscode, ec_ALstatuscode2string(ecatContext_.slavelist[slave].ALstatuscode));
+    }
+  }
+
+  void logErrorEvent(const ec_errort& error) {
+    switch (error.Etype) {
+      case EC_ERR_TYPE_SDO_ERROR:
+      case EC_ERR_TYPE_SDOINFO_ERROR:
+        eventLog_.log(common::EventType::SdoAbort, error.Slave, static_cast<uint32_t>(error.AbortCode), 0, 0, error.Index, error.SubIdx);
+        break;
+      case EC_ERR_TYPE_EMERGENCY:
+        eventLog_.log(common::EventType::Emergency, error.Slave, error.ErrorCode, error.ErrorReg);
+        break;
+      case EC_ERR_TYPE_PACKET_ERROR:
+        eventLog_.log(common::EventType::PacketError, error.Slave, error.ErrorCode, 0, 0, error.Index, error.SubIdx);
+        break;
+      case EC_ERR_TYPE_SOE_ERROR:
+        eventLog_.log(common::EventType::SoeError, error.Slave, error.ErrorCode, 0, 0, error.Index);
         break;
       default:
-        stream << " MBX slave: " << error.Slave << " error: 0x" << std::setfill('0') << std::setw(8) << std::hex
-               << static_cast<unsigned>(error.AbortCode);
+        eventLog_.log(common::EventType::MailboxError, error.Slave, error.ErrorCode);
         break;
     }
-    return stream.str();
   }
 
   /*!
@@ -731,10 +2300,13 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
     while (ecx_iserror(&ecatContext_)) {
       ec_errort error;
       if (ecx_poperror(&ecatContext_, &error)) {
-        std::string errorStr = getErrorString(error);
-        MELO_ERROR_STREAM(errorStr);
+        logErrorEvent(error);
+        logError(error);
         if (error.Slave == slave && error.Index == index) {
-          soem_interface_rsl::common::MessageLog::insertMessage(message_logger::log::levels::Level::Error, errorStr);
+          char text[common::MessageLog::Entry::maxTextLength + 1];
+          std::snprintf(text, sizeof(text), "SDO 0x%04x.%02x: %s", error.Index, error.SubIdx, ec_sdoerror2string(error.AbortCode));
+          common::MessageLog::insertMessage(message_logger::log::levels::Level::Error, error.Slave, static_cast<uint32_t>(error.AbortCode),
+                                            text);
           return true;
         }
       }
@@ -744,6 +2316,8 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
 
   //! Name of the bus.
   std::string name_;
+  //! Link state of the bus interface, maintained by the link monitor.
+  const common::LinkMonitor::LinkState& link_;
 
   //! Whether the bus has been initialized successfully
   bool initlialized_{false};
@@ -761,24 +2335,169 @@ struct EthercatBusBaseTemplateAdapter::EthercatSlaveBaseImpl {
   std::chrono::time_point<std::chrono::high_resolution_clock> updateReadStamp_;
   //! Time of the last successful PDO writing.
   std::chrono::time_point<std::chrono::high_resolution_clock> updateWriteStamp_;
+  //! Durations of the phases of the cycles and working counter statistics, written by updateRead() and updateWrite().
+  common::CycleStatistics cycleStatistics_;
+  //! Timing of the callbacks of the slaves in the order of slaves_, allocated by enableSlaveTiming(..).
+  std::vector<std::unique_ptr<common::SlaveTiming>> slaveTimings_;
+  std::atomic<bool> slaveTimingEnabled_{false};
+
+  //! Per slave working counter attribution after a drop, see setWorkingCounterAttribution(..).
+  struct SentAttributionDatagram {
+    uint16_t address;
+    int offset;
+    uint16_t length;
+    int expectedWorkingCounter;
+    bool alStatus;
+  };
+  //! AL status, reserved and AL status code.
+  static constexpr uint16_t alStatusLength_{6};
+  static constexpr uint16_t noAlStatus_{0xffff};
+  std::atomic<bool> attributionEnabled_{false};
+  bool attributionRequested_{false};
+  int attributionFrameIndex_{-1};
+  //! Next bus address to attribute, a pass over all slaves can span several cycles.
+  uint16_t attributionCursor_{1};
+  std::array<SentAttributionDatagram, 256> sentAttributionDatagrams_{};
+  size_t nSentAttributionDatagrams_{0};
+  //! Results of the running pass, indexed by the bus address.
+  std::vector<WorkingCounterFault> attribution_;
+  //! Guards the faults of the last completed pass, never blocks the cyclic thread.
+  std::mutex attributionMutex_;
+  std::vector<WorkingCounterFault> attributionFaults_;
+  uint64_t attributionPasses_{0};
+
+  //! Register reads appended to the cyclic exchange, see addCyclicRegisterRead(..).
+  struct SentRegisterRead {
+    size_t handle;
+    int offset;
+  };
+  //! Frame length without the frame check sequence.
+  static constexpr int maxFrameLength_ = EC_MAXECATFRAME - 4;
+  common::CyclicRegisterTable registerTable_;
+  //! Number of frames with register reads sent, read by the monitoring.
+  std::atomic<uint64_t> registerCycle_{0};
+  size_t registerCursor_{0};
+  //! Index of the frame with register reads in flight, -1 if none.
+  int registerFrameIndex_{-1};
+  //! Reads in the frame in flight and the offsets of their data in the received frame.
+  std::array<SentRegisterRead, 128> sentRegisterReads_{};
+  size_t nSentRegisterReads_{0};
+
+  //! Topology refreshed through the register frames, see setTopologyRefresh(..).
+  enum class TopologyRefresh { Idle, Latch, Read };
+  struct SentTopologyRead {
+    uint16_t address;
+    int offset;
+  };
+  //! Receive times of the ports 0 to 3.
+  static constexpr uint16_t receiveTimesLength_{16};
+  common::SegmentTopology segmentTopology_;
+  std::atomic<unsigned int> topologyRefreshDecimation_{0};
+  TopologyRefresh topologyRefresh_{TopologyRefresh::Idle};
+  unsigned int topologyRefreshCycles_{0};
+  //! Next bus address to read the receive times from.
+  uint16_t topologyCursor_{1};
+  uint32 topologyLatchData_{0};
+  //! Datagrams of the topology refresh in the register frame in flight.
+  int topologyLatchOffset_{-1};
+  std::array<SentTopologyRead, 64> sentTopologyReads_{};
+  size_t nSentTopologyReads_{0};
+  std::vector<std::array<uint32_t, 4>> topologyReceiveTimes_;
+  //! Guards the topology of the last completed refresh, never blocks the cyclic thread.
+  mutable std::mutex topologyMutex_;
+  std::vector<common::TopologyNode> publishedTopology_;
 
   //! Time to sleep between the retries.
   const double ecatConfigRetrySleep_{1.0};
 
   //! Count working counter too low in a row.
-  unsigned int workingCounterTooLowCounter_{0};
+  std::atomic<unsigned int> workingCounterTooLowCounter_{0};
   //! Maximal number of working counter to low.
   const unsigned int maxWorkingCounterTooLow_{100};
 
+  //! Bring-up stage of a slave, only slaves in stage Operational take part in the cyclic exchange.
+  enum class SlaveStage : uint8_t {
+    Pending = 0,
+    SafeOpRequested = 1,
+    OpRequested = 2,
+    Operational = 3,
+    Remapping = 4,
+    Recovering = 5,
+    Failed = 6
+  };
+  //! Stage per bus address (index 0 is the master), written by the acyclic context, read by the cyclic one.
+  std::vector<std::atomic<SlaveStage>> slaveStages_;
+  //! Deadline for the currently requested state per bus address, staged startup only.
+  std::vector<std::chrono::steady_clock::time_point> stageDeadlines_;
+  //! Working counter contribution per bus address.
+  std::vector<int> slaveWkcContribution_;
+  //! Sum of the working counter contributions of all slaves in stage Operational.
+  std::atomic<int> expectedWorkingCounter_{0};
+  //! Whether a staged startup is in progress.
+  bool stagedStartup_{false};
+  //! Maximal time a single slave may take to reach a requested state during the staged startup or a remap.
+  double slaveStateTimeout_{10.0};
+
+  //! Next action of the recovery of a slave, see stepSlaveRecovery().
+  enum class RecoveryStep : uint8_t {
+    CheckState = 0,
+    Lost = 1,
+    Reconfigure = 2,
+    WaitForInit = 3,
+    WaitForPreOp = 4,
+    WaitForSafeOp = 5,
+    WaitForOp = 6
+  };
+  //! Recovery step per bus address, only valid for slaves in stage Recovering.
+  std::vector<RecoveryStep> recoverySteps_;
+  //! Next bus address to look at, the slaves are served round robin across the time slices.
+  uint16_t recoveryCursor_{1};
+  //! Maximal time one call to stepSlaveRecovery() keeps on starting new steps.
+  const double recoveryTimeSlice_{0.002};
+
   //! Bus Diagnosis Counters, and dl status log
   BusDiagnosisLog busDiagnosisLog_{};
+  //! Error counters of all slaves read by sweepErrorCounters(), same thread as doBusMonitoring.
+  common::ErrorCounterDiagnosis errorCounterDiagnosis_;
+  //! Capture of the frames of the port, does nothing until startFrameCapture(..) is called.
+  common::FrameCapture frameCapture_;
+  //! Recording of the IO map, fed by updateRead() while recordProcessImage_ is set.
+  common::ProcessImageRecorder processImageRecorder_;
+  //! Whether updateRead() records the process image, guarded by the contextMutex_.
+  bool recordProcessImage_{false};
+  //! Recording the process data is served from instead of the NIC, see startReplay(..).
+  const common::ProcessImageRecording* replayRecording_{nullptr};
+  //! Next row to replay and the row replaying stops at.
+  uint64_t replayRow_{0};
+  uint64_t replayEnd_{0};
+  //! Binary log of the bus events, does nothing until openEventLog(..) is called.
+  common::EventLog eventLog_;
+
+  //! Whether ecx_configdc(..) found DC capable slaves.
+  bool hasDistributedClocks_{false};
+  //! Copy of the DC time of the last received frame, read by the cyclic executor.
+  std::atomic<int64_t> distributedClockTime_{0};
+  //! CLOCK_MONOTONIC time of the last ecx_send_processdata(..), in ns.
+  int64_t sendMonotonicTime_{0};
+  //! Send time of the frame which carried distributedClockTime_.
+  std::atomic<int64_t> updateReadMonotonicTime_{0};
+  common::DistributedClockMapping distributedClockMapping_;
   enum class BusDiagState { StateReading = 0, CounterReading = 1 };
   BusDiagState busDiagState_{BusDiagState::StateReading};
   size_t nSlaves_{0};                // number of slaves on the bus - set after startup.
-  size_t busDiagOfCurrentSlave_{0};  // running variable to send only one frame per slave.
 
+  // Headroom of the IO map reserved for a slave remapped while the bus is running, see remapSlave(..).
+  static constexpr size_t ioMapHeadroom_{1024};
   // EtherCAT input/output mapping of the slaves within the datagrams.
-  char ioMap_[4096];
+  char ioMap_[4096 + ioMapHeadroom_];
+  // Size of the IO map used by group 0, the remap group is placed right behind it.
+  size_t ioMapGroupSize_{0};
+  // Group of the remapped slave, group 0 contains all other slaves.
+  static constexpr uint8_t remapGroup_{1};
+  // Address of the slave in the remap group, 0 if there is none.
+  uint16_t remappedSlave_{0};
+  // Whether the remap group is exchanged together with group 0.
+  std::atomic<bool> remapGroupActive_{false};
 
   // EtherCAT context data elements:
 
@@ -877,16 +2596,16 @@ EthercatBusBase::EthercatBusBase(const std::string& name) : EthercatBusBaseTempl
 EthercatBusBase::~EthercatBusBase() = default;
 
 bool EthercatBusBase::busIsAvailable(const std::string& name) {
-  return soem_interface_rsl::busIsAvailable(name);
+  return common::LinkMonitor::instance().isUp(name);
 }
 
 void EthercatBusBase::printAvailableBusses() {
   MELO_INFO_STREAM("Available adapters:");
-  ec_adaptert* adapter = ec_find_adapters();
-  while (adapter != nullptr) {
+  ec_adaptert* adapters = ec_find_adapters();
+  for (ec_adaptert* adapter = adapters; adapter != nullptr; adapter = adapter->next) {
     MELO_INFO_STREAM("- Name: '" << adapter->name << "', description: '" << adapter->desc << "'");
-    adapter = adapter->next;
   }
+  ec_free_adapters(adapters);
 }
 
 const std::string& EthercatBusBase::getName() const {
@@ -897,6 +2616,10 @@ bool EthercatBusBase::busIsAvailable() const {
   return pImpl_->busIsAvailable();
 }
 
+bool EthercatBusBase::hasCarrier() const {
+  return pImpl_->hasCarrier();
+}
+
 int EthercatBusBase::getNumberOfSlaves() const {
   return pImpl_->getNumberOfSlaves();
 }
@@ -914,6 +2637,35 @@ bool EthercatBusBase::startup(std::atomic<bool>& abortFlag, const bool sizeCheck
   return pImpl_->startup(abortFlag, sizeCheck, maxDiscoverRetries);
 }
 
+bool EthercatBusBase::startupStaged(const bool sizeCheck, int maxDiscoverRetries) {
+  std::atomic<bool> tmpAtomicForStart{false};
+  return pImpl_->startupStaged(tmpAtomicForStart, sizeCheck, maxDiscoverRetries);
+}
+
+bool EthercatBusBase::startupStaged(std::atomic<bool>& abortFlag, const bool sizeCheck, int maxDiscoverRetries) {
+  return pImpl_->startupStaged(abortFlag, sizeCheck, maxDiscoverRetries);
+}
+
+bool EthercatBusBase::stepStagedStartup() {
+  return pImpl_->stepStagedStartup();
+}
+
+bool EthercatBusBase::slaveIsActive(const uint16_t slave) const {
+  return pImpl_->slaveIsActive(slave);
+}
+
+void EthercatBusBase::setSlaveStateTimeout(const double timeout) {
+  pImpl_->setSlaveStateTimeout(timeout);
+}
+
+int EthercatBusBase::getExpectedWorkingCounter() const {
+  return pImpl_->getExpectedWorkingCounter();
+}
+
+bool EthercatBusBase::remapSlave(const uint16_t slave, const std::function<bool()>& writePdoAssignment, const bool sizeCheck) {
+  return pImpl_->remapSlave(slave, writePdoAssignment, sizeCheck);
+}
+
 void EthercatBusBase::updateRead() {
   pImpl_->updateRead();
 }
@@ -980,6 +2732,39 @@ void EthercatBusBase::syncDistributedClock0(const uint16_t slave, const bool act
   pImpl_->syncDistributedClock0(slave, activate, cycleTime, cycleShift);
 }
 
+bool EthercatBusBase::hasDistributedClocks() const {
+  return pImpl_->hasDistributedClocks();
+}
+
+uint16_t EthercatBusBase::getReferenceClock() const {
+  return pImpl_->getReferenceClock();
+}
+
+int64_t EthercatBusBase::getDistributedClockTime() const {
+  return pImpl_->getDistributedClockTime();
+}
+
+int64_t EthercatBusBase::getUpdateReadMonotonicTime() const {
+  return pImpl_->getUpdateReadMonotonicTime();
+}
+
+const common::DistributedClockMapping& EthercatBusBase::getDistributedClockMapping() const {
+  return pImpl_->getDistributedClockMapping();
+}
+
+void EthercatBusBase::syncDistributedClock01(const uint16_t slave, const bool activate, const double cycleTime0, const double cycleTime1,
+                                             const double cycleShift) {
+  pImpl_->syncDistributedClock01(slave, activate, cycleTime0, cycleTime1, cycleShift);
+}
+
+bool EthercatBusBase::slaveHasDistributedClock(const uint16_t slave) const {
+  return pImpl_->slaveHasDistributedClock(slave);
+}
+
+double EthercatBusBase::getMaxPropagationDelay() const {
+  return pImpl_->getMaxPropagationDelay();
+}
+
 EthercatBusBase::PdoSizeMap EthercatBusBase::getHardwarePdoSizes() {
   return pImpl_->getHardwarePdoSizes();
 }
@@ -996,10 +2781,86 @@ bool EthercatBusBase::doBusMonitoring(bool logErrorCounterForDiagnosis) {
   return pImpl_->doBusMonitoring(logErrorCounterForDiagnosis);
 }
 
+bool EthercatBusBase::stepSlaveRecovery() {
+  return pImpl_->stepSlaveRecovery();
+}
+
+bool EthercatBusBase::sweepErrorCounters() {
+  return pImpl_->sweepErrorCounters();
+}
+
+const common::ErrorCounterDiagnosis& EthercatBusBase::getErrorCounterDiagnosis() const {
+  return pImpl_->getErrorCounterDiagnosis();
+}
+
+void EthercatBusBase::setErrorCounterDiagnosisOptions(const common::ErrorCounterDiagnosis::Options& options) {
+  pImpl_->setErrorCounterDiagnosisOptions(options);
+}
+
+bool EthercatBusBase::startFrameCapture(const std::string& path, const common::FrameCapture::Options& options) {
+  return pImpl_->startFrameCapture(path, options);
+}
+
+void EthercatBusBase::stopFrameCapture() {
+  pImpl_->stopFrameCapture();
+}
+
+bool EthercatBusBase::triggerFrameCapture() {
+  return pImpl_->triggerFrameCapture();
+}
+
+const common::FrameCapture& EthercatBusBase::getFrameCapture() const {
+  return pImpl_->getFrameCapture();
+}
+
+bool EthercatBusBase::startProcessImageRecording(const std::string& path, const common::ProcessImageRecorder::Options& options) {
+  return pImpl_->startProcessImageRecording(path, options);
+}
+
+void EthercatBusBase::stopProcessImageRecording() {
+  pImpl_->stopProcessImageRecording();
+}
+
+const common::ProcessImageRecorder& EthercatBusBase::getProcessImageRecorder() const {
+  return pImpl_->getProcessImageRecorder();
+}
+
+bool EthercatBusBase::startReplay(const common::ProcessImageRecording& recording, const uint64_t firstRow, const uint64_t numberOfRows) {
+  return pImpl_->startReplay(recording, firstRow, numberOfRows);
+}
+
+void EthercatBusBase::stopReplay() {
+  pImpl_->stopReplay();
+}
+
+bool EthercatBusBase::replayIsFinished() const {
+  return pImpl_->replayIsFinished();
+}
+
+void EthercatBusBase::setTopologyRefresh(const unsigned int decimation) {
+  pImpl_->setTopologyRefresh(decimation);
+}
+
+std::vector<common::TopologyNode> EthercatBusBase::getSegmentTopology() const {
+  return pImpl_->getSegmentTopology();
+}
+
+void EthercatBusBase::setWorkingCounterAttribution(const bool enable) {
+  pImpl_->setWorkingCounterAttribution(enable);
+}
+
 bool EthercatBusBase::getBusDiagnosisLog(BusDiagnosisLog& busDiagnosisLogOut) {
   return pImpl_->getBusDiagnosisLog(busDiagnosisLogOut);
 }
 
+bool EthercatBusBase::openEventLog(const std::string& path, uint64_t capacity) {
+  return pImpl_->openEventLog(path, capacity);
+}
+
+common::EventLog& EthercatBusBase::getEventLog() {
+  return pImpl_->getEventLog();
+}
+
 bool EthercatBusBase::sendSdoReadVisibleString(const uint16_t slave, const uint16_t index, const uint8_t subindex, std::string& value) {
   assert(static_cast<int>(slave) <= getNumberOfSlaves());
   char buffer[128];
@@ -1029,6 +2890,56 @@ const std::chrono::time_point<std::chrono::high_resolution_clock>& EthercatBusBa
   return pImpl_->getUpateWriteStamp();
 }
 
+common::CycleStatisticsSnapshot EthercatBusBase::getCycleStatistics() const {
+  return pImpl_->getCycleStatistics();
+}
+
+void EthercatBusBase::resetCycleStatistics() {
+  pImpl_->resetCycleStatistics();
+}
+
+int EthercatBusBase::addCyclicRegisterRead(const uint16_t slave, const uint16_t address, const uint16_t length,
+                                           const unsigned int decimation) {
+  return pImpl_->addCyclicRegisterRead(slave, address, length, decimation);
+}
+
+bool EthercatBusBase::getCyclicRegister(const int handle, common::RegisterValue& value) const {
+  return pImpl_->getCyclicRegister(handle, value);
+}
+
+bool EthercatBusBase::addCyclicStatusRead(const common::StatusRegister statusRegister, const uint16_t slave,
+                                          const unsigned int decimation) {
+  return pImpl_->addCyclicStatusRead(statusRegister, slave, decimation);
+}
+
+bool EthercatBusBase::addCyclicStatusReadForAllSlaves(const common::StatusRegister statusRegister, const unsigned int decimation) {
+  return pImpl_->addCyclicStatusReadForAllSlaves(statusRegister, decimation);
+}
+
+bool EthercatBusBase::getSlaveStatus(const uint16_t slave, common::SlaveStatus& status) const {
+  return pImpl_->getSlaveStatus(slave, status);
+}
+
+void EthercatBusBase::enableSlaveTiming(const double budget) {
+  pImpl_->enableSlaveTiming(budget);
+}
+
+void EthercatBusBase::disableSlaveTiming() {
+  pImpl_->disableSlaveTiming();
+}
+
+bool EthercatBusBase::setSlaveBudget(const uint16_t slave, const double budget) {
+  return pImpl_->setSlaveBudget(slave, budget);
+}
+
+std::vector<common::SlaveTimingSnapshot> EthercatBusBase::getSlaveTimings() const {
+  return pImpl_->getSlaveTimings();
+}
+
+std::vector<common::SlaveTimingSnapshot> EthercatBusBase::getTopSlaveTimings(const size_t count, const double fraction) const {
+  return pImpl_->getTopSlaveTimings(count, fraction);
+}
+
 template <>
 bool EthercatBusBase::sendSdoRead<std::string>(const uint16_t slave, const uint16_t index, const uint8_t subindex,
                                                const bool completeAccess, std::string& value) {
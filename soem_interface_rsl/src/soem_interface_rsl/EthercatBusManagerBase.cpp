@@ -23,8 +23,32 @@
 //  anydrive
 #include "soem_interface_rsl/EthercatBusManagerBase.hpp"
 
+// std
+#include <climits>
+#include <cstring>
+
+// linux
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
 namespace soem_interface_rsl {
 
+// The workers and the dispatching thread sleep on the atomics directly, a condition variable would add a mutex handover per cycle.
+static void futexWait(std::atomic<uint32_t>& word, const uint32_t expected) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+static void futexWakeAll(std::atomic<uint32_t>& word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+EthercatBusManagerBase::~EthercatBusManagerBase() {
+  stopBusWorkers();
+}
+
 bool EthercatBusManagerBase::addEthercatBus(soem_interface_rsl::EthercatBusBase* bus) {
   if (bus == nullptr) {
     MELO_ERROR_STREAM("[RokubiminiEthercatBusManager::addEthercatBus] bus is nullptr")
@@ -32,6 +56,10 @@ bool EthercatBusManagerBase::addEthercatBus(soem_interface_rsl::EthercatBusBase*
   }
 
   std::lock_guard<std::mutex> lock(busMutex_);
+  if (workersRunning_) {
+    MELO_ERROR_STREAM("[EthercatBusManagerBase::addEthercatBus] Cannot add a bus while the bus workers are running.")
+    return false;
+  }
   const auto& it = buses_.find(bus->getName());
   if (it == buses_.end()) {
     buses_.insert(std::make_pair(bus->getName(), std::unique_ptr<soem_interface_rsl::EthercatBusBase>(bus)));
@@ -48,6 +76,10 @@ bool EthercatBusManagerBase::addEthercatBus(std::unique_ptr<soem_interface_rsl::
   }
 
   std::lock_guard<std::mutex> lock(busMutex_);
+  if (workersRunning_) {
+    MELO_ERROR_STREAM("[EthercatBusManagerBase::addEthercatBus] Cannot add a bus while the bus workers are running.")
+    return false;
+  }
   const auto& it = buses_.find(bus->getName());
   if (it == buses_.end()) {
     buses_.insert(std::make_pair(bus->getName(), std::move(bus)));
@@ -110,8 +142,41 @@ bool EthercatBusManagerBase::startupCommunication() {
   return true;
 }
 
+bool EthercatBusManagerBase::startupAllBusesStaged() {
+  std::lock_guard<std::mutex> lock(busMutex_);
+  for (auto& bus : buses_) {
+    if (!bus.second->startupStaged(true)) {
+      MELO_ERROR_STREAM("Failed to startup bus '" << bus.first << "'.");
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EthercatBusManagerBase::stepStagedStartupAllBuses() {
+  // No lock on busMutex_: the cyclic readAllBuses() and writeToAllBuses() must keep running during the slave startups.
+  bool finished = true;
+  for (auto& bus : buses_) {
+    finished &= bus.second->stepStagedStartup();
+  }
+  return finished;
+}
+
+bool EthercatBusManagerBase::stepSlaveRecoveryAllBuses() {
+  // No lock on busMutex_, see stepStagedStartupAllBuses().
+  bool allRecovered = true;
+  for (auto& bus : buses_) {
+    allRecovered &= bus.second->stepSlaveRecovery();
+  }
+  return allRecovered;
+}
+
 void EthercatBusManagerBase::readAllBuses() {
   std::lock_guard<std::mutex> lock(busMutex_);
+  if (workersRunning_) {
+    dispatchToBusWorkers(BusTask::Read);
+    return;
+  }
   for (auto& bus : buses_) {
     bus.second->updateRead();
   }
@@ -119,11 +184,150 @@ void EthercatBusManagerBase::readAllBuses() {
 
 void EthercatBusManagerBase::writeToAllBuses() {
   std::lock_guard<std::mutex> lock(busMutex_);
+  if (workersRunning_) {
+    dispatchToBusWorkers(BusTask::Write);
+    return;
+  }
   for (auto& bus : buses_) {
     bus.second->updateWrite();
   }
 }
 
+void EthercatBusManagerBase::updateAllBuses() {
+  std::lock_guard<std::mutex> lock(busMutex_);
+  if (workersRunning_) {
+    dispatchToBusWorkers(BusTask::Update);
+    return;
+  }
+  // Send on all busses before waiting for the first frame.
+  for (auto& bus : buses_) {
+    bus.second->updateWrite();
+  }
+  for (auto& bus : buses_) {
+    bus.second->updateRead();
+  }
+}
+
+bool EthercatBusManagerBase::startBusWorkers(const WorkerOptions& options) {
+  std::lock_guard<std::mutex> lock(busMutex_);
+  if (workersRunning_) {
+    MELO_WARN_STREAM("[EthercatBusManagerBase::startBusWorkers] The bus workers are already running.")
+    return false;
+  }
+  workerOptions_ = options;
+  workersRunning_ = true;
+  size_t index = 0;
+  for (auto& bus : buses_) {
+    auto worker = std::make_unique<BusWorker>();
+    worker->bus = bus.second.get();
+    const int cpu = index < options.cpus.size() ? options.cpus[index] : -1;
+    // The generation is read here, a task dispatched before the thread runs is not missed.
+    worker->generation = workerGeneration_.load(std::memory_order_relaxed);
+    worker->thread = std::thread(&EthercatBusManagerBase::runBusWorker, this, std::ref(*worker), cpu);
+    workers_.push_back(std::move(worker));
+    index++;
+  }
+  MELO_INFO_STREAM("[EthercatBusManagerBase::startBusWorkers] Started " << workers_.size() << " bus workers.")
+  return true;
+}
+
+void EthercatBusManagerBase::stopBusWorkers() {
+  std::lock_guard<std::mutex> lock(busMutex_);
+  if (!workersRunning_) {
+    return;
+  }
+  workersRunning_ = false;
+  workerGeneration_.fetch_add(1, std::memory_order_release);
+  futexWakeAll(workerGeneration_);
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+  workers_.clear();
+}
+
+std::vector<std::string> EthercatBusManagerBase::getBusNames() const {
+  std::vector<std::string> names;
+  for (const auto& bus : buses_) {
+    names.push_back(bus.first);
+  }
+  return names;
+}
+
+void EthercatBusManagerBase::runBusTask(EthercatBusBase& bus, const BusTask task) const {
+  switch (task) {
+    case BusTask::Read:
+      bus.updateRead();
+      break;
+    case BusTask::Write:
+      bus.updateWrite();
+      break;
+    case BusTask::Update:
+      bus.updateWrite();
+      bus.updateRead();
+      break;
+  }
+}
+
+void EthercatBusManagerBase::runBusWorker(BusWorker& worker, const int cpu) {
+  const std::string name = worker.bus->getName();
+  if (cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (result != 0) {
+      MELO_WARN_STREAM("[EthercatBusManagerBase] Could not pin the worker of bus '" << name << "' to CPU " << cpu << ": "
+                                                                                    << std::strerror(result))
+    }
+  }
+  if (workerOptions_.priority > 0) {
+    sched_param parameter{};
+    parameter.sched_priority = workerOptions_.priority;
+    const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameter);
+    if (result != 0) {
+      MELO_WARN_STREAM("[EthercatBusManagerBase] Could not set SCHED_FIFO with priority " << workerOptions_.priority
+                                                                                          << " for the worker of bus '" << name
+                                                                                          << "': " << std::strerror(result))
+    }
+  }
+
+  uint32_t generation = worker.generation;
+  while (true) {
+    uint32_t next = workerGeneration_.load(std::memory_order_acquire);
+    while (next == generation) {
+      if (!workerOptions_.spin) {
+        futexWait(workerGeneration_, generation);
+      }
+      next = workerGeneration_.load(std::memory_order_acquire);
+    }
+    generation = next;
+    if (!workersRunning_) {
+      return;
+    }
+    runBusTask(*worker.bus, static_cast<BusTask>(busTask_.load(std::memory_order_relaxed)));
+    if (pendingWorkers_.fetch_sub(1, std::memory_order_acq_rel) == 1 && !workerOptions_.spin) {
+      futexWakeAll(pendingWorkers_);
+    }
+  }
+}
+
+void EthercatBusManagerBase::dispatchToBusWorkers(const BusTask task) {
+  busTask_.store(static_cast<int>(task), std::memory_order_relaxed);
+  pendingWorkers_.store(static_cast<uint32_t>(workers_.size()), std::memory_order_relaxed);
+  workerGeneration_.fetch_add(1, std::memory_order_release);
+  if (!workerOptions_.spin) {
+    futexWakeAll(workerGeneration_);
+  }
+  // Barrier: all busses are done before the caller continues with the inputs.
+  uint32_t pending = pendingWorkers_.load(std::memory_order_acquire);
+  while (pending != 0) {
+    if (!workerOptions_.spin) {
+      futexWait(pendingWorkers_, pending);
+    }
+    pending = pendingWorkers_.load(std::memory_order_acquire);
+  }
+}
+
 void EthercatBusManagerBase::shutdownAllBuses() {
   std::lock_guard<std::mutex> lock(busMutex_);
   for (auto& bus : buses_) {
@@ -132,12 +336,17 @@ void EthercatBusManagerBase::shutdownAllBuses() {
 }
 
 std::unique_ptr<EthercatBusBase> EthercatBusManagerBase::extractBusByName(const std::string& name) {
+  stopBusWorkers();
+  // Another thread may still update the remaining busses serially.
+  std::lock_guard<std::mutex> lock(busMutex_);
   std::unique_ptr<EthercatBusBase> busOut = std::move(buses_.at(name));
   buses_.erase(name);
   return busOut;
 }
 
 EthercatBusManagerBase::BusMap EthercatBusManagerBase::extractBuses() {
+  stopBusWorkers();
+  std::lock_guard<std::mutex> lock(busMutex_);
   BusMap busMapOut;
 
   for (auto& bus : buses_) {
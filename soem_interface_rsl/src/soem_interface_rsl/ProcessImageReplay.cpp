@@ -0,0 +1,166 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// soem_interface_rsl
+#include "soem_interface_rsl/ProcessImageReplay.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+// linux
+#include <time.h>
+
+// message logger
+#include <message_logger/message_logger.hpp>
+
+namespace soem_interface_rsl {
+
+namespace {
+
+double getClock(const clockid_t clock) {
+  timespec time{};
+  clock_gettime(clock, &time);
+  return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+}
+
+std::string getSlaveName(const common::ProcessImageColumnDescriptor& column) {
+  const std::string name(column.name, strnlen(column.name, sizeof(column.name)));
+  return name.substr(0, name.rfind('.'));
+}
+
+}  // namespace
+
+ProcessImageReplay::ProcessImageReplay(EthercatBusBase& bus) : bus_(bus) {}
+
+bool ProcessImageReplay::run(const std::string& path, const Options& options, Result& result, const Callback& callback) {
+  result = Result();
+  common::ProcessImageRecording recording;
+  if (!recording.open(path) || !bus_.startReplay(recording, options.firstRow, options.numberOfRows)) {
+    return false;
+  }
+  const bool compareOutputs = !options.outputPath.empty();
+  if (compareOutputs && !bus_.startProcessImageRecording(options.outputPath)) {
+    bus_.stopReplay();
+    return false;
+  }
+  const common::ProcessImageRecorder& recorder = bus_.getProcessImageRecorder();
+
+  // the first updateRead() needs process data to be sent, as in the cyclic exchange. The outputs of this priming cycle end up in the
+  // first replayed row, they were not computed from recorded inputs and are left out of the comparison.
+  bus_.updateWrite();
+  constexpr uint64_t primingRows = 1;
+  result.firstComparedRow = options.firstRow + primingRows;
+  // reading the thread CPU clock is a system call, it would dominate short cycles if read every cycle. Waiting does not use CPU time.
+  const double cpuStart = getClock(CLOCK_THREAD_CPUTIME_ID);
+  while (!bus_.replayIsFinished()) {
+    // the recorder drops rows instead of blocking, waiting for it keeps the rows of the replay aligned with the recording.
+    while (compareOutputs && recorder.getNumberOfPendingRows() + 1 >= recorder.getRingCapacity()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const double wallStart = getClock(CLOCK_MONOTONIC);
+    bus_.updateRead();
+    if (callback) {
+      callback();
+    }
+    bus_.updateWrite();
+    const double wallTime = getClock(CLOCK_MONOTONIC) - wallStart;
+    result.wallTime += wallTime;
+    result.maxCycleWallTime = std::max(result.maxCycleWallTime, wallTime);
+    result.cycles++;
+  }
+  result.cpuTime = getClock(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+
+  bool success = true;
+  if (compareOutputs) {
+    bus_.stopProcessImageRecording();
+    common::ProcessImageRecording replayed;
+    success = replayed.open(options.outputPath) && compare(recording, options.firstRow, replayed, result.differences, primingRows);
+  }
+  bus_.stopReplay();
+
+  MELO_INFO_STREAM("[soem_interface_rsl::ProcessImageReplay] Replayed " << result.cycles << " cycles of '" << path << "' in "
+                                                                        << result.wallTime << " s, " << result.cpuTime << " s CPU time.")
+  for (const SlaveDifference& difference : result.differences) {
+    MELO_WARN_STREAM("[soem_interface_rsl::ProcessImageReplay] Outputs of slave " << difference.slave << " (" << difference.name
+                                                                                  << ") differ in " << difference.rows
+                                                                                  << " rows, first in row " << difference.firstRow
+                                                                                  << " at byte " << difference.firstByte << ".")
+  }
+  return success;
+}
+
+bool ProcessImageReplay::compare(const common::ProcessImageRecording& reference, const uint64_t firstRow,
+                                 const common::ProcessImageRecording& replayed, std::vector<SlaveDifference>& differences,
+                                 const uint64_t skippedRows) {
+  differences.clear();
+  const uint64_t rows = replayed.getNumberOfRows();
+  if (firstRow + rows > reference.getNumberOfRows()) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageReplay] The replay has more rows than the reference.")
+    return false;
+  }
+  // the replay takes over the stamps of the reference, a mismatch means a row got lost or the recordings do not belong together.
+  for (uint64_t row = 0; row < rows; row++) {
+    if (replayed.getRowHeader(row).stamp != reference.getRowHeader(firstRow + row).stamp) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageReplay] Row " << row << " of the replay does not match row " << firstRow + row
+                                                                        << " of the reference.")
+      return false;
+    }
+  }
+
+  const auto& columns = reference.getColumns();
+  for (size_t i = 0; i < columns.size(); i++) {
+    if (columns[i].kind != static_cast<uint8_t>(common::ProcessImageColumnKind::Outputs)) {
+      continue;
+    }
+    const int replayedColumn = replayed.findColumn(columns[i].slave, common::ProcessImageColumnKind::Outputs);
+    if (replayedColumn < 0 || replayed.getColumns()[replayedColumn].width != columns[i].width) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageReplay] The outputs of slave " << columns[i].slave
+                                                                                         << " are missing or differ in size in the replay.")
+      return false;
+    }
+    SlaveDifference difference;
+    difference.slave = columns[i].slave;
+    difference.name = getSlaveName(columns[i]);
+    for (uint64_t row = skippedRows; row < rows; row++) {
+      const uint8_t* expected = reference.getCell(i, firstRow + row);
+      const uint8_t* actual = replayed.getCell(static_cast<size_t>(replayedColumn), row);
+      if (std::memcmp(expected, actual, columns[i].width) == 0) {
+        continue;
+      }
+      if (difference.rows == 0) {
+        difference.firstRow = firstRow + row;
+        difference.firstByte = static_cast<size_t>(std::mismatch(expected, expected + columns[i].width, actual).first - expected);
+      }
+      difference.rows++;
+    }
+    if (difference.rows > 0) {
+      differences.push_back(difference);
+    }
+  }
+  return true;
+}
+
+}  // namespace soem_interface_rsl
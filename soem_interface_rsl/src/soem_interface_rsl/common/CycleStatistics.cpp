@@ -0,0 +1,201 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/CycleStatistics.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+namespace soem_interface_rsl {
+namespace common {
+
+int64_t HistogramSnapshot::getPercentile(const double fraction) const {
+  if (count == 0) {
+    return 0;
+  }
+  const auto target = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count)));
+  uint64_t cumulative = 0;
+  for (unsigned int i = 0; i < counts.size(); i++) {
+    cumulative += counts[i];
+    if (cumulative >= target && counts[i] > 0) {
+      // Highest value of the bucket, the percentile is not underestimated.
+      const int64_t upper = i + 1 < counts.size() ? LatencyHistogram::getBucketLowerBound(i + 1) - 1 : max;
+      return std::clamp(upper, min, max);
+    }
+  }
+  return max;
+}
+
+unsigned int LatencyHistogram::getBucketIndex(const int64_t value) {
+  if (value < static_cast<int64_t>(subBuckets)) {
+    return static_cast<unsigned int>(std::max<int64_t>(value, 0));
+  }
+  const auto bit = static_cast<unsigned int>(63 - __builtin_clzll(static_cast<uint64_t>(value)));
+  if (bit > maxBit) {
+    return numberOfBuckets - 1;
+  }
+  const unsigned int shift = bit - subBucketBits;
+  return (shift + 1) * subBuckets + static_cast<unsigned int>((static_cast<uint64_t>(value) >> shift) & (subBuckets - 1));
+}
+
+int64_t LatencyHistogram::getBucketLowerBound(const unsigned int index) {
+  if (index < subBuckets) {
+    return index;
+  }
+  const unsigned int shift = index / subBuckets - 1;
+  return static_cast<int64_t>(subBuckets + index % subBuckets) << shift;
+}
+
+void LatencyHistogram::record(const int64_t value) {
+  const int64_t clamped = std::max<int64_t>(value, 0);
+  increment(counts_[getBucketIndex(clamped)]);
+  const uint64_t count = count_.load(std::memory_order_relaxed);
+  if (count == 0 || clamped < min_.load(std::memory_order_relaxed)) {
+    min_.store(clamped, std::memory_order_relaxed);
+  }
+  if (count == 0 || clamped > max_.load(std::memory_order_relaxed)) {
+    max_.store(clamped, std::memory_order_relaxed);
+  }
+  const auto sample = static_cast<double>(clamped);
+  sum_.store(sum_.load(std::memory_order_relaxed) + sample, std::memory_order_relaxed);
+  sumOfSquares_.store(sumOfSquares_.load(std::memory_order_relaxed) + sample * sample, std::memory_order_relaxed);
+  // Published last, a reader seeing the count also sees the sample in the bucket.
+  count_.store(count + 1, std::memory_order_release);
+}
+
+void LatencyHistogram::reset() {
+  for (auto& count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  min_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+  sum_.store(0.0, std::memory_order_relaxed);
+  sumOfSquares_.store(0.0, std::memory_order_relaxed);
+  count_.store(0, std::memory_order_release);
+}
+
+HistogramSnapshot LatencyHistogram::getSnapshot() const {
+  HistogramSnapshot snapshot;
+  snapshot.count = count_.load(std::memory_order_acquire);
+  snapshot.counts.resize(numberOfBuckets);
+  for (unsigned int i = 0; i < numberOfBuckets; i++) {
+    snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+  }
+  if (snapshot.count == 0) {
+    return snapshot;
+  }
+  snapshot.min = min_.load(std::memory_order_relaxed);
+  snapshot.max = max_.load(std::memory_order_relaxed);
+  const auto count = static_cast<double>(snapshot.count);
+  snapshot.mean = sum_.load(std::memory_order_relaxed) / count;
+  const double variance = sumOfSquares_.load(std::memory_order_relaxed) / count - snapshot.mean * snapshot.mean;
+  snapshot.standardDeviation = std::sqrt(std::max(variance, 0.0));
+  return snapshot;
+}
+
+int64_t CycleStatistics::now() {
+  timespec time{};
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+int64_t CycleStatistics::startCycle() {
+  if (resetRequested_.exchange(false, std::memory_order_acq_rel)) {
+    applyReset();
+  }
+  const int64_t start = now();
+  if (lastCycleStart_ != 0) {
+    period_.record(start - lastCycleStart_);
+  }
+  lastCycleStart_ = start;
+  return start;
+}
+
+int64_t CycleStatistics::recordPhase(const Phase phase, const int64_t start) {
+  const int64_t end = now();
+  phases_[static_cast<unsigned int>(phase)].record(end - start);
+  return end;
+}
+
+void CycleStatistics::recordWorkingCounter(const int workingCounter, const int expectedWorkingCounter) {
+  const uint64_t cycles = cycles_.load(std::memory_order_relaxed);
+  if (cycles == 0 || workingCounter < workingCounterMin_.load(std::memory_order_relaxed)) {
+    workingCounterMin_.store(workingCounter, std::memory_order_relaxed);
+  }
+  workingCounterSum_.store(workingCounterSum_.load(std::memory_order_relaxed) + workingCounter, std::memory_order_relaxed);
+  if (workingCounter < expectedWorkingCounter) {
+    const uint64_t run = currentLowWorkingCounterRun_.load(std::memory_order_relaxed) + 1;
+    currentLowWorkingCounterRun_.store(run, std::memory_order_relaxed);
+    if (run == 1) {
+      lowWorkingCounterRuns_.store(lowWorkingCounterRuns_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    if (run > longestLowWorkingCounterRun_.load(std::memory_order_relaxed)) {
+      longestLowWorkingCounterRun_.store(run, std::memory_order_relaxed);
+    }
+  } else {
+    currentLowWorkingCounterRun_.store(0, std::memory_order_relaxed);
+  }
+  cycles_.store(cycles + 1, std::memory_order_release);
+}
+
+void CycleStatistics::reset() {
+  resetRequested_.store(true, std::memory_order_release);
+}
+
+void CycleStatistics::applyReset() {
+  for (auto& phase : phases_) {
+    phase.reset();
+  }
+  period_.reset();
+  lastCycleStart_ = 0;
+  cycles_.store(0, std::memory_order_relaxed);
+  workingCounterMin_.store(0, std::memory_order_relaxed);
+  workingCounterSum_.store(0, std::memory_order_relaxed);
+  lowWorkingCounterRuns_.store(0, std::memory_order_relaxed);
+  longestLowWorkingCounterRun_.store(0, std::memory_order_relaxed);
+  currentLowWorkingCounterRun_.store(0, std::memory_order_relaxed);
+}
+
+CycleStatisticsSnapshot CycleStatistics::getSnapshot() const {
+  CycleStatisticsSnapshot snapshot;
+  snapshot.writeSlaves = phases_[static_cast<unsigned int>(Phase::WriteSlaves)].getSnapshot();
+  snapshot.send = phases_[static_cast<unsigned int>(Phase::Send)].getSnapshot();
+  snapshot.receive = phases_[static_cast<unsigned int>(Phase::Receive)].getSnapshot();
+  snapshot.readSlaves = phases_[static_cast<unsigned int>(Phase::ReadSlaves)].getSnapshot();
+  snapshot.period = period_.getSnapshot();
+  snapshot.cycles = cycles_.load(std::memory_order_acquire);
+  snapshot.workingCounterMin = workingCounterMin_.load(std::memory_order_relaxed);
+  if (snapshot.cycles > 0) {
+    snapshot.workingCounterAverage =
+        static_cast<double>(workingCounterSum_.load(std::memory_order_relaxed)) / static_cast<double>(snapshot.cycles);
+  }
+  snapshot.lowWorkingCounterRuns = lowWorkingCounterRuns_.load(std::memory_order_relaxed);
+  snapshot.longestLowWorkingCounterRun = longestLowWorkingCounterRun_.load(std::memory_order_relaxed);
+  snapshot.currentLowWorkingCounterRun = currentLowWorkingCounterRun_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
@@ -0,0 +1,124 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/CyclicRegisters.hpp"
+
+// std
+#include <algorithm>
+#include <thread>
+
+namespace soem_interface_rsl {
+namespace common {
+
+StatusRegisterBlock StatusRegisterBlock::get(const StatusRegister statusRegister) {
+  switch (statusRegister) {
+    case StatusRegister::AlStatus:
+      return {0x0130, 6};
+    case StatusRegister::DlStatus:
+      return {0x0110, 2};
+    case StatusRegister::ErrorCounters:
+      return {0x0300, 20};
+  }
+  return {0, 0};
+}
+
+int CyclicRegisterTable::add(const uint16_t slave, const uint16_t stationAddress, const uint16_t address, const uint16_t length,
+                             const unsigned int decimation) {
+  if (length == 0 || length > RegisterValue::maxLength) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> lock(addMutex_);
+  const int existing = find(slave, address, length);
+  if (existing >= 0) {
+    entries_[existing].read.decimation.store(std::max(decimation, 1u), std::memory_order_relaxed);
+    return existing;
+  }
+  const size_t handle = size_.load(std::memory_order_relaxed);
+  if (handle >= capacity) {
+    return -1;
+  }
+  Read& read = entries_[handle].read;
+  read.slave = slave;
+  read.stationAddress = stationAddress;
+  read.address = address;
+  read.length = length;
+  read.decimation.store(std::max(decimation, 1u), std::memory_order_relaxed);
+  read.dueCycle = 0;
+  // The cyclic thread only looks at entries below size_.
+  size_.store(handle + 1, std::memory_order_release);
+  return static_cast<int>(handle);
+}
+
+int CyclicRegisterTable::find(const uint16_t slave, const uint16_t address, const uint16_t length) const {
+  const size_t size = size_.load(std::memory_order_acquire);
+  for (size_t handle = 0; handle < size; handle++) {
+    const Read& read = entries_[handle].read;
+    if (read.slave == slave && read.address == address && read.length == length) {
+      return static_cast<int>(handle);
+    }
+  }
+  return -1;
+}
+
+void CyclicRegisterTable::publish(const size_t handle, const uint8_t* data, const uint16_t workingCounter, const uint64_t cycle,
+                                  const int64_t stamp) {
+  Entry& entry = entries_[handle];
+  const uint64_t sequence = entry.sequence.load(std::memory_order_relaxed);
+  // seqlock, readers retry while the sequence is odd or changed.
+  entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(entry.data.data(), data, entry.read.length);
+  entry.workingCounter = workingCounter;
+  entry.cycle = cycle;
+  entry.stamp = stamp;
+  entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool CyclicRegisterTable::get(const int handle, RegisterValue& value) const {
+  if (handle < 0 || static_cast<size_t>(handle) >= size_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  const Entry& entry = entries_[handle];
+  value.slave = entry.read.slave;
+  value.address = entry.read.address;
+  value.length = entry.read.length;
+  value.decimation = entry.read.decimation.load(std::memory_order_relaxed);
+  while (true) {
+    const uint64_t before = entry.sequence.load(std::memory_order_acquire);
+    if ((before & 1u) != 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    std::memcpy(value.data.data(), entry.data.data(), RegisterValue::maxLength);
+    value.workingCounter = entry.workingCounter;
+    value.cycle = entry.cycle;
+    value.stamp = entry.stamp;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (entry.sequence.load(std::memory_order_relaxed) == before) {
+      return true;
+    }
+  }
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
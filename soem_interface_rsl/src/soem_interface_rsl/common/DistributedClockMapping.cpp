@@ -0,0 +1,234 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/DistributedClockMapping.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+namespace soem_interface_rsl {
+namespace common {
+
+DistributedClockMapping::DistributedClockMapping(const size_t windowSize, const size_t minSamples, const double rejectionFactor,
+                                                 const double minRejectionThreshold)
+    : minSamples_(std::max<size_t>(minSamples, 3)),
+      rejectionFactor_(rejectionFactor),
+      minRejectionThreshold_(minRejectionThreshold),
+      samples_(std::max(windowSize, minSamples_)) {}
+
+void DistributedClockMapping::reset() {
+  next_ = 0;
+  size_ = 0;
+  outliersInWindow_ = 0;
+  model_ = Model();
+  latestDistributedClockTime_.store(0, std::memory_order_relaxed);
+  outliers_.store(0, std::memory_order_relaxed);
+  publish();
+}
+
+void DistributedClockMapping::addSample(const int64_t distributedClockTime, const int64_t monotonicTime) {
+  const size_t capacity = samples_.size();
+  if (size_ > 0 && samples_[(next_ + capacity - 1) % capacity].distributedClockTime == distributedClockTime) {
+    // The frame did not carry a new DC time.
+    return;
+  }
+
+  Sample sample{distributedClockTime, monotonicTime, false};
+  sample.outlier = isOutlier(sample);
+  if (sample.outlier) {
+    outliers_.fetch_add(1, std::memory_order_relaxed);
+    if (2 * (outliersInWindow_ + 1) > size_ && size_ >= minSamples_) {
+      // Most of the window deviates from the mapping, one of the clocks has been stepped. Start over.
+      next_ = 0;
+      size_ = 0;
+      outliersInWindow_ = 0;
+      model_.valid = false;
+      sample.outlier = false;
+    }
+  }
+
+  if (size_ == capacity) {
+    outliersInWindow_ -= samples_[next_].outlier ? 1 : 0;
+  } else {
+    size_++;
+  }
+  samples_[next_] = sample;
+  next_ = (next_ + 1) % capacity;
+  outliersInWindow_ += sample.outlier ? 1 : 0;
+  latestDistributedClockTime_.store(distributedClockTime, std::memory_order_relaxed);
+
+  if (!fit() && !model_.valid) {
+    publish();
+  }
+}
+
+bool DistributedClockMapping::isOutlier(const Sample& sample) const {
+  if (!model_.valid) {
+    return false;
+  }
+  const double x = static_cast<double>(sample.distributedClockTime - model_.distributedClockReference);
+  const double residual = static_cast<double>(sample.monotonicTime - model_.monotonicReference) - model_.offset - model_.slope * x;
+  return std::abs(residual) > std::max(rejectionFactor_ * model_.residualRms, minRejectionThreshold_);
+}
+
+bool DistributedClockMapping::fit() {
+  const size_t capacity = samples_.size();
+  const size_t inliers = size_ - outliersInWindow_;
+  if (inliers < minSamples_) {
+    return false;
+  }
+
+  // Regress relative to the latest sample, the differences fit into a double without loss.
+  const Sample& latest = samples_[(next_ + capacity - 1) % capacity];
+  const auto forEachInlier = [&](const auto& function) {
+    for (size_t i = 0; i < size_; i++) {
+      const Sample& sample = samples_[i];
+      if (!sample.outlier) {
+        function(static_cast<double>(sample.distributedClockTime - latest.distributedClockTime),
+                 static_cast<double>(sample.monotonicTime - latest.monotonicTime));
+      }
+    }
+  };
+
+  double meanX = 0.0;
+  double meanY = 0.0;
+  forEachInlier([&](const double x, const double y) {
+    meanX += x;
+    meanY += y;
+  });
+  meanX /= static_cast<double>(inliers);
+  meanY /= static_cast<double>(inliers);
+
+  double sxx = 0.0;
+  double sxy = 0.0;
+  forEachInlier([&](const double x, const double y) {
+    sxx += (x - meanX) * (x - meanX);
+    sxy += (x - meanX) * (y - meanY);
+  });
+  if (sxx <= 0.0) {
+    return false;
+  }
+  const double slope = sxy / sxx;
+  const double offset = meanY - slope * meanX;
+
+  double squaredResiduals = 0.0;
+  forEachInlier([&](const double x, const double y) {
+    const double residual = y - offset - slope * x;
+    squaredResiduals += residual * residual;
+  });
+
+  model_.distributedClockReference = latest.distributedClockTime;
+  model_.monotonicReference = latest.monotonicTime;
+  model_.offset = offset;
+  model_.slope = slope;
+  model_.residualRms = std::sqrt(squaredResiduals / static_cast<double>(inliers - 2));
+  model_.valid = true;
+  publish();
+  return true;
+}
+
+void DistributedClockMapping::publish() {
+  const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  distributedClockReference_.store(model_.distributedClockReference, std::memory_order_relaxed);
+  monotonicReference_.store(model_.monotonicReference, std::memory_order_relaxed);
+  offset_.store(model_.offset, std::memory_order_relaxed);
+  slope_.store(model_.slope, std::memory_order_relaxed);
+  residualRms_.store(model_.residualRms, std::memory_order_relaxed);
+  valid_.store(model_.valid, std::memory_order_relaxed);
+  sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+DistributedClockMapping::Model DistributedClockMapping::load() const {
+  Model model;
+  uint32_t before = 0;
+  do {
+    before = sequence_.load(std::memory_order_acquire);
+    model.distributedClockReference = distributedClockReference_.load(std::memory_order_relaxed);
+    model.monotonicReference = monotonicReference_.load(std::memory_order_relaxed);
+    model.offset = offset_.load(std::memory_order_relaxed);
+    model.slope = slope_.load(std::memory_order_relaxed);
+    model.residualRms = residualRms_.load(std::memory_order_relaxed);
+    model.valid = valid_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((before & 1u) != 0 || sequence_.load(std::memory_order_relaxed) != before);
+  return model;
+}
+
+bool DistributedClockMapping::isValid() const {
+  return valid_.load(std::memory_order_relaxed);
+}
+
+bool DistributedClockMapping::toMonotonic(const int64_t distributedClockTime, int64_t& monotonicTime) const {
+  const Model model = load();
+  if (!model.valid) {
+    return false;
+  }
+  // Only the correction goes through the double, the integer part of the difference stays exact over any distance.
+  const int64_t difference = distributedClockTime - model.distributedClockReference;
+  monotonicTime = model.monotonicReference + difference +
+                  static_cast<int64_t>(std::llround(model.offset + (model.slope - 1.0) * static_cast<double>(difference)));
+  return true;
+}
+
+bool DistributedClockMapping::toMonotonic32(const uint32_t distributedClockTime, int64_t& monotonicTime) const {
+  const int64_t latest = latestDistributedClockTime_.load(std::memory_order_relaxed);
+  const auto difference = static_cast<int32_t>(distributedClockTime - static_cast<uint32_t>(latest));
+  return toMonotonic(latest + difference, monotonicTime);
+}
+
+bool DistributedClockMapping::toDistributedClock(const int64_t monotonicTime, int64_t& distributedClockTime) const {
+  const Model model = load();
+  if (!model.valid) {
+    return false;
+  }
+  const int64_t difference = monotonicTime - model.monotonicReference;
+  const double correction = (static_cast<double>(difference) - model.offset) / model.slope - static_cast<double>(difference);
+  distributedClockTime = model.distributedClockReference + difference + static_cast<int64_t>(std::llround(correction));
+  return true;
+}
+
+double DistributedClockMapping::getResidualRms() const {
+  return load().residualRms;
+}
+
+double DistributedClockMapping::getDrift() const {
+  // monotonic = slope * distributed clock, a faster host clock advances more per DC ns.
+  return 1e6 * (load().slope - 1.0);
+}
+
+uint64_t DistributedClockMapping::getNumberOfOutliers() const {
+  return outliers_.load(std::memory_order_relaxed);
+}
+
+int64_t DistributedClockMapping::getMonotonicTime() {
+  timespec time{};
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
@@ -0,0 +1,133 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/ErrorCounterDiagnosis.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace soem_interface_rsl {
+namespace common {
+
+namespace {
+
+using Counters = REG::ERROR_COUNTERS;
+template <Counters counter>
+constexpr uint16_t offset = registerBlockOffset<REG::ERROR_COUNTERS_LIST, counter>;
+
+// offsets per port in the raw block, resolved at compile time.
+constexpr std::array<uint16_t, 4> frameErrorOffsets{offset<Counters::FRAME_ERROR_PORT0_ADDR>, offset<Counters::FRAME_ERROR_PORT1_ADDR>,
+                                                    offset<Counters::FRAME_ERROR_PORT2_ADDR>, offset<Counters::FRAME_ERROR_PORT3_ADDR>};
+constexpr std::array<uint16_t, 4> physicalErrorOffsets{
+    offset<Counters::PHYSICAL_ERROR_PORT0_ADDR>, offset<Counters::PHYSICAL_ERROR_PORT1_ADDR>, offset<Counters::PHYSICAL_ERROR_PORT2_ADDR>,
+    offset<Counters::PHYSICAL_ERROR_PORT3_ADDR>};
+constexpr std::array<uint16_t, 4> forwardedErrorOffsets{
+    offset<Counters::PREVIOUS_ERROR_CNT_PORT0>, offset<Counters::PREVIOUS_ERROR_CNT_PORT1>, offset<Counters::PREVIOUS_ERROR_CNT_PORT2>,
+    offset<Counters::PREVIOUS_ERROR_CNT_PORT3>};
+constexpr std::array<uint16_t, 4> lostLinkOffsets{offset<Counters::LOST_LINK_CNT_PORT0>, offset<Counters::LOST_LINK_CNT_PORT1>,
+                                                  offset<Counters::LOST_LINK_CNT_PORT2>, offset<Counters::LOST_LINK_CNT_PORT3>};
+static_assert(offset<Counters::LOST_LINK_CNT_PORT3> == ErrorCounterDiagnosis::blockLength - 1);
+
+void filter(double& average, const double value, const double dt, const double timeConstant) {
+  average += (1.0 - std::exp(-dt / timeConstant)) * (value - average);
+}
+
+}  // namespace
+
+void ErrorCounterDiagnosis::reset(const uint16_t nSlaves) {
+  slaves_.assign(static_cast<size_t>(nSlaves) + 1, Slave());
+}
+
+bool ErrorCounterDiagnosis::update(const uint16_t slave, const uint8_t* block, const double time) {
+  if (slave == 0 || slave >= slaves_.size()) {
+    return false;
+  }
+  Slave& entry = slaves_[slave];
+  const bool first = entry.time < 0.0;
+  const double dt = time - entry.time;
+  bool clear = false;
+  // the counters only count up and saturate, a lower value means they have been cleared in between.
+  const auto delta = [&](const uint16_t offset, bool& saturated) -> uint64_t {
+    const uint8_t value = block[offset];
+    const uint8_t previous = entry.previous[offset];
+    saturated |= value == 0xff;
+    clear |= value >= options_.clearThreshold;
+    return value >= previous ? value - previous : value;
+  };
+
+  SlaveErrorCounters& counters = entry.counters;
+  bool unused = false;
+  counters.processingUnitErrors += delta(offset<Counters::MALFORMAT_FRAME_CNT>, unused);
+  counters.pdiErrors += delta(offset<Counters::LOCAL_PROBLEM_CNT>, unused);
+  for (size_t p = 0; p < counters.ports.size(); p++) {
+    PortErrorCounters& port = counters.ports[p];
+    const uint64_t rxErrors = delta(frameErrorOffsets[p], port.saturated) + delta(physicalErrorOffsets[p], port.saturated);
+    const uint64_t lostLinks = delta(lostLinkOffsets[p], port.saturated);
+    port.rxErrors += rxErrors;
+    port.forwardedErrors += delta(forwardedErrorOffsets[p], port.saturated);
+    port.lostLinks += lostLinks;
+    if (first || dt <= 0.0) {
+      // counts since power up, no rate.
+      continue;
+    }
+    filter(port.rxErrorRate, static_cast<double>(rxErrors) / dt, dt, options_.shortTimeConstant);
+    filter(port.rxErrorRateLongTerm, static_cast<double>(rxErrors) / dt, dt, options_.longTimeConstant);
+    filter(port.lostLinkRate, static_cast<double>(lostLinks) / dt, dt, options_.shortTimeConstant);
+    port.rxErrorTrend = port.rxErrorRate - port.rxErrorRateLongTerm;
+    port.health = std::exp(-(port.rxErrorRate / options_.rxErrorRateScale + port.lostLinkRate / options_.lostLinkRateScale));
+  }
+  std::copy(block, block + blockLength, entry.previous.begin());
+  entry.time = time;
+  counters.sweeps++;
+  return clear;
+}
+
+void ErrorCounterDiagnosis::cleared(const uint16_t slave) {
+  if (slave > 0 && slave < slaves_.size()) {
+    slaves_[slave].previous.fill(0);
+  }
+}
+
+std::vector<LinkHealth> ErrorCounterDiagnosis::getWorstLinks(const size_t count) const {
+  std::vector<LinkHealth> links;
+  for (size_t slave = 1; slave < slaves_.size(); slave++) {
+    const auto& ports = slaves_[slave].counters.ports;
+    for (size_t p = 0; p < ports.size(); p++) {
+      if (ports[p].rxErrors > 0 || ports[p].lostLinks > 0) {
+        links.push_back(
+            {static_cast<uint16_t>(slave), static_cast<uint8_t>(p), ports[p].health, ports[p].rxErrorRate, ports[p].rxErrorTrend});
+      }
+    }
+  }
+  std::sort(links.begin(), links.end(), [](const LinkHealth& a, const LinkHealth& b) {
+    return a.health < b.health || (a.health == b.health && a.rxErrorTrend > b.rxErrorTrend);
+  });
+  if (links.size() > count) {
+    links.resize(count);
+  }
+  return links;
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
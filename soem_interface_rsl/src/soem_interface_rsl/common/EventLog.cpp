@@ -0,0 +1,277 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/EventLog.hpp"
+
+// std
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+// linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// message logger
+#include <message_logger/message_logger.hpp>
+
+namespace soem_interface_rsl {
+namespace common {
+
+/**
+ * @brief      EventRecord as it is stored in the file. The sequence is
+ *             shared with readers in other processes, it is constructed in
+ *             place when the file is created
+ */
+struct EventLogSlot {
+  uint64_t stamp;
+  std::atomic<uint32_t> sequence;
+  uint16_t type;
+  uint16_t slave;
+  uint32_t code;
+  uint16_t index;
+  uint8_t subIndex;
+  uint8_t reserved;
+  int32_t value0;
+  int32_t value1;
+};
+static_assert(sizeof(EventLogSlot) == sizeof(EventRecord) && offsetof(EventLogSlot, sequence) == offsetof(EventRecord, sequence) &&
+                  offsetof(EventLogSlot, value1) == offsetof(EventRecord, value1),
+              "The slot has to match the event record.");
+static_assert(std::is_standard_layout_v<EventLogSlot>, "The event log slot is part of the file format.");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "The record sequence is shared through the file mapping.");
+
+static size_t getFileSize(const uint64_t capacity) {
+  return sizeof(EventLogHeader) + capacity * sizeof(EventRecord);
+}
+
+static bool headerIsValid(const EventLogHeader& header, const size_t fileSize) {
+  return std::memcmp(header.magic, EventLogHeader::magic_, sizeof(header.magic)) == 0 && header.version == EventLogHeader::version_ &&
+         header.recordSize == sizeof(EventRecord) && header.capacity > 0 && getFileSize(header.capacity) <= fileSize;
+}
+
+EventLog::~EventLog() {
+  close();
+}
+
+bool EventLog::open(const std::string& path, uint64_t capacity, const std::string& busName) {
+  close();
+  if (capacity == 0) {
+    MELO_ERROR_STREAM("[EventLog] The capacity of the event log '" << path << "' must not be zero.")
+    return false;
+  }
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    MELO_ERROR_STREAM("[EventLog] Could not open the event log '" << path << "': " << std::strerror(errno))
+    return false;
+  }
+  const size_t size = getFileSize(capacity);
+  struct stat status {};
+  bool reuse = false;
+  if (fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) == size) {
+    EventLogHeader existing{};
+    reuse = pread(fd, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing)) && headerIsValid(existing, size) &&
+            existing.capacity == capacity;
+  }
+  if (!reuse && (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+    MELO_ERROR_STREAM("[EventLog] Could not resize the event log '" << path << "': " << std::strerror(errno))
+    ::close(fd);
+    return false;
+  }
+  void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    MELO_ERROR_STREAM("[EventLog] Could not map the event log '" << path << "': " << std::strerror(errno))
+    return false;
+  }
+  // fault in the pages now instead of in the first cycles.
+  madvise(mapping, size, MADV_WILLNEED);
+
+  char* const base = static_cast<char*>(mapping);
+  if (reuse) {
+    // the objects were constructed by the process which created the file.
+    header_ = std::launder(reinterpret_cast<EventLogHeader*>(base));
+    slots_ = std::launder(reinterpret_cast<EventLogSlot*>(base + sizeof(EventLogHeader)));
+  } else {
+    header_ = new (base) EventLogHeader{};
+    std::memcpy(header_->magic, EventLogHeader::magic_, sizeof(header_->magic));
+    header_->version = EventLogHeader::version_;
+    header_->recordSize = sizeof(EventRecord);
+    header_->capacity = capacity;
+    header_->head.store(0);
+    slots_ = reinterpret_cast<EventLogSlot*>(base + sizeof(EventLogHeader));
+    for (uint64_t position = 0; position < capacity; position++) {
+      new (&slots_[position]) EventLogSlot{};
+    }
+  }
+  capacity_ = capacity;
+  mappedSize_ = size;
+  std::memset(header_->busName, 0, sizeof(header_->busName));
+  std::strncpy(header_->busName, busName.c_str(), sizeof(header_->busName) - 1);
+  MELO_INFO_STREAM("[EventLog] " << (reuse ? "Continuing" : "Created") << " event log '" << path << "' with " << capacity
+                                 << " records, " << header_->head.load() << " written so far.")
+  return true;
+}
+
+void EventLog::close() {
+  if (header_ == nullptr) {
+    return;
+  }
+  msync(header_, mappedSize_, MS_ASYNC);
+  munmap(header_, mappedSize_);
+  header_ = nullptr;
+  slots_ = nullptr;
+  capacity_ = 0;
+  mappedSize_ = 0;
+}
+
+void EventLog::log(EventType type, uint16_t slave, uint32_t code, int32_t value0, int32_t value1, uint16_t index, uint8_t subIndex) {
+  if (header_ == nullptr) {
+    return;
+  }
+  const uint64_t position = header_->head.fetch_add(1, std::memory_order_relaxed);
+  EventLogSlot& record = slots_[position % capacity_];
+  // invalidates the slot before it is overwritten, a reader copying it meanwhile sees the sequence change.
+  record.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  record.stamp = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+  record.type = static_cast<uint16_t>(type);
+  record.slave = slave;
+  record.code = code;
+  record.index = index;
+  record.subIndex = subIndex;
+  record.reserved = 0;
+  record.value0 = value0;
+  record.value1 = value1;
+  // the record is valid for readers once the sequence matches its position.
+  record.sequence.store(static_cast<uint32_t>(position + 1), std::memory_order_release);
+}
+
+bool EventLog::read(const std::string& path, EventLogInfo& info, std::vector<EventRecord>& records) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    MELO_ERROR_STREAM("[EventLog] Could not open the event log '" << path << "': " << std::strerror(errno))
+    return false;
+  }
+  struct stat status {};
+  if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(EventLogHeader)) {
+    MELO_ERROR_STREAM("[EventLog] '" << path << "' is not an event log.")
+    ::close(fd);
+    return false;
+  }
+  const size_t size = static_cast<size_t>(status.st_size);
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    MELO_ERROR_STREAM("[EventLog] Could not map the event log '" << path << "': " << std::strerror(errno))
+    return false;
+  }
+  const auto& header = *std::launder(static_cast<const EventLogHeader*>(mapping));
+  if (!headerIsValid(header, size)) {
+    MELO_ERROR_STREAM("[EventLog] '" << path << "' is not an event log or has an unsupported version.")
+    munmap(mapping, size);
+    return false;
+  }
+  const auto* ring = std::launder(reinterpret_cast<const EventLogSlot*>(static_cast<const char*>(mapping) + sizeof(EventLogHeader)));
+  info.busName = std::string(header.busName, strnlen(header.busName, sizeof(header.busName)));
+  info.capacity = header.capacity;
+  info.written = header.head.load(std::memory_order_acquire);
+
+  const uint64_t begin = info.written > info.capacity ? info.written - info.capacity : 0;
+  records.clear();
+  records.reserve(info.written - begin);
+  for (uint64_t position = begin; position < info.written; position++) {
+    const EventLogSlot& slot = ring[position % info.capacity];
+    const auto sequence = static_cast<uint32_t>(position + 1);
+    // skips records which are written concurrently or were lost in a crash before being completed.
+    if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+      continue;
+    }
+    const EventRecord record{slot.stamp, sequence,      slot.type,     slot.slave,  slot.code,
+                             slot.index, slot.subIndex, slot.reserved, slot.value0, slot.value1};
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+      records.push_back(record);
+    }
+  }
+  munmap(mapping, size);
+  return true;
+}
+
+std::string EventLog::getTypeString(EventType type) {
+  switch (type) {
+    case EventType::StateRequest:
+      return "StateRequest";
+    case EventType::StateError:
+      return "StateError";
+    case EventType::WorkingCounterDrop:
+      return "WorkingCounterDrop";
+    case EventType::WorkingCounterRestored:
+      return "WorkingCounterRestored";
+    case EventType::SdoAbort:
+      return "SdoAbort";
+    case EventType::Emergency:
+      return "Emergency";
+    case EventType::PacketError:
+      return "PacketError";
+    case EventType::MailboxError:
+      return "MailboxError";
+    case EventType::SoeError:
+      return "SoeError";
+    case EventType::Overrun:
+      return "Overrun";
+    case EventType::Recovery:
+      return "Recovery";
+    case EventType::SlaveBudgetExceeded:
+      return "SlaveBudgetExceeded";
+    case EventType::WorkingCounterFault:
+      return "WorkingCounterFault";
+    default:
+      return "Unknown";
+  }
+}
+
+std::string EventLog::getRecoveryActionString(RecoveryAction action) {
+  switch (action) {
+    case RecoveryAction::Lost:
+      return "Lost";
+    case RecoveryAction::Found:
+      return "Found";
+    case RecoveryAction::Acknowledge:
+      return "Acknowledge";
+    case RecoveryAction::Reconfigure:
+      return "Reconfigure";
+    case RecoveryAction::Recovered:
+      return "Recovered";
+    default:
+      return "Unknown";
+  }
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
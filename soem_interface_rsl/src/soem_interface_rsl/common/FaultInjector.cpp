@@ -0,0 +1,386 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/FaultInjector.hpp"
+#include "soem_interface_rsl/common/LinkMonitor.hpp"
+
+// std
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+// linux
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netpacket/packet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// soem_rsl
+#include <soem_rsl/ethercat.h>
+
+// message logger
+#include <message_logger/message_logger.hpp>
+
+namespace soem_interface_rsl {
+namespace common {
+
+namespace {
+
+//! Sizes of the ethernet header, the EtherCAT header, a datagram header and a working counter.
+constexpr size_t ethernetHeaderSize = 14;
+constexpr size_t ecatHeaderSize = 2;
+constexpr size_t datagramHeaderSize = 10;
+constexpr size_t workingCounterSize = 2;
+constexpr uint16_t ethertypeEcat = 0x88A4;
+
+uint16_t get16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+void set16(uint8_t* data, const uint16_t value) {
+  data[0] = static_cast<uint8_t>(value);
+  data[1] = static_cast<uint8_t>(value >> 8);
+}
+
+}  // namespace
+
+FaultInjector::FaultInjector(const std::string& interface) : FaultInjector(interface, Options()) {}
+
+FaultInjector::FaultInjector(const std::string& interface, const Options& options)
+    : interface_(interface), options_(options), random_(options.seed) {}
+
+FaultInjector::~FaultInjector() {
+  detach();
+}
+
+bool FaultInjector::attach() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (attached_) {
+    return true;
+  }
+  ec_transportt previous{};
+  if (ecx_findtransport(interface_.c_str(), &previous) > 0) {
+    downstream_ = Downstream{previous.send, previous.recv, previous.userdata};
+  } else if (openSocket()) {
+    downstream_ = Downstream{&FaultInjector::sendSocket, &FaultInjector::receiveSocket, this};
+  } else {
+    return false;
+  }
+  const ec_transportt transport{&FaultInjector::send, &FaultInjector::receive, this};
+  if (ecx_registertransport(interface_.c_str(), &transport) <= 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::FaultInjector] Could not register the transport '" << interface_ << "'.")
+    if (socket_ >= 0) {
+      close(socket_);
+      socket_ = -1;
+    }
+    return false;
+  }
+  attached_ = true;
+  return true;
+}
+
+void FaultInjector::detach() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!attached_) {
+    return;
+  }
+  if (!linkUp_) {
+    setLinkLocked(true);
+  }
+  if (socket_ >= 0) {
+    ecx_registertransport(interface_.c_str(), nullptr);
+    close(socket_);
+    socket_ = -1;
+  } else {
+    const ec_transportt previous{downstream_.send, downstream_.receive, downstream_.userdata};
+    ecx_registertransport(interface_.c_str(), &previous);
+  }
+  downstream_ = Downstream();
+  for (Frame& frame : queue_) {
+    frame.used = false;
+  }
+  attached_ = false;
+}
+
+void FaultInjector::setOptions(const Options& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  options_ = options;
+  // the next random link flap is drawn with the new rate.
+  nextLinkFlap_ = 0;
+}
+
+FaultInjector::Options FaultInjector::getOptions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return options_;
+}
+
+void FaultInjector::flapLink(const int64_t duration) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  linkDownUntil_ = std::max(linkDownUntil_, now() + duration);
+  if (linkUp_) {
+    setLinkLocked(false);
+  }
+}
+
+FaultInjector::Statistics FaultInjector::getStatistics() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return statistics_;
+}
+
+void FaultInjector::resetStatistics() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  statistics_ = Statistics();
+}
+
+int FaultInjector::send(void* userdata, int stack, const void* frame, int length) {
+  auto& injector = *static_cast<FaultInjector*>(userdata);
+  if (length <= 0 || static_cast<size_t>(length) > maxFrameLength) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> lock(injector.mutex_);
+  const int64_t time = now();
+  ++injector.statistics_.frames;
+  injector.updateLinkLocked(time);
+  if (!injector.linkUp_) {
+    // the frame is sent but lost on the wire.
+    return length;
+  }
+  if (injector.random(injector.options_.dropProbability)) {
+    ++injector.statistics_.dropped;
+    injector.statistics_.lastFaultTime = time;
+    return length;
+  }
+  return injector.downstream_.send(injector.downstream_.userdata, stack, frame, length);
+}
+
+int FaultInjector::receive(void* userdata, int stack, void* frame, int length) {
+  auto& injector = *static_cast<FaultInjector*>(userdata);
+  std::lock_guard<std::mutex> lock(injector.mutex_);
+  const int64_t time = now();
+  injector.updateLinkLocked(time);
+
+  // all pending answers are taken from the downstream transport, so that they are delayed from their arrival.
+  std::array<uint8_t, maxFrameLength> buffer;
+  int received = 0;
+  while ((received = injector.downstream_.receive(injector.downstream_.userdata, stack, buffer.data(), buffer.size())) > 0) {
+    injector.queueReplyLocked(buffer.data(), static_cast<uint16_t>(received), time);
+  }
+
+  Frame* next = nullptr;
+  for (Frame& candidate : injector.queue_) {
+    if (candidate.used && !candidate.held && candidate.due <= time &&
+        (next == nullptr || candidate.due < next->due || (candidate.due == next->due && candidate.sequence < next->sequence))) {
+      next = &candidate;
+    }
+  }
+  if (next == nullptr) {
+    return 0;
+  }
+  next->used = false;
+  const int delivered = std::min<int>(next->length, length);
+  std::memcpy(frame, next->data.data(), delivered);
+  return delivered;
+}
+
+int64_t FaultInjector::now() {
+  timespec time{};
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+int FaultInjector::sendSocket(void* userdata, int /*stack*/, const void* frame, int length) {
+  auto& injector = *static_cast<FaultInjector*>(userdata);
+  return static_cast<int>(::send(injector.socket_, frame, length, 0));
+}
+
+int FaultInjector::receiveSocket(void* userdata, int /*stack*/, void* frame, int length) {
+  auto& injector = *static_cast<FaultInjector*>(userdata);
+  return static_cast<int>(::recv(injector.socket_, frame, length, MSG_DONTWAIT));
+}
+
+bool FaultInjector::openSocket() {
+  socket_ = socket(PF_PACKET, SOCK_RAW, htons(ethertypeEcat));
+  if (socket_ < 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::FaultInjector] Could not open a raw socket: " << strerror(errno) << ".")
+    return false;
+  }
+  sockaddr_ll address{};
+  address.sll_family = AF_PACKET;
+  address.sll_protocol = htons(ethertypeEcat);
+  address.sll_ifindex = static_cast<int>(if_nametoindex(interface_.c_str()));
+  if (address.sll_ifindex == 0 || bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::FaultInjector] Could not bind to '" << interface_ << "': " << strerror(errno) << ".")
+    close(socket_);
+    socket_ = -1;
+    return false;
+  }
+  return true;
+}
+
+bool FaultInjector::random(const double probability) {
+  // no number is drawn for disabled faults, a run only depends on the seed and the enabled faults.
+  return probability > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(random_) < probability;
+}
+
+void FaultInjector::updateLinkLocked(const int64_t time) {
+  if (!linkUp_ && time >= linkDownUntil_) {
+    setLinkLocked(true);
+  }
+  if (!linkUp_ || options_.linkFlapRate <= 0.0) {
+    return;
+  }
+  if (nextLinkFlap_ == 0) {
+    scheduleLinkFlapLocked(time);
+  } else if (time >= nextLinkFlap_) {
+    linkDownUntil_ = time + options_.linkFlapDuration;
+    setLinkLocked(false);
+    scheduleLinkFlapLocked(linkDownUntil_);
+  }
+}
+
+void FaultInjector::setLinkLocked(const bool up) {
+  LinkMonitor& monitor = LinkMonitor::instance();
+  if (!up) {
+    ++statistics_.linkFlaps;
+    statistics_.lastFaultTime = now();
+    // a simulated segment owns the link state already, a real interface is taken over for the flap.
+    linkWasVirtual_ = monitor.isVirtualLink(interface_);
+    monitor.setVirtualLinkUp(interface_, false);
+  } else if (linkWasVirtual_) {
+    monitor.setVirtualLinkUp(interface_, true);
+  } else {
+    monitor.releaseVirtualLink(interface_);
+  }
+  linkUp_ = up;
+}
+
+void FaultInjector::scheduleLinkFlapLocked(const int64_t time) {
+  // flaps form a poisson process, the times between them are exponentially distributed.
+  const double interval = std::exponential_distribution<double>(options_.linkFlapRate)(random_);
+  nextLinkFlap_ = time + static_cast<int64_t>(interval * 1e9) + 1;
+}
+
+void FaultInjector::queueReplyLocked(const uint8_t* frame, const uint16_t length, const int64_t time) {
+  if (!linkUp_) {
+    return;
+  }
+  if (random(options_.replyDropProbability)) {
+    ++statistics_.repliesDropped;
+    statistics_.lastFaultTime = time;
+    return;
+  }
+  Frame* reply = pushLocked();
+  if (reply == nullptr) {
+    // the receive ring is full, the answer is lost.
+    return;
+  }
+  std::memcpy(reply->data.data(), frame, length);
+  reply->length = length;
+  reply->sequence = ++sequence_;
+  reply->due = time + options_.delay;
+  if (options_.delayJitter > 0) {
+    reply->due += std::uniform_int_distribution<int64_t>(0, options_.delayJitter)(random_);
+  }
+  if (reply->due > time) {
+    ++statistics_.delayed;
+    statistics_.lastFaultTime = time;
+  }
+  if (random(options_.workingCounterProbability)) {
+    corruptWorkingCounterLocked(reply->data.data(), length);
+  }
+
+  // answers held back before are delivered after this one.
+  for (Frame& other : queue_) {
+    if (other.used && other.held) {
+      other.held = false;
+      other.due = std::max(other.due, reply->due);
+      other.sequence = ++sequence_;
+    }
+  }
+  if (random(options_.reorderProbability)) {
+    reply->held = true;
+    ++statistics_.reordered;
+    statistics_.lastFaultTime = time;
+  }
+  if (random(options_.duplicateProbability)) {
+    Frame* duplicate = pushLocked();
+    if (duplicate != nullptr) {
+      *duplicate = *reply;
+      duplicate->sequence = ++sequence_;
+      ++statistics_.duplicated;
+      statistics_.lastFaultTime = time;
+    }
+  }
+}
+
+void FaultInjector::corruptWorkingCounterLocked(uint8_t* frame, const uint16_t length) {
+  if (length < ethernetHeaderSize + ecatHeaderSize || ((frame[12] << 8) | frame[13]) != ethertypeEcat ||
+      (get16(frame + ethernetHeaderSize) >> 12) != 1) {
+    return;
+  }
+  // working counters of all datagrams, one of them is decremented.
+  std::array<uint8_t*, 64> workingCounters{};
+  size_t count = 0;
+  size_t offset = ethernetHeaderSize + ecatHeaderSize;
+  while (count < workingCounters.size() && offset + datagramHeaderSize + workingCounterSize <= length) {
+    const uint16_t flags = get16(frame + offset + 6);
+    const size_t dataLength = flags & 0x07FF;
+    if (offset + datagramHeaderSize + dataLength + workingCounterSize > length) {
+      break;
+    }
+    workingCounters[count++] = frame + offset + datagramHeaderSize + dataLength;
+    offset += datagramHeaderSize + dataLength + workingCounterSize;
+    if ((flags & 0x8000) == 0) {
+      break;
+    }
+  }
+  if (count == 0) {
+    return;
+  }
+  uint8_t* workingCounter = workingCounters[std::uniform_int_distribution<size_t>(0, count - 1)(random_)];
+  const uint16_t value = get16(workingCounter);
+  if (value == 0) {
+    return;
+  }
+  set16(workingCounter, static_cast<uint16_t>(value - 1));
+  ++statistics_.workingCountersCorrupted;
+  statistics_.lastFaultTime = now();
+}
+
+FaultInjector::Frame* FaultInjector::pushLocked() {
+  for (Frame& frame : queue_) {
+    if (!frame.used) {
+      frame.used = true;
+      frame.held = false;
+      return &frame;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
@@ -0,0 +1,324 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/FrameCapture.hpp"
+
+// std
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+// message logger
+#include <message_logger/message_logger.hpp>
+
+namespace soem_interface_rsl {
+namespace common {
+
+namespace {
+
+// pcapng block types and options, see https://www.ietf.org/archive/id/draft-ietf-opsawg-pcapng-02.html
+constexpr uint32_t sectionHeaderBlock = 0x0a0d0d0a;
+constexpr uint32_t interfaceDescriptionBlock = 0x00000001;
+constexpr uint32_t enhancedPacketBlock = 0x00000006;
+constexpr uint32_t byteOrderMagic = 0x1a2b3c4d;
+constexpr uint16_t linkTypeEthernet = 1;
+constexpr uint16_t optionEnd = 0;
+constexpr uint16_t optionInterfaceName = 2;
+constexpr uint16_t optionTimestampResolution = 9;
+constexpr uint16_t optionPacketFlags = 2;
+constexpr uint32_t flagInbound = 1;
+constexpr uint32_t flagOutbound = 2;
+
+// collects a block framed by its total length, variable length fields are padded to 32 bits.
+class Block {
+ public:
+  explicit Block(const uint32_t type) {
+    append(type);
+    // total length, set by write().
+    append(uint32_t{0});
+  }
+
+  template <class T>
+  void append(const T& value) {
+    appendRaw(&value, sizeof(value));
+  }
+
+  void appendPadded(const void* data, const size_t length) {
+    appendRaw(data, length);
+    buffer_.resize((buffer_.size() + 3) & ~static_cast<size_t>(3), 0);
+  }
+
+  void appendOption(const uint16_t code, const void* data, const uint16_t length) {
+    append(code);
+    append(length);
+    appendPadded(data, length);
+  }
+
+  bool write(FILE* file) {
+    const auto totalLength = static_cast<uint32_t>(buffer_.size() + sizeof(uint32_t));
+    std::memcpy(&buffer_[4], &totalLength, sizeof(totalLength));
+    append(totalLength);
+    return std::fwrite(buffer_.data(), 1, buffer_.size(), file) == buffer_.size();
+  }
+
+ private:
+  void appendRaw(const void* data, const size_t length) {
+    if (length > 0) {
+      const auto* bytes = static_cast<const uint8_t*>(data);
+      buffer_.insert(buffer_.end(), bytes, bytes + length);
+    }
+  }
+
+  std::vector<uint8_t> buffer_;
+};
+
+}  // namespace
+
+FrameCapture::~FrameCapture() {
+  stop();
+}
+
+bool FrameCapture::start(const std::string& path, const Options& options) {
+  stop();
+  if (options.capacity == 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::FrameCapture] The capacity needs to be larger than 0.")
+    return false;
+  }
+  options_ = options;
+  path_ = path;
+  capacity_ = options.capacity;
+  slots_ = std::make_unique<Slot[]>(capacity_);
+  head_ = 0;
+  tail_ = 0;
+  dropped_ = 0;
+  triggerTime_ = 0;
+  dumps_ = 0;
+  if (options_.continuous && !openFile(path_)) {
+    slots_.reset();
+    return false;
+  }
+  stopRequested_ = false;
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread(&FrameCapture::run, this);
+  return true;
+}
+
+void FrameCapture::stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  running_.store(false, std::memory_order_release);
+  stopRequested_ = true;
+  thread_.join();
+  closeFile();
+  slots_.reset();
+}
+
+void FrameCapture::hook(void* userdata, int direction, int stack, const void* frame, int length) {
+  // direction is EC_CAPTURE_TX (0) or EC_CAPTURE_RX (1).
+  static_cast<FrameCapture*>(userdata)->record(direction != 0, stack, frame, length);
+}
+
+int64_t FrameCapture::now() {
+  timespec time{};
+  clock_gettime(CLOCK_REALTIME, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+void FrameCapture::record(const bool received, const int stack, const void* frame, const int length) {
+  if (!running_.load(std::memory_order_acquire) || length <= 0) {
+    return;
+  }
+  const uint64_t number = head_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots_[number % capacity_];
+  slot.sequence.store(2 * number + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.stamp = now();
+  slot.length = static_cast<uint16_t>(std::min(static_cast<size_t>(length), maxFrameLength));
+  slot.received = received;
+  slot.stack = static_cast<uint8_t>(stack);
+  std::memcpy(slot.data.data(), frame, slot.length);
+  slot.sequence.store(2 * number + 2, std::memory_order_release);
+}
+
+bool FrameCapture::trigger(const Trigger reason) {
+  if (!running_.load(std::memory_order_acquire) || options_.continuous ||
+      (reason == Trigger::WorkingCounterDrop && !options_.triggerOnWorkingCounterDrop) ||
+      (reason == Trigger::StateLoss && !options_.triggerOnStateLoss)) {
+    return false;
+  }
+  int64_t none = 0;
+  return triggerTime_.compare_exchange_strong(none, now(), std::memory_order_relaxed);
+}
+
+FrameCapture::ReadResult FrameCapture::read(const uint64_t number, Slot& frame) const {
+  const Slot& slot = slots_[number % capacity_];
+  const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+  if (sequence < 2 * number + 2) {
+    return ReadResult::Pending;
+  }
+  if (sequence != 2 * number + 2) {
+    return ReadResult::Overwritten;
+  }
+  frame.stamp = slot.stamp;
+  frame.length = slot.length;
+  frame.received = slot.received;
+  frame.stack = slot.stack;
+  std::memcpy(frame.data.data(), slot.data.data(), std::min(static_cast<size_t>(slot.length), maxFrameLength));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.sequence.load(std::memory_order_relaxed) == sequence ? ReadResult::Ok : ReadResult::Overwritten;
+}
+
+void FrameCapture::run() {
+  while (!stopRequested_.load()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(pollPeriodMs_));
+    if (options_.continuous) {
+      writeContinuously(false);
+      continue;
+    }
+    const int64_t triggerTime = triggerTime_.load(std::memory_order_relaxed);
+    if (triggerTime != 0 && now() >= triggerTime + static_cast<int64_t>(options_.postTrigger * 1e9)) {
+      dump(triggerTime);
+      triggerTime_.store(0, std::memory_order_relaxed);
+    }
+  }
+  if (options_.continuous) {
+    writeContinuously(true);
+  }
+}
+
+void FrameCapture::writeContinuously(const bool drain) {
+  Slot frame;
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  if (head - tail_ > capacity_) {
+    dropped_.fetch_add(head - capacity_ - tail_, std::memory_order_relaxed);
+    tail_ = head - capacity_;
+  }
+  for (; tail_ < head; tail_++) {
+    const ReadResult result = read(tail_, frame);
+    if (result == ReadResult::Pending && !drain) {
+      // still being written, continue with it next time.
+      break;
+    }
+    if (result == ReadResult::Ok) {
+      writeFrame(frame);
+    } else {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  std::fflush(file_);
+}
+
+void FrameCapture::dump(const int64_t triggerTime) {
+  const uint64_t dumpNumber = dumps_.load(std::memory_order_relaxed) + 1;
+  std::string path = path_;
+  const std::string extension = ".pcapng";
+  const size_t extensionPosition =
+      path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0
+          ? path.size() - extension.size()
+          : path.size();
+  path.insert(extensionPosition, "_" + std::to_string(dumpNumber));
+  if (!openFile(path)) {
+    return;
+  }
+  const int64_t begin = triggerTime - static_cast<int64_t>(options_.preTrigger * 1e9);
+  const int64_t end = triggerTime + static_cast<int64_t>(options_.postTrigger * 1e9);
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  Slot frame;
+  uint64_t written = 0;
+  for (uint64_t number = head > capacity_ ? head - capacity_ : 0; number < head; number++) {
+    if (read(number, frame) == ReadResult::Ok && frame.stamp >= begin && frame.stamp <= end) {
+      writeFrame(frame);
+      written++;
+    }
+  }
+  closeFile();
+  dumps_.store(dumpNumber, std::memory_order_relaxed);
+  MELO_INFO_STREAM("[soem_interface_rsl::FrameCapture] Wrote " << written << " frames around the trigger to '" << path << "'.")
+}
+
+bool FrameCapture::openFile(const std::string& path) {
+  file_ = std::fopen(path.c_str(), "wb");
+  if (file_ == nullptr) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::FrameCapture] Could not open '" << path << "': " << std::strerror(errno))
+    return false;
+  }
+  Block section(sectionHeaderBlock);
+  section.append(byteOrderMagic);
+  section.append(uint16_t{1});
+  section.append(uint16_t{0});
+  // unknown section length.
+  section.append(int64_t{-1});
+  bool ok = section.write(file_);
+  // one interface per stack, the redundant port is the second one.
+  for (const std::string& suffix : {std::string(), std::string(" (redundant)")}) {
+    Block interface(interfaceDescriptionBlock);
+    interface.append(linkTypeEthernet);
+    interface.append(uint16_t{0});
+    interface.append(static_cast<uint32_t>(maxFrameLength));
+    const std::string name = options_.interface + suffix;
+    if (!name.empty()) {
+      interface.appendOption(optionInterfaceName, name.data(), static_cast<uint16_t>(name.size()));
+    }
+    // timestamps in ns.
+    const uint8_t resolution = 9;
+    interface.appendOption(optionTimestampResolution, &resolution, sizeof(resolution));
+    interface.appendOption(optionEnd, nullptr, 0);
+    ok &= interface.write(file_);
+  }
+  if (!ok) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::FrameCapture] Could not write the header of '" << path << "'.")
+    closeFile();
+  }
+  return ok;
+}
+
+void FrameCapture::closeFile() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+void FrameCapture::writeFrame(const Slot& frame) {
+  if (file_ == nullptr) {
+    return;
+  }
+  Block packet(enhancedPacketBlock);
+  packet.append(static_cast<uint32_t>(frame.stack));
+  packet.append(static_cast<uint32_t>(static_cast<uint64_t>(frame.stamp) >> 32));
+  packet.append(static_cast<uint32_t>(static_cast<uint64_t>(frame.stamp) & 0xffffffff));
+  packet.append(static_cast<uint32_t>(frame.length));
+  packet.append(static_cast<uint32_t>(frame.length));
+  packet.appendPadded(frame.data.data(), frame.length);
+  const uint32_t flags = frame.received ? flagInbound : flagOutbound;
+  packet.appendOption(optionPacketFlags, &flags, sizeof(flags));
+  packet.appendOption(optionEnd, nullptr, 0);
+  packet.write(file_);
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
@@ -0,0 +1,256 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/LinkMonitor.hpp"
+
+// std
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+// linux
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// message logger
+#include <message_logger/message_logger.hpp>
+
+namespace soem_interface_rsl {
+namespace common {
+
+static bool isUp(const unsigned int flags) {
+  return (flags & IFF_UP) != 0;
+}
+
+static bool hasCarrier(const unsigned int flags) {
+  return isUp(flags) && (flags & IFF_RUNNING) != 0;
+}
+
+//! Returns the interface flags, 0 if the interface does not exist.
+static unsigned int queryFlags(const std::string& interface) {
+  const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  ifreq request{};
+  strncpy(request.ifr_name, interface.c_str(), IFNAMSIZ - 1);
+  const unsigned int flags = ioctl(fd, SIOCGIFFLAGS, &request) == 0 ? static_cast<unsigned short>(request.ifr_flags) : 0;
+  close(fd);
+  return flags;
+}
+
+LinkMonitor& LinkMonitor::instance() {
+  static LinkMonitor monitor;
+  return monitor;
+}
+
+LinkMonitor::LinkMonitor() {
+  socket_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (socket_ >= 0) {
+    sockaddr_nl address{};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK;
+    if (bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+      close(socket_);
+      socket_ = -1;
+    }
+  }
+  if (socket_ < 0) {
+    MELO_WARN_STREAM("[soem_interface_rsl::LinkMonitor] Could not subscribe to netlink link notifications (" << strerror(errno)
+                                                                                                           << "), polling the links.")
+  }
+  thread_ = std::thread(&LinkMonitor::run, this);
+}
+
+LinkMonitor::~LinkMonitor() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (socket_ >= 0) {
+    close(socket_);
+  }
+}
+
+const LinkMonitor::LinkState& LinkMonitor::watch(const std::string& interface) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const bool known = links_.count(interface) != 0;
+  auto& link = links_[interface];
+  if (!known) {
+    // the initial state is queried once, afterwards the flags follow the notifications.
+    const unsigned int flags = queryFlags(interface);
+    link.state->up = common::isUp(flags);
+    link.state->carrier = common::hasCarrier(flags);
+  }
+  ++link.watchers;
+  return *link.state;
+}
+
+void LinkMonitor::unwatch(const std::string& interface) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = links_.find(interface);
+  if (it == links_.end() || it->second.watchers == 0) {
+    return;
+  }
+  --it->second.watchers;
+  eraseUnusedLinkLocked(interface);
+}
+
+bool LinkMonitor::isUp(const std::string& interface) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (const LinkState* state = findLinkLocked(interface)) {
+      return state->up;
+    }
+  }
+  return common::isUp(queryFlags(interface));
+}
+
+bool LinkMonitor::hasCarrier(const std::string& interface) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (const LinkState* state = findLinkLocked(interface)) {
+      return state->carrier;
+    }
+  }
+  return common::hasCarrier(queryFlags(interface));
+}
+
+void LinkMonitor::setVirtualLinkUp(const std::string& interface, const bool up) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  virtualLinks_.insert(interface);
+  setLinkState(*links_[interface].state, interface, true, up);
+}
+
+void LinkMonitor::releaseVirtualLink(const std::string& interface) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (virtualLinks_.erase(interface) == 0) {
+    return;
+  }
+  eraseUnusedLinkLocked(interface);
+  const auto it = links_.find(interface);
+  if (it != links_.end()) {
+    const unsigned int flags = queryFlags(interface);
+    setLinkState(*it->second.state, interface, common::isUp(flags), common::hasCarrier(flags));
+  }
+}
+
+bool LinkMonitor::isVirtualLink(const std::string& interface) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return virtualLinks_.count(interface) != 0;
+}
+
+void LinkMonitor::run() {
+  while (running_) {
+    if (socket_ < 0) {
+      pollLinks();
+      std::this_thread::sleep_for(std::chrono::milliseconds(pollPeriodMs_));
+      continue;
+    }
+    pollfd descriptor{socket_, POLLIN, 0};
+    if (poll(&descriptor, 1, pollPeriodMs_) > 0 && (descriptor.revents & POLLIN) != 0) {
+      processNetlinkMessages();
+    }
+  }
+}
+
+void LinkMonitor::processNetlinkMessages() {
+  alignas(nlmsghdr) char buffer[8192];
+  const ssize_t length = recv(socket_, buffer, sizeof(buffer), MSG_DONTWAIT);
+  if (length < 0 && errno == ENOBUFS) {
+    // notifications were dropped, the state has to be queried again.
+    pollLinks();
+    return;
+  }
+  if (length <= 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  int remaining = static_cast<int>(length);
+  for (auto* header = reinterpret_cast<nlmsghdr*>(buffer); NLMSG_OK(header, static_cast<unsigned int>(remaining));
+       header = NLMSG_NEXT(header, remaining)) {
+    if (header->nlmsg_type != RTM_NEWLINK && header->nlmsg_type != RTM_DELLINK) {
+      continue;
+    }
+    const auto* info = static_cast<const ifinfomsg*>(NLMSG_DATA(header));
+    unsigned int attributesLength = IFLA_PAYLOAD(header);
+    for (const auto* attribute = IFLA_RTA(info); RTA_OK(attribute, attributesLength); attribute = RTA_NEXT(attribute, attributesLength)) {
+      if (attribute->rta_type != IFLA_IFNAME) {
+        continue;
+      }
+      const std::string interface(static_cast<const char*>(RTA_DATA(attribute)));
+      const auto it = links_.find(interface);
+      if (it != links_.end() && virtualLinks_.count(interface) == 0) {
+        const unsigned int flags = header->nlmsg_type == RTM_NEWLINK ? info->ifi_flags : 0;
+        setLinkState(*it->second.state, interface, common::isUp(flags), common::hasCarrier(flags));
+      }
+      break;
+    }
+  }
+}
+
+void LinkMonitor::pollLinks() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& link : links_) {
+    if (virtualLinks_.count(link.first) != 0) {
+      continue;
+    }
+    const unsigned int flags = queryFlags(link.first);
+    setLinkState(*link.second.state, link.first, common::isUp(flags), common::hasCarrier(flags));
+  }
+}
+
+void LinkMonitor::setLinkState(LinkState& state, const std::string& interface, const bool up, const bool carrier) const {
+  if (state.up.exchange(up) != up && !up) {
+    MELO_WARN_STREAM("[soem_interface_rsl::LinkMonitor] Interface '" << interface << "' is down.")
+  }
+  if (state.carrier.exchange(carrier) == carrier) {
+    return;
+  }
+  if (carrier) {
+    MELO_INFO_STREAM("[soem_interface_rsl::LinkMonitor] Link of '" << interface << "' is up.")
+  } else {
+    MELO_WARN_STREAM("[soem_interface_rsl::LinkMonitor] Link of '" << interface << "' is down.")
+  }
+}
+
+const LinkMonitor::LinkState* LinkMonitor::findLinkLocked(const std::string& interface) const {
+  const auto it = links_.find(interface);
+  return it == links_.end() ? nullptr : it->second.state.get();
+}
+
+void LinkMonitor::eraseUnusedLinkLocked(const std::string& interface) {
+  const auto it = links_.find(interface);
+  if (it != links_.end() && it->second.watchers == 0 && virtualLinks_.count(interface) == 0) {
+    links_.erase(it);
+  }
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
@@ -23,34 +23,143 @@
 //  soem_interface_rsl
 #include "soem_interface_rsl/common/Macros.hpp"
 
+// std
+#include <chrono>
+#include <cstring>
+#include <thread>
+
 namespace soem_interface_rsl {
 namespace common {
 
-std::mutex MessageLog::logMutex_;
-MessageLog::Log MessageLog::log_;
+constexpr size_t MessageLog::Entry::maxTextLength;
+constexpr size_t MessageLog::defaultCapacity;
+constexpr unsigned int MessageLog::maxReadRetries_;
+
+std::mutex MessageLog::allocateMutex_;
+std::vector<std::unique_ptr<MessageLog::Storage>> MessageLog::storages_ = []() {
+  std::vector<std::unique_ptr<Storage>> storages;
+  storages.push_back(std::make_unique<Storage>(defaultCapacity));
+  return storages;
+}();
+std::atomic<MessageLog::Storage*> MessageLog::storage_{MessageLog::storages_.front().get()};
+std::atomic<uint64_t> MessageLog::head_{0};
+std::atomic<uint64_t> MessageLog::dropped_{0};
+uint64_t MessageLog::tail_ = 0;
+std::mutex MessageLog::readMutex_;
+
+bool MessageLog::setCapacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(allocateMutex_);
+  if (head_.load(std::memory_order_acquire) != 0 || capacity == 0) {
+    return false;
+  }
+  storages_.push_back(std::make_unique<Storage>(capacity));
+  storage_.store(storages_.back().get(), std::memory_order_release);
+  return true;
+}
+
+size_t MessageLog::getCapacity() {
+  return storage_.load(std::memory_order_acquire)->capacity;
+}
+
+void MessageLog::insertMessage(message_logger::log::levels::Level level, uint16_t slave, uint32_t code, const char* text) {
+  const Storage& storage = *storage_.load(std::memory_order_acquire);
+  const uint64_t position = head_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = storage.slots[position % storage.capacity];
+
+  // claim the slot, it is taken if it holds a newer entry or an older producer is still writing it (odd sequence).
+  uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  do {
+    if (sequence >= 2 * position + 1 || (sequence & 1) != 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  } while (!slot.sequence.compare_exchange_weak(sequence, 2 * position + 1, std::memory_order_acquire, std::memory_order_relaxed));
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.entry.level = level;
+  slot.entry.stamp = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+  slot.entry.slave = slave;
+  slot.entry.code = code;
+  const size_t length = text == nullptr ? 0 : strnlen(text, Entry::maxTextLength);
+  std::memcpy(slot.entry.text, text, length);
+  slot.entry.text[length] = '\0';
+  // nobody else writes the slot while its sequence is odd.
+  slot.sequence.store(2 * position + 2, std::memory_order_release);
+}
 
 void MessageLog::insertMessage(message_logger::log::levels::Level level, const std::string& message) {
-  std::lock_guard<std::mutex> lock(logMutex_);
-  log_.push_back({level, message});
-  if (log_.size() > maxLogSize_) {
-    log_.pop_front();
+  insertMessage(level, 0, 0, message.c_str());
+}
+
+bool MessageLog::readSlot(const Storage& storage, uint64_t position, Entry& entry) {
+  const Slot& slot = storage.slots[position % storage.capacity];
+  for (unsigned int retry = 0; retry <= maxReadRetries_; retry++) {
+    const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before > 2 * position + 2) {
+      // overwritten by a newer entry.
+      return false;
+    }
+    if (before == 2 * position + 2) {
+      std::memcpy(static_cast<void*>(&entry), &slot.entry, sizeof(Entry));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return slot.sequence.load(std::memory_order_relaxed) == before;
+    }
+    // the producer has not published the entry yet, or it dropped it because the slot was taken.
+    std::this_thread::yield();
   }
+  return false;
 }
 
-MessageLog::Log MessageLog::getLog() {
-  std::lock_guard<std::mutex> lock(logMutex_);
-  return log_;
+MessageLog::Entries MessageLog::read(uint64_t begin, uint64_t end) {
+  const Storage& storage = *storage_.load(std::memory_order_acquire);
+  if (end - begin > storage.capacity) {
+    begin = end - storage.capacity;
+  }
+  Entries entries;
+  entries.reserve(end - begin);
+  Entry entry;
+  for (uint64_t position = begin; position < end; position++) {
+    if (readSlot(storage, position, entry)) {
+      entries.push_back(entry);
+    }
+  }
+  return entries;
+}
+
+MessageLog::Log MessageLog::toLog(const Entries& entries) {
+  Log log;
+  for (const Entry& entry : entries) {
+    log.emplace_back(entry.level, entry.text);
+  }
+  return log;
+}
+
+MessageLog::Entries MessageLog::getEntries() {
+  std::lock_guard<std::mutex> lock(readMutex_);
+  return read(tail_, head_.load(std::memory_order_acquire));
+}
+
+MessageLog::Entries MessageLog::getAndClearEntries() {
+  // one lock for both, a message inserted in between is neither lost nor returned twice.
+  std::lock_guard<std::mutex> lock(readMutex_);
+  const uint64_t end = head_.load(std::memory_order_acquire);
+  Entries entries = read(tail_, end);
+  tail_ = end;
+  return entries;
 }
 
 void MessageLog::clearLog() {
-  std::lock_guard<std::mutex> lock(logMutex_);
-  log_.clear();
+  std::lock_guard<std::mutex> lock(readMutex_);
+  tail_ = head_.load(std::memory_order_acquire);
+}
+
+MessageLog::Log MessageLog::getLog() {
+  return toLog(getEntries());
 }
 
 MessageLog::Log MessageLog::getAndClearLog() {
-  const Log log = getLog();
-  clearLog();
-  return log;
+  return toLog(getAndClearEntries());
 }
 
 }  // namespace common
@@ -0,0 +1,396 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/ProcessImageRecorder.hpp"
+
+// std
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <new>
+
+// linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// message logger
+#include <message_logger/message_logger.hpp>
+
+namespace soem_interface_rsl {
+namespace common {
+
+namespace {
+
+constexpr size_t pageSize = 4096;
+
+size_t roundUp(const size_t value, const size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+int64_t getClock(const clockid_t clock) {
+  timespec time{};
+  clock_gettime(clock, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+ProcessImageColumnDescriptor makeDescriptor(const std::string& name, const uint16_t slave, const ProcessImageColumnKind kind,
+                                            const size_t rowOffset, const size_t width) {
+  ProcessImageColumnDescriptor descriptor{};
+  std::strncpy(descriptor.name, name.c_str(), sizeof(descriptor.name) - 1);
+  descriptor.slave = slave;
+  descriptor.kind = static_cast<uint8_t>(kind);
+  descriptor.width = static_cast<uint32_t>(width);
+  descriptor.rowOffset = static_cast<uint32_t>(rowOffset);
+  return descriptor;
+}
+
+}  // namespace
+
+ProcessImageRecorder::~ProcessImageRecorder() {
+  stop();
+}
+
+bool ProcessImageRecorder::start(const std::string& path, const std::string& busName, const std::vector<Column>& columns,
+                                 const size_t imageSize, const Options& options) {
+  stop();
+  if (options.ringCapacity == 0 || options.rowsPerChunk == 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecorder] The ring capacity and the rows per chunk need to be larger than 0.")
+    return false;
+  }
+
+  // the fields of the row header come first, followed by the columns of the slaves.
+  columns_.clear();
+  columns_.push_back(makeDescriptor("cycle", 0, ProcessImageColumnKind::Cycle, offsetof(ProcessImageRowHeader, cycle), 8));
+  columns_.push_back(makeDescriptor("stamp", 0, ProcessImageColumnKind::Cycle, offsetof(ProcessImageRowHeader, stamp), 8));
+  columns_.push_back(makeDescriptor("distributedClockTime", 0, ProcessImageColumnKind::Cycle,
+                                    offsetof(ProcessImageRowHeader, distributedClockTime), 8));
+  columns_.push_back(
+      makeDescriptor("workingCounter", 0, ProcessImageColumnKind::Cycle, offsetof(ProcessImageRowHeader, workingCounter), 4));
+  columns_.push_back(makeDescriptor("expectedWorkingCounter", 0, ProcessImageColumnKind::Cycle,
+                                    offsetof(ProcessImageRowHeader, expectedWorkingCounter), 4));
+  for (const Column& column : columns) {
+    if (column.width == 0) {
+      continue;
+    }
+    if (static_cast<size_t>(column.offset) + column.width > imageSize) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecorder] Column '" << column.name << "' exceeds the process image of "
+                                                                              << imageSize << " bytes.")
+      return false;
+    }
+    columns_.push_back(makeDescriptor(column.name, column.slave, column.kind, sizeof(ProcessImageRowHeader) + column.offset, column.width));
+  }
+
+  // chunks are page aligned, such that the writer thread maps one chunk at a time.
+  rowsPerChunk_ = options.rowsPerChunk;
+  size_t chunkOffset = 0;
+  for (auto& descriptor : columns_) {
+    descriptor.chunkOffset = chunkOffset;
+    chunkOffset += roundUp(static_cast<size_t>(descriptor.width) * rowsPerChunk_, 8);
+  }
+  chunkSize_ = roundUp(chunkOffset, pageSize);
+  headerSize_ = roundUp(sizeof(ProcessImageFileHeader) + columns_.size() * sizeof(ProcessImageColumnDescriptor), pageSize);
+
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecorder] Could not open '" << path << "': " << std::strerror(errno))
+    return false;
+  }
+  void* mapping = MAP_FAILED;
+  if (ftruncate(fd_, static_cast<off_t>(headerSize_)) == 0) {
+    mapping = mmap(nullptr, headerSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  }
+  if (mapping == MAP_FAILED) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecorder] Could not map '" << path << "': " << std::strerror(errno))
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  header_ = new (mapping) ProcessImageFileHeader{};
+  std::memcpy(header_->magic, ProcessImageFileHeader::magic_, sizeof(header_->magic));
+  header_->version = ProcessImageFileHeader::version_;
+  header_->numberOfColumns = static_cast<uint32_t>(columns_.size());
+  header_->headerSize = headerSize_;
+  header_->chunkSize = chunkSize_;
+  header_->rowsPerChunk = rowsPerChunk_;
+  header_->imageSize = static_cast<uint32_t>(imageSize);
+  header_->rows.store(0);
+  header_->startTime = getClock(CLOCK_REALTIME);
+  header_->startStamp = getClock(CLOCK_MONOTONIC);
+  std::strncpy(header_->busName, busName.c_str(), sizeof(header_->busName) - 1);
+  std::memcpy(reinterpret_cast<uint8_t*>(header_) + sizeof(ProcessImageFileHeader), columns_.data(),
+              columns_.size() * sizeof(ProcessImageColumnDescriptor));
+  chunk_ = nullptr;
+
+  path_ = path;
+  imageSize_ = imageSize;
+  rowSize_ = sizeof(ProcessImageRowHeader) + imageSize;
+  ringCapacity_ = options.ringCapacity;
+  ring_ = std::make_unique<uint8_t[]>(ringCapacity_ * rowSize_);
+  head_ = 0;
+  tail_ = 0;
+  cycle_ = 0;
+  written_ = 0;
+  dropped_ = 0;
+  stopRequested_ = false;
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread(&ProcessImageRecorder::run, this);
+  MELO_INFO_STREAM("[soem_interface_rsl::ProcessImageRecorder] Recording " << columns_.size() << " columns with " << rowSize_
+                                                                           << " bytes per cycle to '" << path << "'.")
+  return true;
+}
+
+void ProcessImageRecorder::stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  running_.store(false, std::memory_order_release);
+  stopRequested_ = true;
+  thread_.join();
+  close();
+  ring_.reset();
+}
+
+bool ProcessImageRecorder::record(const int64_t stamp, const int64_t distributedClockTime, const int32_t workingCounter,
+                                  const int32_t expectedWorkingCounter, const void* image) {
+  if (!running_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  const uint64_t cycle = cycle_.fetch_add(1, std::memory_order_relaxed);
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) >= ringCapacity_) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  uint8_t* row = ring_.get() + (head % ringCapacity_) * rowSize_;
+  const ProcessImageRowHeader header{cycle, stamp, distributedClockTime, workingCounter, expectedWorkingCounter};
+  std::memcpy(row, &header, sizeof(header));
+  std::memcpy(row + sizeof(header), image, imageSize_);
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+void ProcessImageRecorder::run() {
+  while (!stopRequested_.load()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(pollPeriodMs_));
+    flush();
+  }
+  flush();
+}
+
+void ProcessImageRecorder::flush() {
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  uint64_t rows = written_.load(std::memory_order_relaxed);
+  for (; tail < head; tail++, rows++) {
+    if (!mapChunk(rows / rowsPerChunk_)) {
+      // the rows are dropped to keep the cyclic thread going, the file ends with the last complete row.
+      dropped_.fetch_add(head - tail, std::memory_order_relaxed);
+      tail_.store(head, std::memory_order_release);
+      return;
+    }
+    const uint8_t* row = ring_.get() + (tail % ringCapacity_) * rowSize_;
+    const size_t index = rows % rowsPerChunk_;
+    for (const auto& column : columns_) {
+      std::memcpy(chunk_ + column.chunkOffset + index * column.width, row + column.rowOffset, column.width);
+    }
+  }
+  tail_.store(tail, std::memory_order_release);
+  written_.store(rows, std::memory_order_relaxed);
+  // the rows are complete for readers of the file once the count is updated.
+  header_->rows.store(rows, std::memory_order_release);
+}
+
+bool ProcessImageRecorder::mapChunk(const uint64_t chunk) {
+  if (chunk_ != nullptr && mappedChunk_ == chunk) {
+    return true;
+  }
+  if (chunk_ != nullptr) {
+    munmap(chunk_, chunkSize_);
+    chunk_ = nullptr;
+  }
+  const off_t offset = static_cast<off_t>(headerSize_ + chunk * chunkSize_);
+  if (ftruncate(fd_, offset + static_cast<off_t>(chunkSize_)) != 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecorder] Could not grow '" << path_ << "': " << std::strerror(errno))
+    return false;
+  }
+  void* mapping = mmap(nullptr, chunkSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offset);
+  if (mapping == MAP_FAILED) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecorder] Could not map chunk " << chunk << " of '" << path_
+                                                                                        << "': " << std::strerror(errno))
+    return false;
+  }
+  chunk_ = static_cast<uint8_t*>(mapping);
+  mappedChunk_ = chunk;
+  return true;
+}
+
+void ProcessImageRecorder::close() {
+  if (chunk_ != nullptr) {
+    msync(chunk_, chunkSize_, MS_ASYNC);
+    munmap(chunk_, chunkSize_);
+    chunk_ = nullptr;
+  }
+  if (header_ != nullptr) {
+    msync(header_, headerSize_, MS_ASYNC);
+    munmap(header_, headerSize_);
+    header_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  MELO_INFO_STREAM("[soem_interface_rsl::ProcessImageRecorder] Recorded " << written_.load() << " cycles to '" << path_ << "', "
+                                                                          << dropped_.load() << " dropped.")
+}
+
+ProcessImageRecording::~ProcessImageRecording() {
+  close();
+}
+
+bool ProcessImageRecording::open(const std::string& path) {
+  close();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecording] Could not open '" << path << "': " << std::strerror(errno))
+    return false;
+  }
+  struct stat status {};
+  if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(ProcessImageFileHeader)) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecording] '" << path << "' is not a process image recording.")
+    ::close(fd);
+    return false;
+  }
+  const size_t size = static_cast<size_t>(status.st_size);
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecording] Could not map '" << path << "': " << std::strerror(errno))
+    return false;
+  }
+  // the header was constructed by the recorder which created the file.
+  const auto* header = std::launder(static_cast<const ProcessImageFileHeader*>(mapping));
+  if (std::memcmp(header->magic, ProcessImageFileHeader::magic_, sizeof(header->magic)) != 0 ||
+      header->version != ProcessImageFileHeader::version_ || header->rowsPerChunk == 0 || header->chunkSize == 0 ||
+      header->headerSize < sizeof(ProcessImageFileHeader) + header->numberOfColumns * sizeof(ProcessImageColumnDescriptor) ||
+      header->headerSize > size) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecording] '" << path << "' is not a process image recording or has an "
+                                                                      << "unsupported version.")
+    munmap(mapping, size);
+    return false;
+  }
+  header_ = header;
+  mapping_ = static_cast<const uint8_t*>(mapping);
+  mappedSize_ = size;
+  const auto* descriptors = reinterpret_cast<const ProcessImageColumnDescriptor*>(mapping_ + sizeof(ProcessImageFileHeader));
+  columns_.assign(descriptors, descriptors + header->numberOfColumns);
+  for (const auto& column : columns_) {
+    const bool isImage = column.kind != static_cast<uint8_t>(ProcessImageColumnKind::Cycle);
+    if (column.chunkOffset + static_cast<uint64_t>(column.width) * header->rowsPerChunk > header->chunkSize ||
+        (isImage && (column.rowOffset < sizeof(ProcessImageRowHeader) ||
+                     column.rowOffset - sizeof(ProcessImageRowHeader) + column.width > header->imageSize))) {
+      MELO_ERROR_STREAM("[soem_interface_rsl::ProcessImageRecording] Column '"
+                        << std::string(column.name, strnlen(column.name, sizeof(column.name))) << "' of '" << path << "' is invalid.")
+      close();
+      return false;
+    }
+  }
+  // rows of chunks the file did not contain when it was mapped are not accessible.
+  const uint64_t mappedChunks = (size - header->headerSize) / header->chunkSize;
+  rows_ = std::min(header->rows.load(std::memory_order_acquire), mappedChunks * header->rowsPerChunk);
+  return true;
+}
+
+void ProcessImageRecording::close() {
+  if (mapping_ == nullptr) {
+    return;
+  }
+  munmap(const_cast<uint8_t*>(mapping_), mappedSize_);
+  header_ = nullptr;
+  mapping_ = nullptr;
+  mappedSize_ = 0;
+  rows_ = 0;
+  columns_.clear();
+}
+
+std::string ProcessImageRecording::getBusName() const {
+  if (header_ == nullptr) {
+    return "";
+  }
+  return std::string(header_->busName, strnlen(header_->busName, sizeof(header_->busName)));
+}
+
+int ProcessImageRecording::findColumn(const uint16_t slave, const ProcessImageColumnKind kind) const {
+  for (size_t i = 0; i < columns_.size(); i++) {
+    if (columns_[i].slave == slave && columns_[i].kind == static_cast<uint8_t>(kind)) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+const uint8_t* ProcessImageRecording::getCell(const size_t column, const uint64_t row) const {
+  const ProcessImageColumnDescriptor& descriptor = columns_[column];
+  return mapping_ + header_->headerSize + (row / header_->rowsPerChunk) * header_->chunkSize + descriptor.chunkOffset +
+         (row % header_->rowsPerChunk) * descriptor.width;
+}
+
+ProcessImageRowHeader ProcessImageRecording::getRowHeader(const uint64_t row) const {
+  uint8_t buffer[sizeof(ProcessImageRowHeader)]{};
+  for (size_t i = 0; i < columns_.size(); i++) {
+    const ProcessImageColumnDescriptor& column = columns_[i];
+    if (column.kind == static_cast<uint8_t>(ProcessImageColumnKind::Cycle) && column.rowOffset + column.width <= sizeof(buffer)) {
+      std::memcpy(buffer + column.rowOffset, getCell(i, row), column.width);
+    }
+  }
+  ProcessImageRowHeader header{};
+  std::memcpy(&header, buffer, sizeof(header));
+  return header;
+}
+
+void ProcessImageRecording::getImage(const uint64_t row, void* image) const {
+  std::memset(image, 0, getImageSize());
+  copyColumns(row, static_cast<uint8_t*>(image), false);
+}
+
+void ProcessImageRecording::getInputs(const uint64_t row, void* image) const {
+  copyColumns(row, static_cast<uint8_t*>(image), true);
+}
+
+void ProcessImageRecording::copyColumns(const uint64_t row, uint8_t* image, const bool onlyInputs) const {
+  for (size_t i = 0; i < columns_.size(); i++) {
+    const ProcessImageColumnDescriptor& column = columns_[i];
+    if (column.kind == static_cast<uint8_t>(ProcessImageColumnKind::Inputs) ||
+        (!onlyInputs && column.kind == static_cast<uint8_t>(ProcessImageColumnKind::Outputs))) {
+      std::memcpy(image + column.rowOffset - sizeof(ProcessImageRowHeader), getCell(i, row), column.width);
+    }
+  }
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
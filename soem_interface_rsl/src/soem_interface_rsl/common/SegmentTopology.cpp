@@ -0,0 +1,136 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/SegmentTopology.hpp"
+
+namespace soem_interface_rsl {
+namespace common {
+
+uint8_t SegmentTopology::previousPort(const uint8_t activePorts, const uint8_t port) {
+  // the ports before a port in reverse processing order 0 - 3 - 1 - 2.
+  static constexpr std::array<std::array<uint8_t, 3>, 4> candidates{{{2, 1, 3}, {3, 0, 2}, {1, 3, 0}, {0, 2, 1}}};
+  if (port > 3) {
+    return port;
+  }
+  for (const uint8_t candidate : candidates[port]) {
+    if (activePorts & (1 << candidate)) {
+      return candidate;
+    }
+  }
+  return port;
+}
+
+void SegmentTopology::build(const std::vector<TopologyNode>& nodes) {
+  nodes_.assign(nodes.size() + 1, TopologyNode());
+  distributedClockParentPort_.assign(nodes_.size(), 0);
+  laterChild_.assign(nodes_.size(), false);
+  updates_ = 0;
+  // ports of each slave not yet assigned to a child, consumed in the order 3 - 1 - 2 - 0 as the slaves are scanned.
+  std::vector<uint8_t> freePorts(nodes_.size(), 0);
+  // the master has a single port.
+  freePorts[0] = 0x01;
+  for (uint16_t address = 1; address < nodes_.size(); address++) {
+    TopologyNode& node = nodes_[address];
+    node = nodes[address - 1];
+    node.address = address;
+    distributedClockParentPort_[address] = node.parentPort;
+    freePorts[address] = node.activePorts & static_cast<uint8_t>(~(1 << node.entryPort));
+
+    const uint16_t parent = node.parent < address ? node.parent : 0;
+    node.parent = parent;
+    node.parentPort = 0;
+    for (const uint8_t port : {3, 1, 2, 0}) {
+      if (freePorts[parent] & (1 << port)) {
+        node.parentPort = port;
+        freePorts[parent] &= static_cast<uint8_t>(~(1 << port));
+        break;
+      }
+    }
+    nodes_[parent].children[node.parentPort] = address;
+
+    // distributed clock parent and whether the branch of this slave is not the first one of it, as ecx_configdc(..) determines them.
+    uint16_t child = address;
+    uint16_t dcParent = parent;
+    while (dcParent != 0 && !nodes_[dcParent].hasDistributedClock) {
+      child = dcParent;
+      dcParent = nodes_[dcParent].parent;
+    }
+    node.distributedClockParent = dcParent;
+    laterChild_[address] = child - dcParent > 1;
+
+    node.propagationDelay = node.startupPropagationDelay;
+    node.startupHopDelay = dcParent > 0 ? node.startupPropagationDelay - nodes_[dcParent].startupPropagationDelay : 0;
+    node.hopDelay = node.startupHopDelay;
+    node.averageHopDelay = node.startupHopDelay;
+    node.maxHopDelay = node.startupHopDelay;
+  }
+}
+
+int32_t SegmentTopology::portTime(const uint16_t address, const uint8_t port) const {
+  return port < 4 ? static_cast<int32_t>(nodes_[address].receiveTimes[port]) : 0;
+}
+
+void SegmentTopology::update(const std::vector<std::array<uint32_t, 4>>& receiveTimes) {
+  for (uint16_t address = 1; address < nodes_.size() && address < receiveTimes.size(); address++) {
+    nodes_[address].receiveTimes = receiveTimes[address];
+  }
+  // same computation as ecx_configdc(..), the parents come before their children.
+  for (uint16_t address = 1; address < nodes_.size(); address++) {
+    TopologyNode& node = nodes_[address];
+    const uint16_t parent = node.distributedClockParent;
+    if (!node.hasDistributedClock || parent == 0) {
+      continue;
+    }
+    const TopologyNode& parentNode = nodes_[parent];
+    const uint8_t parentPort = distributedClockParentPort_[address];
+    const uint8_t parentPreviousPort = previousPort(parentNode.activePorts, parentPort);
+    // delta time of (parentport - 1) - parentport.
+    const int32_t dt3 = portTime(parent, parentPort) - portTime(parent, parentPreviousPort);
+    // the delays of the children of this slave are subtracted.
+    int32_t dt1 = 0;
+    if (__builtin_popcount(node.activePorts) > 1) {
+      dt1 = portTime(address, previousPort(node.activePorts, node.entryPort)) - portTime(address, node.entryPort);
+    }
+    if (dt1 > dt3) {
+      dt1 = -dt1;
+    }
+    // the delays of the previous children of the parent are added.
+    int32_t dt2 = 0;
+    if (laterChild_[address]) {
+      dt2 = portTime(parent, parentPreviousPort) - portTime(parent, parentNode.entryPort);
+    }
+    if (dt2 < 0) {
+      dt2 = -dt2;
+    }
+    node.propagationDelay = (dt3 - dt1) / 2 + dt2 + parentNode.propagationDelay;
+    node.hopDelay = node.propagationDelay - parentNode.propagationDelay;
+    node.averageHopDelay += averageWeight_ * (node.hopDelay - node.averageHopDelay);
+    if (node.hopDelay > node.maxHopDelay) {
+      node.maxHopDelay = node.hopDelay;
+    }
+  }
+  updates_++;
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
@@ -0,0 +1,70 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/SlaveTiming.hpp"
+
+// std
+#include <ctime>
+
+namespace soem_interface_rsl {
+namespace common {
+
+SlaveTiming::Stamp SlaveTiming::start() {
+  Stamp stamp;
+  timespec time{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  stamp.cpuTime = static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+  stamp.wallTime = CycleStatistics::now();
+  return stamp;
+}
+
+int64_t SlaveTiming::stop(const Callback callback, const Stamp& start) {
+  const int64_t wallTime = CycleStatistics::now() - start.wallTime;
+  timespec time{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  const int64_t cpuTime = static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec - start.cpuTime;
+
+  const auto index = static_cast<unsigned int>(callback);
+  wallTimes_[index].record(wallTime);
+  cpuTimes_[index].record(cpuTime);
+  const int64_t budget = budget_.load(std::memory_order_relaxed);
+  if (budget > 0 && wallTime > budget) {
+    budgetExceeded_.store(budgetExceeded_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return wallTime;
+  }
+  return 0;
+}
+
+SlaveTimingSnapshot SlaveTiming::getSnapshot() const {
+  SlaveTimingSnapshot snapshot;
+  snapshot.readWallTime = wallTimes_[static_cast<unsigned int>(Callback::UpdateRead)].getSnapshot();
+  snapshot.readCpuTime = cpuTimes_[static_cast<unsigned int>(Callback::UpdateRead)].getSnapshot();
+  snapshot.writeWallTime = wallTimes_[static_cast<unsigned int>(Callback::UpdateWrite)].getSnapshot();
+  snapshot.writeCpuTime = cpuTimes_[static_cast<unsigned int>(Callback::UpdateWrite)].getSnapshot();
+  snapshot.budget = getBudget();
+  snapshot.budgetExceeded = budgetExceeded_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
@@ -0,0 +1,369 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+#include "soem_interface_rsl/common/LinkMonitor.hpp"
+
+// std
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+// linux
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netpacket/packet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// soem_rsl
+#include <soem_rsl/ethercat.h>
+
+// message logger
+#include <message_logger/message_logger.hpp>
+
+namespace soem_interface_rsl {
+namespace common {
+
+namespace {
+
+//! Sizes of the ethernet header, the EtherCAT header, a datagram header and a working counter.
+constexpr size_t ethernetHeaderSize = 14;
+constexpr size_t ecatHeaderSize = 2;
+constexpr size_t datagramHeaderSize = 10;
+constexpr size_t workingCounterSize = 2;
+constexpr uint16_t ethertypeEcat = 0x88A4;
+
+uint16_t get16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+void set16(uint8_t* data, const uint16_t value) {
+  data[0] = static_cast<uint8_t>(value);
+  data[1] = static_cast<uint8_t>(value >> 8);
+}
+
+}  // namespace
+
+VirtualSegment::VirtualSegment(const std::string& name) : VirtualSegment(name, Options()) {}
+
+VirtualSegment::VirtualSegment(const std::string& name, const Options& options)
+    : name_(name), options_(options), random_(options.seed) {}
+
+VirtualSegment::~VirtualSegment() {
+  stopServing();
+  detach();
+}
+
+VirtualSlave& VirtualSegment::addSlave(const VirtualSlaveDescription& description) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // the local clocks start at random times, up to 1000 s apart.
+  std::uniform_int_distribution<int64_t> clockOffset(0, 1000000000000);
+  if (!slaves_.empty()) {
+    slaves_.back()->setLinks(true);
+  }
+  slaves_.push_back(std::make_unique<VirtualSlave>(description, clockOffset(random_)));
+  return *slaves_.back();
+}
+
+void VirtualSegment::addSlaves(const VirtualSlaveDescription& description, const size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    addSlave(description);
+  }
+}
+
+size_t VirtualSegment::getNumberOfSlaves() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return slaves_.size();
+}
+
+void VirtualSegment::unplug(const size_t address) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  plugInLocked();
+  if (address == 0 || address > slaves_.size()) {
+    return;
+  }
+  unpluggedAddress_ = address;
+  if (address > 1) {
+    slaves_[address - 2]->setLinks(false);
+  }
+}
+
+void VirtualSegment::plugIn() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  plugInLocked();
+}
+
+void VirtualSegment::plugInLocked() {
+  if (unpluggedAddress_ > 1) {
+    slaves_[unpluggedAddress_ - 2]->setLinks(true);
+  }
+  unpluggedAddress_ = 0;
+}
+
+bool VirtualSegment::attach() {
+  if (attached_) {
+    return true;
+  }
+  const ec_transportt transport{&VirtualSegment::send, &VirtualSegment::receive, this};
+  if (ecx_registertransport(name_.c_str(), &transport) <= 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::VirtualSegment] Could not register the transport '" << name_ << "'.")
+    return false;
+  }
+  LinkMonitor::instance().setVirtualLinkUp(name_, true);
+  attached_ = true;
+  return true;
+}
+
+void VirtualSegment::detach() {
+  if (!attached_) {
+    return;
+  }
+  ecx_registertransport(name_.c_str(), nullptr);
+  LinkMonitor::instance().releaseVirtualLink(name_);
+  attached_ = false;
+}
+
+bool VirtualSegment::serve(const std::string& interface) {
+  if (serving_) {
+    return false;
+  }
+  socket_ = socket(PF_PACKET, SOCK_RAW, htons(ethertypeEcat));
+  if (socket_ < 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::VirtualSegment] Could not open a raw socket: " << strerror(errno) << ".")
+    return false;
+  }
+  sockaddr_ll address{};
+  address.sll_family = AF_PACKET;
+  address.sll_protocol = htons(ethertypeEcat);
+  address.sll_ifindex = static_cast<int>(if_nametoindex(interface.c_str()));
+  // the receive timeout bounds the time to stop serving.
+  timeval timeout{0, 10000};
+  if (address.sll_ifindex == 0 || bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0) {
+    MELO_ERROR_STREAM("[soem_interface_rsl::VirtualSegment] Could not bind to '" << interface << "': " << strerror(errno) << ".")
+    close(socket_);
+    socket_ = -1;
+    return false;
+  }
+  serving_ = true;
+  thread_ = std::thread(&VirtualSegment::serveInterface, this);
+  return true;
+}
+
+void VirtualSegment::stopServing() {
+  serving_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (socket_ >= 0) {
+    close(socket_);
+    socket_ = -1;
+  }
+}
+
+bool VirtualSegment::processFrame(uint8_t* frame, const size_t length) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return processFrameLocked(frame, length);
+}
+
+int VirtualSegment::send(void* userdata, int /*stack*/, const void* frame, int length) {
+  auto& segment = *static_cast<VirtualSegment*>(userdata);
+  if (length <= 0 || static_cast<size_t>(length) > maxFrameLength) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> lock(segment.mutex_);
+  if (segment.queueSize_ == queueCapacity) {
+    // the receive ring is full, the frame is lost on the wire.
+    return length;
+  }
+  Frame& slot = segment.queue_[(segment.queueHead_ + segment.queueSize_) % queueCapacity];
+  std::memcpy(slot.data.data(), frame, length);
+  slot.length = static_cast<uint16_t>(length);
+  if (segment.processFrameLocked(slot.data.data(), slot.length)) {
+    ++segment.queueSize_;
+  }
+  return length;
+}
+
+int VirtualSegment::receive(void* userdata, int /*stack*/, void* frame, int length) {
+  auto& segment = *static_cast<VirtualSegment*>(userdata);
+  std::lock_guard<std::mutex> lock(segment.mutex_);
+  if (segment.queueSize_ == 0) {
+    return 0;
+  }
+  const Frame& slot = segment.queue_[segment.queueHead_];
+  segment.queueHead_ = (segment.queueHead_ + 1) % queueCapacity;
+  --segment.queueSize_;
+  const int received = std::min<int>(slot.length, length);
+  std::memcpy(frame, slot.data.data(), received);
+  return received;
+}
+
+int64_t VirtualSegment::now() {
+  timespec time{};
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+bool VirtualSegment::processFrameLocked(uint8_t* frame, const size_t length) {
+  if (length < ethernetHeaderSize + ecatHeaderSize || ((frame[12] << 8) | frame[13]) != ethertypeEcat) {
+    return false;
+  }
+  const uint16_t header = get16(frame + ethernetHeaderSize);
+  // only frames of type 1 carry datagrams.
+  if ((header >> 12) != 0x01) {
+    return false;
+  }
+  const size_t end = std::min(length, ethernetHeaderSize + ecatHeaderSize + (header & 0x07FF));
+
+  // locate the datagrams, a datagram is followed by another one while its "more" bit is set.
+  std::array<uint8_t*, 64> datagrams{};
+  size_t numberOfDatagrams = 0;
+  size_t offset = ethernetHeaderSize + ecatHeaderSize;
+  while (numberOfDatagrams < datagrams.size() && offset + datagramHeaderSize + workingCounterSize <= end) {
+    uint8_t* datagram = frame + offset;
+    const uint16_t lengthAndFlags = get16(datagram + 6);
+    const size_t next = offset + datagramHeaderSize + (lengthAndFlags & 0x07FF) + workingCounterSize;
+    if (next > end) {
+      break;
+    }
+    datagrams[numberOfDatagrams++] = datagram;
+    offset = next;
+    if ((lengthAndFlags & 0x8000) == 0) {
+      break;
+    }
+  }
+
+  // the frame passes port 0 of every slave on the way out and port 1 on the way back.
+  const int64_t start = now();
+  const auto numberOfSlaves = static_cast<int64_t>(unpluggedAddress_ > 0 ? unpluggedAddress_ - 1 : slaves_.size());
+  for (int64_t position = 0; position < numberOfSlaves; ++position) {
+    VirtualSlave& slave = *slaves_[position];
+    slave.setFrameTimes(start + position * options_.hopDelay, start + (2 * numberOfSlaves - 1 - position) * options_.hopDelay);
+    for (size_t i = 0; i < numberOfDatagrams; ++i) {
+      processDatagram(slave, datagrams[i]);
+    }
+  }
+  frames_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void VirtualSegment::processDatagram(VirtualSlave& slave, uint8_t* datagram) {
+  const uint8_t command = datagram[0];
+  const uint16_t position = get16(datagram + 2);
+  const uint16_t address = get16(datagram + 4);
+  const uint16_t length = get16(datagram + 6) & 0x07FF;
+  uint8_t* data = datagram + datagramHeaderSize;
+
+  // auto increment addressed slaves count the position up, the slave at position 0 is addressed.
+  bool addressed = false;
+  switch (command) {
+    case EC_CMD_APRD:
+    case EC_CMD_APWR:
+    case EC_CMD_APRW:
+    case EC_CMD_ARMW:
+      addressed = position == 0;
+      set16(datagram + 2, static_cast<uint16_t>(position + 1));
+      break;
+    case EC_CMD_FPRD:
+    case EC_CMD_FPWR:
+    case EC_CMD_FPRW:
+    case EC_CMD_FRMW:
+      addressed = position == slave.getStationAddress();
+      break;
+    case EC_CMD_BRD:
+    case EC_CMD_BWR:
+    case EC_CMD_BRW:
+      addressed = true;
+      set16(datagram + 2, static_cast<uint16_t>(position + 1));
+      break;
+    default:
+      break;
+  }
+
+  uint16_t increment = 0;
+  switch (command) {
+    case EC_CMD_APRD:
+    case EC_CMD_FPRD:
+    case EC_CMD_BRD:
+      increment = addressed && slave.read(address, data, length, command == EC_CMD_BRD) ? 1 : 0;
+      break;
+    case EC_CMD_APWR:
+    case EC_CMD_FPWR:
+    case EC_CMD_BWR:
+      increment = addressed && slave.write(address, data, length) ? 1 : 0;
+      break;
+    case EC_CMD_APRW:
+    case EC_CMD_FPRW:
+    case EC_CMD_BRW:
+      if (addressed) {
+        // the incoming data is written, the previous content is returned.
+        const std::vector<uint8_t> written(data, data + length);
+        if (slave.read(address, data, length, command == EC_CMD_BRW) && slave.write(address, written.data(), length)) {
+          increment = 3;
+        }
+      }
+      break;
+    case EC_CMD_LRD:
+    case EC_CMD_LWR:
+    case EC_CMD_LRW:
+      increment = slave.accessLogical((static_cast<uint32_t>(address) << 16) | position, data, length, command != EC_CMD_LWR,
+                                      command != EC_CMD_LRD);
+      break;
+    case EC_CMD_ARMW:
+    case EC_CMD_FRMW:
+      // the addressed slave reads, all others write, e.g. to distribute the reference clock.
+      if (addressed) {
+        increment = slave.read(address, data, length) ? 1 : 0;
+      } else {
+        increment = slave.write(address, data, length) ? 1 : 0;
+      }
+      break;
+    default:
+      break;
+  }
+  if (increment > 0) {
+    uint8_t* workingCounter = data + length;
+    set16(workingCounter, static_cast<uint16_t>(get16(workingCounter) + increment));
+  }
+}
+
+void VirtualSegment::serveInterface() {
+  Frame frame;
+  while (serving_) {
+    const ssize_t length = recv(socket_, frame.data.data(), frame.data.size(), 0);
+    if (length <= 0) {
+      continue;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (processFrameLocked(frame.data.data(), static_cast<size_t>(length))) {
+      ::send(socket_, frame.data.data(), static_cast<size_t>(length), 0);
+    }
+  }
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
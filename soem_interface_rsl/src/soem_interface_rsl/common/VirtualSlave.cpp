@@ -0,0 +1,678 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// soem_interface_rsl
+#include "soem_interface_rsl/common/VirtualSlave.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+
+// soem_rsl
+#include <soem_rsl/ethercat.h>
+
+namespace soem_interface_rsl {
+namespace common {
+
+namespace {
+
+//! Start of the process RAM, the mailboxes and process data are placed there.
+constexpr uint16_t processRamAddress = 0x1000;
+//! Offsets in the FMMU and SyncManager registers.
+constexpr uint16_t fmmuSize = 16;
+constexpr uint16_t syncManagerSize = 8;
+constexpr uint8_t syncManagerMailboxFull = 0x08;
+//! AL status codes.
+constexpr uint16_t alInvalidStateChange = 0x0011;
+constexpr uint16_t alUnknownState = 0x0012;
+constexpr uint16_t alInvalidMailboxConfiguration = 0x0016;
+constexpr uint16_t alInvalidOutputConfiguration = 0x001D;
+constexpr uint16_t alInvalidInputConfiguration = 0x001E;
+//! SDO abort codes.
+constexpr uint32_t sdoCommandInvalid = 0x05040001;
+constexpr uint32_t sdoOutOfMemory = 0x05040005;
+constexpr uint32_t sdoUnsupportedAccess = 0x06010000;
+constexpr uint32_t sdoReadOnly = 0x06010002;
+constexpr uint32_t sdoObjectDoesNotExist = 0x06020000;
+constexpr uint32_t sdoLengthMismatch = 0x06070010;
+constexpr uint32_t sdoSubIndexDoesNotExist = 0x06090011;
+//! Size of the mailbox header and of the CoE SDO header following it.
+constexpr uint16_t mailboxHeaderSize = 6;
+constexpr uint16_t sdoHeaderSize = 10;
+
+uint16_t align8(const size_t address) {
+  return static_cast<uint16_t>((address + 7) & ~static_cast<size_t>(7));
+}
+
+template <typename T>
+void put(std::vector<uint8_t>& buffer, const T value) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    buffer.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+  }
+}
+
+template <typename T>
+std::vector<uint8_t> toBytes(const T value) {
+  std::vector<uint8_t> bytes;
+  put(bytes, value);
+  return bytes;
+}
+
+uint16_t get16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t get32(const uint8_t* data) {
+  return static_cast<uint32_t>(get16(data)) | (static_cast<uint32_t>(get16(data + 2)) << 16);
+}
+
+void set16(uint8_t* data, const uint16_t value) {
+  data[0] = static_cast<uint8_t>(value);
+  data[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void set32(uint8_t* data, const uint32_t value) {
+  set16(data, static_cast<uint16_t>(value));
+  set16(data + 2, static_cast<uint16_t>(value >> 16));
+}
+
+void addPdos(std::vector<VirtualSlaveDescription::Pdo>& pdos, const uint16_t pdoIndex, const uint16_t objectIndex, size_t size) {
+  // a PDO maps at most 254 entries, larger sizes are split into several PDOs.
+  constexpr size_t maxEntries = 254;
+  for (uint16_t offset = 0; size > 0; ++offset) {
+    VirtualSlaveDescription::Pdo pdo;
+    pdo.index = static_cast<uint16_t>(pdoIndex + offset);
+    uint8_t subIndex = 1;
+    for (; size >= 4 && pdo.entries.size() < maxEntries; size -= 4) {
+      pdo.entries.push_back({static_cast<uint16_t>(objectIndex + offset), subIndex++, 32});
+    }
+    for (; size > 0 && pdo.entries.size() < maxEntries; --size) {
+      pdo.entries.push_back({static_cast<uint16_t>(objectIndex + offset), subIndex++, 8});
+    }
+    pdos.push_back(pdo);
+  }
+}
+
+size_t getPdoSize(const std::vector<VirtualSlaveDescription::Pdo>& pdos) {
+  size_t bits = 0;
+  for (const auto& pdo : pdos) {
+    for (const auto& entry : pdo.entries) {
+      bits += entry.bitLength;
+    }
+  }
+  return (bits + 7) / 8;
+}
+
+}  // namespace
+
+VirtualSlaveDescription VirtualSlaveDescription::fromPdoSizes(const std::string& name, const uint32_t vendorId, const uint32_t productCode,
+                                                              const size_t rxPdoSize, const size_t txPdoSize) {
+  VirtualSlaveDescription description;
+  description.name = name;
+  description.vendorId = vendorId;
+  description.productCode = productCode;
+  addPdos(description.rxPdos, 0x1600, 0x7000, rxPdoSize);
+  addPdos(description.txPdos, 0x1A00, 0x6000, txPdoSize);
+  return description;
+}
+
+size_t VirtualSlaveDescription::getRxPdoSize() const {
+  return getPdoSize(rxPdos);
+}
+
+size_t VirtualSlaveDescription::getTxPdoSize() const {
+  return getPdoSize(txPdos);
+}
+
+VirtualSlave::VirtualSlave(const VirtualSlaveDescription& description, const int64_t clockOffset)
+    : description_(description), clockOffset_(clockOffset) {
+  // mailboxes first, then the outputs and inputs, each buffer aligned to 8 bytes.
+  size_t address = processRamAddress;
+  if (description_.hasMailbox) {
+    mailboxOutAddress_ = static_cast<uint16_t>(address);
+    mailboxInAddress_ = align8(mailboxOutAddress_ + description_.mailboxSize);
+    address = mailboxInAddress_ + description_.mailboxSize;
+  }
+  outputsSyncManager_ = description_.hasMailbox ? 2 : 0;
+  outputsAddress_ = align8(address);
+  outputSize_ = description_.getRxPdoSize();
+  inputsAddress_ = align8(outputsAddress_ + outputSize_);
+  inputSize_ = description_.getTxPdoSize();
+  memory_.resize(std::max(memorySize, static_cast<size_t>(inputsAddress_) + inputSize_));
+
+  memory_[ECT_REG_TYPE] = 0x11;
+  memory_[ECT_REG_TYPE + 1] = 0x01;
+  // number of FMMUs and SyncManagers, RAM size in kB.
+  memory_[0x0004] = 8;
+  memory_[0x0005] = 8;
+  memory_[0x0006] = static_cast<uint8_t>((memory_.size() - processRamAddress) / 1024);
+  memory_[ECT_REG_PORTDES] = 0x0F;
+  setRegister16(ECT_REG_ESCSUP, description_.hasDistributedClocks ? 0x000C : 0x0000);
+  setRegister16(ECT_REG_ALSTAT, EC_STATE_INIT);
+  setRegister16(ECT_REG_EEPSTAT, EC_ESTAT_R64);
+  setLinks(false);
+
+  createSii();
+  createObjectDictionary();
+  application_ = [](VirtualSlave& slave) {
+    std::memcpy(slave.getInputs(), slave.getOutputs(), std::min(slave.getInputSize(), slave.getOutputSize()));
+  };
+}
+
+uint16_t VirtualSlave::getStationAddress() const {
+  return getRegister16(ECT_REG_STADR);
+}
+
+uint8_t VirtualSlave::getState() const {
+  return static_cast<uint8_t>(getRegister16(ECT_REG_ALSTAT) & 0x0F);
+}
+
+uint16_t VirtualSlave::getAlStatusCode() const {
+  return getRegister16(ECT_REG_ALSTATCODE);
+}
+
+void VirtualSlave::setLinks(const bool port1) {
+  port1_ = port1;
+  // PDI operational, link and communication on port 0, ports 2 and 3 closed.
+  uint16_t status = 0x0001 | 0x0010 | 0x0200 | 0x1000 | 0x4000;
+  status |= port1 ? (0x0020 | 0x0800) : 0x0400;
+  setRegister16(ECT_REG_DLSTAT, status);
+}
+
+void VirtualSlave::setFrameTimes(const int64_t port0, const int64_t port1) {
+  port0Time_ = port0;
+  port1Time_ = port1;
+}
+
+bool VirtualSlave::read(const uint16_t address, uint8_t* data, const uint16_t length, const bool combine) {
+  if (static_cast<size_t>(address) + length > memory_.size()) {
+    return false;
+  }
+  if (description_.hasDistributedClocks && overlaps(address, length, ECT_REG_DCSYSTIME, 8)) {
+    setRegister64(ECT_REG_DCSYSTIME, static_cast<uint64_t>(getSystemTime(port0Time_)));
+  }
+  if (pendingState_ != 0 && port0Time_ >= pendingStateTime_ && overlaps(address, length, ECT_REG_ALSTAT, 2)) {
+    setRegister16(ECT_REG_ALSTAT, (getRegister16(ECT_REG_ALSTAT) & EC_STATE_ERROR) | pendingState_);
+    pendingState_ = 0;
+  }
+  const uint8_t* source = memory_.data() + address;
+  if (combine) {
+    for (uint16_t i = 0; i < length; ++i) {
+      data[i] |= source[i];
+    }
+  } else {
+    std::memcpy(data, source, length);
+  }
+
+  // reading the last byte of the mailbox empties it.
+  uint8_t& status = memory_[ECT_REG_SM1STAT];
+  const uint16_t mailboxLength = getRegister16(ECT_REG_SM1 + 2);
+  if ((status & syncManagerMailboxFull) != 0 && mailboxLength > 0 &&
+      overlaps(address, length, getRegister16(ECT_REG_SM1) + mailboxLength - 1, 1)) {
+    status &= ~syncManagerMailboxFull;
+  }
+  return true;
+}
+
+bool VirtualSlave::write(const uint16_t address, const uint8_t* data, const uint16_t length) {
+  if (static_cast<size_t>(address) + length > memory_.size()) {
+    return false;
+  }
+  if (address >= processRamAddress) {
+    std::memcpy(memory_.data() + address, data, length);
+  } else {
+    for (uint16_t i = 0; i < length; ++i) {
+      if (!isReadOnly(address + i)) {
+        memory_[address + i] = data[i];
+      }
+    }
+  }
+
+  if (overlaps(address, length, ECT_REG_ALCTL, 2)) {
+    processAlControl();
+  }
+  if (overlaps(address, length, ECT_REG_EEPCTL, 2)) {
+    processEepromCommand();
+  }
+  if (description_.hasDistributedClocks && overlaps(address, length, ECT_REG_DCTIME0, 4)) {
+    // latch the receive times of the ports and the start of the frame.
+    set32(&memory_[ECT_REG_DCTIME0], static_cast<uint32_t>(getLocalTime(port0Time_)));
+    set32(&memory_[ECT_REG_DCTIME1], port1_ ? static_cast<uint32_t>(getLocalTime(port1Time_)) : 0);
+    setRegister64(ECT_REG_DCSOF, static_cast<uint64_t>(getLocalTime(port0Time_)));
+  }
+  if (description_.hasDistributedClocks && address == ECT_REG_DCSYSTIME && length >= 8) {
+    processSystemTime();
+  }
+  const uint16_t mailboxLength = getRegister16(ECT_REG_SM0 + 2);
+  if ((memory_[ECT_REG_SM0 + 6] & 0x01) != 0 && mailboxLength > 0 &&
+      overlaps(address, length, getRegister16(ECT_REG_SM0) + mailboxLength - 1, 1)) {
+    processMailbox();
+  }
+  if (outputSize_ > 0 && getState() == EC_STATE_OPERATIONAL && overlaps(address, length, outputsAddress_ + outputSize_ - 1, 1)) {
+    runApplication();
+  }
+  return true;
+}
+
+uint16_t VirtualSlave::accessLogical(const uint32_t address, uint8_t* data, const uint16_t length, const bool read, const bool write) {
+  const uint8_t state = getState();
+  if (state != EC_STATE_SAFE_OP && state != EC_STATE_OPERATIONAL) {
+    return 0;
+  }
+  bool hasRead = false;
+  bool hasWritten = false;
+  // the inputs are read before the outputs are written, so they are one frame old like on a real slave.
+  for (const bool writePass : {false, true}) {
+    if ((writePass && (!write || state != EC_STATE_OPERATIONAL)) || (!writePass && !read)) {
+      continue;
+    }
+    for (uint8_t fmmu = 0; fmmu < memory_[0x0004]; ++fmmu) {
+      const uint8_t* registers = &memory_[ECT_REG_FMMU0 + fmmu * fmmuSize];
+      const uint8_t type = registers[11];
+      if ((registers[12] & 0x01) == 0 || (type & (writePass ? 0x02 : 0x01)) == 0) {
+        continue;
+      }
+      const uint64_t logicalStart = get32(registers);
+      const uint64_t begin = std::max<uint64_t>(logicalStart, address);
+      const uint64_t end = std::min<uint64_t>(logicalStart + get16(registers + 4), static_cast<uint64_t>(address) + length);
+      if (begin >= end) {
+        continue;
+      }
+      const auto physical = static_cast<uint16_t>(get16(registers + 8) + (begin - logicalStart));
+      const auto size = static_cast<uint16_t>(end - begin);
+      uint8_t* frameData = data + (begin - address);
+      if (writePass) {
+        hasWritten |= this->write(physical, frameData, size);
+      } else {
+        hasRead |= this->read(physical, frameData, size);
+      }
+    }
+  }
+  return static_cast<uint16_t>((hasRead ? 1 : 0) + (hasWritten ? (read ? 2 : 1) : 0));
+}
+
+uint16_t VirtualSlave::getRegister16(const uint16_t address) const {
+  return get16(&memory_[address]);
+}
+
+void VirtualSlave::setRegister16(const uint16_t address, const uint16_t value) {
+  set16(&memory_[address], value);
+}
+
+uint64_t VirtualSlave::getRegister64(const uint16_t address) const {
+  return static_cast<uint64_t>(get32(&memory_[address])) | (static_cast<uint64_t>(get32(&memory_[address + 4])) << 32);
+}
+
+void VirtualSlave::setRegister64(const uint16_t address, const uint64_t value) {
+  set32(&memory_[address], static_cast<uint32_t>(value));
+  set32(&memory_[address + 4], static_cast<uint32_t>(value >> 32));
+}
+
+bool VirtualSlave::isReadOnly(const uint16_t address) {
+  return address < ECT_REG_STADR || (address >= ECT_REG_DLSTAT && address < ECT_REG_DLSTAT + 2) ||
+         (address >= ECT_REG_ALSTAT && address < ECT_REG_ALSTAT + 6) ||
+         (address >= ECT_REG_SM0 && address < ECT_REG_SM0 + 16 * syncManagerSize && (address - ECT_REG_SM0) % syncManagerSize == 5) ||
+         (address >= ECT_REG_DCTIME0 && address < ECT_REG_DCSYSTIME) || (address >= ECT_REG_DCSOF && address < ECT_REG_DCSOF + 8) ||
+         (address >= ECT_REG_DCSYSDIFF && address < ECT_REG_DCSYSDIFF + 4);
+}
+
+bool VirtualSlave::overlaps(const uint16_t address, const uint16_t length, const uint16_t begin, const uint16_t size) {
+  return address < begin + size && begin < address + length;
+}
+
+int64_t VirtualSlave::getSystemTime(const int64_t time) const {
+  return getLocalTime(time) + static_cast<int64_t>(getRegister64(ECT_REG_DCSYSOFFSET));
+}
+
+void VirtualSlave::createSii() {
+  std::vector<uint8_t> sii(2 * ECT_SII_START, 0);
+  set32(&sii[2 * ECT_SII_MANUF], description_.vendorId);
+  set32(&sii[2 * ECT_SII_ID], description_.productCode);
+  set32(&sii[2 * ECT_SII_REV], description_.revision);
+  set32(&sii[2 * 0x000E], description_.serialNumber);
+  if (description_.hasMailbox) {
+    set16(&sii[2 * ECT_SII_RXMBXADR], mailboxOutAddress_);
+    set16(&sii[2 * ECT_SII_RXMBXADR + 2], description_.mailboxSize);
+    set16(&sii[2 * ECT_SII_TXMBXADR], mailboxInAddress_);
+    set16(&sii[2 * ECT_SII_TXMBXADR + 2], description_.mailboxSize);
+    set16(&sii[2 * ECT_SII_MBXPROTO], ECT_MBXPROT_COE);
+  }
+  // size in kbit - 1 and version.
+  set16(&sii[2 * 0x003E], 0x001F);
+  set16(&sii[2 * 0x003F], 0x0001);
+
+  auto addCategory = [&sii](const uint16_t type, std::vector<uint8_t> data) {
+    if (data.size() % 2 != 0) {
+      data.push_back(0);
+    }
+    put(sii, type);
+    put(sii, static_cast<uint16_t>(data.size() / 2));
+    sii.insert(sii.end(), data.begin(), data.end());
+  };
+
+  const std::string name = description_.name.substr(0, 255);
+  std::vector<uint8_t> strings{1, static_cast<uint8_t>(name.size())};
+  strings.insert(strings.end(), name.begin(), name.end());
+  addCategory(ECT_SII_STRING, strings);
+
+  std::vector<uint8_t> general(32, 0);
+  // name string index and CoE details: SDO and PDO assignment, no complete access.
+  general[3] = 1;
+  general[5] = description_.hasMailbox ? (ECT_COEDET_SDO | 0x04) : 0;
+  addCategory(ECT_SII_GENERAL, general);
+
+  // FMMU 0 for the outputs, FMMU 1 for the inputs.
+  addCategory(ECT_SII_FMMU, {0x01, 0x02});
+
+  std::vector<uint8_t> syncManagers;
+  auto addSyncManager = [&syncManagers](const uint16_t address, const size_t length, const uint8_t control, const uint8_t type) {
+    put(syncManagers, address);
+    put(syncManagers, static_cast<uint16_t>(length));
+    syncManagers.push_back(control);
+    syncManagers.push_back(0);
+    syncManagers.push_back(length > 0 ? 0x01 : 0x00);
+    syncManagers.push_back(type);
+  };
+  if (description_.hasMailbox) {
+    addSyncManager(mailboxOutAddress_, description_.mailboxSize, 0x26, 1);
+    addSyncManager(mailboxInAddress_, description_.mailboxSize, 0x22, 2);
+  }
+  addSyncManager(outputsAddress_, outputSize_, 0x64, 3);
+  addSyncManager(inputsAddress_, inputSize_, 0x20, 4);
+  addCategory(ECT_SII_SM, syncManagers);
+
+  auto pdoCategory = [](const std::vector<VirtualSlaveDescription::Pdo>& pdos, const int syncManager) {
+    std::vector<uint8_t> data;
+    for (const auto& pdo : pdos) {
+      put(data, pdo.index);
+      data.push_back(static_cast<uint8_t>(pdo.entries.size()));
+      data.push_back(static_cast<uint8_t>(syncManager));
+      // DC sync, name index and flags.
+      put(data, static_cast<uint32_t>(0));
+      for (const auto& entry : pdo.entries) {
+        put(data, entry.index);
+        data.push_back(entry.subIndex);
+        // name index and data type.
+        put(data, static_cast<uint16_t>(0));
+        data.push_back(entry.bitLength);
+        put(data, static_cast<uint16_t>(0));
+      }
+    }
+    return data;
+  };
+  if (!description_.txPdos.empty()) {
+    addCategory(ECT_SII_PDO, pdoCategory(description_.txPdos, outputsSyncManager_ + 1));
+  }
+  if (!description_.rxPdos.empty()) {
+    addCategory(ECT_SII_PDO + 1, pdoCategory(description_.rxPdos, outputsSyncManager_));
+  }
+  put(sii, static_cast<uint16_t>(0xFFFF));
+
+  sii_.resize(sii.size() / 2);
+  for (size_t i = 0; i < sii_.size(); ++i) {
+    sii_[i] = get16(&sii[2 * i]);
+  }
+}
+
+void VirtualSlave::createObjectDictionary() {
+  if (!description_.hasMailbox) {
+    return;
+  }
+  addObject(0x1000, 0, toBytes<uint32_t>(0));
+  addObject(0x1008, 0, std::vector<uint8_t>(description_.name.begin(), description_.name.end()));
+  addObject(0x1018, 0, toBytes<uint8_t>(4));
+  addObject(0x1018, 1, toBytes(description_.vendorId));
+  addObject(0x1018, 2, toBytes(description_.productCode));
+  addObject(0x1018, 3, toBytes(description_.revision));
+  addObject(0x1018, 4, toBytes(description_.serialNumber));
+  addObject(ECT_SDO_SMCOMMTYPE, 0, toBytes<uint8_t>(4));
+  for (uint8_t syncManager = 0; syncManager < 4; ++syncManager) {
+    addObject(ECT_SDO_SMCOMMTYPE, syncManager + 1, toBytes<uint8_t>(syncManager + 1));
+  }
+
+  auto addPdoObjects = [this](const uint16_t assignIndex, const std::vector<VirtualSlaveDescription::Pdo>& pdos) {
+    addObject(assignIndex, 0, toBytes(static_cast<uint8_t>(pdos.size())));
+    for (size_t i = 0; i < pdos.size(); ++i) {
+      const auto& pdo = pdos[i];
+      addObject(assignIndex, static_cast<uint8_t>(i + 1), toBytes(pdo.index));
+      addObject(pdo.index, 0, toBytes(static_cast<uint8_t>(pdo.entries.size())));
+      for (size_t j = 0; j < pdo.entries.size(); ++j) {
+        const auto& entry = pdo.entries[j];
+        const uint32_t mapping = (static_cast<uint32_t>(entry.index) << 16) | (entry.subIndex << 8) | entry.bitLength;
+        addObject(pdo.index, static_cast<uint8_t>(j + 1), toBytes(mapping));
+      }
+    }
+  };
+  addPdoObjects(ECT_SDO_RXPDOASSIGN, description_.rxPdos);
+  addPdoObjects(ECT_SDO_TXPDOASSIGN, description_.txPdos);
+
+  for (const auto& object : description_.objects) {
+    addObject(object.index, object.subIndex, object.value, true);
+  }
+}
+
+void VirtualSlave::addObject(const uint16_t index, const uint8_t subIndex, const std::vector<uint8_t>& value, const bool writable) {
+  objects_[(static_cast<uint32_t>(index) << 8) | subIndex] = ObjectEntry{value, writable};
+}
+
+void VirtualSlave::processAlControl() {
+  const uint16_t control = getRegister16(ECT_REG_ALCTL);
+  const uint8_t requested = control & 0x0F;
+  uint16_t status = getRegister16(ECT_REG_ALSTAT);
+  const uint8_t current = status & 0x0F;
+  if ((control & EC_STATE_ACK) != 0) {
+    status &= ~EC_STATE_ERROR;
+    setRegister16(ECT_REG_ALSTATCODE, 0);
+  } else if ((status & EC_STATE_ERROR) != 0 && requested > current) {
+    // an error has to be acknowledged before going up again.
+    return;
+  }
+
+  uint16_t code = 0;
+  if (requested != EC_STATE_INIT && requested != EC_STATE_PRE_OP && requested != EC_STATE_BOOT && requested != EC_STATE_SAFE_OP &&
+      requested != EC_STATE_OPERATIONAL) {
+    code = alUnknownState;
+  } else if (requested == current || requested == EC_STATE_INIT) {
+    // always allowed.
+  } else if (current == EC_STATE_BOOT || requested == EC_STATE_BOOT) {
+    code = current == EC_STATE_INIT ? 0 : alInvalidStateChange;
+  } else if (requested < current) {
+    // going down is always allowed.
+  } else if (current == EC_STATE_INIT && requested == EC_STATE_PRE_OP) {
+    if (description_.hasMailbox && (!checkSyncManager(0, mailboxOutAddress_, description_.mailboxSize) ||
+                                    !checkSyncManager(1, mailboxInAddress_, description_.mailboxSize))) {
+      code = alInvalidMailboxConfiguration;
+    }
+  } else if (current == EC_STATE_PRE_OP && requested == EC_STATE_SAFE_OP) {
+    if (outputSize_ > 0 && !checkSyncManager(outputsSyncManager_, outputsAddress_, static_cast<uint16_t>(outputSize_))) {
+      code = alInvalidOutputConfiguration;
+    } else if (inputSize_ > 0 && !checkSyncManager(outputsSyncManager_ + 1, inputsAddress_, static_cast<uint16_t>(inputSize_))) {
+      code = alInvalidInputConfiguration;
+    }
+  } else if (!(current == EC_STATE_SAFE_OP && requested == EC_STATE_OPERATIONAL)) {
+    code = alInvalidStateChange;
+  }
+
+  if (code != 0) {
+    setRegister16(ECT_REG_ALSTAT, current | EC_STATE_ERROR);
+    setRegister16(ECT_REG_ALSTATCODE, code);
+    return;
+  }
+  if (requested == EC_STATE_INIT) {
+    memory_[ECT_REG_SM0STAT] &= ~syncManagerMailboxFull;
+    memory_[ECT_REG_SM1STAT] &= ~syncManagerMailboxFull;
+  }
+  // a new request replaces a state change in progress.
+  pendingState_ = 0;
+  if (description_.stateChangeDelay > 0 && requested > current && (requested == EC_STATE_SAFE_OP || requested == EC_STATE_OPERATIONAL)) {
+    pendingState_ = requested;
+    pendingStateTime_ = port0Time_ + description_.stateChangeDelay;
+    setRegister16(ECT_REG_ALSTAT, status);
+    return;
+  }
+  setRegister16(ECT_REG_ALSTAT, (status & EC_STATE_ERROR) | requested);
+}
+
+bool VirtualSlave::checkSyncManager(const int syncManager, const uint16_t address, const uint16_t length) const {
+  const uint16_t registers = ECT_REG_SM0 + syncManager * syncManagerSize;
+  return getRegister16(registers) == address && getRegister16(registers + 2) == length && (memory_[registers + 6] & 0x01) != 0;
+}
+
+void VirtualSlave::processEepromCommand() {
+  const uint16_t command = getRegister16(ECT_REG_EEPCTL) & 0x0700;
+  const uint32_t address = get32(&memory_[ECT_REG_EEPADR]);
+  if (command == (EC_ECMD_READ & 0x0700)) {
+    for (uint32_t i = 0; i < 4; ++i) {
+      setRegister16(ECT_REG_EEPDAT + 2 * i, address + i < sii_.size() ? sii_[address + i] : 0xFFFF);
+    }
+  } else if (command == (EC_ECMD_WRITE & 0x0700) && address < sii_.size()) {
+    sii_[address] = getRegister16(ECT_REG_EEPDAT);
+  }
+  // commands complete immediately, 8 bytes are read at once.
+  setRegister16(ECT_REG_EEPSTAT, EC_ESTAT_R64);
+}
+
+void VirtualSlave::processSystemTime() {
+  // the written time of the reference clock plus the propagation delay is compared to the own system time.
+  const auto written = static_cast<int64_t>(getRegister64(ECT_REG_DCSYSTIME));
+  const int64_t delay = static_cast<int32_t>(get32(&memory_[ECT_REG_DCSYSDELAY]));
+  const int64_t difference = getSystemTime(port0Time_) - (written + delay);
+  const auto magnitude = static_cast<uint32_t>(std::min<int64_t>(difference < 0 ? -difference : difference, 0x7FFFFFFF));
+  set32(&memory_[ECT_REG_DCSYSDIFF], magnitude | (difference < 0 ? 0x80000000 : 0));
+
+  // the control loop corrects a quarter of the difference per write, as a real ESC converges over many cycles.
+  const int64_t correction = (difference > -4 && difference < 4) ? difference : difference / 4;
+  setRegister64(ECT_REG_DCSYSOFFSET, getRegister64(ECT_REG_DCSYSOFFSET) - static_cast<uint64_t>(correction));
+}
+
+void VirtualSlave::processMailbox() {
+  const uint8_t* request = &memory_[getRegister16(ECT_REG_SM0)];
+  memory_[ECT_REG_SM0STAT] &= ~syncManagerMailboxFull;
+  if (!description_.hasMailbox || (request[5] & 0x0F) != ECT_MBXT_COE || (get16(request + 6) >> 12) != ECT_COES_SDOREQ) {
+    // mailbox error reply, unsupported protocol.
+    std::vector<uint8_t> reply;
+    put(reply, static_cast<uint16_t>(4));
+    put(reply, static_cast<uint16_t>(0));
+    put(reply, static_cast<uint16_t>(ECT_MBXT_ERR));
+    put(reply, static_cast<uint16_t>(0x0001));
+    put(reply, static_cast<uint16_t>(0x0002));
+    sendMailbox(reply.data(), static_cast<uint16_t>(reply.size()));
+    return;
+  }
+
+  const uint8_t command = request[8];
+  const uint16_t index = get16(request + 9);
+  const uint8_t subIndex = request[11];
+  if ((command & 0x10) != 0) {
+    abortSdo(request, sdoUnsupportedAccess);
+    return;
+  }
+  if ((command & 0xE0) != ECT_SDO_UP_REQ && (command & 0xE0) != (ECT_SDO_DOWN_INIT & 0xE0)) {
+    abortSdo(request, sdoCommandInvalid);
+    return;
+  }
+  const auto object = objects_.find((static_cast<uint32_t>(index) << 8) | subIndex);
+  if (object == objects_.end()) {
+    const auto other = objects_.lower_bound(static_cast<uint32_t>(index) << 8);
+    const bool indexExists = other != objects_.end() && (other->first >> 8) == index;
+    abortSdo(request, indexExists ? sdoSubIndexDoesNotExist : sdoObjectDoesNotExist);
+    return;
+  }
+
+  // response header, the mailbox counter of the request is reused.
+  std::vector<uint8_t> reply(mailboxHeaderSize + sdoHeaderSize, 0);
+  reply[5] = request[5];
+  set16(&reply[6], static_cast<uint16_t>(ECT_COES_SDORES << 12));
+  set16(&reply[9], index);
+  reply[11] = subIndex;
+
+  std::vector<uint8_t>& value = object->second.value;
+  if ((command & 0xE0) == ECT_SDO_UP_REQ) {
+    if (value.size() <= 4) {
+      // expedited upload.
+      reply[8] = static_cast<uint8_t>(0x43 | ((4 - value.size()) << 2));
+      std::copy(value.begin(), value.end(), reply.begin() + 12);
+    } else {
+      // normal upload, segmented transfers are not emulated.
+      if (value.size() + mailboxHeaderSize + sdoHeaderSize > getRegister16(ECT_REG_SM1 + 2)) {
+        abortSdo(request, sdoOutOfMemory);
+        return;
+      }
+      reply[8] = 0x41;
+      set32(&reply[12], static_cast<uint32_t>(value.size()));
+      reply.insert(reply.end(), value.begin(), value.end());
+    }
+  } else {
+    const bool expedited = (command & 0x02) != 0;
+    const size_t size = expedited ? ((command & 0x01) != 0 ? 4 - ((command >> 2) & 0x03) : 4) : get32(request + 12);
+    const uint8_t* data = request + (expedited ? 12 : 16);
+    if (!expedited && size + mailboxHeaderSize + sdoHeaderSize > getRegister16(ECT_REG_SM0 + 2)) {
+      abortSdo(request, sdoCommandInvalid);
+      return;
+    }
+    if (!object->second.writable) {
+      abortSdo(request, sdoReadOnly);
+      return;
+    }
+    if (size != value.size()) {
+      abortSdo(request, sdoLengthMismatch);
+      return;
+    }
+    std::copy(data, data + size, value.begin());
+    reply[8] = 0x60;
+  }
+  set16(&reply[0], static_cast<uint16_t>(reply.size() - mailboxHeaderSize));
+  sendMailbox(reply.data(), static_cast<uint16_t>(reply.size()));
+}
+
+void VirtualSlave::sendMailbox(const uint8_t* data, const uint16_t length) {
+  const uint16_t address = getRegister16(ECT_REG_SM1);
+  const uint16_t mailboxLength = getRegister16(ECT_REG_SM1 + 2);
+  if ((memory_[ECT_REG_SM1ACT] & 0x01) == 0 || static_cast<size_t>(address) + mailboxLength > memory_.size()) {
+    return;
+  }
+  std::fill_n(memory_.begin() + address, mailboxLength, 0);
+  std::memcpy(&memory_[address], data, std::min(length, mailboxLength));
+  memory_[ECT_REG_SM1STAT] |= syncManagerMailboxFull;
+}
+
+void VirtualSlave::abortSdo(const uint8_t* request, const uint32_t code) {
+  uint8_t reply[mailboxHeaderSize + sdoHeaderSize] = {};
+  set16(&reply[0], sdoHeaderSize);
+  reply[5] = request[5];
+  // abort transfers are sent with the SDO request service.
+  set16(&reply[6], static_cast<uint16_t>(ECT_COES_SDOREQ << 12));
+  reply[8] = ECT_SDO_ABORT;
+  std::memcpy(&reply[9], request + 9, 3);
+  set32(&reply[12], code);
+  sendMailbox(reply, sizeof(reply));
+}
+
+void VirtualSlave::runApplication() {
+  if (application_) {
+    application_(*this);
+  }
+}
+
+}  // namespace common
+}  // namespace soem_interface_rsl
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/EthercatBusManagerBase.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::EthercatBusManagerBase;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+namespace {
+
+//! Counts the updates and remembers the thread of the last one.
+class CountingSlave : public LoopbackSlave {
+ public:
+  using LoopbackSlave::LoopbackSlave;
+  void updateRead() override {
+    reads_++;
+    thread_ = std::this_thread::get_id();
+    LoopbackSlave::updateRead();
+  }
+  void updateWrite() override {
+    writes_++;
+    thread_ = std::this_thread::get_id();
+    LoopbackSlave::updateWrite();
+  }
+
+  std::atomic<uint64_t> reads_{0};
+  std::atomic<uint64_t> writes_{0};
+  std::atomic<std::thread::id> thread_{};
+};
+
+class BusWorkers : public ::testing::Test {
+ protected:
+  static constexpr size_t numberOfBuses = 3;
+
+  void SetUp() override {
+    for (size_t i = 0; i < numberOfBuses; i++) {
+      const std::string name = "workers" + std::to_string(i);
+      segments_.push_back(std::make_unique<VirtualSegment>(name));
+      segments_.back()->addSlaves(
+          VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize), 1);
+      ASSERT_TRUE(segments_.back()->attach());
+      auto bus = std::make_unique<EthercatBusBase>(name);
+      slaves_.push_back(std::make_shared<CountingSlave>(bus.get(), 1));
+      ASSERT_TRUE(bus->addSlave(slaves_.back()));
+      ASSERT_TRUE(bus->startup(true));
+      bus->setState(EC_STATE_OPERATIONAL);
+      ASSERT_TRUE(bus->waitForState(EC_STATE_OPERATIONAL, 0));
+      ASSERT_TRUE(manager_.addEthercatBus(std::move(bus)));
+    }
+    // the slaves are only read once the working counter of the previous write is complete.
+    for (int cycle = 0; cycle < 3; cycle++) {
+      manager_.updateAllBuses();
+    }
+    ASSERT_TRUE(manager_.allBusesAreOk());
+  }
+
+  void TearDown() override {
+    manager_.stopBusWorkers();
+    manager_.shutdownAllBuses();
+  }
+
+  //! Dispatches each task and checks that every slave was updated exactly once by a worker of its own.
+  void dispatchToWorkers(const bool spin) {
+    EthercatBusManagerBase::WorkerOptions options;
+    options.spin = spin;
+    ASSERT_TRUE(manager_.startBusWorkers(options));
+    EXPECT_FALSE(manager_.startBusWorkers(options));
+
+    for (int cycle = 0; cycle < 50; cycle++) {
+      std::vector<uint64_t> reads;
+      std::vector<uint64_t> writes;
+      for (const auto& slave : slaves_) {
+        reads.push_back(slave->reads_);
+        writes.push_back(slave->writes_);
+      }
+      manager_.writeToAllBuses();
+      manager_.readAllBuses();
+      for (size_t i = 0; i < numberOfBuses; i++) {
+        ASSERT_EQ(slaves_[i]->writes_, writes[i] + 1);
+        ASSERT_EQ(slaves_[i]->reads_, reads[i] + 1);
+      }
+      manager_.updateAllBuses();
+      for (size_t i = 0; i < numberOfBuses; i++) {
+        ASSERT_EQ(slaves_[i]->writes_, writes[i] + 2);
+        ASSERT_EQ(slaves_[i]->reads_, reads[i] + 2);
+      }
+    }
+    std::set<std::thread::id> threads;
+    for (const auto& slave : slaves_) {
+      threads.insert(slave->thread_);
+    }
+    EXPECT_EQ(threads.size(), numberOfBuses);
+    EXPECT_EQ(threads.count(std::this_thread::get_id()), 0u);
+    EXPECT_TRUE(manager_.allBusesAreOk());
+
+    // without the workers the busses are updated by the caller again.
+    manager_.stopBusWorkers();
+    manager_.updateAllBuses();
+    for (const auto& slave : slaves_) {
+      EXPECT_EQ(slave->thread_, std::this_thread::get_id());
+    }
+  }
+
+  //! Stops, restarts and removes busses while another thread keeps dispatching.
+  void changeWorkersWhileDispatching(const bool spin) {
+    EthercatBusManagerBase::WorkerOptions options;
+    options.spin = spin;
+    ASSERT_TRUE(manager_.startBusWorkers(options));
+    std::atomic<bool> cycling{true};
+    std::thread cycleThread([this, &cycling]() {
+      while (cycling) {
+        manager_.updateAllBuses();
+      }
+    });
+    const auto waitForUpdates = [this](const size_t slave) {
+      const uint64_t reads = slaves_[slave]->reads_;
+      const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+      while (slaves_[slave]->reads_ < reads + 10 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      return slaves_[slave]->reads_ >= reads + 10;
+    };
+
+    EXPECT_TRUE(waitForUpdates(0));
+    manager_.stopBusWorkers();
+    EXPECT_TRUE(waitForUpdates(0));
+    ASSERT_TRUE(manager_.startBusWorkers(options));
+    EXPECT_TRUE(waitForUpdates(0));
+
+    // the remaining busses keep cycling without the removed one.
+    auto bus = manager_.extractBusByName("workers1");
+    ASSERT_NE(bus, nullptr);
+    const uint64_t removedReads = slaves_[1]->reads_;
+    EXPECT_TRUE(waitForUpdates(0));
+    EXPECT_TRUE(waitForUpdates(2));
+    EXPECT_EQ(slaves_[1]->reads_, removedReads);
+    ASSERT_TRUE(manager_.startBusWorkers(options));
+    EXPECT_TRUE(waitForUpdates(2));
+
+    cycling = false;
+    cycleThread.join();
+    bus->shutdown();
+  }
+
+  // the segments are declared first, so that they outlive the busses.
+  std::vector<std::unique_ptr<VirtualSegment>> segments_;
+  EthercatBusManagerBase manager_;
+  std::vector<std::shared_ptr<CountingSlave>> slaves_;
+};
+
+}  // namespace
+
+TEST_F(BusWorkers, sleepingWorkersUpdateEveryBusOncePerDispatch) {  // NOLINT
+  dispatchToWorkers(false);
+}
+
+TEST_F(BusWorkers, spinningWorkersUpdateEveryBusOncePerDispatch) {  // NOLINT
+  dispatchToWorkers(true);
+}
+
+TEST_F(BusWorkers, sleepingWorkersStopWhileDispatching) {  // NOLINT
+  changeWorkersWhileDispatching(false);
+}
+
+TEST_F(BusWorkers, spinningWorkersStopWhileDispatching) {  // NOLINT
+  changeWorkersWhileDispatching(true);
+}
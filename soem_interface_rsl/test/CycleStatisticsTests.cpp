@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "soem_interface_rsl/common/CycleStatistics.hpp"
+
+using soem_interface_rsl::common::CycleStatistics;
+using soem_interface_rsl::common::HistogramSnapshot;
+using soem_interface_rsl::common::LatencyHistogram;
+
+TEST(CycleStatistics, bucketsBoundTheRelativeError) {  // NOLINT
+  for (int64_t value = 0; value < 32; value++) {
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(value), static_cast<unsigned int>(value));
+  }
+  unsigned int lastIndex = 0;
+  for (int64_t value = 1; value < (int64_t{1} << 37); value = value * 3 / 2 + 1) {
+    const unsigned int index = LatencyHistogram::getBucketIndex(value);
+    ASSERT_LT(index, LatencyHistogram::numberOfBuckets);
+    EXPECT_GE(index, lastIndex);
+    lastIndex = index;
+    const int64_t lower = LatencyHistogram::getBucketLowerBound(index);
+    EXPECT_LE(lower, value);
+    if (index + 1 < LatencyHistogram::numberOfBuckets) {
+      EXPECT_LT(value, LatencyHistogram::getBucketLowerBound(index + 1));
+      EXPECT_LE(static_cast<double>(value - lower), static_cast<double>(value) / LatencyHistogram::subBuckets);
+    }
+  }
+  // values beyond the range go into the last bucket.
+  EXPECT_EQ(LatencyHistogram::getBucketIndex(int64_t{1} << 50), LatencyHistogram::numberOfBuckets - 1);
+  EXPECT_EQ(LatencyHistogram::getBucketIndex(-5), 0u);
+}
+
+TEST(CycleStatistics, histogramSnapshotHasTheMoments) {  // NOLINT
+  auto histogram = std::make_unique<LatencyHistogram>();
+  EXPECT_EQ(histogram->getSnapshot().getPercentile(0.5), 0);
+  for (int64_t value = 1; value <= 1000; value++) {
+    histogram->record(value * 1000);
+  }
+  const HistogramSnapshot snapshot = histogram->getSnapshot();
+  EXPECT_EQ(snapshot.count, 1000u);
+  EXPECT_EQ(snapshot.min, 1000);
+  EXPECT_EQ(snapshot.max, 1000000);
+  EXPECT_DOUBLE_EQ(snapshot.mean, 500500.0);
+  EXPECT_NEAR(snapshot.standardDeviation, 288675.0, 1.0);
+  // the percentiles are not underestimated and are precise to a bucket.
+  const int64_t median = snapshot.getPercentile(0.5);
+  EXPECT_GE(median, 500000);
+  EXPECT_LE(median, 500000 + 500000 / LatencyHistogram::subBuckets);
+  EXPECT_EQ(snapshot.getPercentile(1.0), 1000000);
+  EXPECT_GE(snapshot.getPercentile(0.0), 1000);
+  EXPECT_LE(snapshot.getPercentile(0.0), 1000 + 1000 / LatencyHistogram::subBuckets);
+
+  histogram->reset();
+  EXPECT_EQ(histogram->getSnapshot().count, 0u);
+}
+
+TEST(CycleStatistics, lowWorkingCounterRunsAreCounted) {  // NOLINT
+  auto statistics = std::make_unique<CycleStatistics>();
+  for (const int workingCounter : {3, 2, 2, 3, 1, 1, 1, 3, 2}) {
+    statistics->startCycle();
+    statistics->recordWorkingCounter(workingCounter, 3);
+  }
+  auto snapshot = statistics->getSnapshot();
+  EXPECT_EQ(snapshot.cycles, 9u);
+  EXPECT_EQ(snapshot.workingCounterMin, 1);
+  EXPECT_DOUBLE_EQ(snapshot.workingCounterAverage, 18.0 / 9.0);
+  EXPECT_EQ(snapshot.lowWorkingCounterRuns, 3u);
+  EXPECT_EQ(snapshot.longestLowWorkingCounterRun, 3u);
+  EXPECT_EQ(snapshot.currentLowWorkingCounterRun, 1u);
+  EXPECT_EQ(snapshot.period.count, 8u);
+
+  // the reset is carried out at the start of the next cycle.
+  statistics->reset();
+  EXPECT_EQ(statistics->getSnapshot().cycles, 9u);
+  const int64_t start = statistics->startCycle();
+  statistics->recordPhase(CycleStatistics::Phase::Receive, start);
+  statistics->recordWorkingCounter(3, 3);
+  snapshot = statistics->getSnapshot();
+  EXPECT_EQ(snapshot.cycles, 1u);
+  EXPECT_EQ(snapshot.lowWorkingCounterRuns, 0u);
+  EXPECT_EQ(snapshot.period.count, 0u);
+  EXPECT_EQ(snapshot.receive.count, 1u);
+  EXPECT_EQ(snapshot.send.count, 0u);
+}
+
+TEST(CycleStatistics, snapshotsDoNotBlockTheWriter) {  // NOLINT
+  auto histogram = std::make_unique<LatencyHistogram>();
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+    for (int64_t i = 0; i < 200000; i++) {
+      histogram->record(1000 + i % 1000);
+    }
+    done = true;
+  });
+  uint64_t lastCount = 0;
+  while (!done) {
+    const HistogramSnapshot snapshot = histogram->getSnapshot();
+    EXPECT_GE(snapshot.count, lastCount);
+    lastCount = snapshot.count;
+    if (snapshot.count > 0) {
+      EXPECT_GE(snapshot.min, 1000);
+      EXPECT_LT(snapshot.max, 2000);
+    }
+  }
+  writer.join();
+  EXPECT_EQ(histogram->getSnapshot().count, 200000u);
+}
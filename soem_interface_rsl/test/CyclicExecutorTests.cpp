@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/CyclicExecutor.hpp"
+#include "soem_interface_rsl/common/EventLog.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::CyclicExecutor;
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::EthercatBusManagerBase;
+using soem_interface_rsl::common::EventLog;
+using soem_interface_rsl::common::EventLogInfo;
+using soem_interface_rsl::common::EventRecord;
+using soem_interface_rsl::common::EventType;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlave;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+namespace {
+
+//! Executor stepped by the test instead of its thread, with a simulated reference clock running at an offset to the host clock.
+class SimulatedDcExecutor : public CyclicExecutor {
+ public:
+  explicit SimulatedDcExecutor(const Options& options)
+      : CyclicExecutor([]() {}, []() {}, options), period_(std::llround(options.cycleTime * 1e9)) {
+    dcTime_ = [this]() { return cycleStart_ + clockOffset_; };
+  }
+  SimulatedDcExecutor(EthercatBusBase& bus, const Options& options)
+      : CyclicExecutor(bus, options), period_(std::llround(options.cycleTime * 1e9)) {
+    dcTime_ = [this]() { return cycleStart_ + clockOffset_; };
+  }
+
+  //! One cycle like run(): the frame passes the reference clock at the cycle start, the next start is corrected.
+  Statistics cycle() {
+    cycleStart_ += period_ + updateDcSync(period_);
+    return getStatistics();
+  }
+
+  int64_t clockOffset_{1234567};
+
+ protected:
+  const int64_t period_;
+  int64_t cycleStart_{1000000000};
+};
+
+//! Steps the executor until it reports the lock.
+bool lock(SimulatedDcExecutor& executor) {
+  for (int cycle = 0; cycle < 1000; cycle++) {
+    if (executor.cycle().dcLocked) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename Value>
+Value readRegister(VirtualSlave& slave, const uint16_t address) {
+  Value value{};
+  slave.read(address, reinterpret_cast<uint8_t*>(&value), sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+TEST(CyclicExecutor, managerWithUnknownDcBusRunsFreeAndLogsOverruns) {  // NOLINT
+  VirtualSegment segment("executor0");
+  segment.addSlaves(VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize), 1);
+  ASSERT_TRUE(segment.attach());
+  const std::string eventLogPath = ::testing::TempDir() + "executor0.events";
+  std::remove(eventLogPath.c_str());
+
+  EthercatBusManagerBase manager;
+  {
+    auto bus = std::make_unique<EthercatBusBase>("executor0");
+    ASSERT_TRUE(bus->addSlave(std::make_shared<LoopbackSlave>(bus.get(), 1)));
+    ASSERT_TRUE(bus->startup(true));
+    ASSERT_TRUE(bus->openEventLog(eventLogPath, 64));
+    ASSERT_TRUE(manager.addEthercatBus(std::move(bus)));
+  }
+  EXPECT_TRUE(manager.hasBus("executor0"));
+  EXPECT_FALSE(manager.hasBus("missing"));
+
+  CyclicExecutor::Options options;
+  options.cycleTime = 0.001;
+  options.policy = CyclicExecutor::SchedulingPolicy::Other;
+  options.lockMemory = false;
+  options.dcSync = true;
+  options.dcSyncBus = "missing";
+  std::unique_ptr<CyclicExecutor> executor;
+  ASSERT_NO_THROW(executor = std::make_unique<CyclicExecutor>(manager, options));
+
+  int cycle = 0;
+  ASSERT_TRUE(executor->start([&cycle]() {
+    // every tenth cycle takes longer than the period.
+    if (++cycle % 10 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    }
+  }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  executor->stop();
+  EXPECT_GT(executor->getStatistics().overruns, 0u);
+
+  EventLogInfo info;
+  std::vector<EventRecord> records;
+  ASSERT_TRUE(EventLog::read(eventLogPath, info, records));
+  bool overrunLogged = false;
+  for (const auto& record : records) {
+    overrunLogged |= record.type == static_cast<uint16_t>(EventType::Overrun);
+  }
+  EXPECT_TRUE(overrunLogged);
+
+  manager.shutdownAllBuses();
+  segment.detach();
+  std::remove(eventLogPath.c_str());
+}
+
+TEST(CyclicExecutor, phaseLocksToTheDcTime) {  // NOLINT
+  CyclicExecutor::Options options;
+  options.cycleTime = 0.002;
+  options.dcSync = true;
+  options.dcSyncShift = 0.0003;
+  SimulatedDcExecutor executor(options);
+  const double window = 0.1 * options.cycleTime;
+
+  // the lock is reported once the phase error stayed within a tenth of the cycle for 100 cycles.
+  CyclicExecutor::Statistics statistics;
+  unsigned int cycle = 0;
+  unsigned int cyclesInWindow = 0;
+  for (; cycle < 1000 && !statistics.dcLocked; cycle++) {
+    statistics = executor.cycle();
+    cyclesInWindow = std::abs(statistics.dcOffset) < window ? cyclesInWindow + 1 : 0;
+  }
+  ASSERT_TRUE(statistics.dcLocked);
+  EXPECT_EQ(cyclesInWindow, 100u);
+  EXPECT_GT(cycle, 100u);
+  EXPECT_LT(statistics.maxDcOffset, window);
+
+  // the offset converges, the jitter decays with the errors of the pull in.
+  for (int i = 0; i < 2000; i++) {
+    statistics = executor.cycle();
+    ASSERT_TRUE(statistics.dcLocked);
+  }
+  EXPECT_LT(std::abs(statistics.dcOffset), 1e-6);
+  EXPECT_LT(statistics.dcOffsetJitter, 1e-6);
+
+  // a step of the reference clock breaks the lock at once, it is acquired again at the new phase.
+  executor.clockOffset_ += 800000;
+  statistics = executor.cycle();
+  EXPECT_FALSE(statistics.dcLocked);
+  EXPECT_NEAR(statistics.dcOffset, 0.0008, 1e-6);
+  for (cycle = 1; cycle < 1000 && !statistics.dcLocked; cycle++) {
+    statistics = executor.cycle();
+  }
+  EXPECT_TRUE(statistics.dcLocked);
+  EXPECT_GT(cycle, 100u);
+  for (int i = 0; i < 2000; i++) {
+    statistics = executor.cycle();
+  }
+  EXPECT_LT(std::abs(statistics.dcOffset), 1e-6);
+  // the largest error is measured from the new lock on.
+  EXPECT_LT(statistics.maxDcOffset, window);
+}
+
+TEST(CyclicExecutor, syncShiftCoversTheLatency) {  // NOLINT
+  VirtualSegment segment("executor1");
+  segment.addSlaves(VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize), 3);
+  ASSERT_TRUE(segment.attach());
+  EthercatBusBase bus("executor1");
+  for (uint32_t address = 1; address <= 3; address++) {
+    ASSERT_TRUE(bus.addSlave(std::make_shared<LoopbackSlave>(&bus, address)));
+  }
+  ASSERT_TRUE(bus.startup(true));
+  ASSERT_TRUE(bus.hasDistributedClocks());
+  // the frames need the hop delays of the segment to reach the last slave.
+  EXPECT_GT(bus.getMaxPropagationDelay(), 0.0);
+
+  CyclicExecutor::Options options;
+  options.cycleTime = 0.002;
+  options.dcSync = true;
+  options.dcSyncShift = 0.0003;
+  SimulatedDcExecutor executor(bus, options);
+  double shift = 0.0;
+  EXPECT_FALSE(executor.getRecommendedSyncShift(shift));
+  EXPECT_FALSE(executor.tuneSyncShift());
+
+  ASSERT_TRUE(lock(executor));
+  ASSERT_TRUE(executor.getRecommendedSyncShift(shift));
+  const auto statistics = executor.getStatistics();
+  EXPECT_NEAR(shift, options.dcSyncShift + statistics.maxDcOffset + bus.getMaxPropagationDelay() + options.syncShiftMargin, 1e-9);
+  EXPECT_GT(shift, options.dcSyncShift + bus.getMaxPropagationDelay());
+  EXPECT_LT(shift, options.cycleTime);
+
+  // SYNC0 fires the shift after a multiple of the cycle, SYNC1 the given delay after it.
+  ASSERT_TRUE(executor.tuneSyncShift({}, 0.0005));
+  const auto shiftNs = static_cast<int64_t>(1e9 * shift);
+  for (size_t address = 1; address <= 3; address++) {
+    VirtualSlave& slave = segment.getSlave(address);
+    EXPECT_EQ(readRegister<uint8_t>(slave, ECT_REG_DCSYNCACT), 1 + 2 + 4);
+    EXPECT_EQ(readRegister<uint32_t>(slave, ECT_REG_DCCYCLE0), 2000000u);
+    EXPECT_EQ(readRegister<uint32_t>(slave, ECT_REG_DCCYCLE1), 500000u);
+    EXPECT_EQ(readRegister<int64_t>(slave, ECT_REG_DCSTART0) % 2000000, shiftNs);
+  }
+  ASSERT_TRUE(executor.tuneSyncShift({2}));
+  EXPECT_EQ(readRegister<uint8_t>(segment.getSlave(2), ECT_REG_DCSYNCACT), 1 + 2);
+  EXPECT_EQ(readRegister<uint8_t>(segment.getSlave(3), ECT_REG_DCSYNCACT), 1 + 2 + 4);
+
+  // a shift which leaves no time for the latency within the cycle is not recommended.
+  options.dcSyncShift = options.cycleTime - bus.getMaxPropagationDelay();
+  SimulatedDcExecutor lateExecutor(bus, options);
+  ASSERT_TRUE(lock(lateExecutor));
+  EXPECT_FALSE(lateExecutor.getRecommendedSyncShift(shift));
+  EXPECT_FALSE(lateExecutor.tuneSyncShift());
+
+  bus.shutdown();
+  segment.detach();
+}
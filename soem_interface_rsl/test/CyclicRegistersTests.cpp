@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/common/CyclicRegisters.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::common::CyclicRegisterTable;
+using soem_interface_rsl::common::RegisterValue;
+using soem_interface_rsl::common::SlaveStatus;
+using soem_interface_rsl::common::StatusRegister;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+TEST(CyclicRegisters, readsAreAddedOnce) {  // NOLINT
+  auto table = std::make_unique<CyclicRegisterTable>();
+  EXPECT_EQ(table->add(1, 0x1001, 0x0130, 6, 1), 0);
+  EXPECT_EQ(table->add(2, 0x1002, 0x0130, 6, 1), 1);
+  // registering it again only changes the decimation.
+  EXPECT_EQ(table->add(1, 0x1001, 0x0130, 6, 10), 0);
+  EXPECT_EQ(table->getRead(0).decimation.load(), 10u);
+  EXPECT_EQ(table->size(), 2u);
+
+  EXPECT_EQ(table->find(2, 0x0130, 6), 1);
+  EXPECT_EQ(table->find(2, 0x0130, 2), -1);
+  EXPECT_EQ(table->add(1, 0x1001, 0x0300, 0, 1), -1);
+  EXPECT_EQ(table->add(1, 0x1001, 0x0300, RegisterValue::maxLength + 1, 1), -1);
+
+  RegisterValue value;
+  EXPECT_TRUE(table->get(0, value));
+  EXPECT_EQ(value.cycle, 0u);
+  EXPECT_FALSE(table->get(2, value));
+  EXPECT_FALSE(table->get(-1, value));
+}
+
+TEST(CyclicRegisters, fullTableRejectsReads) {  // NOLINT
+  auto table = std::make_unique<CyclicRegisterTable>();
+  for (size_t i = 0; i < CyclicRegisterTable::capacity; i++) {
+    ASSERT_EQ(table->add(static_cast<uint16_t>(i), 0, 0x0130, 2, 1), static_cast<int>(i));
+  }
+  EXPECT_EQ(table->add(0xffff, 0, 0x0130, 2, 1), -1);
+}
+
+TEST(CyclicRegisters, publishedValueIsRead) {  // NOLINT
+  auto table = std::make_unique<CyclicRegisterTable>();
+  const int handle = table->add(1, 0x1001, 0x0130, 6, 1);
+  const uint8_t data[6] = {0x08, 0x00, 0x00, 0x00, 0x1d, 0x00};
+  table->publish(static_cast<size_t>(handle), data, 1, 42, 1000);
+
+  RegisterValue value;
+  ASSERT_TRUE(table->get(handle, value));
+  EXPECT_EQ(value.slave, 1);
+  EXPECT_EQ(value.address, 0x0130);
+  EXPECT_EQ(value.workingCounter, 1);
+  EXPECT_EQ(value.cycle, 42u);
+  EXPECT_EQ(value.stamp, 1000);
+  EXPECT_EQ(value.get<uint16_t>(0), 0x0008);
+  EXPECT_EQ(value.get<uint16_t>(4), 0x001d);
+  // out of the block.
+  EXPECT_EQ(value.get<uint32_t>(4), 0u);
+}
+
+TEST(CyclicRegisters, readersNeverSeeTornValues) {  // NOLINT
+  auto table = std::make_unique<CyclicRegisterTable>();
+  const int handle = table->add(1, 0x1001, 0x0300, RegisterValue::maxLength, 1);
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+    std::array<uint8_t, RegisterValue::maxLength> data{};
+    for (uint64_t cycle = 1; cycle <= 200000; cycle++) {
+      data.fill(static_cast<uint8_t>(cycle));
+      table->publish(static_cast<size_t>(handle), data.data(), 1, cycle, static_cast<int64_t>(cycle));
+    }
+    done = true;
+  });
+
+  uint64_t lastCycle = 0;
+  while (!done) {
+    RegisterValue value;
+    ASSERT_TRUE(table->get(handle, value));
+    EXPECT_GE(value.cycle, lastCycle);
+    EXPECT_EQ(value.stamp, static_cast<int64_t>(value.cycle));
+    for (const uint8_t byte : value.data) {
+      ASSERT_EQ(byte, static_cast<uint8_t>(value.cycle));
+    }
+    lastCycle = value.cycle;
+  }
+  writer.join();
+}
+
+TEST(CyclicRegisters, statusOfAllSlavesIsRead) {  // NOLINT
+  VirtualSegment segment("registers0");
+  segment.addSlaves(VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize), 2);
+  ASSERT_TRUE(segment.attach());
+
+  EthercatBusBase bus("registers0");
+  std::vector<std::shared_ptr<LoopbackSlave>> slaves;
+  for (uint32_t address = 1; address <= 2; address++) {
+    slaves.push_back(std::make_shared<LoopbackSlave>(&bus, address));
+    ASSERT_TRUE(bus.addSlave(slaves.back()));
+  }
+  ASSERT_TRUE(bus.startup(true));
+  bus.setState(EC_STATE_OPERATIONAL);
+  ASSERT_TRUE(bus.waitForState(EC_STATE_OPERATIONAL, 0));
+  ASSERT_TRUE(bus.addCyclicStatusRead(StatusRegister::AlStatus));
+  ASSERT_TRUE(bus.addCyclicStatusReadForAllSlaves(StatusRegister::AlStatus));
+  EXPECT_FALSE(bus.addCyclicStatusRead(StatusRegister::AlStatus, 3));
+
+  for (int cycle = 0; cycle < 3; cycle++) {
+    bus.updateWrite();
+    bus.updateRead();
+  }
+  for (uint16_t slave = 0; slave <= 2; slave++) {
+    SlaveStatus status;
+    ASSERT_TRUE(bus.getSlaveStatus(slave, status));
+    EXPECT_GT(status.alStatusRegister.cycle, 0u);
+    EXPECT_EQ(status.alStatus & 0x0f, EC_STATE_OPERATIONAL);
+    // the broadcast read is answered by every slave.
+    EXPECT_EQ(status.alStatusRegister.workingCounter, slave == 0 ? 2 : 1);
+  }
+  SlaveStatus status;
+  EXPECT_FALSE(bus.getSlaveStatus(3, status));
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+
+#include "soem_interface_rsl/common/DistributedClockMapping.hpp"
+
+using soem_interface_rsl::common::DistributedClockMapping;
+
+namespace {
+
+constexpr int64_t period = 1000000;
+//! The host clock runs 50 ppm faster and is 7 s ahead.
+constexpr double slope = 1.00005;
+constexpr int64_t offset = 7000000000;
+
+//! Feeds cycles of a host clock with a jitter of up to 500 ns, returns the DC time of the last one.
+int64_t addCycles(DistributedClockMapping& mapping, const int64_t firstCycle, const int64_t cycles, const int64_t step = 0) {
+  std::mt19937 random(static_cast<unsigned int>(firstCycle));
+  std::uniform_int_distribution<int64_t> jitter(-500, 500);
+  int64_t distributedClockTime = 0;
+  for (int64_t cycle = firstCycle; cycle < firstCycle + cycles; cycle++) {
+    distributedClockTime = cycle * period;
+    const auto monotonicTime = static_cast<int64_t>(static_cast<double>(distributedClockTime) * slope) + offset + step + jitter(random);
+    mapping.addSample(distributedClockTime, monotonicTime);
+  }
+  return distributedClockTime;
+}
+
+int64_t getExpectedMonotonicTime(const int64_t distributedClockTime, const int64_t step = 0) {
+  return static_cast<int64_t>(static_cast<double>(distributedClockTime) * slope) + offset + step;
+}
+
+}  // namespace
+
+TEST(DistributedClockMapping, mappingFollowsTheDrift) {  // NOLINT
+  DistributedClockMapping mapping(200, 20);
+  int64_t monotonicTime = 0;
+  addCycles(mapping, 1, 19);
+  EXPECT_FALSE(mapping.isValid());
+  EXPECT_FALSE(mapping.toMonotonic(0, monotonicTime));
+
+  const int64_t latest = addCycles(mapping, 20, 500);
+  ASSERT_TRUE(mapping.isValid());
+  EXPECT_NEAR(mapping.getDrift(), 50.0, 1.0);
+  EXPECT_LT(mapping.getResidualRms(), 500.0);
+  EXPECT_EQ(mapping.getNumberOfOutliers(), 0u);
+
+  // also somewhat ahead of the latest sample.
+  for (const int64_t distributedClockTime : {latest - 100 * period, latest, latest + 100 * period}) {
+    ASSERT_TRUE(mapping.toMonotonic(distributedClockTime, monotonicTime));
+    EXPECT_NEAR(static_cast<double>(monotonicTime), static_cast<double>(getExpectedMonotonicTime(distributedClockTime)), 300.0);
+    int64_t roundTrip = 0;
+    ASSERT_TRUE(mapping.toDistributedClock(monotonicTime, roundTrip));
+    EXPECT_NEAR(static_cast<double>(roundTrip), static_cast<double>(distributedClockTime), 2.0);
+  }
+
+  // 32 bit clocks are extended with the upper bits of the latest sample.
+  int64_t monotonicTime32 = 0;
+  ASSERT_TRUE(mapping.toMonotonic32(static_cast<uint32_t>(latest - period), monotonicTime32));
+  ASSERT_TRUE(mapping.toMonotonic(latest - period, monotonicTime));
+  EXPECT_EQ(monotonicTime32, monotonicTime);
+}
+
+TEST(DistributedClockMapping, outliersAreRejected) {  // NOLINT
+  DistributedClockMapping mapping(200, 20);
+  const int64_t latest = addCycles(mapping, 1, 100);
+  int64_t before = 0;
+  ASSERT_TRUE(mapping.toMonotonic(latest, before));
+
+  // the sending thread got preempted for 1 ms.
+  mapping.addSample(latest + period, getExpectedMonotonicTime(latest + period) + 1000000);
+  EXPECT_EQ(mapping.getNumberOfOutliers(), 1u);
+  int64_t after = 0;
+  ASSERT_TRUE(mapping.toMonotonic(latest, after));
+  EXPECT_NEAR(static_cast<double>(after), static_cast<double>(before), 100.0);
+
+  // a frame without a new DC time is ignored.
+  mapping.addSample(latest + period, 0);
+  EXPECT_EQ(mapping.getNumberOfOutliers(), 1u);
+}
+
+TEST(DistributedClockMapping, steppedClockStartsOver) {  // NOLINT
+  DistributedClockMapping mapping(100, 20);
+  addCycles(mapping, 1, 100);
+  constexpr int64_t step = 2000000000;
+  const int64_t latest = addCycles(mapping, 101, 200, step);
+  ASSERT_TRUE(mapping.isValid());
+  int64_t monotonicTime = 0;
+  ASSERT_TRUE(mapping.toMonotonic(latest, monotonicTime));
+  EXPECT_NEAR(static_cast<double>(monotonicTime), static_cast<double>(getExpectedMonotonicTime(latest, step)), 500.0);
+
+  mapping.reset();
+  EXPECT_FALSE(mapping.isValid());
+  EXPECT_EQ(mapping.getNumberOfOutliers(), 0u);
+}
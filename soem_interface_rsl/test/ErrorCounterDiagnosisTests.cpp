@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+
+#include "soem_interface_rsl/common/ErrorCounterDiagnosis.hpp"
+
+using soem_interface_rsl::common::ErrorCounterDiagnosis;
+
+namespace {
+
+using Block = std::array<uint8_t, ErrorCounterDiagnosis::blockLength>;
+
+// offsets into the raw block 0x0300 - 0x0313.
+size_t frameError(const size_t port) {
+  return 2 * port;
+}
+size_t physicalError(const size_t port) {
+  return 2 * port + 1;
+}
+size_t forwardedError(const size_t port) {
+  return 0x08 + port;
+}
+size_t lostLink(const size_t port) {
+  return 0x10 + port;
+}
+
+}  // namespace
+
+TEST(ErrorCounterDiagnosis, countersAreAccumulated) {  // NOLINT
+  ErrorCounterDiagnosis diagnosis;
+  diagnosis.reset(2);
+  EXPECT_EQ(diagnosis.getNumberOfSlaves(), 2);
+  Block block{};
+  // counts since power up, no rate yet.
+  block[frameError(0)] = 3;
+  block[physicalError(0)] = 2;
+  block[forwardedError(1)] = 4;
+  block[lostLink(0)] = 1;
+  block[0x0c] = 5;
+  EXPECT_FALSE(diagnosis.update(1, block.data(), 0.0));
+  block[frameError(0)] = 4;
+  block[0x0d] = 1;
+  EXPECT_FALSE(diagnosis.update(1, block.data(), 1.0));
+
+  const auto& slave = diagnosis.getSlave(1);
+  EXPECT_EQ(slave.sweeps, 2u);
+  EXPECT_EQ(slave.ports[0].rxErrors, 6u);
+  EXPECT_EQ(slave.ports[0].lostLinks, 1u);
+  EXPECT_EQ(slave.ports[1].forwardedErrors, 4u);
+  EXPECT_EQ(slave.processingUnitErrors, 5u);
+  EXPECT_EQ(slave.pdiErrors, 1u);
+  EXPECT_GT(slave.ports[0].rxErrorRate, 0.0);
+  EXPECT_LT(slave.ports[0].health, 1.0);
+  EXPECT_FALSE(slave.ports[0].saturated);
+
+  EXPECT_FALSE(diagnosis.update(0, block.data(), 2.0));
+  EXPECT_FALSE(diagnosis.update(3, block.data(), 2.0));
+}
+
+TEST(ErrorCounterDiagnosis, degradingLinkIsReportedFirst) {  // NOLINT
+  ErrorCounterDiagnosis diagnosis;
+  diagnosis.reset(3);
+  Block degrading{};
+  Block stable{};
+  Block clean{};
+  // slave 2 gets 10 RX errors per second on port 1, slave 3 had a single error on port 0.
+  stable[frameError(0)] = 1;
+  for (int second = 0; second <= 10; second++) {
+    degrading[frameError(1)] = static_cast<uint8_t>(5 * second);
+    degrading[physicalError(1)] = static_cast<uint8_t>(5 * second);
+    EXPECT_FALSE(diagnosis.update(1, clean.data(), second));
+    EXPECT_FALSE(diagnosis.update(2, degrading.data(), second));
+    EXPECT_FALSE(diagnosis.update(3, stable.data(), second));
+  }
+
+  const auto& port = diagnosis.getSlave(2).ports[1];
+  EXPECT_EQ(port.rxErrors, 100u);
+  EXPECT_NEAR(port.rxErrorRate, 10.0, 0.01);
+  EXPECT_GT(port.rxErrorTrend, 0.0);
+  EXPECT_NEAR(port.health, std::exp(-port.rxErrorRate), 1e-9);
+
+  const auto links = diagnosis.getWorstLinks(5);
+  ASSERT_EQ(links.size(), 2u);
+  EXPECT_EQ(links[0].slave, 2);
+  EXPECT_EQ(links[0].port, 1);
+  EXPECT_EQ(links[1].slave, 3);
+  EXPECT_EQ(links[1].port, 0);
+  EXPECT_DOUBLE_EQ(links[1].health, 1.0);
+  EXPECT_EQ(diagnosis.getWorstLinks(1).size(), 1u);
+}
+
+TEST(ErrorCounterDiagnosis, countersAreClearedBeforeSaturating) {  // NOLINT
+  ErrorCounterDiagnosis::Options options;
+  options.clearThreshold = 0x80;
+  ErrorCounterDiagnosis diagnosis(options);
+  diagnosis.reset(1);
+  Block block{};
+  block[frameError(2)] = 0x7f;
+  EXPECT_FALSE(diagnosis.update(1, block.data(), 0.0));
+  block[frameError(2)] = 0x90;
+  EXPECT_TRUE(diagnosis.update(1, block.data(), 1.0));
+  diagnosis.cleared(1);
+
+  // counted again from zero.
+  block[frameError(2)] = 0x02;
+  EXPECT_FALSE(diagnosis.update(1, block.data(), 2.0));
+  EXPECT_EQ(diagnosis.getSlave(1).ports[2].rxErrors, 0x92u);
+
+  // a counter which was not cleared in time is a lower bound.
+  block[frameError(2)] = 0xff;
+  EXPECT_TRUE(diagnosis.update(1, block.data(), 3.0));
+  EXPECT_TRUE(diagnosis.getSlave(1).ports[2].saturated);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "soem_interface_rsl/common/EventLog.hpp"
+
+using soem_interface_rsl::common::EventLog;
+using soem_interface_rsl::common::EventLogInfo;
+using soem_interface_rsl::common::EventRecord;
+using soem_interface_rsl::common::EventType;
+
+static std::string getPath(const std::string& name) {
+  const std::string path = testing::TempDir() + "soem_event_log_" + name;
+  std::remove(path.c_str());
+  return path;
+}
+
+TEST(EventLog, recordsAreReadBack) {  // NOLINT
+  const std::string path = getPath("read");
+  EventLog log;
+  ASSERT_TRUE(log.open(path, 16, "bus0"));
+  log.log(EventType::StateRequest, 1, 0, 2, 8);
+  log.log(EventType::SdoAbort, 2, 0x06020000, 0, 0, 0x6040, 1);
+
+  EventLogInfo info;
+  std::vector<EventRecord> records;
+  ASSERT_TRUE(EventLog::read(path, info, records));
+  EXPECT_EQ(info.busName, "bus0");
+  EXPECT_EQ(info.capacity, 16u);
+  EXPECT_EQ(info.written, 2u);
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].sequence, 1u);
+  EXPECT_EQ(records[0].type, static_cast<uint16_t>(EventType::StateRequest));
+  EXPECT_EQ(records[0].slave, 1);
+  EXPECT_EQ(records[0].value0, 2);
+  EXPECT_EQ(records[0].value1, 8);
+  EXPECT_EQ(records[1].sequence, 2u);
+  EXPECT_EQ(records[1].code, 0x06020000u);
+  EXPECT_EQ(records[1].index, 0x6040);
+  EXPECT_EQ(records[1].subIndex, 1);
+  EXPECT_LE(records[0].stamp, records[1].stamp);
+}
+
+TEST(EventLog, onlyTheLastRecordsAreKept) {  // NOLINT
+  const std::string path = getPath("wrap");
+  EventLog log;
+  ASSERT_TRUE(log.open(path, 4));
+  for (int32_t i = 0; i < 10; i++) {
+    log.log(EventType::Overrun, 0, 0, i);
+  }
+
+  EventLogInfo info;
+  std::vector<EventRecord> records;
+  ASSERT_TRUE(EventLog::read(path, info, records));
+  EXPECT_EQ(info.written, 10u);
+  ASSERT_EQ(records.size(), 4u);
+  for (size_t i = 0; i < records.size(); i++) {
+    EXPECT_EQ(records[i].value0, static_cast<int32_t>(6 + i));
+    EXPECT_EQ(records[i].sequence, 7 + i);
+  }
+}
+
+TEST(EventLog, fileIsContinuedWithTheSameCapacity) {  // NOLINT
+  const std::string path = getPath("continue");
+  EventLog log;
+  ASSERT_TRUE(log.open(path, 8));
+  log.log(EventType::Overrun, 0, 0, 1);
+  log.close();
+
+  ASSERT_TRUE(log.open(path, 8));
+  log.log(EventType::Overrun, 0, 0, 2);
+  EventLogInfo info;
+  std::vector<EventRecord> records;
+  ASSERT_TRUE(EventLog::read(path, info, records));
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[1].value0, 2);
+
+  // another capacity does not match the file, it is created again.
+  ASSERT_TRUE(log.open(path, 16));
+  ASSERT_TRUE(EventLog::read(path, info, records));
+  EXPECT_EQ(info.capacity, 16u);
+  EXPECT_TRUE(records.empty());
+}
+
+TEST(EventLog, concurrentLoggersDoNotLoseRecords) {  // NOLINT
+  const std::string path = getPath("concurrent");
+  constexpr int threads = 4;
+  constexpr int recordsPerThread = 1000;
+  EventLog log;
+  ASSERT_TRUE(log.open(path, threads * recordsPerThread));
+
+  std::vector<std::thread> loggers;
+  for (int thread = 0; thread < threads; thread++) {
+    loggers.emplace_back([&log, thread]() {
+      for (int i = 0; i < recordsPerThread; i++) {
+        log.log(EventType::WorkingCounterDrop, static_cast<uint16_t>(thread), 0, i);
+      }
+    });
+  }
+  for (auto& logger : loggers) {
+    logger.join();
+  }
+
+  EventLogInfo info;
+  std::vector<EventRecord> records;
+  ASSERT_TRUE(EventLog::read(path, info, records));
+  ASSERT_EQ(records.size(), static_cast<size_t>(threads * recordsPerThread));
+  std::set<std::pair<uint16_t, int32_t>> events;
+  for (size_t i = 0; i < records.size(); i++) {
+    EXPECT_EQ(records[i].sequence, i + 1);
+    events.emplace(records[i].slave, records[i].value0);
+  }
+  EXPECT_EQ(events.size(), records.size());
+}
+
+TEST(EventLog, otherFilesAreRejected) {  // NOLINT
+  const std::string path = getPath("invalid");
+  FILE* file = std::fopen(path.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  const std::vector<char> garbage(256, 'x');
+  std::fwrite(garbage.data(), 1, garbage.size(), file);
+  std::fclose(file);
+
+  EventLogInfo info;
+  std::vector<EventRecord> records;
+  EXPECT_FALSE(EventLog::read(path, info, records));
+  EXPECT_FALSE(EventLog::read(getPath("missing"), info, records));
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "soem_interface_rsl/common/FaultInjector.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::common::FaultInjector;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+
+namespace {
+
+using Frame = std::array<uint8_t, 30>;
+
+//! Ethernet frame with a single BRD of the ESC type register, every slave increments its working counter.
+Frame broadcastRead(const uint8_t index) {
+  Frame frame{};
+  frame[12] = 0x88;
+  frame[13] = 0xA4;
+  // ecat header: length of the datagram, type 1.
+  frame[14] = 14;
+  frame[15] = 0x10;
+  frame[16] = 0x07;
+  frame[17] = index;
+  // address 0x0000, 2 bytes of data.
+  frame[22] = 2;
+  return frame;
+}
+
+uint16_t workingCounter(const Frame& frame) { return static_cast<uint16_t>(frame[28] | (frame[29] << 8)); }
+
+class Segment {
+ public:
+  explicit Segment(const std::string& name) : segment_(name) {
+    segment_.addSlaves(VirtualSlaveDescription::fromPdoSizes("slave", 0x1, 0x2, 2, 2), 2);
+    segment_.attach();
+  }
+
+ private:
+  VirtualSegment segment_;
+};
+
+//! Sends a frame through the stage and collects all answers delivered meanwhile.
+std::vector<Frame> exchange(FaultInjector& injector, const uint8_t index) {
+  Frame frame = broadcastRead(index);
+  EXPECT_EQ(FaultInjector::send(&injector, 0, frame.data(), frame.size()), static_cast<int>(frame.size()));
+  std::vector<Frame> answers;
+  while (FaultInjector::receive(&injector, 0, frame.data(), frame.size()) > 0) {
+    answers.push_back(frame);
+  }
+  return answers;
+}
+
+}  // namespace
+
+TEST(FaultInjector, passesFramesUnchanged) {  // NOLINT
+  Segment segment("fault0");
+  FaultInjector injector("fault0");
+  ASSERT_TRUE(injector.attach());
+
+  const auto answers = exchange(injector, 1);
+  ASSERT_EQ(answers.size(), 1u);
+  EXPECT_EQ(answers[0][17], 1);
+  EXPECT_EQ(workingCounter(answers[0]), 2);
+  EXPECT_EQ(injector.getStatistics().frames, 1u);
+  EXPECT_EQ(injector.getStatistics().lastFaultTime, 0);
+}
+
+TEST(FaultInjector, injectsConfiguredFaults) {  // NOLINT
+  Segment segment("fault1");
+  FaultInjector injector("fault1");
+  ASSERT_TRUE(injector.attach());
+
+  FaultInjector::Options options;
+  options.dropProbability = 1.0;
+  injector.setOptions(options);
+  EXPECT_TRUE(exchange(injector, 1).empty());
+  EXPECT_EQ(injector.getStatistics().dropped, 1u);
+
+  options.dropProbability = 0.0;
+  options.replyDropProbability = 1.0;
+  injector.setOptions(options);
+  EXPECT_TRUE(exchange(injector, 2).empty());
+  EXPECT_EQ(injector.getStatistics().repliesDropped, 1u);
+
+  options.replyDropProbability = 0.0;
+  options.workingCounterProbability = 1.0;
+  options.duplicateProbability = 1.0;
+  injector.setOptions(options);
+  const auto answers = exchange(injector, 3);
+  ASSERT_EQ(answers.size(), 2u);
+  EXPECT_EQ(workingCounter(answers[0]), 1);
+  EXPECT_EQ(answers[0], answers[1]);
+
+  const auto statistics = injector.getStatistics();
+  EXPECT_EQ(statistics.frames, 3u);
+  EXPECT_EQ(statistics.workingCountersCorrupted, 1u);
+  EXPECT_EQ(statistics.duplicated, 1u);
+  EXPECT_GT(statistics.lastFaultTime, 0);
+
+  injector.resetStatistics();
+  EXPECT_EQ(injector.getStatistics().frames, 0u);
+}
+
+TEST(FaultInjector, delaysAndReordersAnswers) {  // NOLINT
+  Segment segment("fault2");
+  FaultInjector injector("fault2");
+  ASSERT_TRUE(injector.attach());
+
+  FaultInjector::Options options;
+  options.delay = 5000000;
+  injector.setOptions(options);
+  EXPECT_TRUE(exchange(injector, 1).empty());
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  Frame frame{};
+  ASSERT_GT(FaultInjector::receive(&injector, 0, frame.data(), frame.size()), 0);
+  EXPECT_EQ(frame[17], 1);
+  EXPECT_EQ(injector.getStatistics().delayed, 1u);
+
+  // the first answer is held back until the second one arrived.
+  options.delay = 0;
+  options.reorderProbability = 1.0;
+  injector.setOptions(options);
+  EXPECT_TRUE(exchange(injector, 2).empty());
+  options.reorderProbability = 0.0;
+  injector.setOptions(options);
+  const auto answers = exchange(injector, 3);
+  ASSERT_EQ(answers.size(), 2u);
+  EXPECT_EQ(answers[0][17], 3);
+  EXPECT_EQ(answers[1][17], 2);
+  EXPECT_EQ(injector.getStatistics().reordered, 1u);
+}
+
+TEST(FaultInjector, linkFlapLosesFrames) {  // NOLINT
+  Segment segment("fault3");
+  FaultInjector injector("fault3");
+  ASSERT_TRUE(injector.attach());
+
+  injector.flapLink(5000000);
+  EXPECT_FALSE(injector.isLinkUp());
+  EXPECT_TRUE(exchange(injector, 1).empty());
+  EXPECT_EQ(injector.getStatistics().linkFlaps, 1u);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(exchange(injector, 2).size(), 1u);
+  EXPECT_TRUE(injector.isLinkUp());
+}
+
+TEST(FaultInjector, seedMakesRunsReproducible) {  // NOLINT
+  FaultInjector::Options options;
+  options.dropProbability = 0.5;
+  options.seed = 42;
+
+  std::array<std::vector<bool>, 2> runs;
+  for (size_t run = 0; run < runs.size(); run++) {
+    Segment segment("fault4");
+    FaultInjector injector("fault4", options);
+    ASSERT_TRUE(injector.attach());
+    for (uint8_t index = 0; index < 64; index++) {
+      runs[run].push_back(exchange(injector, index).empty());
+    }
+    injector.detach();
+  }
+  EXPECT_EQ(runs[0], runs[1]);
+  EXPECT_NE(std::count(runs[0].begin(), runs[0].end(), true), 0);
+  EXPECT_NE(std::count(runs[0].begin(), runs[0].end(), false), 0);
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "soem_interface_rsl/common/FrameCapture.hpp"
+
+using soem_interface_rsl::common::FrameCapture;
+
+namespace {
+
+struct Packet {
+  uint32_t interface{0};
+  std::vector<uint8_t> data;
+  bool received{false};
+};
+
+std::string getPath(const std::string& name) {
+  const std::string path = testing::TempDir() + "soem_capture_" + name + ".pcapng";
+  std::remove(path.c_str());
+  return path;
+}
+
+template <typename T>
+T get(const std::vector<uint8_t>& buffer, const size_t offset) {
+  T value{};
+  std::memcpy(&value, buffer.data() + offset, sizeof(T));
+  return value;
+}
+
+//! Parses the enhanced packet blocks of a pcapng file, checks the framing of all blocks.
+std::vector<Packet> readPackets(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  const std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::vector<Packet> packets;
+  size_t interfaces = 0;
+  EXPECT_GE(buffer.size(), 12u);
+  EXPECT_EQ(get<uint32_t>(buffer, 0), 0x0a0d0d0au);
+  for (size_t offset = 0; offset + 12 <= buffer.size();) {
+    const auto type = get<uint32_t>(buffer, offset);
+    const auto length = get<uint32_t>(buffer, offset + 4);
+    if (length % 4 != 0 || offset + length > buffer.size() || get<uint32_t>(buffer, offset + length - 4) != length) {
+      ADD_FAILURE() << "Invalid block at " << offset;
+      break;
+    }
+    if (type == 1) {
+      interfaces++;
+    } else if (type == 6) {
+      Packet packet;
+      packet.interface = get<uint32_t>(buffer, offset + 8);
+      const auto captured = get<uint32_t>(buffer, offset + 20);
+      packet.data.assign(buffer.begin() + static_cast<long>(offset) + 28, buffer.begin() + static_cast<long>(offset) + 28 + captured);
+      // the flags option follows the padded packet data.
+      const size_t option = offset + 28 + ((captured + 3) & ~3u);
+      EXPECT_EQ(get<uint16_t>(buffer, option), 2);
+      packet.received = get<uint32_t>(buffer, option + 4) == 1;
+      packets.push_back(packet);
+    }
+    offset += length;
+  }
+  EXPECT_EQ(interfaces, 2u);
+  return packets;
+}
+
+std::vector<uint8_t> makeFrame(const size_t length, const uint8_t value) {
+  return std::vector<uint8_t>(length, value);
+}
+
+}  // namespace
+
+TEST(FrameCapture, continuousCaptureWritesAllFrames) {  // NOLINT
+  const std::string path = getPath("continuous");
+  FrameCapture capture;
+  FrameCapture::Options options;
+  options.capacity = 64;
+  options.continuous = true;
+  options.interface = "eth0";
+  ASSERT_TRUE(capture.start(path, options));
+  for (uint8_t i = 0; i < 10; i++) {
+    const auto frame = makeFrame(60 + i, i);
+    capture.record(i % 2 == 1, i == 9 ? 1 : 0, frame.data(), static_cast<int>(frame.size()));
+  }
+  // too long frames are truncated.
+  const auto jumbo = makeFrame(FrameCapture::maxFrameLength + 100, 0xff);
+  capture.record(false, 0, jumbo.data(), static_cast<int>(jumbo.size()));
+  capture.stop();
+  EXPECT_EQ(capture.getNumberOfFrames(), 11u);
+  EXPECT_EQ(capture.getNumberOfDroppedFrames(), 0u);
+
+  const auto packets = readPackets(path);
+  ASSERT_EQ(packets.size(), 11u);
+  for (uint8_t i = 0; i < 10; i++) {
+    EXPECT_EQ(packets[i].data, makeFrame(60 + i, i));
+    EXPECT_EQ(packets[i].received, i % 2 == 1);
+    EXPECT_EQ(packets[i].interface, i == 9 ? 1u : 0u);
+  }
+  EXPECT_EQ(packets[10].data.size(), FrameCapture::maxFrameLength);
+}
+
+TEST(FrameCapture, concurrentFramesAreNotLost) {  // NOLINT
+  const std::string path = getPath("concurrent");
+  constexpr int threads = 4;
+  constexpr int framesPerThread = 1000;
+  FrameCapture capture;
+  FrameCapture::Options options;
+  options.capacity = threads * framesPerThread;
+  options.continuous = true;
+  ASSERT_TRUE(capture.start(path, options));
+  std::vector<std::thread> producers;
+  for (int thread = 0; thread < threads; thread++) {
+    producers.emplace_back([&capture, thread]() {
+      const auto frame = makeFrame(64, static_cast<uint8_t>(thread));
+      for (int i = 0; i < framesPerThread; i++) {
+        capture.record(false, 0, frame.data(), static_cast<int>(frame.size()));
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  capture.stop();
+
+  const auto packets = readPackets(path);
+  ASSERT_EQ(packets.size(), static_cast<size_t>(threads * framesPerThread));
+  std::vector<int> counts(threads, 0);
+  for (const Packet& packet : packets) {
+    ASSERT_LT(packet.data[0], threads);
+    // a frame is never mixed with another one.
+    EXPECT_EQ(packet.data, makeFrame(64, packet.data[0]));
+    counts[packet.data[0]]++;
+  }
+  for (const int count : counts) {
+    EXPECT_EQ(count, framesPerThread);
+  }
+}
+
+TEST(FrameCapture, triggerDumpsTheFramesAroundIt) {  // NOLINT
+  const std::string path = getPath("trigger");
+  const std::string dumpPath = testing::TempDir() + "soem_capture_trigger_1.pcapng";
+  std::remove(dumpPath.c_str());
+  FrameCapture capture;
+  FrameCapture::Options options;
+  options.capacity = 16;
+  options.preTrigger = 10.0;
+  options.postTrigger = 0.05;
+  options.triggerOnStateLoss = false;
+  ASSERT_TRUE(capture.start(path, options));
+  // the ring keeps the last frames only.
+  for (uint8_t i = 0; i < 20; i++) {
+    const auto frame = makeFrame(60, i);
+    capture.record(false, 0, frame.data(), static_cast<int>(frame.size()));
+  }
+  EXPECT_FALSE(capture.trigger(FrameCapture::Trigger::StateLoss));
+  EXPECT_TRUE(capture.trigger(FrameCapture::Trigger::WorkingCounterDrop));
+  // a dump is pending already.
+  EXPECT_FALSE(capture.trigger());
+  for (int i = 0; i < 200 && capture.getNumberOfDumps() == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(capture.getNumberOfDumps(), 1u);
+  capture.stop();
+
+  const auto packets = readPackets(dumpPath);
+  ASSERT_EQ(packets.size(), 16u);
+  EXPECT_EQ(packets.front().data[0], 4);
+  EXPECT_EQ(packets.back().data[0], 19);
+}
+
+TEST(FrameCapture, framesAreIgnoredWhenStopped) {  // NOLINT
+  FrameCapture capture;
+  const auto frame = makeFrame(60, 0);
+  capture.record(false, 0, frame.data(), static_cast<int>(frame.size()));
+  EXPECT_EQ(capture.getNumberOfFrames(), 0u);
+  EXPECT_FALSE(capture.trigger());
+
+  FrameCapture::Options options;
+  options.capacity = 0;
+  EXPECT_FALSE(capture.start(getPath("empty"), options));
+  EXPECT_FALSE(capture.isRunning());
+}
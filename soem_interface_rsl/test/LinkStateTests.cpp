@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include "soem_interface_rsl/EthercatBusBase.hpp"
+#include "soem_interface_rsl/common/FaultInjector.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::common::FaultInjector;
+using soem_interface_rsl::common::VirtualSegment;
+
+TEST(LinkState, unwatchedBusIsQueriedOnce) {  // NOLINT
+  EXPECT_FALSE(EthercatBusBase::busIsAvailable("link0"));
+
+  VirtualSegment segment("link0");
+  ASSERT_TRUE(segment.attach());
+  EXPECT_TRUE(EthercatBusBase::busIsAvailable("link0"));
+
+  // the query did not register the name, once released it is asked from the kernel again.
+  segment.detach();
+  EXPECT_FALSE(EthercatBusBase::busIsAvailable("link0"));
+}
+
+TEST(LinkState, busFollowsSegment) {  // NOLINT
+  VirtualSegment segment("link1");
+  {
+    EthercatBusBase bus("link1");
+    EXPECT_FALSE(bus.busIsAvailable());
+    EXPECT_FALSE(bus.hasCarrier());
+
+    ASSERT_TRUE(segment.attach());
+    EXPECT_TRUE(bus.busIsAvailable());
+    EXPECT_TRUE(bus.hasCarrier());
+
+    // the watched state outlives the segment as long as the bus exists.
+    segment.detach();
+    EXPECT_FALSE(bus.busIsAvailable());
+    EXPECT_FALSE(bus.hasCarrier());
+  }
+  EXPECT_FALSE(EthercatBusBase::busIsAvailable("link1"));
+}
+
+TEST(LinkState, linkFlapOnlyDropsCarrier) {  // NOLINT
+  VirtualSegment segment("link2");
+  ASSERT_TRUE(segment.attach());
+  FaultInjector injector("link2");
+  ASSERT_TRUE(injector.attach());
+
+  EthercatBusBase bus("link2");
+  injector.flapLink(1000000000);
+  EXPECT_FALSE(injector.isLinkUp());
+  // a bus can still be started while the cable is unplugged.
+  EXPECT_TRUE(bus.busIsAvailable());
+  EXPECT_FALSE(bus.hasCarrier());
+
+  injector.detach();
+  EXPECT_TRUE(bus.busIsAvailable());
+  EXPECT_TRUE(bus.hasCarrier());
+}
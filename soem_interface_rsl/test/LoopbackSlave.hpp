@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "soem_interface_rsl/EthercatBusBase.hpp"
+#include "soem_interface_rsl/EthercatSlaveBase.hpp"
+
+namespace soem_interface_rsl::test {
+
+/**
+ * @brief      Slave exchanging a fixed number of bytes with a virtual slave
+ *             running the default loopback application
+ */
+class LoopbackSlave : public EthercatSlaveBase {
+ public:
+  static constexpr size_t pdoSize = 8;
+  using Pdo = std::array<uint8_t, pdoSize>;
+
+  LoopbackSlave(EthercatBusBase* bus, const uint32_t address) : EthercatSlaveBase(bus, address) {}
+
+  std::string getName() const override { return "loopback" + std::to_string(address_); }
+  bool startup() override { return true; }
+  void updateRead() override { bus_->readTxPdo(address_, inputs_); }
+  void updateWrite() override { bus_->writeRxPdo(address_, outputs_); }
+  void shutdown() override {}
+  bool recover() override {
+    recoveries_++;
+    return true;
+  }
+  PdoInfo getCurrentPdoInfo() const override {
+    PdoInfo pdoInfo;
+    pdoInfo.rxPdoSize_ = pdoSize;
+    pdoInfo.txPdoSize_ = pdoSize;
+    return pdoInfo;
+  }
+
+  Pdo inputs_{};
+  Pdo outputs_{};
+  int recoveries_{0};
+};
+
+}  // namespace soem_interface_rsl::test
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "soem_interface_rsl/common/Macros.hpp"
+
+using soem_interface_rsl::common::MessageLog;
+using message_logger::log::levels::Level;
+
+TEST(MessageLog, getAndClearLogReturnsEveryEntryOnce) {  // NOLINT
+  MessageLog::clearLog();
+  MessageLog::insertMessage(Level::Error, 1, 0x06020000, "first");
+  MessageLog::insertMessage(Level::Warn, "second");
+  MessageLog::insertMessage(Level::Error, 3, 7, "third");
+
+  const MessageLog::Entries entries = MessageLog::getAndClearEntries();
+  ASSERT_EQ(entries.size(), 3u);
+  EXPECT_EQ(entries[0].slave, 1);
+  EXPECT_EQ(entries[0].code, 0x06020000u);
+  EXPECT_STREQ(entries[0].text, "first");
+  EXPECT_STREQ(entries[1].text, "second");
+  EXPECT_EQ(entries[2].level, Level::Error);
+  EXPECT_TRUE(MessageLog::getAndClearEntries().empty());
+
+  MessageLog::insertMessage(Level::Info, "fourth");
+  const MessageLog::Log log = MessageLog::getAndClearLog();
+  ASSERT_EQ(log.size(), 1u);
+  EXPECT_EQ(log.front().first, Level::Info);
+  EXPECT_EQ(log.front().second, "fourth");
+}
+
+TEST(MessageLog, getLogKeepsTheEntries) {  // NOLINT
+  MessageLog::clearLog();
+  MessageLog::insertMessage(Level::Error, "kept");
+  EXPECT_EQ(MessageLog::getLog().size(), 1u);
+  EXPECT_EQ(MessageLog::getLog().size(), 1u);
+  MessageLog::clearLog();
+  EXPECT_TRUE(MessageLog::getLog().empty());
+}
+
+TEST(MessageLog, longTextsAreCut) {  // NOLINT
+  MessageLog::clearLog();
+  MessageLog::insertMessage(Level::Error, std::string(500, 'x'));
+  const MessageLog::Entries entries = MessageLog::getAndClearEntries();
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(std::string(entries[0].text), std::string(MessageLog::Entry::maxTextLength, 'x'));
+}
+
+TEST(MessageLog, wraparoundKeepsTheNewestEntries) {  // NOLINT
+  MessageLog::clearLog();
+  const size_t capacity = MessageLog::getCapacity();
+  const size_t inserted = 3 * capacity + 10;
+  for (size_t i = 0; i < inserted; i++) {
+    MessageLog::insertMessage(Level::Error, 0, static_cast<uint32_t>(i), std::to_string(i).c_str());
+  }
+  const MessageLog::Entries entries = MessageLog::getAndClearEntries();
+  ASSERT_EQ(entries.size(), capacity);
+  for (size_t i = 0; i < capacity; i++) {
+    const size_t expected = inserted - capacity + i;
+    EXPECT_EQ(entries[i].code, expected);
+    EXPECT_EQ(std::string(entries[i].text), std::to_string(expected));
+  }
+  EXPECT_FALSE(MessageLog::setCapacity(2 * capacity));
+}
+
+TEST(MessageLog, concurrentWritersAreNotTorn) {  // NOLINT
+  MessageLog::clearLog();
+  constexpr unsigned int writers = 4;
+  constexpr unsigned int messagesPerWriter = 20000;
+  const uint64_t droppedBefore = MessageLog::getNumberOfDroppedMessages();
+  std::atomic<bool> done{false};
+  std::set<uint32_t> codes;
+  size_t read = 0;
+
+  std::thread reader([&]() {
+    while (!done) {
+      for (const auto& entry : MessageLog::getAndClearEntries()) {
+        // every entry is consistent and returned only once.
+        EXPECT_EQ(std::string(entry.text), std::to_string(entry.code));
+        EXPECT_EQ(entry.slave, entry.code / messagesPerWriter);
+        EXPECT_TRUE(codes.insert(entry.code).second);
+        read++;
+      }
+    }
+  });
+  std::vector<std::thread> threads;
+  for (unsigned int writer = 0; writer < writers; writer++) {
+    threads.emplace_back([writer]() {
+      for (unsigned int i = 0; i < messagesPerWriter; i++) {
+        const uint32_t code = writer * messagesPerWriter + i;
+        MessageLog::insertMessage(Level::Error, static_cast<uint16_t>(writer), code, std::to_string(code).c_str());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  done = true;
+  reader.join();
+
+  // entries are only lost to overwriting or to slots taken by other writers, the last ones are all there.
+  const MessageLog::Entries remaining = MessageLog::getAndClearEntries();
+  const uint64_t dropped = MessageLog::getNumberOfDroppedMessages() - droppedBefore;
+  EXPECT_LE(read + remaining.size() + dropped, static_cast<size_t>(writers) * messagesPerWriter);
+  EXPECT_GT(read + remaining.size(), 0u);
+  for (const auto& entry : remaining) {
+    EXPECT_EQ(std::string(entry.text), std::to_string(entry.code));
+    EXPECT_TRUE(codes.insert(entry.code).second);
+  }
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "soem_interface_rsl/common/ProcessImageRecorder.hpp"
+
+using soem_interface_rsl::common::ProcessImageColumnKind;
+using soem_interface_rsl::common::ProcessImageRecorder;
+using soem_interface_rsl::common::ProcessImageRecording;
+using soem_interface_rsl::common::ProcessImageRowHeader;
+
+namespace {
+
+constexpr size_t imageSize = 16;
+
+std::string getPath(const std::string& name) {
+  const std::string path = testing::TempDir() + "soem_process_image_" + name;
+  std::remove(path.c_str());
+  return path;
+}
+
+//! Outputs and inputs of two slaves, the last two bytes of the image are not covered by a column.
+std::vector<ProcessImageRecorder::Column> getColumns() {
+  return {{"drive1.outputs", 1, ProcessImageColumnKind::Outputs, 0, 4},
+          {"drive1.inputs", 1, ProcessImageColumnKind::Inputs, 4, 4},
+          {"io2.outputs", 2, ProcessImageColumnKind::Outputs, 8, 2},
+          {"io2.inputs", 2, ProcessImageColumnKind::Inputs, 10, 4}};
+}
+
+std::array<uint8_t, imageSize> makeImage(const uint64_t row) {
+  std::array<uint8_t, imageSize> image{};
+  for (size_t i = 0; i < imageSize; i++) {
+    image[i] = static_cast<uint8_t>(row * imageSize + i);
+  }
+  return image;
+}
+
+}  // namespace
+
+TEST(ProcessImageRecorder, rowsAreReadBackByColumn) {  // NOLINT
+  const std::string path = getPath("columns");
+  ProcessImageRecorder recorder;
+  ProcessImageRecorder::Options options;
+  // the rows span several chunks.
+  options.rowsPerChunk = 4;
+  ASSERT_TRUE(recorder.start(path, "bus0", getColumns(), imageSize, options));
+  constexpr uint64_t rows = 10;
+  for (uint64_t row = 0; row < rows; row++) {
+    const auto image = makeImage(row);
+    ASSERT_TRUE(recorder.record(static_cast<int64_t>(1000 * row), static_cast<int64_t>(2000 * row), 3, 3, image.data()));
+  }
+  recorder.stop();
+  EXPECT_EQ(recorder.getNumberOfRows(), rows);
+  EXPECT_EQ(recorder.getNumberOfDroppedRows(), 0u);
+
+  ProcessImageRecording recording;
+  ASSERT_TRUE(recording.open(path));
+  EXPECT_EQ(recording.getBusName(), "bus0");
+  EXPECT_EQ(recording.getImageSize(), imageSize);
+  ASSERT_EQ(recording.getNumberOfRows(), rows);
+  // the fields of the row header come first.
+  EXPECT_EQ(recording.getColumns().size(), 5u + getColumns().size());
+  const int inputs = recording.findColumn(2, ProcessImageColumnKind::Inputs);
+  ASSERT_GE(inputs, 0);
+  EXPECT_EQ(recording.findColumn(3, ProcessImageColumnKind::Inputs), -1);
+
+  for (uint64_t row = 0; row < rows; row++) {
+    const ProcessImageRowHeader header = recording.getRowHeader(row);
+    EXPECT_EQ(header.cycle, row);
+    EXPECT_EQ(header.stamp, static_cast<int64_t>(1000 * row));
+    EXPECT_EQ(header.distributedClockTime, static_cast<int64_t>(2000 * row));
+    EXPECT_EQ(header.workingCounter, 3);
+    const auto expected = makeImage(row);
+    EXPECT_EQ(recording.getCell(static_cast<size_t>(inputs), row)[0], expected[10]);
+
+    std::array<uint8_t, imageSize> image{};
+    recording.getImage(row, image.data());
+    EXPECT_TRUE(std::equal(expected.begin(), expected.begin() + 14, image.begin()));
+    EXPECT_EQ(image[14], 0);
+
+    std::array<uint8_t, imageSize> inputImage{};
+    inputImage.fill(0xee);
+    recording.getInputs(row, inputImage.data());
+    EXPECT_EQ(inputImage[0], 0xee);
+    EXPECT_EQ(inputImage[4], expected[4]);
+    EXPECT_EQ(inputImage[8], 0xee);
+    EXPECT_EQ(inputImage[13], expected[13]);
+  }
+}
+
+TEST(ProcessImageRecorder, fullRingDropsRows) {  // NOLINT
+  const std::string path = getPath("drop");
+  ProcessImageRecorder recorder;
+  ProcessImageRecorder::Options options;
+  options.ringCapacity = 4;
+  ASSERT_TRUE(recorder.start(path, "bus0", getColumns(), imageSize, options));
+  constexpr uint64_t rows = 100;
+  uint64_t recorded = 0;
+  for (uint64_t row = 0; row < rows; row++) {
+    const auto image = makeImage(row);
+    recorded += recorder.record(0, 0, 0, 0, image.data()) ? 1 : 0;
+  }
+  recorder.stop();
+  EXPECT_EQ(recorder.getNumberOfRows(), recorded);
+  EXPECT_EQ(recorder.getNumberOfDroppedRows(), rows - recorded);
+  EXPECT_FALSE(recorder.record(0, 0, 0, 0, makeImage(0).data()));
+
+  // dropped cycles leave a gap in the cycle numbers, the rows still match their images.
+  ProcessImageRecording recording;
+  ASSERT_TRUE(recording.open(path));
+  ASSERT_EQ(recording.getNumberOfRows(), recorded);
+  std::array<uint8_t, imageSize> image{};
+  for (uint64_t row = 0; row < recorded; row++) {
+    const uint64_t cycle = recording.getRowHeader(row).cycle;
+    if (row > 0) {
+      EXPECT_GT(cycle, recording.getRowHeader(row - 1).cycle);
+    }
+    recording.getImage(row, image.data());
+    EXPECT_EQ(image[0], makeImage(cycle)[0]);
+  }
+}
+
+TEST(ProcessImageRecorder, recordingIsReadWhileBeingWritten) {  // NOLINT
+  const std::string path = getPath("live");
+  ProcessImageRecorder recorder;
+  ProcessImageRecorder::Options options;
+  options.rowsPerChunk = 16;
+  ASSERT_TRUE(recorder.start(path, "bus0", getColumns(), imageSize, options));
+  std::atomic<bool> done{false};
+  std::thread cyclic([&]() {
+    for (uint64_t row = 0; row < 200; row++) {
+      const auto image = makeImage(row);
+      EXPECT_TRUE(recorder.record(static_cast<int64_t>(row), 0, 0, 0, image.data()));
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    done = true;
+  });
+
+  // only complete rows are visible, their number never goes back.
+  uint64_t visible = 0;
+  while (!done) {
+    ProcessImageRecording recording;
+    ASSERT_TRUE(recording.open(path));
+    EXPECT_GE(recording.getNumberOfRows(), visible);
+    visible = recording.getNumberOfRows();
+    std::array<uint8_t, imageSize> image{};
+    for (uint64_t row = 0; row < visible; row++) {
+      ASSERT_EQ(recording.getRowHeader(row).stamp, static_cast<int64_t>(row));
+      recording.getImage(row, image.data());
+      ASSERT_EQ(image[13], makeImage(row)[13]);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  cyclic.join();
+  recorder.stop();
+  EXPECT_EQ(recorder.getNumberOfRows(), 200u);
+}
+
+TEST(ProcessImageRecorder, invalidRecordingsAreRejected) {  // NOLINT
+  ProcessImageRecorder recorder;
+  ProcessImageRecorder::Options options;
+  EXPECT_FALSE(recorder.start(getPath("invalid"), "bus0", getColumns(), 8, options));
+  options.ringCapacity = 0;
+  EXPECT_FALSE(recorder.start(getPath("invalid"), "bus0", getColumns(), imageSize, options));
+
+  const std::string path = getPath("garbage");
+  FILE* file = std::fopen(path.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  const std::vector<char> garbage(4096, 'x');
+  std::fwrite(garbage.data(), 1, garbage.size(), file);
+  std::fclose(file);
+  ProcessImageRecording recording;
+  EXPECT_FALSE(recording.open(path));
+  EXPECT_FALSE(recording.isOpen());
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/ProcessImageReplay.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::ProcessImageReplay;
+using soem_interface_rsl::common::ProcessImageRecording;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+namespace {
+
+constexpr uint64_t recordedCycles = 50;
+
+std::string getPath(const std::string& name) {
+  const std::string path = testing::TempDir() + "soem_replay_" + name;
+  std::remove(path.c_str());
+  return path;
+}
+
+//! Controller whose outputs only depend on the inputs, the replay reproduces them.
+void control(std::vector<std::shared_ptr<LoopbackSlave>>& slaves) {
+  for (auto& slave : slaves) {
+    for (size_t i = 0; i < LoopbackSlave::pdoSize; i++) {
+      slave->outputs_[i] = static_cast<uint8_t>(slave->inputs_[i] + i + 1);
+    }
+  }
+}
+
+std::vector<std::shared_ptr<LoopbackSlave>> addSlaves(EthercatBusBase& bus) {
+  std::vector<std::shared_ptr<LoopbackSlave>> slaves;
+  for (uint32_t address = 1; address <= 2; address++) {
+    slaves.push_back(std::make_shared<LoopbackSlave>(&bus, address));
+    EXPECT_TRUE(bus.addSlave(slaves.back()));
+  }
+  return slaves;
+}
+
+//! Records the cycles of a bus on a virtual segment, after the outputs were running for a while.
+void record(const std::string& path) {
+  VirtualSegment segment("replay0");
+  segment.addSlaves(VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize), 2);
+  ASSERT_TRUE(segment.attach());
+  EthercatBusBase bus("replay0");
+  auto slaves = addSlaves(bus);
+  ASSERT_TRUE(bus.startup(true));
+  bus.setState(EC_STATE_OPERATIONAL);
+  ASSERT_TRUE(bus.waitForState(EC_STATE_OPERATIONAL, 0));
+
+  bus.updateWrite();
+  for (uint64_t cycle = 0; cycle < 20 + recordedCycles; cycle++) {
+    if (cycle == 20) {
+      ASSERT_TRUE(bus.startProcessImageRecording(path));
+    }
+    bus.updateRead();
+    control(slaves);
+    bus.updateWrite();
+  }
+  bus.stopProcessImageRecording();
+  bus.shutdown();
+}
+
+}  // namespace
+
+TEST(ProcessImageReplay, replayReproducesTheOutputs) {  // NOLINT
+  const std::string path = getPath("recording");
+  record(path);
+  ProcessImageRecording recording;
+  ASSERT_TRUE(recording.open(path));
+  ASSERT_EQ(recording.getNumberOfRows(), recordedCycles);
+
+  for (const uint64_t firstRow : {0, 10}) {
+    const std::string outputPath = getPath("outputs" + std::to_string(firstRow));
+    EthercatBusBase bus("replay1");
+    auto slaves = addSlaves(bus);
+    ProcessImageReplay replay(bus);
+    ProcessImageReplay::Options options;
+    options.firstRow = firstRow;
+    options.outputPath = outputPath;
+    ProcessImageReplay::Result result;
+    ASSERT_TRUE(replay.run(path, options, result, [&slaves]() { control(slaves); }));
+    EXPECT_EQ(result.cycles, recordedCycles - firstRow);
+    EXPECT_EQ(result.firstComparedRow, firstRow + 1);
+    EXPECT_TRUE(result.differences.empty());
+
+    // the outputs of the priming cycle were not computed from the recorded inputs.
+    ProcessImageRecording replayed;
+    ASSERT_TRUE(replayed.open(outputPath));
+    std::vector<ProcessImageReplay::SlaveDifference> differences;
+    ASSERT_TRUE(ProcessImageReplay::compare(recording, firstRow, replayed, differences));
+    ASSERT_EQ(differences.size(), 2u);
+    EXPECT_EQ(differences[0].rows, 1u);
+    EXPECT_EQ(differences[0].firstRow, firstRow);
+  }
+}
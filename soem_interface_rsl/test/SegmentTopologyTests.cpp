@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/common/SegmentTopology.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::common::SegmentTopology;
+using soem_interface_rsl::common::TopologyNode;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+namespace {
+
+constexpr int32_t hopDelay = 500;
+
+class SegmentTopologyLine : public ::testing::Test {
+ protected:
+  //! Starts a line of three slaves in OP.
+  void start(const std::string& name) {
+    VirtualSegment::Options options;
+    options.hopDelay = hopDelay;
+    segment_ = std::make_unique<VirtualSegment>(name, options);
+    segment_->addSlaves(VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize), 3);
+    ASSERT_TRUE(segment_->attach());
+
+    bus_ = std::make_unique<EthercatBusBase>(name);
+    for (uint32_t address = 1; address <= 3; address++) {
+      slaves_.push_back(std::make_shared<LoopbackSlave>(bus_.get(), address));
+      ASSERT_TRUE(bus_->addSlave(slaves_.back()));
+    }
+    ASSERT_TRUE(bus_->startup(true));
+    ASSERT_TRUE(bus_->hasDistributedClocks());
+    bus_->setState(EC_STATE_OPERATIONAL);
+    ASSERT_TRUE(bus_->waitForState(EC_STATE_OPERATIONAL, 0));
+  }
+
+  void TearDown() override {
+    if (bus_) {
+      bus_->shutdown();
+    }
+    if (segment_) {
+      segment_->detach();
+    }
+  }
+
+  //! Cycles the bus while stepping the recovery, returns true if no slave is recovering after the last cycle.
+  bool cycle(const int cycles) {
+    bool recovered = false;
+    for (int i = 0; i < cycles; i++) {
+      bus_->updateWrite();
+      bus_->updateRead();
+      recovered = bus_->stepSlaveRecovery();
+    }
+    return recovered;
+  }
+
+  std::unique_ptr<VirtualSegment> segment_;
+  std::unique_ptr<EthercatBusBase> bus_;
+  std::vector<std::shared_ptr<LoopbackSlave>> slaves_;
+};
+
+//! Expects the delays of the last refresh to match the ones measured at startup.
+void expectStartupDelays(const std::vector<TopologyNode>& nodes) {
+  for (size_t address = 1; address < nodes.size(); address++) {
+    SCOPED_TRACE(address);
+    EXPECT_EQ(nodes[address].propagationDelay, nodes[address].startupPropagationDelay);
+    EXPECT_EQ(nodes[address].hopDelay, nodes[address].startupHopDelay);
+    EXPECT_DOUBLE_EQ(nodes[address].averageHopDelay, nodes[address].startupHopDelay);
+    EXPECT_EQ(nodes[address].maxHopDelay, nodes[address].startupHopDelay);
+  }
+}
+
+}  // namespace
+
+TEST(SegmentTopology, previousPortFollowsTheProcessingOrder) {  // NOLINT
+  // the frames pass the ports in the order 0 - 3 - 1 - 2.
+  EXPECT_EQ(SegmentTopology::previousPort(0x0F, 0), 2);
+  EXPECT_EQ(SegmentTopology::previousPort(0x0F, 3), 0);
+  EXPECT_EQ(SegmentTopology::previousPort(0x0F, 1), 3);
+  EXPECT_EQ(SegmentTopology::previousPort(0x0F, 2), 1);
+  // ports without a link are skipped.
+  EXPECT_EQ(SegmentTopology::previousPort(0x03, 0), 1);
+  EXPECT_EQ(SegmentTopology::previousPort(0x03, 1), 0);
+  EXPECT_EQ(SegmentTopology::previousPort(0x01, 0), 0);
+}
+
+TEST_F(SegmentTopologyLine, lineIsBuiltAtStartup) {  // NOLINT
+  start("topology0");
+  const auto nodes = bus_->getSegmentTopology();
+  ASSERT_EQ(nodes.size(), 4u);
+  EXPECT_EQ(nodes[0].children[0], 1);
+  for (uint16_t address = 1; address <= 3; address++) {
+    SCOPED_TRACE(address);
+    const TopologyNode& node = nodes[address];
+    EXPECT_EQ(node.address, address);
+    EXPECT_EQ(node.parent, address - 1);
+    EXPECT_EQ(node.distributedClockParent, address - 1);
+    EXPECT_TRUE(node.hasDistributedClock);
+    // the frames enter at port 0 and leave to the next slave at port 1.
+    EXPECT_EQ(node.entryPort, 0);
+    EXPECT_EQ(node.parentPort, address == 1 ? 0 : 1);
+    EXPECT_EQ(node.activePorts, address == 3 ? 0x01 : 0x03);
+    EXPECT_EQ(node.children[1], address == 3 ? 0 : address + 1);
+  }
+
+  // the reference clock has no hop, the frames pass one hop to each following slave and turn around in the last one.
+  EXPECT_EQ(nodes[1].startupPropagationDelay, 0);
+  EXPECT_EQ(nodes[1].startupHopDelay, 0);
+  EXPECT_EQ(nodes[2].startupHopDelay, hopDelay);
+  EXPECT_EQ(nodes[3].startupHopDelay, hopDelay + hopDelay / 2);
+  EXPECT_EQ(nodes[3].startupPropagationDelay, nodes[2].startupPropagationDelay + nodes[3].startupHopDelay);
+  EXPECT_EQ(bus_->getMaxPropagationDelay(), 1e-9 * nodes[3].startupPropagationDelay);
+  expectStartupDelays(nodes);
+}
+
+TEST_F(SegmentTopologyLine, refreshMeasuresTheStartupDelays) {  // NOLINT
+  start("topology1");
+  const auto startupNodes = bus_->getSegmentTopology();
+  // without a refresh the topology stays as measured at startup.
+  cycle(10);
+  EXPECT_EQ(bus_->getSegmentTopology()[3].receiveTimes, startupNodes[3].receiveTimes);
+
+  bus_->setTopologyRefresh(1);
+  cycle(10);
+  const auto nodes = bus_->getSegmentTopology();
+  for (size_t address = 1; address <= 3; address++) {
+    EXPECT_NE(nodes[address].receiveTimes, startupNodes[address].receiveTimes);
+  }
+  // the same hops are measured by every refresh.
+  expectStartupDelays(nodes);
+  cycle(10);
+  EXPECT_NE(bus_->getSegmentTopology()[3].receiveTimes, nodes[3].receiveTimes);
+  expectStartupDelays(bus_->getSegmentTopology());
+
+  bus_->setTopologyRefresh(0);
+  cycle(2);
+  const auto stoppedNodes = bus_->getSegmentTopology();
+  cycle(10);
+  EXPECT_EQ(bus_->getSegmentTopology()[3].receiveTimes, stoppedNodes[3].receiveTimes);
+}
+
+TEST_F(SegmentTopologyLine, refreshResumesWhenTheSlaveIsBack) {  // NOLINT
+  start("topology2");
+  bus_->setTopologyRefresh(1);
+  ASSERT_TRUE(cycle(10));
+
+  // a refresh missing a slave is dropped, the last complete one stays published.
+  segment_->unplug(3);
+  cycle(20);
+  EXPECT_FALSE(bus_->slaveIsActive(3));
+  const auto unpluggedNodes = bus_->getSegmentTopology();
+  cycle(20);
+  auto nodes = bus_->getSegmentTopology();
+  for (size_t address = 1; address <= 3; address++) {
+    EXPECT_EQ(nodes[address].receiveTimes, unpluggedNodes[address].receiveTimes);
+  }
+  expectStartupDelays(nodes);
+
+  segment_->plugIn();
+  bool recovered = false;
+  for (int i = 0; i < 100 && !recovered; i++) {
+    recovered = cycle(50);
+  }
+  ASSERT_TRUE(recovered);
+  EXPECT_TRUE(bus_->slaveIsActive(3));
+  cycle(10);
+  nodes = bus_->getSegmentTopology();
+  for (size_t address = 1; address <= 3; address++) {
+    EXPECT_NE(nodes[address].receiveTimes, unpluggedNodes[address].receiveTimes);
+  }
+  expectStartupDelays(nodes);
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlave;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+namespace {
+
+//! Puts a virtual slave back into INIT with its SyncManagers and FMMUs cleared, like after a power cycle.
+void powerCycle(VirtualSlave& slave) {
+  const uint16_t init = EC_STATE_INIT;
+  slave.write(ECT_REG_ALCTL, reinterpret_cast<const uint8_t*>(&init), sizeof(init));
+  const std::vector<uint8_t> zeros(0x100, 0);
+  slave.write(ECT_REG_FMMU0, zeros.data(), static_cast<uint16_t>(zeros.size()));
+  slave.write(ECT_REG_SM0, zeros.data(), 0x80);
+}
+
+//! Cycles the bus while stepping the recovery, returns the number of cycles until no slave is recovering, -1 on timeout.
+int cycleUntilRecovered(EthercatBusBase& bus, std::vector<std::shared_ptr<LoopbackSlave>>& slaves, const int maxCycles) {
+  for (int cycle = 0; cycle < maxCycles; cycle++) {
+    for (auto& slave : slaves) {
+      slave->outputs_.fill(static_cast<uint8_t>(cycle));
+    }
+    bus.updateWrite();
+    bus.updateRead();
+    const auto begin = std::chrono::steady_clock::now();
+    const bool recovered = bus.stepSlaveRecovery();
+    // every call only runs short steps, the context is never locked while waiting for a slave.
+    EXPECT_LT(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(), 0.1);
+    if (recovered && cycle > 0) {
+      return cycle;
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
+TEST(SlaveRecovery, powerCycledSlaveIsReconfigured) {  // NOLINT
+  VirtualSegment segment("recovery0");
+  segment.addSlaves(VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize), 3);
+  ASSERT_TRUE(segment.attach());
+
+  EthercatBusBase bus("recovery0");
+  std::vector<std::shared_ptr<LoopbackSlave>> slaves;
+  for (uint32_t address = 1; address <= 3; address++) {
+    slaves.push_back(std::make_shared<LoopbackSlave>(&bus, address));
+    ASSERT_TRUE(bus.addSlave(slaves.back()));
+  }
+  ASSERT_TRUE(bus.startup(true));
+  bus.setState(EC_STATE_OPERATIONAL);
+  ASSERT_TRUE(bus.waitForState(EC_STATE_OPERATIONAL, 0));
+  ASSERT_GT(cycleUntilRecovered(bus, slaves, 10), 0);
+
+  powerCycle(segment.getSlave(2));
+  ASSERT_GT(cycleUntilRecovered(bus, slaves, 5000), 0);
+  EXPECT_EQ(segment.getSlave(2).getState(), EC_STATE_OPERATIONAL);
+  EXPECT_EQ(slaves[1]->recoveries_, 1);
+  EXPECT_EQ(slaves[0]->recoveries_, 0);
+  EXPECT_TRUE(bus.slaveIsActive(2));
+
+  // the process data of the reconfigured slave is exchanged again.
+  for (int cycle = 0; cycle < 3; cycle++) {
+    slaves[1]->outputs_.fill(0x5a);
+    bus.updateWrite();
+    bus.updateRead();
+  }
+  EXPECT_EQ(slaves[1]->inputs_[0], 0x5a);
+  EXPECT_TRUE(bus.busIsOk());
+
+  bus.shutdown();
+  segment.detach();
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+namespace {
+
+class SlaveRemap : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto description = VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize);
+    // the TxPDO assignment can be rewritten over SDO, the process data of the virtual slave keeps its size.
+    description.objects.push_back({ECT_SDO_TXPDOASSIGN, 0, {1}});
+    segment_.addSlaves(description, 3);
+    ASSERT_TRUE(segment_.attach());
+    for (uint32_t address = 1; address <= 3; address++) {
+      slaves_.push_back(std::make_shared<LoopbackSlave>(&bus_, address));
+      ASSERT_TRUE(bus_.addSlave(slaves_.back()));
+    }
+    ASSERT_TRUE(bus_.startup(true));
+    bus_.setState(EC_STATE_OPERATIONAL);
+    ASSERT_TRUE(bus_.waitForState(EC_STATE_OPERATIONAL, 0));
+    cycling_ = true;
+    cycleThread_ = std::thread([this]() {
+      while (cycling_) {
+        bus_.updateWrite();
+        bus_.updateRead();
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+      }
+    });
+  }
+
+  void TearDown() override {
+    stopCycling();
+    bus_.shutdown();
+    segment_.detach();
+  }
+
+  void stopCycling() {
+    cycling_ = false;
+    if (cycleThread_.joinable()) {
+      cycleThread_.join();
+    }
+  }
+
+  //! Steps the recovery until no slave is recovering.
+  bool recover() {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while (std::chrono::steady_clock::now() < deadline) {
+      if (bus_.stepSlaveRecovery()) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+  }
+
+  //! Checks that the outputs of a slave are looped back to its inputs.
+  bool exchangesProcessData(const size_t address) {
+    stopCycling();
+    for (int cycle = 0; cycle < 3; cycle++) {
+      slaves_[address - 1]->outputs_.fill(static_cast<uint8_t>(0x40 + address));
+      bus_.updateWrite();
+      bus_.updateRead();
+    }
+    return slaves_[address - 1]->inputs_[0] == 0x40 + address && bus_.busIsOk();
+  }
+
+  bool writeTxPdoCount(const uint8_t count) { return bus_.sendSdoWrite(2, ECT_SDO_TXPDOASSIGN, 0, false, count); }
+
+  VirtualSegment segment_{"remap0"};
+  EthercatBusBase bus_{"remap0"};
+  std::vector<std::shared_ptr<LoopbackSlave>> slaves_;
+  std::atomic<bool> cycling_{false};
+  std::thread cycleThread_;
+};
+
+}  // namespace
+
+TEST_F(SlaveRemap, slaveIsRemappedWhileTheOthersCycle) {  // NOLINT
+  ASSERT_TRUE(bus_.remapSlave(2, [this]() { return writeTxPdoCount(1); }));
+  EXPECT_TRUE(bus_.slaveIsActive(2));
+  // remapping the slave in the headroom again is possible.
+  ASSERT_TRUE(bus_.remapSlave(2, [this]() { return writeTxPdoCount(1); }));
+  EXPECT_FALSE(bus_.remapSlave(3, [this]() { return true; }));
+  EXPECT_TRUE(bus_.slaveIsActive(3));
+  EXPECT_TRUE(exchangesProcessData(2));
+  EXPECT_EQ(segment_.getSlave(2).getState(), EC_STATE_OPERATIONAL);
+}
+
+TEST_F(SlaveRemap, failedPdoAssignmentRestoresThePreviousMapping) {  // NOLINT
+  EXPECT_FALSE(bus_.remapSlave(2, []() { return false; }));
+  EXPECT_FALSE(bus_.slaveIsActive(2));
+  ASSERT_TRUE(recover());
+  EXPECT_TRUE(bus_.slaveIsActive(2));
+  EXPECT_TRUE(exchangesProcessData(2));
+}
+
+TEST_F(SlaveRemap, rejectedMappingRestoresThePreviousMapping) {  // NOLINT
+  // without TxPDOs the sizes do not match the slave object, the previous mapping is restored.
+  EXPECT_FALSE(bus_.remapSlave(2, [this]() { return writeTxPdoCount(0); }));
+  ASSERT_TRUE(writeTxPdoCount(1));
+  ASSERT_TRUE(recover());
+  EXPECT_EQ(slaves_[1]->recoveries_, 1);
+  EXPECT_TRUE(bus_.slaveIsActive(2));
+  EXPECT_TRUE(exchangesProcessData(2));
+
+  // the slave rejects SAFE_OP with a mapping that does not match its sync managers, the previous mapping is restored as well.
+  EXPECT_FALSE(bus_.remapSlave(2, [this]() { return writeTxPdoCount(0); }, false));
+  EXPECT_FALSE(bus_.slaveIsActive(2));
+  ASSERT_TRUE(recover());
+  EXPECT_TRUE(bus_.slaveIsActive(2));
+  EXPECT_TRUE(exchangesProcessData(2));
+}
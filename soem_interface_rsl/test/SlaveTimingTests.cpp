@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/common/EventLog.hpp"
+#include "soem_interface_rsl/common/SlaveTiming.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::common::EventLog;
+using soem_interface_rsl::common::EventLogInfo;
+using soem_interface_rsl::common::EventRecord;
+using soem_interface_rsl::common::EventType;
+using soem_interface_rsl::common::SlaveTiming;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+namespace {
+
+//! Slave blocking in updateRead(), like a device SDK doing a syscall.
+class BlockingSlave : public LoopbackSlave {
+ public:
+  using LoopbackSlave::LoopbackSlave;
+  void updateRead() override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    LoopbackSlave::updateRead();
+  }
+};
+
+}  // namespace
+
+TEST(SlaveTiming, blockingShowsInTheWallTimeOnly) {  // NOLINT
+  SlaveTiming timing;
+  timing.setBudget(1000000);
+  const SlaveTiming::Stamp start = SlaveTiming::start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  EXPECT_GE(timing.stop(SlaveTiming::Callback::UpdateRead, start), 2000000);
+  // well below the budget.
+  EXPECT_EQ(timing.stop(SlaveTiming::Callback::UpdateWrite, SlaveTiming::start()), 0);
+
+  const auto snapshot = timing.getSnapshot();
+  EXPECT_EQ(snapshot.budget, 1000000);
+  EXPECT_EQ(snapshot.budgetExceeded, 1u);
+  EXPECT_EQ(snapshot.readWallTime.count, 1u);
+  EXPECT_GE(snapshot.readWallTime.min, 2000000);
+  EXPECT_LT(snapshot.readCpuTime.max, 1000000);
+  EXPECT_EQ(snapshot.writeWallTime.count, 1u);
+}
+
+TEST(SlaveTiming, slowSlaveIsRankedFirst) {  // NOLINT
+  VirtualSegment segment("timing0");
+  segment.addSlaves(VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize), 3);
+  ASSERT_TRUE(segment.attach());
+
+  EthercatBusBase bus("timing0");
+  std::vector<std::shared_ptr<LoopbackSlave>> slaves;
+  for (uint32_t address = 1; address <= 3; address++) {
+    slaves.push_back(address == 2 ? std::make_shared<BlockingSlave>(&bus, address) : std::make_shared<LoopbackSlave>(&bus, address));
+    ASSERT_TRUE(bus.addSlave(slaves.back()));
+  }
+  ASSERT_TRUE(bus.startup(true));
+  bus.setState(EC_STATE_OPERATIONAL);
+  ASSERT_TRUE(bus.waitForState(EC_STATE_OPERATIONAL, 0));
+  const std::string path = testing::TempDir() + "soem_slave_timing_events";
+  std::remove(path.c_str());
+  ASSERT_TRUE(bus.openEventLog(path, 64));
+
+  EXPECT_TRUE(bus.getSlaveTimings().empty());
+  bus.enableSlaveTiming(0.001);
+  EXPECT_FALSE(bus.setSlaveBudget(4, 0.001));
+  // the budget of slave 3 is too small for any callback.
+  EXPECT_TRUE(bus.setSlaveBudget(3, 1e-9));
+  constexpr int cycles = 5;
+  for (int cycle = 0; cycle < cycles; cycle++) {
+    bus.updateWrite();
+    bus.updateRead();
+  }
+
+  const auto timings = bus.getSlaveTimings();
+  ASSERT_EQ(timings.size(), 3u);
+  EXPECT_EQ(timings[1].address, 2u);
+  EXPECT_EQ(timings[1].readWallTime.count, static_cast<uint64_t>(cycles));
+  EXPECT_EQ(timings[1].budgetExceeded, static_cast<uint64_t>(cycles));
+  EXPECT_EQ(timings[0].budgetExceeded, 0u);
+  EXPECT_EQ(timings[2].budgetExceeded, static_cast<uint64_t>(2 * cycles));
+  const auto top = bus.getTopSlaveTimings(1);
+  ASSERT_EQ(top.size(), 1u);
+  EXPECT_EQ(top[0].address, 2u);
+  EXPECT_EQ(top[0].name, "loopback2");
+
+  EventLogInfo info;
+  std::vector<EventRecord> records;
+  ASSERT_TRUE(EventLog::read(path, info, records));
+  int slowReads = 0;
+  for (const EventRecord& record : records) {
+    if (record.type == static_cast<uint16_t>(EventType::SlaveBudgetExceeded) && record.slave == 2) {
+      EXPECT_EQ(record.code, static_cast<uint32_t>(SlaveTiming::Callback::UpdateRead));
+      EXPECT_GE(record.value0, 2000);
+      EXPECT_EQ(record.value1, 1000);
+      slowReads++;
+    }
+  }
+  EXPECT_EQ(slowReads, cycles);
+
+  // the recorded timings are kept.
+  bus.disableSlaveTiming();
+  bus.updateWrite();
+  bus.updateRead();
+  EXPECT_EQ(bus.getSlaveTimings()[1].readWallTime.count, static_cast<uint64_t>(cycles));
+}
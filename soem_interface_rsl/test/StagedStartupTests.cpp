@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+namespace {
+
+class StagedStartup : public ::testing::Test {
+ protected:
+  //! Starts three slaves, the second one takes stateChangeDelay to reach SAFE_OP and OP.
+  void start(const std::string& name, const int64_t stateChangeDelay) {
+    auto description = VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize);
+    segment_ = std::make_unique<VirtualSegment>(name);
+    segment_->addSlave(description);
+    description.stateChangeDelay = stateChangeDelay;
+    segment_->addSlave(description);
+    description.stateChangeDelay = 0;
+    segment_->addSlave(description);
+    ASSERT_TRUE(segment_->attach());
+
+    bus_ = std::make_unique<EthercatBusBase>(name);
+    for (uint32_t address = 1; address <= 3; address++) {
+      slaves_.push_back(std::make_shared<LoopbackSlave>(bus_.get(), address));
+      ASSERT_TRUE(bus_->addSlave(slaves_.back()));
+    }
+    bus_->setSlaveStateTimeout(0.5);
+    ASSERT_TRUE(bus_->startupStaged(true));
+    // nobody takes part in the cyclic exchange yet.
+    EXPECT_EQ(bus_->getExpectedWorkingCounter(), 0);
+    for (uint16_t address = 1; address <= 3; address++) {
+      EXPECT_FALSE(bus_->slaveIsActive(address));
+    }
+
+    cycling_ = true;
+    cycleThread_ = std::thread([this]() {
+      while (cycling_) {
+        bus_->updateWrite();
+        bus_->updateRead();
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+      }
+    });
+  }
+
+  void TearDown() override {
+    stopCycling();
+    if (bus_) {
+      bus_->shutdown();
+    }
+  }
+
+  void stopCycling() {
+    cycling_ = false;
+    if (cycleThread_.joinable()) {
+      cycleThread_.join();
+    }
+  }
+
+  //! Steps the staged startup until it finished, the expected working counter while only the first and the last slave are active is
+  //! stored.
+  bool step(int& partialWorkingCounter) {
+    partialWorkingCounter = -1;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+      const bool finished = bus_->stepStagedStartup();
+      if (bus_->slaveIsActive(1) && !bus_->slaveIsActive(2) && bus_->slaveIsActive(3)) {
+        partialWorkingCounter = bus_->getExpectedWorkingCounter();
+        // the working counter of the pending slave is not expected, the bus is ok.
+        EXPECT_TRUE(bus_->busIsOk());
+      }
+      if (finished) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+  }
+
+  std::unique_ptr<VirtualSegment> segment_;
+  std::unique_ptr<EthercatBusBase> bus_;
+  std::vector<std::shared_ptr<LoopbackSlave>> slaves_;
+  std::atomic<bool> cycling_{false};
+  std::thread cycleThread_;
+};
+
+}  // namespace
+
+TEST_F(StagedStartup, slowSlaveJoinsTheCyclicExchange) {  // NOLINT
+  start("staged0", 100000000);
+  int partialWorkingCounter = -1;
+  ASSERT_TRUE(step(partialWorkingCounter));
+
+  // the others reached OP while the slow slave was still pending, its contribution was added once it joined.
+  for (uint16_t address = 1; address <= 3; address++) {
+    EXPECT_TRUE(bus_->slaveIsActive(address));
+    EXPECT_EQ(segment_->getSlave(address).getState(), EC_STATE_OPERATIONAL);
+  }
+  ASSERT_GT(partialWorkingCounter, 0);
+  EXPECT_EQ(bus_->getExpectedWorkingCounter(), partialWorkingCounter * 3 / 2);
+
+  stopCycling();
+  for (int cycle = 0; cycle < 3; cycle++) {
+    slaves_[1]->outputs_.fill(0x42);
+    bus_->updateWrite();
+    bus_->updateRead();
+  }
+  EXPECT_EQ(slaves_[1]->inputs_[0], 0x42);
+  EXPECT_TRUE(bus_->busIsOk());
+}
+
+TEST_F(StagedStartup, slaveMissingTheTimeoutIsLeftOut) {  // NOLINT
+  start("staged1", 60000000000);
+  int partialWorkingCounter = -1;
+  // the staged startup finishes once the slow slave missed the timeout.
+  ASSERT_TRUE(step(partialWorkingCounter));
+  EXPECT_FALSE(bus_->slaveIsActive(2));
+  EXPECT_NE(segment_->getSlave(2).getState(), EC_STATE_OPERATIONAL);
+  EXPECT_TRUE(bus_->slaveIsActive(1));
+  EXPECT_TRUE(bus_->slaveIsActive(3));
+  ASSERT_GT(partialWorkingCounter, 0);
+  EXPECT_EQ(bus_->getExpectedWorkingCounter(), partialWorkingCounter);
+
+  // the failed slave is not stepped again.
+  EXPECT_TRUE(bus_->stepStagedStartup());
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_TRUE(bus_->busIsOk());
+}
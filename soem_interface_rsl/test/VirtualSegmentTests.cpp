@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlave;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+namespace {
+
+using Frame = std::array<uint8_t, 30>;
+
+//! Ethernet frame with a single datagram reading 2 bytes of the ESC memory.
+Frame readFrame(const uint8_t command, const uint16_t position, const uint16_t address) {
+  Frame frame{};
+  frame[12] = 0x88;
+  frame[13] = 0xA4;
+  // ecat header: length of the datagram, type 1.
+  frame[14] = 14;
+  frame[15] = 0x10;
+  frame[16] = command;
+  frame[18] = static_cast<uint8_t>(position);
+  frame[19] = static_cast<uint8_t>(position >> 8);
+  frame[20] = static_cast<uint8_t>(address);
+  frame[21] = static_cast<uint8_t>(address >> 8);
+  frame[22] = 2;
+  return frame;
+}
+
+uint16_t get16(const uint8_t* data) { return static_cast<uint16_t>(data[0] | (data[1] << 8)); }
+
+VirtualSlaveDescription loopbackDescription() {
+  return VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize);
+}
+
+}  // namespace
+
+TEST(VirtualSegment, datagramsPassAllSlaves) {  // NOLINT
+  VirtualSegment segment("segment0");
+  segment.addSlaves(loopbackDescription(), 3);
+  EXPECT_EQ(segment.getNumberOfSlaves(), 3u);
+
+  // every slave answers a broadcast.
+  Frame frame = readFrame(EC_CMD_BRD, 0, ECT_REG_TYPE);
+  ASSERT_TRUE(segment.processFrame(frame.data(), frame.size()));
+  EXPECT_EQ(get16(frame.data() + 28), 3);
+
+  // an auto increment address only matches the slave at the position.
+  frame = readFrame(EC_CMD_APRD, static_cast<uint16_t>(-1), ECT_REG_TYPE);
+  ASSERT_TRUE(segment.processFrame(frame.data(), frame.size()));
+  EXPECT_EQ(get16(frame.data() + 28), 1);
+  frame = readFrame(EC_CMD_APRD, static_cast<uint16_t>(-3), ECT_REG_TYPE);
+  ASSERT_TRUE(segment.processFrame(frame.data(), frame.size()));
+  EXPECT_EQ(get16(frame.data() + 28), 0);
+  EXPECT_EQ(segment.getNumberOfFrames(), 3u);
+
+  Frame other{};
+  other[12] = 0x08;
+  EXPECT_FALSE(segment.processFrame(other.data(), other.size()));
+}
+
+TEST(VirtualSegment, transportQueuesAnswers) {  // NOLINT
+  VirtualSegment segment("segment1");
+  segment.addSlaves(loopbackDescription(), 1);
+  Frame frame{};
+  EXPECT_EQ(VirtualSegment::receive(&segment, 0, frame.data(), frame.size()), 0);
+
+  for (uint16_t index = 0; index < 40; index++) {
+    frame = readFrame(EC_CMD_BRD, 0, ECT_REG_TYPE);
+    frame[17] = static_cast<uint8_t>(index);
+    EXPECT_EQ(VirtualSegment::send(&segment, 0, frame.data(), frame.size()), static_cast<int>(frame.size()));
+  }
+  // the answers are received in order, those beyond the receive ring are lost.
+  size_t received = 0;
+  while (VirtualSegment::receive(&segment, 0, frame.data(), frame.size()) > 0) {
+    EXPECT_EQ(frame[17], received);
+    EXPECT_EQ(get16(frame.data() + 28), 1);
+    received++;
+  }
+  EXPECT_EQ(received, 32u);
+}
+
+TEST(VirtualSegment, busRunsOnTheSegment) {  // NOLINT
+  VirtualSegment segment("segment2");
+  auto description = loopbackDescription();
+  description.objects.push_back({0x2000, 1, {0x34, 0x12}});
+  segment.addSlaves(description, 2);
+  // the second slave inverts its outputs instead of looping them back.
+  segment.getSlave(2).setApplication([](VirtualSlave& slave) {
+    for (size_t i = 0; i < slave.getInputSize(); i++) {
+      slave.getInputs()[i] = static_cast<uint8_t>(~slave.getOutputs()[i]);
+    }
+  });
+  ASSERT_TRUE(segment.attach());
+
+  EthercatBusBase bus("segment2");
+  std::vector<std::shared_ptr<LoopbackSlave>> slaves;
+  for (uint32_t address = 1; address <= 2; address++) {
+    slaves.push_back(std::make_shared<LoopbackSlave>(&bus, address));
+    ASSERT_TRUE(bus.addSlave(slaves.back()));
+  }
+  ASSERT_TRUE(bus.startup(true));
+  EXPECT_EQ(bus.getNumberOfSlaves(), 2);
+  bus.setState(EC_STATE_OPERATIONAL);
+  ASSERT_TRUE(bus.waitForState(EC_STATE_OPERATIONAL, 0));
+  EXPECT_EQ(segment.getSlave(1).getState(), EC_STATE_OPERATIONAL);
+  EXPECT_NE(segment.getSlave(1).getStationAddress(), segment.getSlave(2).getStationAddress());
+
+  uint16_t value = 0;
+  ASSERT_TRUE(bus.sendSdoRead(1, 0x2000, 1, false, value));
+  EXPECT_EQ(value, 0x1234);
+  ASSERT_TRUE(bus.sendSdoWrite(1, 0x2000, 1, false, static_cast<uint16_t>(0x5678)));
+  ASSERT_TRUE(bus.sendSdoRead(1, 0x2000, 1, false, value));
+  EXPECT_EQ(value, 0x5678);
+
+  for (int cycle = 0; cycle < 3; cycle++) {
+    slaves[0]->outputs_.fill(0x11);
+    slaves[1]->outputs_.fill(0x22);
+    bus.updateWrite();
+    bus.updateRead();
+  }
+  EXPECT_TRUE(bus.busIsOk());
+  EXPECT_EQ(segment.getSlave(1).getOutputs()[0], 0x11);
+  EXPECT_EQ(slaves[0]->inputs_[0], 0x11);
+  EXPECT_EQ(slaves[1]->inputs_[0], static_cast<uint8_t>(~0x22));
+
+  bus.shutdown();
+  EXPECT_NE(segment.getSlave(1).getState(), EC_STATE_OPERATIONAL);
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include <soem_rsl/ethercat.h>
+
+#include "LoopbackSlave.hpp"
+#include "soem_interface_rsl/common/VirtualSegment.hpp"
+
+using soem_interface_rsl::BusDiagnosisLog;
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+using soem_interface_rsl::test::LoopbackSlave;
+
+TEST(WorkingCounterAttribution, slaveWithDisabledFmmusIsFound) {  // NOLINT
+  VirtualSegment segment("attribution0");
+  segment.addSlaves(VirtualSlaveDescription::fromPdoSizes("loopback", 0x1, 0x2, LoopbackSlave::pdoSize, LoopbackSlave::pdoSize), 3);
+  ASSERT_TRUE(segment.attach());
+
+  EthercatBusBase bus("attribution0");
+  std::vector<std::shared_ptr<LoopbackSlave>> slaves;
+  for (uint32_t address = 1; address <= 3; address++) {
+    slaves.push_back(std::make_shared<LoopbackSlave>(&bus, address));
+    ASSERT_TRUE(bus.addSlave(slaves.back()));
+  }
+  ASSERT_TRUE(bus.startup(true));
+  bus.setState(EC_STATE_OPERATIONAL);
+  ASSERT_TRUE(bus.waitForState(EC_STATE_OPERATIONAL, 0));
+  bus.setWorkingCounterAttribution(true);
+
+  // slave 2 stays in OP but no longer takes part in the process data.
+  const std::vector<uint8_t> disabledFmmus(2 * 16, 0);
+  segment.getSlave(2).write(ECT_REG_FMMU0, disabledFmmus.data(), static_cast<uint16_t>(disabledFmmus.size()));
+
+  BusDiagnosisLog log;
+  for (int cycle = 0; cycle < 100 && log.workingCounterAttributions == 0; cycle++) {
+    bus.updateWrite();
+    bus.updateRead();
+    bus.doBusMonitoring(true);
+    bus.getBusDiagnosisLog(log);
+  }
+  ASSERT_GT(log.workingCounterAttributions, 0u);
+  ASSERT_EQ(log.workingCounterFaults.size(), 1u);
+  const auto& fault = log.workingCounterFaults.front();
+  EXPECT_EQ(fault.slave, 2);
+  EXPECT_TRUE(fault.answered);
+  EXPECT_EQ(fault.alStatus & 0x0f, EC_STATE_OPERATIONAL);
+  EXPECT_EQ(fault.workingCounter, 0);
+  // group 0 blocks LRW: one LRD of the inputs and one LWR of the outputs, each expected to count once.
+  EXPECT_EQ(fault.expectedWorkingCounter, 2);
+
+  bus.shutdown();
+  segment.detach();
+}
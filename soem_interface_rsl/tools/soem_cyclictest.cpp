@@ -0,0 +1,599 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Runs the bus cycle for a number of cycles and prints latency histograms per phase, overruns and the timelines of the worst
+// cycles as JSON, to compare kernels, NICs and configurations. The bus is a real interface, an in-process simulated segment or a
+// simulated segment served on one end of a veth pair.
+// Usage: soem_cyclictest [--bus <interface>] [--slaves <n>] [--sim <n>] [--veth <peer>] [--pdo <bytes>] [--cycle-time <us>]
+//                        [--cycles <n>] [--warmup <n>] [--executor cyclic|loop|manager|workers] [--wait sleep|spin|busy]
+//                        [--spin-time <us>] [--policy fifo|other|deadline] [--priority <n>] [--cpu <n>] [--worker-cpu <n>]
+//                        [--packing pdo|al|dl|errors[,...]] [--packing-decimation <n>] [--timelines <n>] [--output <file>]
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// linux
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+// soem_interface_rsl
+#include <soem_interface_rsl/CyclicExecutor.hpp>
+#include <soem_interface_rsl/EthercatBusBase.hpp>
+#include <soem_interface_rsl/EthercatBusManagerBase.hpp>
+#include <soem_interface_rsl/EthercatSlaveBase.hpp>
+#include <soem_interface_rsl/common/CycleStatistics.hpp>
+#include <soem_interface_rsl/common/VirtualSegment.hpp>
+
+// soem_rsl
+#include <soem_rsl/ethercat.h>
+
+using soem_interface_rsl::CyclicExecutor;
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::EthercatBusManagerBase;
+using soem_interface_rsl::EthercatSlaveBase;
+using soem_interface_rsl::common::CycleStatistics;
+using soem_interface_rsl::common::HistogramSnapshot;
+using soem_interface_rsl::common::LatencyHistogram;
+using soem_interface_rsl::common::StatusRegister;
+using soem_interface_rsl::common::VirtualSegment;
+using soem_interface_rsl::common::VirtualSlaveDescription;
+
+namespace {
+
+struct Configuration {
+  std::string bus;
+  int slaves{0};
+  int simulatedSlaves{0};
+  std::string veth;
+  int pdoSize{8};
+  double cycleTime{0.001};
+  uint64_t cycles{10000};
+  uint64_t warmup{1000};
+  std::string executor{"cyclic"};
+  std::string wait{"sleep"};
+  double spinTime{50e-6};
+  std::string policy{"fifo"};
+  int priority{90};
+  int cpu{-1};
+  int workerCpu{-1};
+  std::string packing{"pdo"};
+  unsigned int packingDecimation{1};
+  size_t timelines{10};
+  std::string output;
+};
+
+// Slave without application, the benchmark only exchanges the process image.
+class BenchmarkSlave : public EthercatSlaveBase {
+ public:
+  BenchmarkSlave(EthercatBusBase* bus, const uint32_t address) : EthercatSlaveBase(bus, address) {}
+  std::string getName() const override { return "slave" + std::to_string(address_); }
+  bool startup() override { return true; }
+  void updateRead() override {}
+  void updateWrite() override {}
+  void shutdown() override {}
+  PdoInfo getCurrentPdoInfo() const override { return PdoInfo(); }
+};
+
+// Timeline of one cycle, times relative to the scheduled cycle start in ns.
+struct CycleTrace {
+  uint64_t cycle{0};
+  int64_t scheduled{0};
+  int64_t wakeUp{0};
+  int64_t readEnd{0};
+  int64_t writeEnd{0};
+  bool overrun{false};
+};
+
+// Measures the cycles from the cyclic thread without allocating. The schedule mirrors CyclicExecutor::run(): the next cycle starts a
+// cycle time after the previous one, after an overrun it starts right away.
+class CycleProbe {
+ public:
+  CycleProbe(const Configuration& configuration, EthercatBusBase& bus)
+      : period_(static_cast<int64_t>(configuration.cycleTime * 1e9)),
+        warmup_(configuration.warmup),
+        end_(configuration.warmup + configuration.cycles),
+        bus_(bus),
+        traces_(configuration.timelines) {}
+
+  void startCycle() {
+    const int64_t start = CycleStatistics::now();
+    if (scheduled_ == 0) {
+      scheduled_ = start;
+    }
+    trace_ = CycleTrace();
+    trace_.cycle = cycle_;
+    trace_.scheduled = scheduled_;
+    trace_.wakeUp = start - scheduled_;
+    lastStart_ = start;
+  }
+
+  void endRead() { trace_.readEnd = CycleStatistics::now() - scheduled_; }
+
+  void endCycle() {
+    const int64_t end = CycleStatistics::now();
+    trace_.writeEnd = end - scheduled_;
+    int64_t next = scheduled_ + period_;
+    trace_.overrun = end > next;
+    if (trace_.overrun) {
+      next = end;
+    }
+    if (cycle_ >= end_) {
+      // the executor is being stopped, the cycles after the measurement are not reported.
+      scheduled_ = next;
+      return;
+    }
+    overruns_ += trace_.overrun ? 1 : 0;
+    wakeUp_.record(trace_.wakeUp);
+    read_.record(trace_.readEnd - trace_.wakeUp);
+    write_.record(trace_.writeEnd - trace_.readEnd);
+    cycleDuration_.record(trace_.writeEnd - trace_.wakeUp);
+    latency_.record(trace_.writeEnd);
+    if (previousStart_ != 0) {
+      periodHistogram_.record(lastStart_ - previousStart_);
+    }
+    previousStart_ = lastStart_;
+    keepTrace();
+    scheduled_ = next;
+
+    if (++cycle_ == warmup_) {
+      // the warm up fills the caches and settles the clocks, its cycles are not reported.
+      for (LatencyHistogram* histogram : {&wakeUp_, &read_, &write_, &cycleDuration_, &latency_, &periodHistogram_}) {
+        histogram->reset();
+      }
+      overruns_ = 0;
+      std::fill(traces_.begin(), traces_.end(), CycleTrace());
+      bus_.resetCycleStatistics();
+    }
+    if (cycle_ >= end_) {
+      finished_.store(true, std::memory_order_release);
+    }
+  }
+
+  bool isFinished() const { return finished_.load(std::memory_order_acquire); }
+  int64_t getScheduled() const { return scheduled_; }
+  uint64_t getOverruns() const { return overruns_; }
+
+  std::vector<CycleTrace> getWorstTraces() const {
+    std::vector<CycleTrace> traces;
+    for (const CycleTrace& trace : traces_) {
+      if (trace.scheduled != 0) {
+        traces.push_back(trace);
+      }
+    }
+    std::sort(traces.begin(), traces.end(), [](const CycleTrace& a, const CycleTrace& b) { return a.writeEnd > b.writeEnd; });
+    return traces;
+  }
+
+  LatencyHistogram wakeUp_;
+  LatencyHistogram read_;
+  LatencyHistogram write_;
+  LatencyHistogram cycleDuration_;
+  LatencyHistogram latency_;
+  LatencyHistogram periodHistogram_;
+
+ protected:
+  // Replaces the trace with the earliest end if the current cycle ended later.
+  void keepTrace() {
+    if (traces_.empty()) {
+      return;
+    }
+    auto shortest = std::min_element(traces_.begin(), traces_.end(),
+                                      [](const CycleTrace& a, const CycleTrace& b) { return a.writeEnd < b.writeEnd; });
+    if (shortest->scheduled == 0 || trace_.writeEnd > shortest->writeEnd) {
+      *shortest = trace_;
+    }
+  }
+
+  const int64_t period_;
+  const uint64_t warmup_;
+  const uint64_t end_;
+  EthercatBusBase& bus_;
+  uint64_t cycle_{0};
+  uint64_t overruns_{0};
+  int64_t scheduled_{0};
+  int64_t lastStart_{0};
+  int64_t previousStart_{0};
+  CycleTrace trace_;
+  std::vector<CycleTrace> traces_;
+  std::atomic<bool> finished_{false};
+};
+
+void printUsage(const char* program) {
+  std::cerr << "Usage: " << program
+            << " [--bus <interface>] [--slaves <n>] [--sim <n>] [--veth <peer>] [--pdo <bytes>] [--cycle-time <us>] [--cycles <n>]"
+               " [--warmup <n>] [--executor cyclic|loop|manager|workers] [--wait sleep|spin|busy] [--spin-time <us>]"
+               " [--policy fifo|other|deadline] [--priority <n>] [--cpu <n>] [--worker-cpu <n>] [--packing pdo|al|dl|errors[,...]]"
+               " [--packing-decimation <n>] [--timelines <n>] [--output <file>]"
+            << std::endl;
+}
+
+bool parseArguments(int argc, char** argv, Configuration& configuration) {
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value of " << argv[i] << std::endl;
+      return false;
+    }
+    const std::string option = argv[i];
+    const char* value = argv[i + 1];
+    if (option == "--bus") {
+      configuration.bus = value;
+    } else if (option == "--slaves") {
+      configuration.slaves = std::atoi(value);
+    } else if (option == "--sim") {
+      configuration.simulatedSlaves = std::atoi(value);
+    } else if (option == "--veth") {
+      configuration.veth = value;
+    } else if (option == "--pdo") {
+      configuration.pdoSize = std::atoi(value);
+    } else if (option == "--cycle-time") {
+      configuration.cycleTime = std::atof(value) * 1e-6;
+    } else if (option == "--cycles") {
+      configuration.cycles = std::strtoull(value, nullptr, 10);
+    } else if (option == "--warmup") {
+      configuration.warmup = std::strtoull(value, nullptr, 10);
+    } else if (option == "--executor") {
+      configuration.executor = value;
+    } else if (option == "--wait") {
+      configuration.wait = value;
+    } else if (option == "--spin-time") {
+      configuration.spinTime = std::atof(value) * 1e-6;
+    } else if (option == "--policy") {
+      configuration.policy = value;
+    } else if (option == "--priority") {
+      configuration.priority = std::atoi(value);
+    } else if (option == "--cpu") {
+      configuration.cpu = std::atoi(value);
+    } else if (option == "--worker-cpu") {
+      configuration.workerCpu = std::atoi(value);
+    } else if (option == "--packing") {
+      configuration.packing = value;
+    } else if (option == "--packing-decimation") {
+      configuration.packingDecimation = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+    } else if (option == "--timelines") {
+      configuration.timelines = static_cast<size_t>(std::atol(value));
+    } else if (option == "--output") {
+      configuration.output = value;
+    } else {
+      std::cerr << "Unknown option " << option << std::endl;
+      return false;
+    }
+  }
+
+  if (configuration.bus.empty()) {
+    if (configuration.simulatedSlaves == 0 || !configuration.veth.empty()) {
+      std::cerr << "A bus is needed unless the segment is simulated in-process." << std::endl;
+      return false;
+    }
+    configuration.bus = "sim0";
+  }
+  if (configuration.slaves == 0) {
+    configuration.slaves = configuration.simulatedSlaves;
+  }
+  if (configuration.slaves <= 0 || configuration.cycleTime <= 0.0 || configuration.cycles == 0 || configuration.pdoSize < 0) {
+    std::cerr << "Invalid configuration, the number of slaves, the cycle time and the number of cycles have to be positive." << std::endl;
+    return false;
+  }
+  const auto isOneOf = [](const std::string& option, const std::string& value, const std::vector<std::string>& choices) {
+    if (std::find(choices.begin(), choices.end(), value) == choices.end()) {
+      std::cerr << "Invalid value " << value << " of " << option << "." << std::endl;
+      return false;
+    }
+    return true;
+  };
+  if (!isOneOf("--executor", configuration.executor, {"cyclic", "loop", "manager", "workers"}) ||
+      !isOneOf("--wait", configuration.wait, {"sleep", "spin", "busy"}) ||
+      !isOneOf("--policy", configuration.policy, {"fifo", "other", "deadline"})) {
+    return false;
+  }
+  // the packing is a comma separated list.
+  std::stringstream stream(configuration.packing);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (!isOneOf("--packing", item, {"pdo", "al", "dl", "errors"})) {
+      return false;
+    }
+  }
+  return true;
+}
+
+CyclicExecutor::Options getExecutorOptions(const Configuration& configuration) {
+  CyclicExecutor::Options options;
+  options.cycleTime = configuration.cycleTime;
+  options.cpu = configuration.cpu;
+  options.priority = configuration.priority;
+  if (configuration.policy == "other") {
+    options.policy = CyclicExecutor::SchedulingPolicy::Other;
+  } else if (configuration.policy == "deadline") {
+    options.policy = CyclicExecutor::SchedulingPolicy::Deadline;
+  }
+  // a spin time of a whole cycle never sleeps.
+  if (configuration.wait == "spin") {
+    options.spinTime = configuration.spinTime;
+  } else if (configuration.wait == "busy") {
+    options.spinTime = configuration.cycleTime;
+  }
+  return options;
+}
+
+// The loop executor runs in the main thread with the same schedule as CyclicExecutor, but without its thread setup.
+void runLoop(const Configuration& configuration, const std::function<void()>& read, const std::function<void()>& write,
+             CycleProbe& probe) {
+  if (configuration.cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(configuration.cpu, &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+      std::cerr << "Could not pin the loop to CPU " << configuration.cpu << "." << std::endl;
+    }
+  }
+  if (configuration.policy == "fifo") {
+    sched_param parameter{};
+    parameter.sched_priority = configuration.priority;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameter) != 0) {
+      std::cerr << "Could not set SCHED_FIFO with priority " << configuration.priority << "." << std::endl;
+    }
+  }
+  const int64_t spin = static_cast<int64_t>(getExecutorOptions(configuration).spinTime * 1e9);
+  while (!probe.isFinished()) {
+    probe.startCycle();
+    read();
+    probe.endRead();
+    write();
+    probe.endCycle();
+    const int64_t wakeUp = probe.getScheduled() - spin;
+    if (wakeUp > CycleStatistics::now()) {
+      timespec time{};
+      time.tv_sec = static_cast<time_t>(wakeUp / 1000000000);
+      time.tv_nsec = static_cast<long>(wakeUp % 1000000000);
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR) {
+      }
+    }
+    while (CycleStatistics::now() < probe.getScheduled()) {
+    }
+  }
+}
+
+void printHistogram(std::ostream& out, const char* name, const HistogramSnapshot& histogram, const bool last = false) {
+  out << "    \"" << name << "\": {\"count\": " << histogram.count << ", \"min\": " << histogram.min << ", \"max\": " << histogram.max
+      << ", \"mean\": " << histogram.mean << ", \"stddev\": " << histogram.standardDeviation
+      << ", \"p50\": " << histogram.getPercentile(0.5) << ", \"p90\": " << histogram.getPercentile(0.9)
+      << ", \"p99\": " << histogram.getPercentile(0.99) << ", \"p999\": " << histogram.getPercentile(0.999) << ", \"buckets\": [";
+  bool first = true;
+  for (size_t i = 0; i < histogram.counts.size(); i++) {
+    if (histogram.counts[i] == 0) {
+      continue;
+    }
+    out << (first ? "" : ", ") << "[" << LatencyHistogram::getBucketLowerBound(static_cast<unsigned int>(i)) << ", " << histogram.counts[i]
+        << "]";
+    first = false;
+  }
+  out << "]}" << (last ? "" : ",") << "\n";
+}
+
+void printResults(std::ostream& out, const Configuration& configuration, const std::string& mode, CycleProbe& probe,
+                  EthercatBusBase& bus, const CyclicExecutor* executor) {
+  utsname system{};
+  uname(&system);
+  const auto statistics = bus.getCycleStatistics();
+  out << "{\n";
+  out << "  \"host\": {\"hostname\": \"" << system.nodename << "\", \"kernel\": \"" << system.release << "\", \"machine\": \""
+      << system.machine << "\"},\n";
+  out << "  \"config\": {\"bus\": \"" << configuration.bus << "\", \"mode\": \"" << mode << "\", \"slaves\": " << configuration.slaves
+      << ", \"cycle_time_ns\": " << static_cast<int64_t>(configuration.cycleTime * 1e9) << ", \"cycles\": " << configuration.cycles
+      << ", \"warmup\": " << configuration.warmup << ", \"executor\": \"" << configuration.executor << "\", \"wait\": \""
+      << configuration.wait << "\", \"spin_time_ns\": " << static_cast<int64_t>(getExecutorOptions(configuration).spinTime * 1e9)
+      << ", \"policy\": \"" << configuration.policy << "\", \"priority\": " << configuration.priority << ", \"cpu\": " << configuration.cpu
+      << ", \"worker_cpu\": " << configuration.workerCpu << ", \"packing\": \"" << configuration.packing
+      << "\", \"packing_decimation\": " << configuration.packingDecimation << "},\n";
+  // the phases are recorded by the bus until the executor stopped, a few cycles more than measured.
+  out << "  \"bus_cycles\": " << statistics.cycles << ",\n";
+  out << "  \"overruns\": " << probe.getOverruns() << ",\n";
+  if (executor != nullptr) {
+    out << "  \"max_cycle_duration_ns\": " << static_cast<int64_t>(executor->getStatistics().maxCycleDuration * 1e9) << ",\n";
+  }
+  out << "  \"bus_ok\": " << (bus.busIsOk() ? "true" : "false") << ",\n";
+  out << "  \"working_counter\": {\"min\": " << statistics.workingCounterMin << ", \"average\": " << statistics.workingCounterAverage
+      << ", \"low_runs\": " << statistics.lowWorkingCounterRuns << ", \"longest_low_run\": " << statistics.longestLowWorkingCounterRun
+      << "},\n";
+  // times of the cycle as seen by the executor, in ns.
+  out << "  \"cycle\": {\n";
+  printHistogram(out, "wake_up", probe.wakeUp_.getSnapshot());
+  printHistogram(out, "read", probe.read_.getSnapshot());
+  printHistogram(out, "write", probe.write_.getSnapshot());
+  printHistogram(out, "duration", probe.cycleDuration_.getSnapshot());
+  printHistogram(out, "latency", probe.latency_.getSnapshot());
+  printHistogram(out, "period", probe.periodHistogram_.getSnapshot(), true);
+  out << "  },\n";
+  // phases inside updateWrite() and updateRead(), see CycleStatisticsSnapshot.
+  out << "  \"phases\": {\n";
+  printHistogram(out, "write_slaves", statistics.writeSlaves);
+  printHistogram(out, "send", statistics.send);
+  printHistogram(out, "receive", statistics.receive);
+  printHistogram(out, "read_slaves", statistics.readSlaves);
+  printHistogram(out, "period", statistics.period, true);
+  out << "  },\n";
+  out << "  \"worst_cycles\": [";
+  const auto traces = probe.getWorstTraces();
+  for (size_t i = 0; i < traces.size(); i++) {
+    const CycleTrace& trace = traces[i];
+    out << (i == 0 ? "\n" : ",\n") << "    {\"cycle\": " << trace.cycle << ", \"scheduled\": " << trace.scheduled
+        << ", \"wake_up\": " << trace.wakeUp << ", \"read_end\": " << trace.readEnd << ", \"write_end\": " << trace.writeEnd
+        << ", \"overrun\": " << (trace.overrun ? "true" : "false") << "}";
+  }
+  out << (traces.empty() ? "]\n" : "\n  ]\n");
+  out << "}" << std::endl;
+}
+
+bool addPacking(const Configuration& configuration, EthercatBusBase& bus) {
+  std::stringstream stream(configuration.packing);
+  std::string item;
+  bool ok = true;
+  while (std::getline(stream, item, ',')) {
+    if (item == "al") {
+      ok &= bus.addCyclicStatusReadForAllSlaves(StatusRegister::AlStatus, configuration.packingDecimation);
+    } else if (item == "dl") {
+      ok &= bus.addCyclicStatusReadForAllSlaves(StatusRegister::DlStatus, configuration.packingDecimation);
+    } else if (item == "errors") {
+      ok &= bus.addCyclicStatusReadForAllSlaves(StatusRegister::ErrorCounters, configuration.packingDecimation);
+    }
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Configuration configuration;
+  if (!parseArguments(argc, argv, configuration)) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // the segment is declared first, so that it outlives the bus.
+  std::unique_ptr<VirtualSegment> segment;
+  std::string mode = "real";
+  if (configuration.simulatedSlaves > 0) {
+    segment = std::make_unique<VirtualSegment>(configuration.veth.empty() ? configuration.bus : configuration.veth);
+    segment->addSlaves(VirtualSlaveDescription::fromPdoSizes("cyclictest", 0, 0, static_cast<size_t>(configuration.pdoSize),
+                                                             static_cast<size_t>(configuration.pdoSize)),
+                       static_cast<size_t>(configuration.simulatedSlaves));
+    if (configuration.veth.empty()) {
+      mode = "sim";
+      if (!segment->attach()) {
+        return EXIT_FAILURE;
+      }
+    } else {
+      mode = "veth";
+      if (!segment->serve(configuration.veth)) {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  auto ownedBus = std::make_unique<EthercatBusBase>(configuration.bus);
+  EthercatBusBase& bus = *ownedBus;
+  for (int address = 1; address <= configuration.slaves; address++) {
+    bus.addSlave(std::make_shared<BenchmarkSlave>(&bus, static_cast<uint32_t>(address)));
+  }
+  if (!bus.startup(false)) {
+    std::cerr << "Could not start the bus " << configuration.bus << "." << std::endl;
+    return EXIT_FAILURE;
+  }
+  bus.setState(EC_STATE_OPERATIONAL);
+  if (!bus.waitForState(EC_STATE_OPERATIONAL, 0) || !addPacking(configuration, bus)) {
+    std::cerr << "Could not bring the bus " << configuration.bus << " to OP." << std::endl;
+    bus.shutdown();
+    return EXIT_FAILURE;
+  }
+
+  EthercatBusManagerBase manager;
+  std::function<void()> read = [&bus]() { bus.updateRead(); };
+  std::function<void()> write = [&bus]() { bus.updateWrite(); };
+  if (configuration.executor == "manager" || configuration.executor == "workers") {
+    manager.addEthercatBus(std::move(ownedBus));
+    read = [&manager]() { manager.readAllBuses(); };
+    write = [&manager]() { manager.writeToAllBuses(); };
+    if (configuration.executor == "workers") {
+      EthercatBusManagerBase::WorkerOptions workerOptions;
+      workerOptions.cpus = {configuration.workerCpu};
+      workerOptions.priority = configuration.policy == "fifo" ? configuration.priority : 0;
+      workerOptions.spin = configuration.wait != "sleep";
+      if (!manager.startBusWorkers(workerOptions)) {
+        std::cerr << "Could not start the bus workers." << std::endl;
+        manager.shutdownAllBuses();
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  CycleProbe probe(configuration, bus);
+  std::unique_ptr<CyclicExecutor> executor;
+  if (configuration.executor == "loop") {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      std::cerr << "Could not lock the memory." << std::endl;
+    }
+    runLoop(configuration, read, write, probe);
+  } else {
+    executor = std::make_unique<CyclicExecutor>(
+        [&probe, &read]() {
+          probe.startCycle();
+          read();
+          probe.endRead();
+        },
+        [&probe, &write]() {
+          write();
+          probe.endCycle();
+        },
+        getExecutorOptions(configuration));
+    if (!executor->start()) {
+      if (configuration.executor == "workers") {
+        manager.stopBusWorkers();
+      }
+      if (ownedBus) {
+        bus.shutdown();
+      } else {
+        manager.shutdownAllBuses();
+      }
+      return EXIT_FAILURE;
+    }
+    while (!probe.isFinished()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    executor->stop();
+  }
+
+  if (configuration.output.empty()) {
+    printResults(std::cout, configuration, mode, probe, bus, executor.get());
+  } else {
+    std::ofstream file(configuration.output);
+    printResults(file, configuration, mode, probe, bus, executor.get());
+  }
+
+  const bool busIsOk = bus.busIsOk();
+  if (configuration.executor == "workers") {
+    manager.stopBusWorkers();
+  }
+  if (ownedBus) {
+    bus.shutdown();
+  } else {
+    manager.shutdownAllBuses();
+  }
+  return busIsOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
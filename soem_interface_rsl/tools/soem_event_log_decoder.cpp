@@ -0,0 +1,157 @@
+/*
+** Copyright (2019-2020) Robotics Systems Lab - ETH Zurich:
+** Markus Staeuble, Jonas Junger, Johannes Pankert, Philipp Leemann,
+** Tom Lankhorst, Samuel Bachmann, Gabriel Hottiger, Lennert Nachtigall,
+** Mario Mauerer, Remo Diethelm
+**
+** This file is part of the soem_interface_rsl.
+**
+** The soem_interface_rsl is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** The seom_interface is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with the soem_interface_rsl.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Prints the records of a binary event log written by EthercatBusBase::openEventLog(..).
+// Usage: soem_event_log_decoder <file> [--slave <address>] [--tail <n>]
+
+// std
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// soem_interface_rsl
+#include <soem_interface_rsl/EthercatBusBase.hpp>
+#include <soem_interface_rsl/common/EventLog.hpp>
+
+// soem_rsl
+#include <soem_rsl/ethercat.h>
+
+using soem_interface_rsl::EthercatBusBase;
+using soem_interface_rsl::common::EventLog;
+using soem_interface_rsl::common::EventLogInfo;
+using soem_interface_rsl::common::EventRecord;
+using soem_interface_rsl::common::EventType;
+using soem_interface_rsl::common::RecoveryAction;
+
+static std::string formatStamp(const uint64_t stamp) {
+  const time_t seconds = static_cast<time_t>(stamp / 1000000000);
+  tm time{};
+  localtime_r(&seconds, &time);
+  char buffer[64];
+  const size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &time);
+  std::snprintf(buffer + length, sizeof(buffer) - length, ".%06u", static_cast<unsigned>((stamp % 1000000000) / 1000));
+  return buffer;
+}
+
+static std::string state(const int32_t value) {
+  return EthercatBusBase::getStateString(static_cast<uint16_t>(value));
+}
+
+static std::string describe(const EventRecord& record) {
+  char buffer[256];
+  switch (static_cast<EventType>(record.type)) {
+    case EventType::StateRequest:
+      return state(record.value0) + " -> " + state(record.value1);
+    case EventType::StateError:
+      std::snprintf(buffer, sizeof(buffer), "%s not reached, current %s, alStatusCode: 0x%04x %s", state(record.value1).c_str(),
+                    state(record.value0).c_str(), record.code, ec_ALstatuscode2string(static_cast<uint16>(record.code)));
+      return buffer;
+    case EventType::WorkingCounterDrop:
+      std::snprintf(buffer, sizeof(buffer), "wkc %d < %d", record.value0, record.value1);
+      return buffer;
+    case EventType::WorkingCounterRestored:
+      std::snprintf(buffer, sizeof(buffer), "wkc %d after %d cycles too low", record.value0, record.value1);
+      return buffer;
+    case EventType::SdoAbort:
+      std::snprintf(buffer, sizeof(buffer), "0x%04x.%02x abort code: 0x%08x %s", record.index, record.subIndex, record.code,
+                    ec_sdoerror2string(record.code));
+      return buffer;
+    case EventType::Emergency:
+      std::snprintf(buffer, sizeof(buffer), "error code: 0x%04x error register: 0x%02x", record.code, static_cast<unsigned>(record.value0));
+      return buffer;
+    case EventType::PacketError:
+      std::snprintf(buffer, sizeof(buffer), "0x%04x.%02x error code: 0x%08x", record.index, record.subIndex, record.code);
+      return buffer;
+    case EventType::MailboxError:
+      std::snprintf(buffer, sizeof(buffer), "error code: 0x%04x %s", record.code, ec_mbxerror2string(static_cast<uint16>(record.code)));
+      return buffer;
+    case EventType::SoeError:
+      std::snprintf(buffer, sizeof(buffer), "IDN 0x%04x error code: 0x%04x %s", record.index, record.code,
+                    ec_soeerror2string(static_cast<uint16>(record.code)));
+      return buffer;
+    case EventType::Overrun:
+      std::snprintf(buffer, sizeof(buffer), "cycle took %d us, period %d us", record.value0, record.value1);
+      return buffer;
+    case EventType::Recovery:
+      return EventLog::getRecoveryActionString(static_cast<RecoveryAction>(record.value0)) + ", state " + state(record.value1);
+    case EventType::SlaveBudgetExceeded:
+      std::snprintf(buffer, sizeof(buffer), "%s took %d us, budget %d us", record.code == 0 ? "updateRead()" : "updateWrite()",
+                    record.value0, record.value1);
+      return buffer;
+    case EventType::WorkingCounterFault:
+      if (record.index == 0xffff) {
+        std::snprintf(buffer, sizeof(buffer), "working counter %d of %d, no answer", record.value0, record.value1);
+      } else {
+        std::snprintf(buffer, sizeof(buffer), "working counter %d of %d, state %s, AL status code: 0x%04x %s", record.value0, record.value1,
+                      state(record.index).c_str(), record.code, ec_ALstatuscode2string(static_cast<uint16>(record.code)));
+      }
+      return buffer;
+    default:
+      std::snprintf(buffer, sizeof(buffer), "code: 0x%08x values: %d %d", record.code, record.value0, record.value1);
+      return buffer;
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <file> [--slave <address>] [--tail <n>]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  int slave = -1;
+  size_t tail = 0;
+  for (int i = 2; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--slave") == 0) {
+      slave = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--tail") == 0) {
+      tail = static_cast<size_t>(std::atol(argv[i + 1]));
+    } else {
+      std::cerr << "Unknown option " << argv[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  EventLogInfo info;
+  std::vector<EventRecord> records;
+  if (!EventLog::read(argv[1], info, records)) {
+    return EXIT_FAILURE;
+  }
+  std::cout << "Bus: " << info.busName << ", records written: " << info.written << ", kept: " << records.size() << " of "
+            << info.capacity << std::endl;
+
+  std::vector<const EventRecord*> selected;
+  for (const auto& record : records) {
+    if (slave < 0 || record.slave == slave) {
+      selected.push_back(&record);
+    }
+  }
+  const size_t begin = tail > 0 && tail < selected.size() ? selected.size() - tail : 0;
+  for (size_t i = begin; i < selected.size(); i++) {
+    const EventRecord& record = *selected[i];
+    std::cout << formatStamp(record.stamp) << " slave " << record.slave << " "
+              << EventLog::getTypeString(static_cast<EventType>(record.type)) << ": " << describe(record) << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
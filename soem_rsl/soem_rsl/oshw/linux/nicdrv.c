@@ -72,6 +72,89 @@ const uint16 secMAC[3] = { 0x0404, 0x0404, 0x0404 };
 /** second MAC word is used for identification */
 #define RX_SEC secMAC[1]
 
+/** Maximum number of registered transports */
+#define EC_MAXTRANSPORT 8
+
+/** Transport registered for an interface name */
+typedef struct
+{
+   char ifname[64];
+   ec_transportt transport;
+} ec_transportentryt;
+
+static ec_transportentryt ec_transportlist[EC_MAXTRANSPORT];
+static pthread_mutex_t ec_transportmutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** Register a transport for an interface name. A port set up with this name
+ * afterwards uses the transport instead of a raw socket, ports already set up
+ * are not affected.
+ * @param[in] ifname    = interface name, e.g. "virtual0"
+ * @param[in] transport = transport, NULL to remove the registration
+ * @return >0 if OK, 0 if the name is too long or the list is full
+ */
+int ecx_registertransport(const char *ifname, const ec_transportt *transport)
+{
+   int i, slot = -1, rval = 0;
+
+   if (strlen(ifname) >= sizeof(ec_transportlist[0].ifname))
+   {
+      return 0;
+   }
+   pthread_mutex_lock(&ec_transportmutex);
+   for (i = 0; i < EC_MAXTRANSPORT; i++)
+   {
+      if (ec_transportlist[i].ifname[0] == 0)
+      {
+         if (slot < 0) slot = i;
+      }
+      else if (strcmp(ec_transportlist[i].ifname, ifname) == 0)
+      {
+         slot = i;
+         break;
+      }
+   }
+   if (slot >= 0)
+   {
+      if (transport)
+      {
+         strcpy(ec_transportlist[slot].ifname, ifname);
+         ec_transportlist[slot].transport = *transport;
+      }
+      else
+      {
+         memset(&ec_transportlist[slot], 0, sizeof(ec_transportlist[slot]));
+      }
+      rval = 1;
+   }
+   pthread_mutex_unlock(&ec_transportmutex);
+
+   return rval;
+}
+
+/** Look up the transport registered for an interface name.
+ * @param[in]  ifname    = interface name
+ * @param[out] transport = registered transport, unchanged if none
+ * @return >0 if a transport is registered
+ */
+int ecx_findtransport(const char *ifname, ec_transportt *transport)
+{
+   int i, rval = 0;
+
+   pthread_mutex_lock(&ec_transportmutex);
+   for (i = 0; i < EC_MAXTRANSPORT; i++)
+   {
+      if ((ec_transportlist[i].ifname[0] != 0) && (strcmp(ec_transportlist[i].ifname, ifname) == 0))
+      {
+         *transport = ec_transportlist[i].transport;
+         rval = 1;
+         break;
+      }
+   }
+   pthread_mutex_unlock(&ec_transportmutex);
+
+   return rval;
+}
+
 static void ecx_clear_rxbufstat(int *rxbufstat)
 {
    int i;
@@ -107,6 +190,7 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
          psock = &(port->redport->sockhandle);
          *psock = -1;
          port->redstate                   = ECT_RED_DOUBLE;
+         memset(&(port->redport->transport), 0, sizeof(port->redport->transport));
          port->redport->stack.sock        = &(port->redport->sockhandle);
          port->redport->stack.txbuf       = &(port->txbuf);
          port->redport->stack.txbuflength = &(port->txbuflength);
@@ -115,6 +199,11 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
          port->redport->stack.rxbufstat   = &(port->redport->rxbufstat);
          port->redport->stack.rxsa        = &(port->redport->rxsa);
          ecx_clear_rxbufstat(&(port->redport->rxbufstat[0]));
+         /* registered transport replaces the socket of the secondary port */
+         if (ecx_findtransport(ifname, &(port->redport->transport)))
+         {
+            return 1;
+         }
       }
       else
       {
@@ -132,6 +221,9 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
       port->sockhandle        = -1;
       port->lastidx           = 0;
       port->redstate          = ECT_RED_NONE;
+      port->capturehook       = NULL;
+      port->capturehookdata   = NULL;
+      memset(&(port->transport), 0, sizeof(port->transport));
       port->stack.sock        = &(port->sockhandle);
       port->stack.txbuf       = &(port->txbuf);
       port->stack.txbuflength = &(port->txbuflength);
@@ -141,6 +233,16 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
       port->stack.rxsa        = &(port->rxsa);
       ecx_clear_rxbufstat(&(port->rxbufstat[0]));
       psock = &(port->sockhandle);
+      /* registered transport replaces the socket of the primary port */
+      if (ecx_findtransport(ifname, &(port->transport)))
+      {
+         for (i = 0; i < EC_MAXBUF; i++)
+         {
+            ec_setupheader(&(port->txbuf[i]));
+         }
+         ec_setupheader(&(port->txbuf2));
+         return 1;
+      }
    }
    /* we use RAW packet socket, with packet type ETH_P_ECAT */
    *psock = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_ECAT));
@@ -271,26 +373,52 @@ int ecx_outframe(ecx_portt *port, int idx, int stacknumber)
 {
    int lp, rval;
    ec_stackT *stack;
+   ec_transportt *transport;
 
    if (!stacknumber)
    {
       stack = &(port->stack);
+      transport = &(port->transport);
    }
    else
    {
       stack = &(port->redport->stack);
+      transport = &(port->redport->transport);
    }
    lp = (*stack->txbuflength)[idx];
    (*stack->rxbufstat)[idx] = EC_BUF_TX;
-   rval = send(*stack->sock, (*stack->txbuf)[idx], lp, 0);
+   if (transport->send)
+   {
+      rval = transport->send(transport->userdata, stacknumber, (*stack->txbuf)[idx], lp);
+   }
+   else
+   {
+      rval = send(*stack->sock, (*stack->txbuf)[idx], lp, 0);
+   }
    if (rval == -1)
    {
       (*stack->rxbufstat)[idx] = EC_BUF_EMPTY;
    }
+   else if (port->capturehook)
+   {
+      port->capturehook(port->capturehookdata, EC_CAPTURE_TX, stacknumber, (*stack->txbuf)[idx], lp);
+   }
 
    return rval;
 }
 
+/** Set the frame capture hook of a port. Call it after ecx_setupnic and
+ * while no frames are sent or received.
+ * @param[in] port     = port context struct
+ * @param[in] hook     = hook called with every frame, NULL to remove it
+ * @param[in] userdata = pointer passed to the hook
+ */
+void ecx_setcapturehook(ecx_portt *port, ec_capturehookt hook, void *userdata)
+{
+   port->capturehookdata = userdata;
+   port->capturehook = hook;
+}
+
 /** Transmit buffer over socket (non blocking).
  * @param[in] port        = port context struct
  * @param[in] idx = index in tx buffer array
@@ -338,18 +466,32 @@ static int ecx_recvpkt(ecx_portt *port, int stacknumber)
 {
    int lp, bytesrx;
    ec_stackT *stack;
+   ec_transportt *transport;
 
    if (!stacknumber)
    {
       stack = &(port->stack);
+      transport = &(port->transport);
    }
    else
    {
       stack = &(port->redport->stack);
+      transport = &(port->redport->transport);
    }
    lp = sizeof(port->tempinbuf);
-   bytesrx = recv(*stack->sock, (*stack->tempbuf), lp, 0);
+   if (transport->recv)
+   {
+      bytesrx = transport->recv(transport->userdata, stacknumber, (*stack->tempbuf), lp);
+   }
+   else
+   {
+      bytesrx = recv(*stack->sock, (*stack->tempbuf), lp, 0);
+   }
    port->tempinbufs = bytesrx;
+   if ((bytesrx > 0) && port->capturehook)
+   {
+      port->capturehook(port->capturehookdata, EC_CAPTURE_RX, stacknumber, (*stack->tempbuf), bytesrx);
+   }
 
    return (bytesrx > 0);
 }
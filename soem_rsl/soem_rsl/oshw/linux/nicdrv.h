@@ -18,6 +18,35 @@ extern "C"
 
 #include <pthread.h>
 
+/** capture direction of a frame passed to the capture hook */
+#define EC_CAPTURE_TX 0
+#define EC_CAPTURE_RX 1
+
+/** Frame capture hook, called with every frame sent or received on a port.
+ * It runs in the sending or receiving thread and has to return quickly.
+ * @param[in] userdata    = pointer given to ecx_setcapturehook
+ * @param[in] direction   = EC_CAPTURE_TX or EC_CAPTURE_RX
+ * @param[in] stacknumber = 0=primary 1=secondary stack
+ * @param[in] frame       = ethernet frame
+ * @param[in] length      = length of the frame in bytes
+ */
+typedef void (*ec_capturehookt)(void *userdata, int direction, int stacknumber, const void *frame, int length);
+
+/** Transport replacing the raw socket of a port, e.g. an in-process simulated
+ * segment. Both functions run in the calling thread of the master.
+ */
+typedef struct
+{
+   /** Send a frame, returns the number of bytes sent or -1 on failure.
+    * Arguments are userdata, stacknumber, frame and length. */
+   int (*send)(void *userdata, int stacknumber, const void *frame, int length);
+   /** Non blocking receive of a frame into a buffer of the given size,
+    * returns the number of bytes received, <= 0 if none is pending. */
+   int (*recv)(void *userdata, int stacknumber, void *frame, int length);
+   /** user data passed to send and recv */
+   void *userdata;
+} ec_transportt;
+
 /** pointer structure to Tx and Rx stacks */
 typedef struct
 {
@@ -50,6 +79,8 @@ typedef struct
    int rxsa[EC_MAXBUF];
    /** temporary rx buffer */
    ec_bufT tempinbuf;
+   /** transport used instead of the socket, send is NULL if none */
+   ec_transportt transport;
 } ecx_redportt;
 
 /** pointer structure to buffers, vars and mutexes for port instantiation */
@@ -84,6 +115,12 @@ typedef struct
    pthread_mutex_t getindex_mutex;
    pthread_mutex_t tx_mutex;
    pthread_mutex_t rx_mutex;
+   /** frame capture hook, NULL if none */
+   ec_capturehookt capturehook;
+   /** user data passed to the capture hook */
+   void *capturehookdata;
+   /** transport used instead of the socket, send is NULL if none */
+   ec_transportt transport;
 } ecx_portt;
 
 extern const uint16 priMAC[3];
@@ -112,6 +149,9 @@ int ecx_outframe(ecx_portt *port, int idx, int sock);
 int ecx_outframe_red(ecx_portt *port, int idx);
 int ecx_waitinframe(ecx_portt *port, int idx, int timeout);
 int ecx_srconfirm(ecx_portt *port, int idx,int timeout);
+void ecx_setcapturehook(ecx_portt *port, ec_capturehookt hook, void *userdata);
+int ecx_registertransport(const char *ifname, const ec_transportt *transport);
+int ecx_findtransport(const char *ifname, ec_transportt *transport);
 
 #ifdef __cplusplus
 }